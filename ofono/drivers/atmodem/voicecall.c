@@ -62,6 +62,8 @@ static const char *atd_prefix[] = { "+COLP:", NULL };
 #define FLAG_NEED_CNAP 2
 #define FLAG_NEED_CDIP 4
 
+struct call_progress;
+
 struct voicecall_data {
 	GSList *calls;
 	unsigned int local_release;
@@ -72,6 +74,7 @@ struct voicecall_data {
 	guint vts_source;
 	unsigned int vts_delay;
 	unsigned char flags;
+	const struct call_progress *progress;
 };
 
 struct release_id_req {
@@ -89,6 +92,7 @@ struct change_state_req {
 };
 
 static gboolean poll_clcc(gpointer user_data);
+static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data);
 
 static int class_to_call_type(int cls)
 {
@@ -106,7 +110,8 @@ static int class_to_call_type(int cls)
 
 static struct ofono_call *create_call(struct ofono_voicecall *vc, int type,
 					int direction, int status,
-					const char *num, int num_type, int clip)
+					const char *num, int num_type, int clip,
+					int id)
 {
 	struct voicecall_data *d = ofono_voicecall_get_data(vc);
 	struct ofono_call *call;
@@ -118,7 +123,7 @@ static struct ofono_call *create_call(struct ofono_voicecall *vc, int type,
 
 	ofono_call_init(call);
 
-	call->id = ofono_voicecall_get_next_callid(vc);
+	call->id = id;
 	call->type = type;
 	call->direction = direction;
 	call->status = status;
@@ -144,6 +149,8 @@ static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	GSList *calls;
 	GSList *n, *o;
 	struct ofono_call *nc, *oc;
+	struct ofono_call *snapshot;
+	unsigned int num_calls = 0;
 	gboolean poll_again = FALSE;
 	struct ofono_error error;
 
@@ -168,6 +175,7 @@ static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	}
 
 	calls = at_util_parse_clcc(result);
+	snapshot = g_new(struct ofono_call, g_slist_length(calls));
 
 	n = calls;
 	o = vd->calls;
@@ -203,7 +211,7 @@ static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data)
 		} else if (nc && (oc == NULL || (nc->id < oc->id))) {
 			/* new call, signal it */
 			if (nc->type == 0)
-				ofono_voicecall_notify(vc, nc);
+				snapshot[num_calls++] = *nc;
 
 			n = n->next;
 		} else {
@@ -240,19 +248,21 @@ static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data)
 			 * here
 			 */
 			if (nc->status == CALL_STATUS_INCOMING &&
-					(vd->flags & FLAG_NEED_CLIP)) {
-				if (nc->type == 0)
-					ofono_voicecall_notify(vc, nc);
-
+					(vd->flags & FLAG_NEED_CLIP))
 				vd->flags &= ~FLAG_NEED_CLIP;
-			} else if (memcmp(nc, oc, sizeof(*nc)) && nc->type == 0)
-				ofono_voicecall_notify(vc, nc);
+
+			/* The core only signals what actually changed */
+			if (nc->type == 0)
+				snapshot[num_calls++] = *nc;
 
 			n = n->next;
 			o = o->next;
 		}
 	}
 
+	ofono_voicecall_notify_list(vc, snapshot, num_calls);
+	g_free(snapshot);
+
 	g_slist_foreach(vd->calls, (GFunc) g_free, NULL);
 	g_slist_free(vd->calls);
 
@@ -261,7 +271,8 @@ static void clcc_poll_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	vd->local_release = 0;
 
 poll_again:
-	if (poll_again && !vd->clcc_source)
+	/* With call progress indications CLCC only reconciles */
+	if (poll_again && !vd->clcc_source && vd->progress == NULL)
 		vd->clcc_source = g_timeout_add(POLL_CLCC_INTERVAL,
 						poll_clcc, vc);
 }
@@ -344,6 +355,15 @@ static void atd_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	if (!ok)
 		goto out;
 
+	/* The call progress indication may have beaten the OK */
+	if (vd->progress != NULL && (g_slist_find_custom(vd->calls,
+				GINT_TO_POINTER(CALL_STATUS_DIALING),
+				at_util_call_compare_by_status) ||
+			g_slist_find_custom(vd->calls,
+				GINT_TO_POINTER(CALL_STATUS_ALERTING),
+				at_util_call_compare_by_status)))
+		goto out;
+
 	/* On a success, make sure to put all active calls on hold */
 	for (l = vd->calls; l; l = l->next) {
 		call = l->data;
@@ -370,7 +390,8 @@ static void atd_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	}
 
 	/* Generate a voice call that was just dialed, we guess the ID */
-	call = create_call(vc, 0, 0, CALL_STATUS_DIALING, num, type, validity);
+	call = create_call(vc, 0, 0, CALL_STATUS_DIALING, num, type, validity,
+				ofono_voicecall_get_next_callid(vc));
 	if (call == NULL) {
 		ofono_error("Unable to malloc, call tracking will fail!");
 		return;
@@ -384,7 +405,7 @@ static void atd_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	if (validity != 2)
 		ofono_voicecall_notify(vc, call);
 
-	if (!vd->clcc_source)
+	if (!vd->clcc_source && vd->progress == NULL)
 		vd->clcc_source = g_timeout_add(POLL_CLCC_INTERVAL,
 						poll_clcc, vc);
 
@@ -671,7 +692,8 @@ static void ring_notify(GAtResult *result, gpointer user_data)
 		return;
 
 	/* Generate an incoming call of unknown type */
-	call = create_call(vc, 9, 1, CALL_STATUS_INCOMING, NULL, 128, 2);
+	call = create_call(vc, 9, 1, CALL_STATUS_INCOMING, NULL, 128, 2,
+				ofono_voicecall_get_next_callid(vc));
 	if (call == NULL) {
 		ofono_error("Couldn't create call, call management is fubar!");
 		return;
@@ -724,7 +746,8 @@ static void cring_notify(GAtResult *result, gpointer user_data)
 		type = 9;
 
 	/* Generate an incoming call */
-	create_call(vc, type, 1, CALL_STATUS_INCOMING, NULL, 128, 2);
+	create_call(vc, type, 1, CALL_STATUS_INCOMING, NULL, 128, 2,
+			ofono_voicecall_get_next_callid(vc));
 
 	/* We have a call, and call type but don't know the number and
 	 * must wait for the CLIP to arrive before announcing the call.
@@ -945,7 +968,8 @@ static void ccwa_notify(GAtResult *result, gpointer user_data)
 	DBG("%s %d %d %d", num, num_type, cls, validity);
 
 	call = create_call(vc, class_to_call_type(cls), 1, CALL_STATUS_WAITING,
-				num, num_type, validity);
+				num, num_type, validity,
+				ofono_voicecall_get_next_callid(vc));
 	if (call == NULL) {
 		ofono_error("Unable to malloc. Call management is fubar");
 		return;
@@ -954,7 +978,7 @@ static void ccwa_notify(GAtResult *result, gpointer user_data)
 	if (call->type == 0) /* Only notify voice calls */
 		ofono_voicecall_notify(vc, call);
 
-	if (vd->clcc_source == 0)
+	if (vd->clcc_source == 0 && vd->progress == NULL)
 		vd->clcc_source = g_timeout_add(POLL_CLCC_INTERVAL,
 						poll_clcc, vc);
 }
@@ -1045,6 +1069,301 @@ out:
 	ofono_voicecall_ssn_mt_notify(vc, 0, code, index, &ph);
 }
 
+/*
+ * Some modems report every call state change as an unsolicited result.
+ * With those the call list is tracked from the indications alone and
+ * CLCC is only sent to reconcile whenever they do not add up.
+ */
+struct call_progress_urc {
+	const char *prefix;
+	GAtNotifyFunc notify;
+};
+
+struct call_progress {
+	unsigned int vendor;
+	const char *enable;
+	const struct call_progress_urc *urcs;
+};
+
+static void reconcile_calls(struct ofono_voicecall *vc)
+{
+	struct voicecall_data *vd = ofono_voicecall_get_data(vc);
+
+	DBG("");
+
+	if (vd->clcc_source) {
+		g_source_remove(vd->clcc_source);
+		vd->clcc_source = 0;
+	}
+
+	g_at_chat_send(vd->chat, "AT+CLCC", clcc_prefix,
+			clcc_poll_cb, vc, NULL);
+}
+
+static void call_progress_update(struct ofono_voicecall *vc, int id,
+					int type, int status,
+					const char *num, int num_type)
+{
+	struct voicecall_data *vd = ofono_voicecall_get_data(vc);
+	enum ofono_disconnect_reason reason;
+	struct ofono_call *call;
+	int direction;
+	GSList *l;
+
+	DBG("id: %d, type: %d, status: %d", id, type, status);
+
+	l = g_slist_find_custom(vd->calls, GINT_TO_POINTER(id),
+				at_util_call_compare_by_id);
+
+	if (l != NULL) {
+		call = l->data;
+
+		if (status == CALL_STATUS_DISCONNECTED) {
+			if (vd->local_release & (1 << id))
+				reason = OFONO_DISCONNECT_REASON_LOCAL_HANGUP;
+			else
+				reason = OFONO_DISCONNECT_REASON_REMOTE_HANGUP;
+
+			if (call->type == 0)
+				ofono_voicecall_disconnected(vc, id,
+								reason, NULL);
+
+			vd->local_release &= ~(1 << id);
+			vd->calls = g_slist_remove(vd->calls, call);
+			g_free(call);
+			return;
+		}
+
+		if (call->status == status)
+			return;
+
+		call->status = status;
+
+		if (call->type == 0)
+			ofono_voicecall_notify(vc, call);
+
+		return;
+	}
+
+	switch (status) {
+	case CALL_STATUS_DISCONNECTED:
+		/* Nothing to do, e.g. the release of a data call */
+		return;
+	case CALL_STATUS_DIALING:
+	case CALL_STATUS_ALERTING:
+		if (g_slist_find_custom(vd->calls,
+					GINT_TO_POINTER(CALL_STATUS_DIALING),
+					at_util_call_compare_by_status) ||
+				g_slist_find_custom(vd->calls,
+					GINT_TO_POINTER(CALL_STATUS_ALERTING),
+					at_util_call_compare_by_status))
+			break;
+
+		direction = CALL_DIRECTION_MOBILE_ORIGINATED;
+		goto create;
+	case CALL_STATUS_INCOMING:
+	case CALL_STATUS_WAITING:
+		if (g_slist_find_custom(vd->calls,
+					GINT_TO_POINTER(CALL_STATUS_INCOMING),
+					at_util_call_compare_by_status) ||
+				g_slist_find_custom(vd->calls,
+					GINT_TO_POINTER(CALL_STATUS_WAITING),
+					at_util_call_compare_by_status))
+			break;
+
+		direction = CALL_DIRECTION_MOBILE_TERMINATED;
+		goto create;
+	}
+
+	/* An active or held call we never heard of */
+	reconcile_calls(vc);
+	return;
+
+create:
+	if (num != NULL && num[0] != '\0')
+		call = create_call(vc, type, direction, status, num,
+					num_type, 0, id);
+	else
+		call = create_call(vc, type, direction, status, NULL, 128, 2,
+					id);
+
+	if (call == NULL) {
+		ofono_error("Unable to malloc. Call management is fubar");
+		return;
+	}
+
+	/* Outgoing calls are always signalled, core knows the number */
+	if (direction == CALL_DIRECTION_MOBILE_ORIGINATED ||
+			call->clip_validity == 0) {
+		if (call->type == 0)
+			ofono_voicecall_notify(vc, call);
+
+		return;
+	}
+
+	/* Give CLIP a chance to arrive before announcing the call */
+	vd->flags = FLAG_NEED_CLIP | FLAG_NEED_CNAP | FLAG_NEED_CDIP;
+
+	if (vd->clcc_source == 0)
+		vd->clcc_source = g_timeout_add(CLIP_INTERVAL, poll_clcc, vc);
+}
+
+static int ecam_to_call_status(int status)
+{
+	switch (status) {
+	case 1:
+		return CALL_STATUS_DIALING;
+	case 2:
+		return CALL_STATUS_ALERTING;
+	case 3:
+		return CALL_STATUS_ACTIVE;
+	case 4:
+		return CALL_STATUS_HELD;
+	case 5:
+		return CALL_STATUS_WAITING;
+	case 6:
+		return CALL_STATUS_INCOMING;
+	}
+
+	/* Idle, busy and released */
+	return CALL_STATUS_DISCONNECTED;
+}
+
+/* #ECAM: <ccid>,<ccstatus>,<calltype>[,<number>,<type>] */
+static void ecam_notify(GAtResult *result, gpointer user_data)
+{
+	struct ofono_voicecall *vc = user_data;
+	GAtResultIter iter;
+	const char *num = NULL;
+	int num_type = 129;
+	int id, status, call_type;
+
+	g_at_result_iter_init(&iter, result);
+
+	if (!g_at_result_iter_next(&iter, "#ECAM:"))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &id))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &status))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &call_type))
+		return;
+
+	if (g_at_result_iter_next_string(&iter, &num))
+		g_at_result_iter_next_number(&iter, &num_type);
+
+	call_progress_update(vc, id, call_type == 1 ? 0 : 1,
+				ecam_to_call_status(status), num, num_type);
+}
+
+/* +CLCC: <id>,<dir>,<stat>,<mode>,<mpty>[,<number>,<type>] */
+static void clcc_notify(GAtResult *result, gpointer user_data)
+{
+	struct ofono_voicecall *vc = user_data;
+	GAtResultIter iter;
+	const char *num = NULL;
+	int num_type = 129;
+	int id, dir, status, mode, mpty;
+
+	g_at_result_iter_init(&iter, result);
+
+	if (!g_at_result_iter_next(&iter, "+CLCC:"))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &id))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &dir))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &status))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &mode))
+		return;
+
+	if (!g_at_result_iter_next_number(&iter, &mpty))
+		return;
+
+	if (g_at_result_iter_next_string(&iter, &num))
+		g_at_result_iter_next_number(&iter, &num_type);
+
+	/* SIMCom reports released calls with status 6 */
+	if (status > CALL_STATUS_WAITING)
+		status = CALL_STATUS_DISCONNECTED;
+
+	call_progress_update(vc, id, mode, status, num, num_type);
+}
+
+static const struct call_progress_urc ecam_urcs[] = {
+	{ "#ECAM:",	ecam_notify		},
+	{ }
+};
+
+static const struct call_progress_urc clcc_urcs[] = {
+	{ "+CLCC:",	clcc_notify		},
+	{ }
+};
+
+static const struct call_progress call_progress_table[] = {
+	{ OFONO_VENDOR_TELIT,	"AT#ECAM=1",	ecam_urcs	},
+	{ OFONO_VENDOR_SIMCOM,	"AT+CLCC=1",	clcc_urcs	},
+	{ }
+};
+
+static const struct call_progress *call_progress_find(unsigned int vendor)
+{
+	const struct call_progress *progress;
+
+	for (progress = call_progress_table; progress->urcs; progress++)
+		if (progress->vendor == vendor)
+			return progress;
+
+	return NULL;
+}
+
+static void call_progress_register(struct ofono_voicecall *vc,
+					const struct call_progress *progress)
+{
+	struct voicecall_data *vd = ofono_voicecall_get_data(vc);
+	const struct call_progress_urc *urc;
+
+	for (urc = progress->urcs; urc->prefix; urc++)
+		g_at_chat_register(vd->chat, urc->prefix, urc->notify,
+					FALSE, vc, NULL);
+
+	vd->progress = progress;
+}
+
+static void call_progress_enable_cb(gboolean ok, GAtResult *result,
+					gpointer user_data)
+{
+	struct ofono_voicecall *vc = user_data;
+	struct voicecall_data *vd = ofono_voicecall_get_data(vc);
+
+	/* Otherwise we keep polling CLCC */
+	if (!ok)
+		return;
+
+	call_progress_register(vc, call_progress_find(vd->vendor));
+}
+
+static void call_progress_enable(struct ofono_voicecall *vc)
+{
+	struct voicecall_data *vd = ofono_voicecall_get_data(vc);
+	const struct call_progress *progress;
+
+	progress = call_progress_find(vd->vendor);
+	if (progress == NULL)
+		return;
+
+	g_at_chat_send(vd->chat, progress->enable, none_prefix,
+			call_progress_enable_cb, vc, NULL);
+}
+
 static void vtd_query_cb(gboolean ok, GAtResult *result, gpointer user_data)
 {
 	struct ofono_voicecall *vc = user_data;
@@ -1092,6 +1411,8 @@ static void at_voicecall_initialized(gboolean ok, GAtResult *result,
 	g_at_chat_register(vd->chat, "+CSSI:", cssi_notify, FALSE, vc, NULL);
 	g_at_chat_register(vd->chat, "+CSSU:", cssu_notify, FALSE, vc, NULL);
 
+	call_progress_enable(vc);
+
 	ofono_voicecall_register(vc);
 
 	/* Populate the call list */
@@ -539,6 +539,10 @@ static void __debug_msg(const char dir, const void *buf, size_t len,
 		const struct qmi_tlv_hdr *tlv = ptr + offset;
 		uint16_t tlv_length = GUINT16_FROM_LE(tlv->length);
 
+		if (tlv_length > GUINT16_FROM_LE(msg->length) - offset -
+							QMI_TLV_HDR_SIZE)
+			break;
+
 		if (tlv->type == 0x02 && tlv_length == QMI_RESULT_CODE_SIZE) {
 			const struct qmi_result_code *result = ptr + offset +
 							QMI_TLV_HDR_SIZE;
@@ -780,26 +784,31 @@ static void handle_packet(struct qmi_device *device,
 	__request_free(req, NULL);
 }
 
-static gboolean received_data(GIOChannel *channel, GIOCondition cond,
-							gpointer user_data)
+static bool message_valid(const struct qmi_mux_hdr *hdr, uint16_t len)
 {
-	struct qmi_device *device = user_data;
-	struct qmi_mux_hdr *hdr;
-	unsigned char buf[2048];
-	ssize_t bytes_read;
-	uint16_t offset;
+	const struct qmi_message_hdr *msg;
+	uint16_t hdr_size;
 
-	if (cond & G_IO_NVAL)
-		return FALSE;
+	if (hdr->service == QMI_SERVICE_CONTROL)
+		hdr_size = QMI_MUX_HDR_SIZE + QMI_CONTROL_HDR_SIZE;
+	else
+		hdr_size = QMI_MUX_HDR_SIZE + QMI_SERVICE_HDR_SIZE;
 
-	bytes_read = read(device->fd, buf, sizeof(buf));
-	if (bytes_read < 0)
-		return TRUE;
+	if (len < hdr_size + QMI_MESSAGE_HDR_SIZE)
+		return false;
 
-	__hexdump('<', buf, bytes_read,
-				device->debug_func, device->debug_data);
+	msg = (const void *) hdr + hdr_size;
 
-	offset = 0;
+	/* The TLVs of the message must not run past the frame */
+	return GUINT16_FROM_LE(msg->length) <=
+				len - hdr_size - QMI_MESSAGE_HDR_SIZE;
+}
+
+static void received_frames(struct qmi_device *device,
+				const unsigned char *buf, ssize_t bytes_read)
+{
+	const struct qmi_mux_hdr *hdr;
+	ssize_t offset = 0;
 
 	while (offset < bytes_read) {
 		uint16_t len;
@@ -808,7 +817,7 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 		if (bytes_read - offset < QMI_MUX_HDR_SIZE)
 			break;
 
-		hdr = (void *) (buf + offset);
+		hdr = (const void *) (buf + offset);
 
 		/* Check for fixed frame and flags value */
 		if (hdr->frame != 0x01 || hdr->flags != 0x80)
@@ -817,9 +826,14 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 		len = GUINT16_FROM_LE(hdr->length) + 1;
 
 		/* Check that packet size matches frame size */
-		if (bytes_read - offset < len)
+		if (len < QMI_MUX_HDR_SIZE || bytes_read - offset < len)
 			break;
 
+		if (!message_valid(hdr, len)) {
+			offset += len;
+			continue;
+		}
+
 		__debug_msg(' ', buf + offset, len,
 				device->debug_func, device->debug_data);
 
@@ -827,6 +841,26 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 
 		offset += len;
 	}
+}
+
+static gboolean received_data(GIOChannel *channel, GIOCondition cond,
+							gpointer user_data)
+{
+	struct qmi_device *device = user_data;
+	unsigned char buf[2048];
+	ssize_t bytes_read;
+
+	if (cond & G_IO_NVAL)
+		return FALSE;
+
+	bytes_read = read(device->fd, buf, sizeof(buf));
+	if (bytes_read < 0)
+		return TRUE;
+
+	__hexdump('<', buf, bytes_read,
+				device->debug_func, device->debug_data);
+
+	received_frames(device, buf, bytes_read);
 
 	return TRUE;
 }
@@ -972,6 +1006,9 @@ static const void *tlv_get(const void *data, uint16_t size,
 		const struct qmi_tlv_hdr *tlv = ptr;
 		uint16_t tlv_length = GUINT16_FROM_LE(tlv->length);
 
+		if (tlv_length > len - QMI_TLV_HDR_SIZE)
+			return NULL;
+
 		if (tlv->type == type) {
 			if (length)
 				*length = tlv_length;
@@ -1023,7 +1060,8 @@ static void discover_callback(uint16_t message, uint16_t length,
 	if (!service_list)
 		goto done;
 
-	if (len < QMI_SERVICE_LIST_SIZE)
+	if (len < QMI_SERVICE_LIST_SIZE + service_list->count *
+					sizeof(service_list->services[0]))
 		goto done;
 
 	list = g_try_malloc(sizeof(struct qmi_version) * service_list->count);
@@ -1063,9 +1101,17 @@ static void discover_callback(uint16_t message, uint16_t length,
 	if (!ptr)
 		goto done;
 
+	if (len < 1 || len < *((uint8_t *) ptr) + 1 + QMI_SERVICE_LIST_SIZE)
+		goto done;
+
 	device->version_str = strndup(ptr + 1, *((uint8_t *) ptr));
 
 	service_list = ptr + *((uint8_t *) ptr) + 1;
+	len -= *((uint8_t *) ptr) + 1;
+
+	if (len < QMI_SERVICE_LIST_SIZE + service_list->count *
+					sizeof(service_list->services[0]))
+		goto done;
 
 	for (i = 0; i < service_list->count; i++) {
 		if (service_list->services[i].type == QMI_SERVICE_CONTROL)
@@ -1429,6 +1475,9 @@ bool qmi_result_get_uint8(struct qmi_result *result, uint8_t type,
 	if (!ptr)
 		return false;
 
+	if (len < 1)
+		return false;
+
 	if (value)
 		*value = *ptr;
 
@@ -1448,6 +1497,9 @@ bool qmi_result_get_uint16(struct qmi_result *result, uint8_t type,
 	if (!ptr)
 		return false;
 
+	if (len < 2)
+		return false;
+
 	memcpy(&tmp, ptr, 2);
 
 	if (value)
@@ -1470,6 +1522,9 @@ bool qmi_result_get_uint32(struct qmi_result *result, uint8_t type,
 	if (!ptr)
 		return false;
 
+	if (len < 4)
+		return false;
+
 	memcpy(&tmp, ptr, 4);
 
 	if (value)
@@ -1492,6 +1547,9 @@ bool qmi_result_get_uint64(struct qmi_result *result, uint8_t type,
 	if (!ptr)
 		return false;
 
+	if (len < 8)
+		return false;
+
 	memcpy(&tmp, ptr, 8);
 
 	if (value)
@@ -1971,6 +2029,8 @@ static GQueue *remove_client(GQueue *queue, uint8_t client)
 			continue;
 		}
 
+		g_list_free_1(list);
+
 		service_send_free(req->user_data);
 
 		__request_free(req, NULL);
@@ -114,6 +114,9 @@ static void clcc_poll_cb(struct ril_msg *message, gpointer user_data)
 	GSList *calls;
 	GSList *n, *o;
 	struct ofono_call *nc, *oc;
+	struct ofono_call *snapshot;
+	unsigned int num_calls = 0;
+	gboolean new_call = FALSE;
 	struct ofono_error error;
 
 	if (message->error != RIL_E_SUCCESS) {
@@ -123,6 +126,7 @@ static void clcc_poll_cb(struct ril_msg *message, gpointer user_data)
 	}
 
 	calls = ril_util_parse_clcc(vd->ril, message);
+	snapshot = g_new(struct ofono_call, g_slist_length(calls));
 
 	n = calls;
 	o = vd->calls;
@@ -153,14 +157,8 @@ static void clcc_poll_cb(struct ril_msg *message, gpointer user_data)
 		} else if (nc && (oc == NULL || (nc->id < oc->id))) {
 			/* new call, signal it */
 			if (nc->type) {
-				ofono_voicecall_notify(vc, nc);
-				if (vd->cb) {
-					ofono_voicecall_cb_t cb = vd->cb;
-					decode_ril_error(&error, "OK");
-					cb(&error, vd->data);
-					vd->cb = NULL;
-					vd->data = NULL;
-				}
+				snapshot[num_calls++] = *nc;
+				new_call = TRUE;
 			}
 
 			n = n->next;
@@ -191,19 +189,30 @@ static void clcc_poll_cb(struct ril_msg *message, gpointer user_data)
 			 * here
 			 */
 			if (nc->status == CALL_STATUS_INCOMING &&
-					(vd->flags & FLAG_NEED_CLIP)) {
-				if (nc->type)
-					ofono_voicecall_notify(vc, nc);
-
+					(vd->flags & FLAG_NEED_CLIP))
 				vd->flags &= ~FLAG_NEED_CLIP;
-			} else if (memcmp(nc, oc, sizeof(*nc)) && nc->type)
-				ofono_voicecall_notify(vc, nc);
+
+			/* The core only signals what actually changed */
+			if (nc->type)
+				snapshot[num_calls++] = *nc;
 
 			n = n->next;
 			o = o->next;
 		}
 	}
 
+	ofono_voicecall_notify_list(vc, snapshot, num_calls);
+	g_free(snapshot);
+
+	if (new_call && vd->cb) {
+		ofono_voicecall_cb_t cb = vd->cb;
+
+		decode_ril_error(&error, "OK");
+		cb(&error, vd->data);
+		vd->cb = NULL;
+		vd->data = NULL;
+	}
+
 	g_slist_foreach(vd->calls, (GFunc) g_free, NULL);
 	g_slist_free(vd->calls);
 
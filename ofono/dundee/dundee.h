@@ -75,7 +75,8 @@ static inline struct cb_data *cb_data_new(void *cb, void *data)
 #include <ofono/log.h>
 
 int __ofono_log_init(const char *program, const char *debug,
-					ofono_bool_t detach);
+			ofono_bool_t detach, unsigned int ring_size,
+			unsigned int rate);
 void __ofono_log_cleanup(void);
 void __ofono_log_enable(struct ofono_debug_desc *start,
 					struct ofono_debug_desc *stop);
@@ -197,7 +197,7 @@ int main(int argc, char **argv)
 
 	signal = setup_signalfd();
 
-	__ofono_log_init(argv[0], option_debug, option_detach);
+	__ofono_log_init(argv[0], option_debug, option_detach, 0, 0);
 
 	dbus_error_init(&error);
 
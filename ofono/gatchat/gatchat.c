@@ -687,7 +687,6 @@ error:
 
 static char *extract_line(struct at_chat *p, struct ring_buffer *rbuf)
 {
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned int pos = 0;
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, pos);
 	gboolean in_string = FALSE;
@@ -710,9 +709,6 @@ static char *extract_line(struct at_chat *p, struct ring_buffer *rbuf)
 
 		buf += 1;
 		pos += 1;
-
-		if (pos == wrap)
-			buf = ring_buffer_read_ptr(rbuf, pos);
 	}
 
 	line = g_try_new(char, line_length + 1);
@@ -734,7 +730,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 {
 	struct at_chat *p = user_data;
 	unsigned int len = ring_buffer_len(rbuf);
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
 
 	GAtSyntaxResult result;
@@ -742,17 +737,12 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 	p->in_read_handler = TRUE;
 
 	while (p->suspended == FALSE && (p->read_so_far < len)) {
-		gsize rbytes = MIN(len - p->read_so_far, wrap - p->read_so_far);
+		gsize rbytes = len - p->read_so_far;
 		result = p->syntax->feed(p->syntax, (char *)buf, &rbytes);
 
 		buf += rbytes;
 		p->read_so_far += rbytes;
 
-		if (p->read_so_far == wrap) {
-			buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
-			wrap = len;
-		}
-
 		if (result == G_AT_SYNTAX_RESULT_UNSURE)
 			continue;
 
@@ -777,7 +767,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 		}
 
 		len -= p->read_so_far;
-		wrap -= p->read_so_far;
 		p->read_so_far = 0;
 	}
 
@@ -202,7 +202,6 @@ static gboolean hdlc_suspend(gpointer user_data)
 static gboolean check_escape(GAtHDLC *hdlc, struct ring_buffer *rbuf)
 {
 	unsigned int len = ring_buffer_len(rbuf);
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, 0);
 	unsigned int pos = 0;
 	unsigned int elapsed = g_timer_elapsed(hdlc->timer, NULL) * 1000;
@@ -219,9 +218,6 @@ static gboolean check_escape(GAtHDLC *hdlc, struct ring_buffer *rbuf)
 		num_plus++;
 		buf++;
 		pos++;
-
-		if (pos == wrap)
-			buf = ring_buffer_read_ptr(rbuf, pos);
 	}
 
 	if (num_plus != len)
@@ -246,7 +242,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 {
 	GAtHDLC *hdlc = user_data;
 	unsigned int len = ring_buffer_len(rbuf);
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, 0);
 	unsigned int pos = 0;
 
@@ -267,7 +262,7 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 			return;
 	}
 
-	hdlc_record(hdlc, TRUE, buf, wrap);
+	hdlc_record(hdlc, TRUE, buf, len);
 
 	hdlc->in_read_handler = TRUE;
 
@@ -312,11 +307,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 
 		buf++;
 		pos++;
-
-		if (pos == wrap) {
-			buf = ring_buffer_read_ptr(rbuf, pos);
-			hdlc_record(hdlc, TRUE, buf, len - wrap);
-		}
 	}
 
 out:
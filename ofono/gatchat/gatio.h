@@ -45,6 +45,12 @@ GIOChannel *g_at_io_get_channel(GAtIO *io);
 GAtIO *g_at_io_ref(GAtIO *io);
 void g_at_io_unref(GAtIO *io);
 
+/*!
+ * Sets the function that is passed the read buffer whenever data arrived.
+ * The handler drains what it consumed.  While no handler is set reading
+ * pauses once the buffer is full, a handler that leaves the buffer full at
+ * its largest size closes the channel
+ */
 gboolean g_at_io_set_read_handler(GAtIO *io, GAtIOReadFunc read_handler,
 					gpointer user_data);
 gboolean g_at_io_set_write_handler(GAtIO *io, GAtIOWriteFunc write_handler,
@@ -256,6 +256,19 @@ out:
 	return TRUE;
 }
 
+/* Accumulate one decimal digit, failing instead of overflowing */
+static inline gboolean add_digit(int *value, char c)
+{
+	int digit = c - '0';
+
+	if (*value > (G_MAXINT - digit) / 10)
+		return FALSE;
+
+	*value = *value * 10 + digit;
+
+	return TRUE;
+}
+
 gboolean g_at_result_iter_next_number(GAtResultIter *iter, gint *number)
 {
 	int pos;
@@ -277,7 +290,9 @@ gboolean g_at_result_iter_next_number(GAtResultIter *iter, gint *number)
 	end = pos;
 
 	while (line[end] >= '0' && line[end] <= '9') {
-		value = value * 10 + (int)(line[end] - '0');
+		if (add_digit(&value, line[end]) == FALSE)
+			return FALSE;
+
 		end += 1;
 	}
 
@@ -348,7 +363,9 @@ gboolean g_at_result_iter_next_range(GAtResultIter *iter, gint *min, gint *max)
 	end = pos;
 
 	while (line[end] >= '0' && line[end] <= '9') {
-		low = low * 10 + (int)(line[end] - '0');
+		if (add_digit(&low, line[end]) == FALSE)
+			return FALSE;
+
 		end += 1;
 	}
 
@@ -363,7 +380,9 @@ gboolean g_at_result_iter_next_range(GAtResultIter *iter, gint *min, gint *max)
 	pos = end = end + 1;
 
 	while (line[end] >= '0' && line[end] <= '9') {
-		high = high * 10 + (int)(line[end] - '0');
+		if (add_digit(&high, line[end]) == FALSE)
+			return FALSE;
+
 		end += 1;
 	}
 
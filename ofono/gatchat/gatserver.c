@@ -128,6 +128,8 @@ struct _GAtServer {
 	gboolean in_read_handler;
 	GAtServerFinishFunc finishf;		/* Callback when cmd finishes */
 	gpointer finish_data;			/* Finish func data */
+	GAtServerPduFunc pdu_func;		/* Reads text after prompt */
+	gpointer pdu_data;			/* PDU func data */
 };
 
 static void server_wakeup_writer(GAtServer *server);
@@ -258,6 +260,21 @@ void g_at_server_send_unsolicited(GAtServer *server, const char *result)
 	send_result_common(server, result);
 }
 
+void g_at_server_expect_pdu(GAtServer *server, GAtServerPduFunc func,
+							gpointer user_data)
+{
+	char buf[5];
+
+	if (server == NULL || func == NULL)
+		return;
+
+	server->pdu_func = func;
+	server->pdu_data = user_data;
+
+	sprintf(buf, "%c%c> ", server->v250.s3, server->v250.s4);
+	send_common(server, buf, 4);
+}
+
 void g_at_server_send_info(GAtServer *server, const char *line, gboolean last)
 {
 	char buf[MAX_TEXT_SIZE + 1];
@@ -937,7 +954,6 @@ out:
 
 static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 {
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned int pos = 0;
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, pos);
 	int strip_front = 0;
@@ -960,9 +976,6 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 
 		buf += 1;
 		pos += 1;
-
-		if (pos == wrap)
-			buf = ring_buffer_read_ptr(rbuf, pos);
 	}
 
 	/* We will strip AT and S3 */
@@ -979,7 +992,6 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 
 	pos = 0;
 	i = 0;
-	wrap = ring_buffer_len_no_wrap(rbuf);
 	buf = ring_buffer_read_ptr(rbuf, pos);
 
 	while (pos < (p->read_so_far - strip_front - 2)) {
@@ -996,9 +1008,6 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 
 		buf += 1;
 		pos += 1;
-
-		if (pos == wrap)
-			buf = ring_buffer_read_ptr(rbuf, pos);
 	}
 
 	/* Strip S3 */
@@ -1009,14 +1018,50 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 	return line;
 }
 
+static void read_pdu(GAtServer *p, struct ring_buffer *rbuf)
+{
+	unsigned int len = ring_buffer_len(rbuf);
+	unsigned char *buf = ring_buffer_read_ptr(rbuf, 0);
+	GAtServerPduFunc func = p->pdu_func;
+	char *pdu = NULL;
+	unsigned int i;
+
+	/* Ctrl-Z ends the text, ESC cancels it */
+	for (i = 0; i < len; i++)
+		if (buf[i] == 0x1a || buf[i] == 0x1b)
+			break;
+
+	if (i == len)
+		return;
+
+	if (buf[i] == 0x1a)
+		pdu = g_strndup((char *) buf, i);
+
+	ring_buffer_drain(rbuf, i + 1);
+	p->pdu_func = NULL;
+
+	p->in_read_handler = TRUE;
+	func(p, pdu, p->pdu_data);
+	p->in_read_handler = FALSE;
+
+	g_free(pdu);
+
+	if (p->destroyed)
+		g_free(p);
+}
+
 static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 {
 	GAtServer *p = user_data;
 	unsigned int len = ring_buffer_len(rbuf);
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned char *buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
 	enum ParserResult result;
 
+	if (p->pdu_func) {
+		read_pdu(p, rbuf);
+		return;
+	}
+
 	/* We do not support command abortion, so ignore input */
 	if (p->final_async) {
 		ring_buffer_drain(rbuf, len);
@@ -1026,7 +1071,7 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 	p->in_read_handler = TRUE;
 
 	while (p->io && (p->read_so_far < len)) {
-		gsize rbytes = MIN(len - p->read_so_far, wrap - p->read_so_far);
+		gsize rbytes = len - p->read_so_far;
 		result = server_feed(p, (char *)buf, &rbytes);
 
 		if (p->v250.echo)
@@ -1035,11 +1080,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 		buf += rbytes;
 		p->read_so_far += rbytes;
 
-		if (p->read_so_far == wrap) {
-			buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
-			wrap = len;
-		}
-
 		switch (result) {
 		case PARSER_RESULT_UNSURE:
 			continue;
@@ -1085,7 +1125,6 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 		}
 
 		len -= p->read_so_far;
-		wrap -= p->read_so_far;
 		p->read_so_far = 0;
 
 		/*
@@ -71,6 +71,9 @@ typedef void (*GAtServerNotifyFunc)(GAtServer *server,
 
 typedef void (*GAtServerFinishFunc)(GAtServer *server, gpointer user_data);
 
+typedef void (*GAtServerPduFunc)(GAtServer *server, const char *pdu,
+					gpointer user_data);
+
 GAtServer *g_at_server_new(GIOChannel *io);
 GIOChannel *g_at_server_get_channel(GAtServer *server);
 GAtIO *g_at_server_get_io(GAtServer *server);
@@ -117,6 +120,14 @@ void g_at_server_send_unsolicited(GAtServer *server, const char *result);
  */
 void g_at_server_send_info(GAtServer *server, const char *line, gboolean last);
 
+/*
+ * Send the "> " prompt and pass the text entered up to Ctrl-Z to func, e.g.
+ * the PDU of +CMGS.  If the DTE cancels with ESC, func gets NULL.  Call it
+ * from a command handler before the final result is sent.
+ */
+void g_at_server_expect_pdu(GAtServer *server, GAtServerPduFunc func,
+							gpointer user_data);
+
 gboolean g_at_server_set_finish_callback(GAtServer *server,
 						GAtServerFinishFunc finishf,
 						gpointer user_data);
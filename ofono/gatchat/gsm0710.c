@@ -143,6 +143,10 @@ int gsm0710_advanced_extract_frame(guint8 *buf, int len,
 			}
 		}
 
+		/* Address, control and FCS must survive the unquoting */
+		if (posn2 < 3)
+			continue;
+
 		/* Validate the checksum on the packet header */
 		if (!gsm0710_check_fcs(buf, 2, buf[posn2 - 1]))
 			continue;
@@ -23,7 +23,15 @@
 #include <config.h>
 #endif
 
+#define _GNU_SOURCE
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include <glib.h>
 
@@ -31,33 +39,181 @@
 
 #define MAX_SIZE 262144
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+
+static int memfd_create(const char *name, unsigned int flags)
+{
+#ifdef __NR_memfd_create
+	return syscall(__NR_memfd_create, name, flags);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+#endif
+
+enum mirror_type {
+	MIRROR_NONE,
+	MIRROR_MAPPED,
+	MIRROR_COPIED,
+};
+
+/*
+ * A mirrored buffer is followed by a second copy of itself, so that the
+ * data between the read and the write counters is always contiguous in
+ * memory no matter where it wraps.  The copy is either a second mapping
+ * of the same pages or, where shared memory is not available, kept up to
+ * date by hand on every write.
+ */
 struct ring_buffer {
 	unsigned char *buffer;
 	unsigned int size;
 	unsigned int mask;
 	unsigned int in;
 	unsigned int out;
+	enum mirror_type mirror;
 };
 
-struct ring_buffer *ring_buffer_new(unsigned int size)
+static int create_shared_fd(unsigned int size)
 {
-	unsigned int real_size = 1;
-	struct ring_buffer *buffer;
+	char path[] = "/dev/shm/ringbuffer-XXXXXX";
+	int fd;
+
+	fd = memfd_create("ringbuffer", MFD_CLOEXEC);
+	if (fd < 0) {
+		/* Older kernels, fall back to an unlinked shm file */
+		fd = mkostemp(path, O_CLOEXEC);
+		if (fd < 0)
+			return -1;
+
+		unlink(path);
+	}
+
+	if (ftruncate(fd, size) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static unsigned char *mirror_map(unsigned int size)
+{
+	unsigned char *addr;
+	void *lower;
+	void *upper;
+	int fd;
+
+	fd = create_shared_fd(size);
+	if (fd < 0)
+		return NULL;
+
+	/* Reserve the address space for both copies first */
+	addr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0);
+	if (addr == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+
+	lower = mmap(addr, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED, fd, 0);
+	upper = mmap(addr + size, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED, fd, 0);
+
+	/* The mappings keep the memory alive */
+	close(fd);
+
+	if (lower == MAP_FAILED || upper == MAP_FAILED) {
+		munmap(addr, 2 * size);
+		return NULL;
+	}
+
+	return addr;
+}
+
+static unsigned char *alloc_memory(unsigned int size, enum mirror_type *mirror)
+{
+	unsigned char *addr;
+
+	if (*mirror == MIRROR_NONE)
+		return g_slice_alloc(size);
+
+	addr = mirror_map(size);
+	if (addr != NULL) {
+		*mirror = MIRROR_MAPPED;
+		return addr;
+	}
+
+	addr = g_try_malloc(2 * size);
+	if (addr != NULL)
+		*mirror = MIRROR_COPIED;
+
+	return addr;
+}
+
+static void free_memory(unsigned char *addr, unsigned int size,
+				enum mirror_type mirror)
+{
+	switch (mirror) {
+	case MIRROR_NONE:
+		g_slice_free1(size, addr);
+		break;
+	case MIRROR_MAPPED:
+		munmap(addr, 2 * size);
+		break;
+	case MIRROR_COPIED:
+		g_free(addr);
+		break;
+	}
+}
+
+/* Brings the other copy of len bytes written at offset up to date */
+static void update_mirror(struct ring_buffer *buf, unsigned int offset,
+				unsigned int len)
+{
+	unsigned int end = offset + len;
+
+	if (buf->mirror != MIRROR_COPIED)
+		return;
+
+	memcpy(buf->buffer + buf->size + offset, buf->buffer + offset,
+			MIN(end, buf->size) - offset);
+
+	if (end > buf->size)
+		memcpy(buf->buffer, buf->buffer + buf->size, end - buf->size);
+}
+
+static unsigned int real_size_for(unsigned int size, unsigned int min_size)
+{
+	unsigned int real_size = min_size;
+
+	if (size > MAX_SIZE)
+		return 0;
 
 	/* Find the next power of two for size */
-	while (real_size < size && real_size < MAX_SIZE)
+	while (real_size < size)
 		real_size = real_size << 1;
 
-	if (real_size > MAX_SIZE)
+	return real_size;
+}
+
+static struct ring_buffer *buffer_new(unsigned int real_size,
+					enum mirror_type mirror)
+{
+	struct ring_buffer *buffer;
+
+	if (real_size == 0)
 		return NULL;
 
 	buffer = g_slice_new(struct ring_buffer);
 	if (buffer == NULL)
 		return NULL;
 
-	buffer->buffer = g_slice_alloc(real_size);
+	buffer->buffer = alloc_memory(real_size, &mirror);
 	if (buffer->buffer == NULL) {
-		g_free(buffer);
+		g_slice_free1(sizeof(struct ring_buffer), buffer);
 		return NULL;
 	}
 
@@ -65,10 +221,54 @@ struct ring_buffer *ring_buffer_new(unsigned int size)
 	buffer->mask = real_size - 1;
 	buffer->in = 0;
 	buffer->out = 0;
+	buffer->mirror = mirror;
 
 	return buffer;
 }
 
+struct ring_buffer *ring_buffer_new(unsigned int size)
+{
+	return buffer_new(real_size_for(size, 1), MIRROR_NONE);
+}
+
+struct ring_buffer *ring_buffer_new_mirrored(unsigned int size)
+{
+	/* Mappings come in pages */
+	return buffer_new(real_size_for(size, sysconf(_SC_PAGESIZE)),
+				MIRROR_MAPPED);
+}
+
+int ring_buffer_grow(struct ring_buffer *buf, unsigned int size)
+{
+	unsigned int real_size;
+	enum mirror_type mirror = buf->mirror;
+	unsigned int len = buf->in - buf->out;
+	unsigned char *buffer;
+
+	real_size = real_size_for(size, buf->size);
+	if (real_size <= buf->size)
+		return -1;
+
+	buffer = alloc_memory(real_size, &mirror);
+	if (buffer == NULL)
+		return -1;
+
+	/* The old and the new buffer might mirror in different ways */
+	ring_buffer_read(buf, buffer, len);
+	free_memory(buf->buffer, buf->size, buf->mirror);
+
+	buf->buffer = buffer;
+	buf->size = real_size;
+	buf->mask = real_size - 1;
+	buf->in = len;
+	buf->out = 0;
+	buf->mirror = mirror;
+
+	update_mirror(buf, 0, len);
+
+	return real_size;
+}
+
 int ring_buffer_write(struct ring_buffer *buf, const void *data,
 			unsigned int len)
 {
@@ -87,6 +287,11 @@ int ring_buffer_write(struct ring_buffer *buf, const void *data,
 	/* Now put the remainder on the beginning of the buffer */
 	memcpy(buf->buffer, d + end, len - end);
 
+	update_mirror(buf, offset, end);
+
+	if (len > end)
+		update_mirror(buf, 0, len - end);
+
 	buf->in += len;
 
 	return len;
@@ -103,12 +308,18 @@ int ring_buffer_avail_no_wrap(struct ring_buffer *buf)
 	unsigned int offset = buf->in & buf->mask;
 	unsigned int len = buf->size - buf->in + buf->out;
 
+	if (buf->mirror != MIRROR_NONE)
+		return len;
+
 	return MIN(len, buf->size - offset);
 }
 
 int ring_buffer_write_advance(struct ring_buffer *buf, unsigned int len)
 {
 	len = MIN(len, buf->size - buf->in + buf->out);
+
+	update_mirror(buf, buf->in & buf->mask, len);
+
 	buf->in += len;
 
 	return len;
@@ -155,6 +366,9 @@ int ring_buffer_len_no_wrap(struct ring_buffer *buf)
 	unsigned int offset = buf->out & buf->mask;
 	unsigned int len = buf->in - buf->out;
 
+	if (buf->mirror != MIRROR_NONE)
+		return len;
+
 	return MIN(len, buf->size - offset);
 }
 
@@ -202,6 +416,6 @@ void ring_buffer_free(struct ring_buffer *buf)
 	if (buf == NULL)
 		return;
 
-	g_slice_free1(buf->size, buf->buffer);
+	free_memory(buf->buffer, buf->size, buf->mirror);
 	g_slice_free1(sizeof(struct ring_buffer), buf);
 }
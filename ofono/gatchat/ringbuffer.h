@@ -22,10 +22,27 @@
 struct ring_buffer;
 
 /*!
- * Creates a new ring buffer with capacity size
+ * Creates a new ring buffer with capacity size.  The capacity is rounded up
+ * to a power of two.  Returns NULL if size is larger than 256 KiB
  */
 struct ring_buffer *ring_buffer_new(unsigned int size);
 
+/*!
+ * Creates a new ring buffer like ring_buffer_new, with a capacity of at
+ * least a page.  The buffer is mirrored right behind itself, so data
+ * written to or read from it never wraps.  Meant for long lived buffers,
+ * each one costs a shared memory mapping where available
+ */
+struct ring_buffer *ring_buffer_new_mirrored(unsigned int size);
+
+/*!
+ * Grows the capacity of the ring buffer to at least size, keeping all data
+ * inside the buffer.  Pointers into the buffer are no longer valid after
+ * this call.  Returns -1 if the buffer could not grow, including when size
+ * is larger than 256 KiB, or the new capacity
+ */
+int ring_buffer_grow(struct ring_buffer *buf, unsigned int size);
+
 /*!
  * Frees the resources allocated for the ring buffer
  */
@@ -69,7 +86,8 @@ unsigned char *ring_buffer_write_ptr(struct ring_buffer *buf,
 int ring_buffer_avail(struct ring_buffer *buf);
 
 /*!
- * Returns the number of free bytes available in the buffer without wrapping
+ * Returns the number of free bytes available in the buffer without wrapping,
+ * for a mirrored buffer this is the same as ring_buffer_avail
  */
 int ring_buffer_avail_no_wrap(struct ring_buffer *buf);
 
@@ -96,7 +114,7 @@ int ring_buffer_len(struct ring_buffer *buf);
 
 /*!
  * Returns the number of bytes currently available to be read in the buffer
- * without wrapping.
+ * without wrapping, for a mirrored buffer this is the same as ring_buffer_len
  */
 int ring_buffer_len_no_wrap(struct ring_buffer *buf);
 
@@ -0,0 +1,139 @@
+/*
+ *
+ *  AT chat library with GLib integration
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "spscqueue.h"
+
+#define MAX_SIZE 65536
+#define CACHELINE_SIZE 64
+
+/*
+ * The producer only ever writes tail and the consumer only ever writes
+ * head.  Both counters run freely and are masked on access, so the queue
+ * is full when they are size apart.  The atomic accesses order the item
+ * stores against the counter that publishes them.
+ */
+struct spsc_queue {
+	void **items;
+	unsigned int size;
+	unsigned int mask;
+	/* Keep the two counters on different cache lines */
+	char pad1[CACHELINE_SIZE];
+	gint tail;
+	char pad2[CACHELINE_SIZE];
+	gint head;
+};
+
+struct spsc_queue *spsc_queue_new(unsigned int size)
+{
+	unsigned int real_size = 1;
+	struct spsc_queue *queue;
+
+	if (size == 0 || size > MAX_SIZE)
+		return NULL;
+
+	while (real_size < size)
+		real_size = real_size << 1;
+
+	queue = g_try_new0(struct spsc_queue, 1);
+	if (queue == NULL)
+		return NULL;
+
+	queue->items = g_try_new0(void *, real_size);
+	if (queue->items == NULL) {
+		g_free(queue);
+		return NULL;
+	}
+
+	queue->size = real_size;
+	queue->mask = real_size - 1;
+
+	return queue;
+}
+
+void spsc_queue_free(struct spsc_queue *queue)
+{
+	if (queue == NULL)
+		return;
+
+	g_free(queue->items);
+	g_free(queue);
+}
+
+unsigned int spsc_queue_capacity(struct spsc_queue *queue)
+{
+	return queue->size;
+}
+
+gboolean spsc_queue_push(struct spsc_queue *queue, void *item)
+{
+	unsigned int tail = queue->tail;
+	unsigned int head = g_atomic_int_get(&queue->head);
+
+	if (item == NULL)
+		return FALSE;
+
+	if (tail - head == queue->size)
+		return FALSE;
+
+	queue->items[tail & queue->mask] = item;
+	g_atomic_int_set(&queue->tail, tail + 1);
+
+	return TRUE;
+}
+
+void *spsc_queue_peek(struct spsc_queue *queue)
+{
+	unsigned int head = queue->head;
+	unsigned int tail = g_atomic_int_get(&queue->tail);
+
+	if (head == tail)
+		return NULL;
+
+	return queue->items[head & queue->mask];
+}
+
+void *spsc_queue_pop(struct spsc_queue *queue)
+{
+	unsigned int head = queue->head;
+	void *item;
+
+	item = spsc_queue_peek(queue);
+	if (item == NULL)
+		return NULL;
+
+	g_atomic_int_set(&queue->head, head + 1);
+
+	return item;
+}
+
+unsigned int spsc_queue_len(struct spsc_queue *queue)
+{
+	unsigned int head = g_atomic_int_get(&queue->head);
+	unsigned int tail = g_atomic_int_get(&queue->tail);
+
+	return tail - head;
+}
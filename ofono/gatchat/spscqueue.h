@@ -0,0 +1,63 @@
+/*
+ *
+ *  AT chat library with GLib integration
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+struct spsc_queue;
+
+/*!
+ * Creates a new bounded queue holding up to size pointers.  The size is
+ * rounded up to a power of two.  Exactly one thread may push to the queue
+ * and exactly one thread may pop from it, neither of them ever blocks
+ */
+struct spsc_queue *spsc_queue_new(unsigned int size);
+
+/*!
+ * Frees the queue.  Items still inside the queue are not freed
+ */
+void spsc_queue_free(struct spsc_queue *queue);
+
+/*!
+ * Returns the maximum number of items the queue can hold
+ */
+unsigned int spsc_queue_capacity(struct spsc_queue *queue);
+
+/*!
+ * Appends item to the queue, item must not be NULL.  Returns FALSE if the
+ * queue is full.  Only to be called from the producer thread
+ */
+gboolean spsc_queue_push(struct spsc_queue *queue, void *item);
+
+/*!
+ * Returns the item at the head of the queue without removing it, or NULL
+ * if the queue is empty.  Only to be called from the consumer thread
+ */
+void *spsc_queue_peek(struct spsc_queue *queue);
+
+/*!
+ * Removes and returns the item at the head of the queue, or NULL if the
+ * queue is empty.  Only to be called from the consumer thread
+ */
+void *spsc_queue_pop(struct spsc_queue *queue);
+
+/*!
+ * Returns the number of items in the queue.  The value is only a snapshot
+ * when the other side is active at the same time
+ */
+unsigned int spsc_queue_len(struct spsc_queue *queue);
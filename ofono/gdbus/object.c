@@ -85,8 +85,11 @@ struct property_data {
 };
 
 static struct generic_data *root;
+static GDBusFlushFunction flush_function;
 
 static gboolean process_changes(gpointer user_data);
+static dbus_bool_t send_message(DBusConnection *connection,
+						DBusMessage *message);
 static void process_properties_from_interface(struct generic_data *data,
 						struct interface_data *iface);
 static void process_property_changes(struct generic_data *data);
@@ -277,7 +280,7 @@ static DBusHandlerResult process_message(DBusConnection *connection,
 	if (reply == NULL)
 		return DBUS_HANDLER_RESULT_NEED_MEMORY;
 
-	dbus_connection_send(connection, reply, NULL);
+	send_message(connection, reply);
 	dbus_message_unref(reply);
 
 	return DBUS_HANDLER_RESULT_HANDLED;
@@ -328,7 +331,7 @@ void g_dbus_pending_error_valist(DBusConnection *connection,
 		reply = g_dbus_create_error_valist(secdata->message,
 							name, format, args);
 		if (reply != NULL) {
-			dbus_connection_send(connection, reply, NULL);
+			send_message(connection, reply);
 			dbus_message_unref(reply);
 		}
 
@@ -484,7 +487,7 @@ void g_dbus_pending_property_error_valist(GDBusPendingReply id,
 	reply = g_dbus_create_error_valist(propdata->message, name, format,
 									args);
 	if (reply != NULL) {
-		dbus_connection_send(propdata->conn, reply, NULL);
+		send_message(propdata->conn, reply);
 		dbus_message_unref(reply);
 	}
 
@@ -1291,7 +1294,7 @@ static dbus_bool_t emit_signal_valist(DBusConnection *conn,
 		goto fail;
 	}
 
-	ret = dbus_connection_send(conn, signal, NULL);
+	ret = send_message(conn, signal);
 
 fail:
 	dbus_message_unref(signal);
@@ -1432,6 +1435,24 @@ DBusMessage *g_dbus_create_reply(DBusMessage *message, int type, ...)
 	return reply;
 }
 
+/*
+ * Messages queued by the flush function, e.g. coalesced property changes,
+ * have to go out before anything sent after them.
+ */
+static dbus_bool_t send_message(DBusConnection *connection,
+						DBusMessage *message)
+{
+	if (flush_function != NULL)
+		flush_function(connection);
+
+	return dbus_connection_send(connection, message, NULL);
+}
+
+void g_dbus_set_flush_function(GDBusFlushFunction function)
+{
+	flush_function = function;
+}
+
 gboolean g_dbus_send_message(DBusConnection *connection, DBusMessage *message)
 {
 	dbus_bool_t result;
@@ -1439,13 +1460,24 @@ gboolean g_dbus_send_message(DBusConnection *connection, DBusMessage *message)
 	if (dbus_message_get_type(message) == DBUS_MESSAGE_TYPE_METHOD_CALL)
 		dbus_message_set_no_reply(message, TRUE);
 
-	result = dbus_connection_send(connection, message, NULL);
+	result = send_message(connection, message);
 
 	dbus_message_unref(message);
 
 	return result;
 }
 
+gboolean g_dbus_send_message_with_reply(DBusConnection *connection,
+					DBusMessage *message,
+					DBusPendingCall **call, int timeout)
+{
+	if (flush_function != NULL)
+		flush_function(connection);
+
+	return dbus_connection_send_with_reply(connection, message, call,
+								timeout);
+}
+
 gboolean g_dbus_send_error_valist(DBusConnection *connection,
 					DBusMessage *message, const char *name,
 					const char *format, va_list args)
@@ -31,6 +31,8 @@
 
 #include <glib.h>
 
+#include "gdbus.h"
+
 int polkit_check_authorization(DBusConnection *conn,
 				const char *action, gboolean interaction,
 				void (*function) (dbus_bool_t authorized,
@@ -177,7 +179,7 @@ int polkit_check_authorization(DBusConnection *conn,
 	dbus_message_iter_init_append(msg, &iter);
 	add_arguments(conn, &iter, action, flags);
 
-	if (dbus_connection_send_with_reply(conn, msg,
+	if (g_dbus_send_message_with_reply(conn, msg,
 						&call, timeout) == FALSE) {
 		dbus_message_unref(msg);
 		dbus_free(data);
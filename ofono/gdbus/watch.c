@@ -668,7 +668,7 @@ static void check_service(DBusConnection *connection,
 	dbus_message_append_args(message, DBUS_TYPE_STRING, &name,
 							DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(connection, message,
+	if (g_dbus_send_message_with_reply(connection, message,
 							&data->call, -1) == FALSE) {
 		error("Failed to execute method call");
 		g_free(data);
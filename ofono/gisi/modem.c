@@ -43,9 +43,19 @@
 	if ((m) != NULL && (m)->debug != NULL)		\
 		m->debug("gisi: "fmt, ##__VA_ARGS__);
 
+/*
+ * Up to this many messages are received per system call, as long as the
+ * receive buffers for the batch fit in RECV_BATCH_BYTES.
+ */
+#define RECV_BATCH_MAX 16
+#define RECV_BATCH_BYTES 65536
+#define RECV_DEFAULT_MTU 65541
+
 struct _GIsiServiceMux {
 	GIsiModem *modem;
-	GSList *pending;
+	GSList *pings;
+	GIsiPending *resp[256];		/* Indexed by UTID */
+	GSList *subscribers[256];	/* Indexed by message ID */
 	GIsiVersion version;
 	uint8_t resource;
 	uint8_t last_utid;
@@ -70,6 +80,11 @@ struct _GIsiModem {
 	GIsiNotifyFunc trace;
 	void *opaque;
 	unsigned long flags;
+	uint8_t *recv_buf;
+	size_t recv_size;
+	unsigned recv_batch;
+	gboolean dispatching;
+	gboolean destroyed;
 };
 
 struct _GIsiPending {
@@ -151,11 +166,42 @@ static void pending_dispatch(GIsiPending *pend, GIsiMessage *msg)
 	pend->notify(msg, pend->data);
 }
 
+static void pending_unlink(GIsiPending *op)
+{
+	GIsiServiceMux *mux = op->service;
+
+	switch (op->type) {
+	case GISI_MESSAGE_TYPE_REQ:
+	case GISI_MESSAGE_TYPE_IND:
+	case GISI_MESSAGE_TYPE_NTF:
+		mux->subscribers[op->msgid] =
+			g_slist_remove(mux->subscribers[op->msgid], op);
+		break;
+
+	case GISI_MESSAGE_TYPE_RESP:
+		if (mux->resp[op->utid] == op)
+			mux->resp[op->utid] = NULL;
+		break;
+
+	case GISI_MESSAGE_TYPE_COMMON:
+		mux->pings = g_slist_remove(mux->pings, op);
+		break;
+	}
+}
+
+static gboolean utid_in_use(GIsiServiceMux *mux, GIsiPending *op)
+{
+	if (mux->resp[op->utid] != NULL)
+		return TRUE;
+
+	return g_slist_find_custom(mux->pings, op, utid_equal) != NULL;
+}
+
 static void pending_remove_and_dispatch(GIsiPending *op, GIsiMessage *msg)
 {
 	GIsiModem *modem;
 
-	op->service->pending = g_slist_remove(op->service->pending, op);
+	pending_unlink(op);
 
 	if (op->notify == NULL || msg == NULL)
 		goto destroy;
@@ -183,48 +229,53 @@ destroy:
 static void service_dispatch(GIsiServiceMux *mux, GIsiMessage *msg,
 				gboolean is_indication)
 {
+	GIsiModem *modem = mux->modem;
 	uint8_t msgid = g_isi_msg_id(msg);
 	uint8_t utid = g_isi_msg_utid(msg);
+	GIsiPending *resp;
+	GSList *l;
 
-	GSList *l = mux->pending;
+	/*
+	 * Version query responses are dispatched to all pending pings,
+	 * based on the message ID only.  Some of these may be synthesized,
+	 * but nevertheless need to be removed.
+	 */
+	if (msgid == COMMON_MESSAGE) {
+		GSList *pings = g_slist_copy(mux->pings);
 
-	while (l != NULL) {
-		GSList *next = l->next;
-		GIsiPending *pend = l->data;
-
-		/*
-		 * REQs, NTFs and INDs are dispatched on message ID.  While
-		 * INDs have the unique transaction ID set to zero, NTFs
-		 * typically mirror the UTID of the request that set up the
-		 * session, and REQs can naturally have any transaction ID.
-		 *
-		 * RESPs are dispatched on unique transaction ID, explicitly
-		 * ignoring the msgid.  A RESP also completes a transaction,
-		 * so it needs to be removed after being notified of.
-		 *
-		 * Version query responses are dispatched in a similar fashion
-		 * as RESPs, but based on the pending type and the message ID.
-		 * Some of these may be synthesized, but nevertheless need to
-		 * be removed.
-		 */
-		if (pend->type < GISI_MESSAGE_TYPE_RESP
-				&& pend->msgid == msgid) {
+		for (l = pings; l != NULL && !modem->destroyed; l = l->next)
+			if (g_slist_find(mux->pings, l->data))
+				pending_remove_and_dispatch(l->data, msg);
 
-			pending_dispatch(pend, msg);
+		g_slist_free(pings);
+	}
 
-		} else if (pend->type == GISI_MESSAGE_TYPE_RESP &&
-				!is_indication && pend->utid == utid) {
+	if (modem->destroyed)
+		return;
 
-			pending_remove_and_dispatch(pend, msg);
-			break;
+	/*
+	 * RESPs are dispatched on unique transaction ID, explicitly
+	 * ignoring the msgid.  A RESP also completes a transaction,
+	 * so it needs to be removed after being notified of.
+	 */
+	resp = is_indication ? NULL : mux->resp[utid];
+	if (resp != NULL) {
+		pending_remove_and_dispatch(resp, msg);
+		return;
+	}
 
-		} else if (pend->type == GISI_MESSAGE_TYPE_COMMON &&
-				msgid == COMMON_MESSAGE &&
-				pend->msgid == COMM_ISI_VERSION_GET_REQ) {
+	/*
+	 * REQs, NTFs and INDs are dispatched on message ID.  While
+	 * INDs have the unique transaction ID set to zero, NTFs
+	 * typically mirror the UTID of the request that set up the
+	 * session, and REQs can naturally have any transaction ID.
+	 */
+	l = mux->subscribers[msgid];
 
-			pending_remove_and_dispatch(pend, msg);
-		}
+	while (l != NULL && !modem->destroyed) {
+		GSList *next = l->next;
 
+		pending_dispatch(l->data, msg);
 		l = next;
 	}
 }
@@ -277,62 +328,107 @@ static void firewall_notify_handle(GIsiModem *modem, GIsiMessage *msg)
 	ISIDBG(modem, "firewall blocked message 0x%02X", id);
 }
 
+static void isi_dispatch(GIsiModem *modem, struct sockaddr_pn *addr,
+				void *buf, size_t len, gboolean is_indication)
+{
+	GIsiServiceMux *mux;
+	GIsiMessage msg;
+	unsigned key;
+
+	if (len < 2)
+		return;
+
+	msg.addr = addr;
+	msg.error = 0;
+	msg.data = buf;
+	msg.len = len;
+
+	if (modem->trace != NULL)
+		modem->trace(&msg, NULL);
+
+	key = addr->spn_resource;
+	mux = g_hash_table_lookup(modem->services, GINT_TO_POINTER(key));
+	if (mux == NULL) {
+		/*
+		 * Unfortunately, the FW report has the wrong
+		 * resource ID in the N900 modem.
+		 */
+		if (key == PN_FIREWALL)
+			firewall_notify_handle(modem, &msg);
+
+		return;
+	}
+
+	msg.version = &mux->version;
+
+	if (g_isi_msg_id(&msg) == COMMON_MESSAGE)
+		common_message_decode(mux, &msg);
+
+	service_dispatch(mux, &msg, is_indication);
+}
+
+static void modem_free(GIsiModem *modem);
+
 static gboolean isi_callback(GIOChannel *channel, GIOCondition cond,
 				gpointer data)
 {
 	GIsiModem *modem = data;
-	int len;
-	int fd;
+	struct sockaddr_pn addr[RECV_BATCH_MAX];
+	struct mmsghdr msgs[RECV_BATCH_MAX];
+	struct iovec iov[RECV_BATCH_MAX];
+	gboolean is_indication;
+	unsigned i;
+	int count;
 
 	if (cond & (G_IO_NVAL|G_IO_HUP)) {
 		ISIDBG(modem, "Unexpected event on PhoNet channel %p", channel);
 		return FALSE;
 	}
 
-	fd = g_io_channel_unix_get_fd(channel);
-	len = g_isi_phonet_peek_length(channel);
-
-	if (len > 0) {
-		struct sockaddr_pn addr;
-		uint32_t buf[(len + 3) / 4];
-
-		GIsiServiceMux *mux;
-		GIsiMessage msg;
-		unsigned key;
-
-		len = g_isi_phonet_read(channel, buf, len, &addr);
-		if (len < 2)
-			return TRUE;
-
-		msg.addr = &addr;
-		msg.error = 0;
-		msg.data = buf;
-		msg.len = len;
-
-		if (modem->trace != NULL)
-			modem->trace(&msg, NULL);
-
-		key = addr.spn_resource;
-		mux = g_hash_table_lookup(modem->services,
-						GINT_TO_POINTER(key));
-		if (mux == NULL) {
-			/*
-			 * Unfortunately, the FW report has the wrong
-			 * resource ID in the N900 modem.
-			 */
-			if (key == PN_FIREWALL)
-				firewall_notify_handle(modem, &msg);
-
-			return TRUE;
+	is_indication = g_io_channel_unix_get_fd(channel) == modem->ind_fd;
+
+	modem->dispatching = TRUE;
+
+	/*
+	 * Drain the socket, receiving as many messages per system call
+	 * as the batch holds.  Callbacks may destroy the modem, in which
+	 * case the rest of the messages are dropped.
+	 */
+	do {
+		memset(msgs, 0, sizeof(msgs));
+
+		for (i = 0; i < modem->recv_batch; i++) {
+			iov[i].iov_base = modem->recv_buf +
+						i * modem->recv_size;
+			iov[i].iov_len = modem->recv_size;
+
+			msgs[i].msg_hdr.msg_name = &addr[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
 		}
 
-		msg.version = &mux->version;
+		count = g_isi_phonet_read_batch(channel, msgs,
+							modem->recv_batch);
+
+		for (i = 0; (int) i < count && !modem->destroyed; i++) {
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				ISIDBG(modem, "Truncated message dropped");
+				continue;
+			}
+
+			isi_dispatch(modem, &addr[i], iov[i].iov_base,
+					msgs[i].msg_len, is_indication);
+		}
+	} while (count == (int) modem->recv_batch && !modem->destroyed);
 
-		if (g_isi_msg_id(&msg) == COMMON_MESSAGE)
-			common_message_decode(mux, &msg);
+	modem->dispatching = FALSE;
 
-		service_dispatch(mux, &msg, fd == modem->ind_fd);
+	if (modem->destroyed) {
+		modem_free(modem);
+		return FALSE;
 	}
+
 	return TRUE;
 }
 
@@ -459,6 +555,7 @@ static void service_finalize(gpointer value)
 {
 	GIsiServiceMux *mux = value;
 	GIsiModem *modem = mux->modem;
+	unsigned i;
 
 	if (mux->subscriptions > 0)
 		modem_subs_update_when_idle(modem);
@@ -466,8 +563,16 @@ static void service_finalize(gpointer value)
 	if (mux->registrations > 0)
 		service_name_deregister(mux);
 
-	g_slist_foreach(mux->pending, pending_destroy, NULL);
-	g_slist_free(mux->pending);
+	for (i = 0; i < G_N_ELEMENTS(mux->resp); i++)
+		pending_destroy(mux->resp[i], NULL);
+
+	for (i = 0; i < G_N_ELEMENTS(mux->subscribers); i++) {
+		g_slist_foreach(mux->subscribers[i], pending_destroy, NULL);
+		g_slist_free(mux->subscribers[i]);
+	}
+
+	g_slist_foreach(mux->pings, pending_destroy, NULL);
+	g_slist_free(mux->pings);
 	g_free(mux);
 }
 
@@ -476,6 +581,7 @@ GIsiModem *g_isi_modem_create(unsigned index)
 	GIsiModem *modem;
 	GIOChannel *inds;
 	GIOChannel *reqs;
+	size_t mtu;
 
 	if (index == 0) {
 		errno = ENODEV;
@@ -496,6 +602,27 @@ GIsiModem *g_isi_modem_create(unsigned index)
 		return NULL;
 	}
 
+	/*
+	 * Every receive buffer of a batch must fit the largest message
+	 * the link can carry, so that nothing gets truncated.
+	 */
+	mtu = g_isi_phonet_mtu(reqs, index);
+	if (mtu == 0)
+		mtu = RECV_DEFAULT_MTU;
+
+	modem->recv_size = (mtu + 7) & ~7;
+	modem->recv_batch = CLAMP(RECV_BATCH_BYTES / modem->recv_size,
+					1, RECV_BATCH_MAX);
+	modem->recv_buf = g_try_malloc(modem->recv_batch * modem->recv_size);
+
+	if (modem->recv_buf == NULL) {
+		g_io_channel_unref(reqs);
+		g_io_channel_unref(inds);
+		g_free(modem);
+		errno = ENOMEM;
+		return NULL;
+	}
+
 	modem->req_fd = g_io_channel_unix_get_fd(reqs);
 	modem->req_watch = g_io_add_watch(reqs,
 					G_IO_IN|G_IO_ERR|G_IO_HUP|G_IO_NVAL,
@@ -628,11 +755,8 @@ static void service_regs_decr(GIsiServiceMux *mux)
 		service_name_deregister(mux);
 }
 
-void g_isi_modem_destroy(GIsiModem *modem)
+static void modem_free(GIsiModem *modem)
 {
-	if (modem == NULL)
-		return;
-
 	g_hash_table_remove_all(modem->services);
 
 	if (modem->subs_source > 0) {
@@ -648,9 +772,24 @@ void g_isi_modem_destroy(GIsiModem *modem)
 	if (modem->req_watch > 0)
 		g_source_remove(modem->req_watch);
 
+	g_free(modem->recv_buf);
 	g_free(modem);
 }
 
+void g_isi_modem_destroy(GIsiModem *modem)
+{
+	if (modem == NULL)
+		return;
+
+	/* Freed once the messages being dispatched have been handled */
+	if (modem->dispatching) {
+		modem->destroyed = TRUE;
+		return;
+	}
+
+	modem_free(modem);
+}
+
 unsigned g_isi_modem_index(GIsiModem *modem)
 {
 	return modem != NULL ? modem->index : 0;
@@ -782,7 +921,7 @@ GIsiPending *g_isi_request_vsendto(GIsiModem *modem, struct sockaddr_pn *dst,
 	resp->destroy = destroy;
 	resp->data = data;
 
-	if (g_slist_find_custom(mux->pending, resp, utid_equal)) {
+	if (utid_in_use(mux, resp)) {
 		/*
 		 * FIXME: perhaps retry with randomized access after
 		 * initial miss. Although if the rate at which
@@ -815,7 +954,7 @@ GIsiPending *g_isi_request_vsendto(GIsiModem *modem, struct sockaddr_pn *dst,
 		goto error;
 	}
 
-	mux->pending = g_slist_prepend(mux->pending, resp);
+	mux->resp[resp->utid] = resp;
 
 	if (timeout > 0)
 		resp->timeout = g_timeout_add_seconds(timeout, resp_timeout,
@@ -854,8 +993,7 @@ void g_isi_pending_remove(GIsiPending *op)
 		return;
 	}
 
-	op->service->pending = g_slist_remove(op->service->pending, op);
-
+	pending_unlink(op);
 	pending_destroy(op, NULL);
 }
 
@@ -886,30 +1024,54 @@ void g_isi_pending_set_owner(GIsiPending *op, gpointer owner)
 	op->owner = owner;
 }
 
+static GSList *take_owned(GSList **list, gpointer owner, GSList *owned)
+{
+	GSList *l;
+	GSList *next;
+	GIsiPending *op;
+
+	for (l = *list; l != NULL; l = next) {
+		next = l->next;
+		op = l->data;
+
+		if (op->owner != owner)
+			continue;
+
+		*list = g_slist_remove_link(*list, l);
+
+		l->next = owned;
+		owned = l;
+	}
+
+	return owned;
+}
+
 void g_isi_remove_pending_by_owner(GIsiModem *modem, uint8_t resource,
 					gpointer owner)
 {
 	GIsiServiceMux *mux;
 	GSList *l;
-	GSList *next;
 	GIsiPending *op;
 	GSList *owned = NULL;
+	unsigned i;
 
 	mux = service_get(modem, resource);
 	if (mux == NULL)
 		return;
 
-	for (l = mux->pending; l != NULL; l = next) {
-		next = l->next;
-		op = l->data;
+	for (i = 0; i < G_N_ELEMENTS(mux->subscribers); i++)
+		owned = take_owned(&mux->subscribers[i], owner, owned);
 
-		if (op->owner != owner)
-			continue;
+	owned = take_owned(&mux->pings, owner, owned);
 
-		mux->pending = g_slist_remove_link(mux->pending, l);
+	for (i = 0; i < G_N_ELEMENTS(mux->resp); i++) {
+		op = mux->resp[i];
 
-		l->next = owned;
-		owned = l;
+		if (op == NULL || op->owner != owner)
+			continue;
+
+		mux->resp[i] = NULL;
+		owned = g_slist_prepend(owned, op);
 	}
 
 	for (l = owned; l != NULL; l = l->next) {
@@ -947,7 +1109,7 @@ GIsiPending *g_isi_ntf_subscribe(GIsiModem *modem, uint8_t resource,
 	ntf->destroy = destroy;
 	ntf->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, ntf);
+	mux->subscribers[msgid] = g_slist_append(mux->subscribers[msgid], ntf);
 
 	ISIDBG(modem, "Subscribed to %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(ntf->type), ntf, resource, msgid);
@@ -981,7 +1143,7 @@ GIsiPending *g_isi_service_bind(GIsiModem *modem, uint8_t resource,
 	srv->destroy = destroy;
 	srv->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, srv);
+	mux->subscribers[msgid] = g_slist_append(mux->subscribers[msgid], srv);
 
 	ISIDBG(modem, "Bound service for %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(srv->type), srv, resource, msgid);
@@ -1017,7 +1179,7 @@ GIsiPending *g_isi_ind_subscribe(GIsiModem *modem, uint8_t resource,
 	ind->destroy = destroy;
 	ind->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, ind);
+	mux->subscribers[msgid] = g_slist_append(mux->subscribers[msgid], ind);
 
 	ISIDBG(modem, "Subscribed for %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(ind->type), ind, resource, msgid);
@@ -1165,7 +1327,7 @@ static int version_get_send(GIsiModem *modem, GIsiPending *ping)
 	};
 	ssize_t ret;
 
-	if (g_slist_find_custom(mux->pending, ping, utid_equal))
+	if (utid_in_use(mux, ping))
 		return -EBUSY;
 
 	ret = sendto(modem->req_fd, msg, sizeof(msg), MSG_NOSIGNAL,
@@ -1247,7 +1409,7 @@ GIsiPending *g_isi_resource_ping(GIsiModem *modem, uint8_t resource,
 
 	ping->timeout = g_timeout_add_seconds(COMMON_TIMEOUT, resp_timeout,
 						ping);
-	mux->pending = g_slist_prepend(mux->pending, ping);
+	mux->pings = g_slist_prepend(mux->pings, ping);
 	mux->version_pending = TRUE;
 
 	ISIDBG(modem, "Ping sent %s (%p) [res=0x%02X]",
@@ -23,7 +23,9 @@
 #include <config.h>
 #endif
 
+#define _GNU_SOURCE
 #include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
@@ -91,3 +93,23 @@ ssize_t g_isi_phonet_read(GIOChannel *channel, void *restrict buf, size_t len,
 
 	return ret;
 }
+
+int g_isi_phonet_read_batch(GIOChannel *channel, struct mmsghdr *msgs,
+				unsigned int count)
+{
+	return recvmmsg(g_io_channel_unix_get_fd(channel), msgs, count,
+			MSG_DONTWAIT, NULL);
+}
+
+size_t g_isi_phonet_mtu(GIOChannel *channel, unsigned int ifindex)
+{
+	struct ifreq req;
+	int fd = g_io_channel_unix_get_fd(channel);
+
+	memset(&req, 0, sizeof(req));
+
+	if (if_indextoname(ifindex, req.ifr_name) == NULL)
+		return 0;
+
+	return ioctl(fd, SIOCGIFMTU, &req) ? 0 : req.ifr_mtu;
+}
@@ -571,15 +571,14 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 	struct ril_msg *message;
 	struct ril_s *p = user_data;
 	unsigned int len = ring_buffer_len(rbuf);
-	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	guchar *buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
 
 	p->in_read_handler = TRUE;
 
-	DBG("len: %d, wrap: %d", len, wrap);
+	DBG("len: %d", len);
 
 	while (p->suspended == FALSE && (p->read_so_far < len)) {
-		gsize rbytes = MIN(len - p->read_so_far, wrap - p->read_so_far);
+		gsize rbytes = len - p->read_so_far;
 
 		if (rbytes < 4) {
 			DBG("Not enough bytes for header length: len: %d", len);
@@ -603,18 +602,11 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 		buf += rbytes;
 		p->read_so_far += rbytes;
 
-		/* TODO: need to better understand how wrap works! */
-		if (p->read_so_far == wrap) {
-			buf = ring_buffer_read_ptr(rbuf, p->read_so_far);
-			wrap = len;
-		}
-
 		dispatch(p, message);
 
 		ring_buffer_drain(rbuf, p->read_so_far);
 
 		len -= p->read_so_far;
-		wrap -= p->read_so_far;
 		p->read_so_far = 0;
 	}
 
@@ -853,6 +845,8 @@ static struct ril_s *create_ril()
 	g_io_channel_set_flags(io, G_IO_FLAG_NONBLOCK, NULL);
 
 	ril->io = g_ril_io_new(io);
+	g_io_channel_unref(io);
+
 	if (ril->io == NULL) {
 		ofono_error("create_ril: can't create ril->io");
 		goto error;
@@ -1071,6 +1065,7 @@ void g_ril_init_parcel(struct ril_msg *message, struct parcel *rilp)
 	rilp->size = message->buf_len;
 	rilp->capacity = message->buf_len;
 	rilp->offset = 0;
+	rilp->malformed = 0;
 }
 
 GRil *g_ril_new()
@@ -38,6 +38,8 @@
 #include "grilio.h"
 #include "grilutil.h"
 
+#define MAX_BUFFER_SIZE 262144
+
 struct _GRilIO {
 	gint ref_count;				/* Ref count */
 	guint read_watch;			/* GSource read id, 0 if no */
@@ -46,6 +48,7 @@ struct _GRilIO {
 	GRilDisconnectFunc user_disconnect;	/* user disconnect func */
 	gpointer user_disconnect_data;		/* user disconnect data */
 	struct ring_buffer *buf;		/* Current read buffer */
+	gboolean read_throttled;		/* Paused on full buffer */
 	guint max_read_attempts;		/* max reads / select */
 	GRilIOReadFunc read_handler;		/* Read callback */
 	gpointer read_data;			/* Read callback userdata */
@@ -63,16 +66,22 @@ static void read_watcher_destroy_notify(gpointer user_data)
 {
 	GRilIO *io = user_data;
 
+	io->read_watch = 0;
+
+	/* Reading is only paused until the buffer is drained */
+	if (io->read_throttled && !io->destroyed)
+		return;
+
 	ring_buffer_free(io->buf);
 	io->buf = NULL;
 
 	io->debugf = NULL;
 	io->debug_data = NULL;
 
-	io->read_watch = 0;
 	io->read_handler = NULL;
 	io->read_data = NULL;
 
+	g_io_channel_unref(io->channel);
 	io->channel = NULL;
 
 	if (io->destroyed)
@@ -81,6 +90,23 @@ static void read_watcher_destroy_notify(gpointer user_data)
 		io->user_disconnect(io->user_disconnect_data);
 }
 
+static gboolean grow_buffer(GRilIO *io)
+{
+	int size = ring_buffer_capacity(io->buf);
+
+	if (size >= MAX_BUFFER_SIZE)
+		return FALSE;
+
+	return ring_buffer_grow(io->buf, MIN(size * 2, MAX_BUFFER_SIZE)) > 0;
+}
+
+static void read_overflow(GRilIO *io)
+{
+	if (io->debugf)
+		io->debugf("Read buffer overflow, closing channel",
+				io->debug_data);
+}
+
 static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 				gpointer data)
 {
@@ -97,7 +123,11 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 
 	/* Regardless of condition, try to read all the data available */
 	do {
-		toread = ring_buffer_avail_no_wrap(io->buf);
+		toread = ring_buffer_avail(io->buf);
+
+		/* Make room for a burst instead of leaving data behind */
+		if (toread == 0 && grow_buffer(io))
+			toread = ring_buffer_avail(io->buf);
 
 		if (toread == 0)
 			break;
@@ -130,13 +160,45 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 	if (read_count > 0 && rbytes == 0 && status != G_IO_STATUS_AGAIN)
 		return FALSE;
 
-	/* We're overflowing the buffer, shutdown the socket */
-	if (ring_buffer_avail(io->buf) == 0)
+	/*
+	 * The buffer is full and can't grow any further.  A suspended
+	 * reader drains it once it is back, stop polling for input until
+	 * then.  A reader that left the buffer full is waiting for a frame
+	 * larger than the buffer, which would stall the channel for good.
+	 */
+	if (ring_buffer_avail(io->buf) == 0 && !grow_buffer(io)) {
+		if (io->read_handler) {
+			read_overflow(io);
+			return FALSE;
+		}
+
+		io->read_throttled = TRUE;
 		return FALSE;
+	}
 
 	return TRUE;
 }
 
+static void add_read_watch(GRilIO *io)
+{
+	io->read_watch = g_io_add_watch_full(io->channel, G_PRIORITY_DEFAULT,
+				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				received_data, io,
+				read_watcher_destroy_notify);
+}
+
+static void resume_read(GRilIO *io)
+{
+	if (io->read_throttled == FALSE || io->read_watch > 0)
+		return;
+
+	if (ring_buffer_avail(io->buf) == 0)
+		return;
+
+	io->read_throttled = FALSE;
+	add_read_watch(io);
+}
+
 gsize g_ril_io_write(GRilIO *io, const gchar *data, gsize count)
 {
 	GIOStatus status;
@@ -146,7 +208,13 @@ gsize g_ril_io_write(GRilIO *io, const gchar *data, gsize count)
 						count, &bytes_written, NULL);
 
 	if (status != G_IO_STATUS_NORMAL) {
-		g_source_remove(io->read_watch);
+		io->read_throttled = FALSE;
+
+		if (io->read_watch > 0)
+			g_source_remove(io->read_watch);
+		else if (io->buf)
+			read_watcher_destroy_notify(io);
+
 		return 0;
 	}
 
@@ -207,7 +275,8 @@ static GRilIO *create_io(GIOChannel *channel, GIOFlags flags)
 		io->use_write_watch = FALSE;
 	}
 
-	io->buf = ring_buffer_new(8192);
+	/* The parsers rely on the data in the read buffer never wrapping */
+	io->buf = ring_buffer_new_mirrored(8192);
 
 	if (!io->buf)
 		goto error;
@@ -215,11 +284,9 @@ static GRilIO *create_io(GIOChannel *channel, GIOFlags flags)
 	if (!g_ril_util_setup_io(channel, flags))
 		goto error;
 
-	io->channel = channel;
-	io->read_watch = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
-				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-				received_data, io,
-				read_watcher_destroy_notify);
+	/* Reading can pause without a watch holding on to the channel */
+	io->channel = g_io_channel_ref(channel);
+	add_read_watch(io);
 
 	return io;
 
@@ -262,6 +329,8 @@ gboolean g_ril_io_set_read_handler(GRilIO *io, GRilIOReadFunc read_handler,
 	if (read_handler && ring_buffer_len(io->buf) > 0)
 		read_handler(io->buf, user_data);
 
+	resume_read(io);
+
 	return TRUE;
 }
 
@@ -343,10 +412,18 @@ void g_ril_io_unref(GRilIO *io)
 	 * destroyed already.  We have to wait until the read_watcher
 	 * destroy function gets called
 	 */
-	if (io->read_watch > 0)
+	if (io->read_watch > 0) {
 		io->destroyed = TRUE;
-	else
-		g_free(io);
+		return;
+	}
+
+	/* Reading might have been paused with data left in the buffer */
+	ring_buffer_free(io->buf);
+
+	if (io->channel)
+		g_io_channel_unref(io->channel);
+
+	g_free(io);
 }
 
 gboolean g_ril_io_set_disconnect_function(GRilIO *io,
@@ -385,4 +462,5 @@ void g_ril_io_set_write_done(GRilIO *io, GRilDisconnectFunc func,
 void g_ril_io_drain_ring_buffer(GRilIO *io, guint len)
 {
 	ring_buffer_drain(io->buf, len);
+	resume_read(io);
 }
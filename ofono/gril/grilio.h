@@ -46,6 +46,12 @@ GIOChannel *g_ril_io_get_channel(GRilIO *io);
 GRilIO *g_ril_io_ref(GRilIO *io);
 void g_ril_io_unref(GRilIO *io);
 
+/*!
+ * Sets the function that is passed the read buffer whenever data arrived.
+ * The handler drains what it consumed.  While no handler is set reading
+ * pauses once the buffer is full, a handler that leaves the buffer full at
+ * its largest size closes the channel
+ */
 gboolean g_ril_io_set_read_handler(GRilIO *io, GRilIOReadFunc read_handler,
 					gpointer user_data);
 gboolean g_ril_io_set_write_handler(GRilIO *io, GRilIOWriteFunc write_handler,
@@ -120,6 +120,12 @@ struct reply_setup_data_call *g_ril_reply_parse_data_call(GRil *gril,
 	dnses = parcel_r_string(&rilp);
 	raw_gws = parcel_r_string(&rilp);
 
+	if (rilp.malformed) {
+		ofono_error("%s: malformed parcel", __func__);
+		OFONO_EINVAL(error);
+		goto error;
+	}
+
 	g_ril_append_print_buf(gril,
 				"{version=%d,num=%d [status=%d,retry=%d,"
 				"cid=%d,active=%d,type=%s,ifname=%s,address=%s"
@@ -129,6 +129,13 @@ struct unsol_data_call_list *g_ril_unsol_parse_data_call_list(GRil *gril,
 		call->dnses = parcel_r_string(&rilp);
 		call->gateways = parcel_r_string(&rilp);
 
+		if (rilp.malformed) {
+			ofono_error("%s: malformed parcel", __func__);
+			free_data_call(call, NULL);
+			OFONO_EINVAL(error);
+			goto error;
+		}
+
 		g_ril_append_print_buf(gril,
 					"%s [status=%d,retry=%d,cid=%d,"
 					"active=%d,type=%s,ifname=%s,"
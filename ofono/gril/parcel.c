@@ -53,6 +53,7 @@ void parcel_init(struct parcel *p)
 	p->size = 0;
 	p->capacity = sizeof(int32_t);
 	p->offset = 0;
+	p->malformed = 0;
 }
 
 void parcel_grow(struct parcel *p, size_t size)
@@ -73,6 +74,13 @@ void parcel_free(struct parcel *p)
 int32_t parcel_r_int32(struct parcel *p)
 {
 	int32_t ret;
+
+	/* Reads past the end yield 0 and mark the parcel as malformed */
+	if (p->offset + sizeof(int32_t) > p->size) {
+		p->malformed = 1;
+		return 0;
+	}
+
 	ret = *((int32_t *) (p->data + p->offset));
 	p->offset += sizeof(int32_t);
 	return ret;
@@ -171,6 +179,12 @@ char* parcel_r_string(struct parcel *p)
 	if (len16 < 0)
 		return NULL;
 
+	if (p->malformed ||
+		(size_t) len16 > parcel_data_avail(p) / sizeof(char16_t)) {
+		p->malformed = 1;
+		return NULL;
+	}
+
 	ret = g_utf16_to_utf8((gunichar2 *) (p->data + p->offset),
 				len16, NULL, NULL, NULL);
 	if (ret == NULL)
@@ -183,5 +197,8 @@ char* parcel_r_string(struct parcel *p)
 
 size_t parcel_data_avail(struct parcel *p)
 {
+	if (p->offset >= p->size)
+		return 0;
+
 	return (p->size - p->offset);
 }
@@ -47,6 +47,7 @@ struct ofono_debug_desc {
 #define OFONO_DEBUG_FLAG_DEFAULT (0)
 #define OFONO_DEBUG_FLAG_PRINT   (1 << 0)
 	unsigned int flags;
+	unsigned int hits;
 } __attribute__((aligned(8)));
 
 /**
@@ -55,13 +56,16 @@ struct ofono_debug_desc {
  * @arg...: list of arguments
  *
  * Simple macro around ofono_debug() which also include the function
- * name it is called in.
+ * name it is called in.  Every pass is counted, whether the message
+ * gets printed or not.
  */
 #define DBG(fmt, arg...) do { \
 	static struct ofono_debug_desc __ofono_debug_desc \
 	__attribute__((used, section("__debug"), aligned(8))) = { \
-		.file = __FILE__, .flags = OFONO_DEBUG_FLAG_DEFAULT, \
+		.name = __FUNCTION__, .file = __FILE__, \
+		.flags = OFONO_DEBUG_FLAG_DEFAULT, \
 	}; \
+	__ofono_debug_desc.hits++; \
 	if (__ofono_debug_desc.flags & OFONO_DEBUG_FLAG_PRINT) \
 		ofono_debug("%s:%s() " fmt, \
 					__FILE__, __FUNCTION__ , ## arg); \
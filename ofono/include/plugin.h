@@ -53,6 +53,7 @@ struct ofono_plugin_desc {
 	void (*exit) (void);
 	void *debug_start;
 	void *debug_stop;
+	const char **modem_drivers;
 };
 
 /**
@@ -84,6 +85,42 @@ struct ofono_plugin_desc {
 		};
 #endif
 
+/**
+ * OFONO_MODEM_PLUGIN_DEFINE:
+ * @name: plugin name
+ * @description: plugin description
+ * @version: plugin version string
+ * @init: init function called on plugin loading
+ * @exit: exit function called on plugin removal
+ * @...: names of the modem drivers registered by @init
+ *
+ * Macro for defining the descriptor of a plugin that only registers
+ * modem drivers.  Such a plugin can be deferred, it is then initialized
+ * once a modem using one of its drivers is registered.
+ */
+#ifdef OFONO_PLUGIN_BUILTIN
+#define OFONO_MODEM_PLUGIN_DEFINE(name, description, version, priority, \
+					init, exit, ...) \
+		struct ofono_plugin_desc __ofono_builtin_ ## name = { \
+			#name, description, version, priority, init, exit, \
+			NULL, NULL, (const char *[]) { __VA_ARGS__, NULL } \
+		};
+#else
+#define OFONO_MODEM_PLUGIN_DEFINE(name, description, version, priority, \
+					init, exit, ...) \
+		extern struct ofono_debug_desc __start___debug[] \
+				__attribute__ ((weak, visibility("hidden"))); \
+		extern struct ofono_debug_desc __stop___debug[] \
+				__attribute__ ((weak, visibility("hidden"))); \
+		extern struct ofono_plugin_desc ofono_plugin_desc \
+				__attribute__ ((visibility("default"))); \
+		struct ofono_plugin_desc ofono_plugin_desc = { \
+			#name, description, version, priority, init, exit, \
+			__start___debug, __stop___debug, \
+			(const char *[]) { __VA_ARGS__, NULL } \
+		};
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -140,6 +140,16 @@ void ofono_voicecall_en_list_notify(struct ofono_voicecall *vc,
 
 void ofono_voicecall_notify(struct ofono_voicecall *vc,
 				const struct ofono_call *call);
+
+/*
+ * Reports the current state of a set of calls at once, e.g. the result
+ * of a CLCC poll.  Only the calls that are new or have changed since the
+ * last report are signalled.  Calls missing from the set are left alone,
+ * drivers report them through ofono_voicecall_disconnected.
+ */
+void ofono_voicecall_notify_list(struct ofono_voicecall *vc,
+					const struct ofono_call *calls,
+					unsigned int num_calls);
 void ofono_voicecall_disconnected(struct ofono_voicecall *vc, int id,
 				enum ofono_disconnect_reason reason,
 				const struct ofono_error *error);
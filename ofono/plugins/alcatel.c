@@ -276,5 +276,6 @@ static void alcatel_exit(void)
 	ofono_modem_driver_unregister(&alcatel_driver);
 }
 
-OFONO_PLUGIN_DEFINE(alcatel, "Alcatel modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, alcatel_init, alcatel_exit)
+OFONO_MODEM_PLUGIN_DEFINE(alcatel, "Alcatel modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, alcatel_init, alcatel_exit,
+		"alcatel")
@@ -120,7 +120,7 @@ int bluetooth_send_with_reply(const char *path, const char *interface,
 	if (timeout > 0)
 		timeout *= 1000;
 
-	if (!dbus_connection_send_with_reply(connection, msg, &c, timeout)) {
+	if (!g_dbus_send_message_with_reply(connection, msg, &c, timeout)) {
 		ofono_error("Sending %s failed", method);
 		err = -EIO;
 		goto fail;
@@ -560,6 +560,6 @@ static void calypso_exit(void)
 	ofono_modem_driver_unregister(&calypso_driver);
 }
 
-OFONO_PLUGIN_DEFINE(calypso, "TI Calypso modem driver", VERSION,
+OFONO_MODEM_PLUGIN_DEFINE(calypso, "TI Calypso modem driver", VERSION,
 			OFONO_PLUGIN_PRIORITY_DEFAULT,
-			calypso_init, calypso_exit)
+			calypso_init, calypso_exit, "calypso")
@@ -72,9 +72,7 @@ static void send_release(const char *path)
 
 	dbus_message_append_args(message, DBUS_TYPE_OBJECT_PATH, &path,
 					DBUS_TYPE_INVALID);
-	dbus_message_set_no_reply(message, TRUE);
-	dbus_connection_send(connection, message, NULL);
-	dbus_message_unref(message);
+	g_dbus_send_message(connection, message);
 }
 
 static void connman_release(int uid)
@@ -251,7 +249,7 @@ static int connman_request(ofono_private_network_cb_t cb, void *data)
 		return -ENOMEM;
 	}
 
-	if (dbus_connection_send_with_reply(connection, message,
+	if (g_dbus_send_message_with_reply(connection, message,
 						&call, 5000) == FALSE) {
 		g_free(req);
 		dbus_message_unref(message);
@@ -498,5 +498,6 @@ static void gobi_exit(void)
 	ofono_modem_driver_unregister(&gobi_driver);
 }
 
-OFONO_PLUGIN_DEFINE(gobi, "Qualcomm Gobi modem driver", VERSION,
-			OFONO_PLUGIN_PRIORITY_DEFAULT, gobi_init, gobi_exit)
+OFONO_MODEM_PLUGIN_DEFINE(gobi, "Qualcomm Gobi modem driver", VERSION,
+			OFONO_PLUGIN_PRIORITY_DEFAULT, gobi_init, gobi_exit,
+			"gobi")
@@ -892,5 +892,6 @@ static void huawei_exit(void)
 	ofono_modem_driver_unregister(&huawei_driver);
 }
 
-OFONO_PLUGIN_DEFINE(huawei, "HUAWEI Mobile modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, huawei_init, huawei_exit)
+OFONO_MODEM_PLUGIN_DEFINE(huawei, "HUAWEI Mobile modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, huawei_init, huawei_exit,
+		"huawei")
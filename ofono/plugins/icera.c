@@ -431,5 +431,6 @@ static void icera_exit(void)
 	ofono_modem_driver_unregister(&icera_driver);
 }
 
-OFONO_PLUGIN_DEFINE(icera, "Icera modem driver", VERSION,
-			OFONO_PLUGIN_PRIORITY_DEFAULT, icera_init, icera_exit)
+OFONO_MODEM_PLUGIN_DEFINE(icera, "Icera modem driver", VERSION,
+			OFONO_PLUGIN_PRIORITY_DEFAULT, icera_init, icera_exit,
+			"icera")
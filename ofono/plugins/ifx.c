@@ -756,5 +756,6 @@ static void ifx_exit(void)
 	ofono_modem_driver_unregister(&ifx_driver);
 }
 
-OFONO_PLUGIN_DEFINE(ifx, "Infineon modem driver", VERSION,
-			OFONO_PLUGIN_PRIORITY_DEFAULT, ifx_init, ifx_exit)
+OFONO_MODEM_PLUGIN_DEFINE(ifx, "Infineon modem driver", VERSION,
+			OFONO_PLUGIN_PRIORITY_DEFAULT, ifx_init, ifx_exit,
+			"ifx")
@@ -471,6 +471,6 @@ static void isiusb_exit(void)
 	ofono_modem_driver_unregister(&driver);
 }
 
-OFONO_PLUGIN_DEFINE(isiusb, "Generic modem driver for isi",
+OFONO_MODEM_PLUGIN_DEFINE(isiusb, "Generic modem driver for isi",
 			VERSION, OFONO_PLUGIN_PRIORITY_DEFAULT,
-			isiusb_init, isiusb_exit)
+			isiusb_init, isiusb_exit, "isiusb")
@@ -507,5 +507,6 @@ static void mbm_exit(void)
 	ofono_modem_driver_unregister(&mbm_driver);
 }
 
-OFONO_PLUGIN_DEFINE(mbm, "Ericsson MBM modem driver", VERSION,
-			OFONO_PLUGIN_PRIORITY_DEFAULT, mbm_init, mbm_exit)
+OFONO_MODEM_PLUGIN_DEFINE(mbm, "Ericsson MBM modem driver", VERSION,
+			OFONO_PLUGIN_PRIORITY_DEFAULT, mbm_init, mbm_exit,
+			"mbm")
@@ -24,6 +24,8 @@
 #endif
 
 #include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -42,6 +44,10 @@
 							"serviceproviders.xml"
 #endif
 
+#ifndef MBPI_INDEX
+#define MBPI_INDEX STORAGEDIR "/serviceproviders.idx"
+#endif
+
 #include "mbpi.h"
 
 #define _(x) case x: return (#x)
@@ -64,6 +70,78 @@ struct cdma_data {
 	gboolean match_found;
 };
 
+/*
+ * The compiled index holds every APN and CDMA provider name of the
+ * database, keyed by MCC/MNC and SID.  Both key tables are sorted, so a
+ * lookup is a binary search in the mapped file.  Strings are offsets
+ * into a string table, offset 0 is the empty string used for NULL.
+ */
+#define MBPI_INDEX_MAGIC "MBPIIDX"
+#define MBPI_INDEX_VERSION 1
+
+struct mbpi_index_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t size;
+	int64_t db_mtime;
+	int64_t db_mtime_nsec;
+	int64_t db_size;
+	uint64_t db_ino;
+	uint32_t num_gsm;
+	uint32_t gsm_offset;
+	uint32_t num_apns;
+	uint32_t apn_offset;
+	uint32_t num_cdma;
+	uint32_t cdma_offset;
+	uint32_t strings_offset;
+	uint32_t strings_size;
+};
+
+struct mbpi_index_gsm {
+	char mcc[4];
+	char mnc[4];
+	uint32_t apn;
+	uint32_t seq;
+};
+
+struct mbpi_index_apn {
+	uint32_t type;
+	uint32_t line;
+	uint32_t name;
+	uint32_t apn;
+	uint32_t username;
+	uint32_t password;
+};
+
+struct mbpi_index_cdma {
+	char sid[8];
+	uint32_t name;
+	uint32_t seq;
+};
+
+struct compile_data {
+	GArray *gsm;
+	GArray *apns;
+	GArray *cdma;
+	GString *strings;
+	GArray *network_ids; /* network-id elements of the current gsm */
+	GArray *sids; /* sid elements of the current provider */
+	uint32_t provider_name;
+	uint32_t *text;
+	gboolean in_provider;
+	gboolean in_gsm;
+	gboolean in_cdma;
+	gboolean in_apn;
+};
+
+static const char *index_path = MBPI_INDEX;
+
+static struct {
+	char *data;
+	size_t size;
+	gboolean mapped;
+} mbpi_index;
+
 const char *mbpi_ap_type(enum ofono_gprs_context_type type)
 {
 	switch (type) {
@@ -564,12 +642,646 @@ static gboolean mbpi_parse(const GMarkupParser *parser, gpointer userdata,
 	return ret;
 }
 
+static uint32_t compile_string(struct compile_data *data, const char *str,
+				gsize len)
+{
+	uint32_t offset = data->strings->len;
+
+	g_string_append_len(data->strings, str, len);
+	g_string_append_c(data->strings, '\0');
+
+	return offset;
+}
+
+static const char *find_attribute(const gchar **attribute_names,
+					const gchar **attribute_values,
+					const char *name)
+{
+	int i;
+
+	for (i = 0; attribute_names[i]; i++)
+		if (g_str_equal(attribute_names[i], name) == TRUE)
+			return attribute_values[i];
+
+	return NULL;
+}
+
+static void compile_network_id(GMarkupParseContext *context,
+				struct compile_data *data,
+				const gchar **attribute_names,
+				const gchar **attribute_values,
+				GError **error)
+{
+	struct mbpi_index_gsm key;
+	const char *mcc;
+	const char *mnc;
+
+	mcc = find_attribute(attribute_names, attribute_values, "mcc");
+	mnc = find_attribute(attribute_names, attribute_values, "mnc");
+
+	if (mcc == NULL || mnc == NULL) {
+		mbpi_g_set_error(context, error, G_MARKUP_ERROR,
+					G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+					"Missing attribute: %s",
+					mcc == NULL ? "mcc" : "mnc");
+		return;
+	}
+
+	if (strlen(mcc) >= sizeof(key.mcc) || strlen(mnc) >= sizeof(key.mnc)) {
+		mbpi_g_set_error(context, error, G_MARKUP_ERROR,
+					G_MARKUP_ERROR_INVALID_CONTENT,
+					"Invalid network-id: %s %s", mcc, mnc);
+		return;
+	}
+
+	memset(&key, 0, sizeof(key));
+	strcpy(key.mcc, mcc);
+	strcpy(key.mnc, mnc);
+
+	g_array_append_val(data->network_ids, key);
+}
+
+static void compile_apn(GMarkupParseContext *context,
+				struct compile_data *data,
+				const gchar **attribute_names,
+				const gchar **attribute_values,
+				GError **error)
+{
+	struct mbpi_index_apn ap;
+	const char *apn;
+
+	apn = find_attribute(attribute_names, attribute_values, "value");
+	if (apn == NULL) {
+		mbpi_g_set_error(context, error, G_MARKUP_ERROR,
+					G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+					"APN attribute missing");
+		return;
+	}
+
+	memset(&ap, 0, sizeof(ap));
+	ap.type = OFONO_GPRS_CONTEXT_TYPE_INTERNET;
+	ap.apn = compile_string(data, apn, strlen(apn));
+
+	g_array_append_val(data->apns, ap);
+	data->in_apn = TRUE;
+}
+
+static void compile_sid(GMarkupParseContext *context,
+				struct compile_data *data,
+				const gchar **attribute_names,
+				const gchar **attribute_values,
+				GError **error)
+{
+	struct mbpi_index_cdma key;
+	const char *sid;
+
+	sid = find_attribute(attribute_names, attribute_values, "value");
+	if (sid == NULL) {
+		mbpi_g_set_error(context, error, G_MARKUP_ERROR,
+					G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+					"Missing attribute: sid");
+		return;
+	}
+
+	if (strlen(sid) >= sizeof(key.sid)) {
+		mbpi_g_set_error(context, error, G_MARKUP_ERROR,
+					G_MARKUP_ERROR_INVALID_CONTENT,
+					"Invalid sid: %s", sid);
+		return;
+	}
+
+	memset(&key, 0, sizeof(key));
+	strcpy(key.sid, sid);
+
+	g_array_append_val(data->sids, key);
+}
+
+static void compile_start(GMarkupParseContext *context,
+				const gchar *element_name,
+				const gchar **attribute_names,
+				const gchar **attribute_values,
+				gpointer userdata, GError **error)
+{
+	struct compile_data *data = userdata;
+	struct mbpi_index_apn *ap;
+	enum ofono_gprs_context_type type;
+
+	if (data->in_apn) {
+		ap = &g_array_index(data->apns, struct mbpi_index_apn,
+					data->apns->len - 1);
+
+		if (g_str_equal(element_name, "name"))
+			data->text = &ap->name;
+		else if (g_str_equal(element_name, "username"))
+			data->text = &ap->username;
+		else if (g_str_equal(element_name, "password"))
+			data->text = &ap->password;
+		else if (g_str_equal(element_name, "usage")) {
+			type = ap->type;
+			usage_start(context, attribute_names, attribute_values,
+					&type, error);
+			ap->type = type;
+		}
+	} else if (data->in_gsm) {
+		if (g_str_equal(element_name, "network-id"))
+			compile_network_id(context, data, attribute_names,
+						attribute_values, error);
+		else if (g_str_equal(element_name, "apn"))
+			compile_apn(context, data, attribute_names,
+					attribute_values, error);
+	} else if (data->in_cdma) {
+		if (g_str_equal(element_name, "sid"))
+			compile_sid(context, data, attribute_names,
+					attribute_values, error);
+	} else if (g_str_equal(element_name, "gsm")) {
+		data->in_gsm = TRUE;
+		g_array_set_size(data->network_ids, 0);
+	} else if (g_str_equal(element_name, "cdma"))
+		data->in_cdma = TRUE;
+	else if (g_str_equal(element_name, "provider")) {
+		data->in_provider = TRUE;
+		data->provider_name = 0;
+		g_array_set_size(data->sids, 0);
+	} else if (data->in_provider && g_str_equal(element_name, "name"))
+		data->text = &data->provider_name;
+}
+
+static void compile_end(GMarkupParseContext *context,
+				const gchar *element_name,
+				gpointer userdata, GError **error)
+{
+	struct compile_data *data = userdata;
+	struct mbpi_index_apn *ap;
+	struct mbpi_index_gsm *key;
+	struct mbpi_index_cdma *sid;
+	int line, column;
+	guint i;
+
+	data->text = NULL;
+
+	if (data->in_apn) {
+		if (g_str_equal(element_name, "apn") == FALSE)
+			return;
+
+		ap = &g_array_index(data->apns, struct mbpi_index_apn,
+					data->apns->len - 1);
+		g_markup_parse_context_get_position(context, &line, &column);
+		ap->line = line;
+
+		/* The APN belongs to the network ids seen so far */
+		for (i = 0; i < data->network_ids->len; i++) {
+			key = &g_array_index(data->network_ids,
+						struct mbpi_index_gsm, i);
+			key->apn = data->apns->len - 1;
+			key->seq = data->gsm->len;
+			g_array_append_vals(data->gsm, key, 1);
+		}
+
+		data->in_apn = FALSE;
+	} else if (g_str_equal(element_name, "gsm"))
+		data->in_gsm = FALSE;
+	else if (g_str_equal(element_name, "cdma"))
+		data->in_cdma = FALSE;
+	else if (g_str_equal(element_name, "provider")) {
+		for (i = 0; i < data->sids->len; i++) {
+			sid = &g_array_index(data->sids,
+						struct mbpi_index_cdma, i);
+			sid->name = data->provider_name;
+			sid->seq = data->cdma->len;
+			g_array_append_vals(data->cdma, sid, 1);
+		}
+
+		data->in_provider = FALSE;
+	}
+}
+
+static void compile_text(GMarkupParseContext *context,
+				const gchar *text, gsize text_len,
+				gpointer userdata, GError **error)
+{
+	struct compile_data *data = userdata;
+
+	if (data->text)
+		*data->text = compile_string(data, text, text_len);
+}
+
+static const GMarkupParser compile_parser = {
+	compile_start,
+	compile_end,
+	compile_text,
+	NULL,
+	NULL,
+};
+
+static int compare_gsm(const void *a, const void *b)
+{
+	const struct mbpi_index_gsm *key1 = a;
+	const struct mbpi_index_gsm *key2 = b;
+	int r;
+
+	r = memcmp(key1->mcc, key2->mcc, sizeof(key1->mcc) +
+						sizeof(key1->mnc));
+	if (r)
+		return r;
+
+	return key1->seq < key2->seq ? -1 : key1->seq > key2->seq;
+}
+
+static int compare_cdma(const void *a, const void *b)
+{
+	const struct mbpi_index_cdma *key1 = a;
+	const struct mbpi_index_cdma *key2 = b;
+	int r;
+
+	r = memcmp(key1->sid, key2->sid, sizeof(key1->sid));
+	if (r)
+		return r;
+
+	return key1->seq < key2->seq ? -1 : key1->seq > key2->seq;
+}
+
+static void append_table(GString *index, uint32_t *offset, GArray *table,
+				size_t size)
+{
+	*offset = index->len;
+	g_string_append_len(index, table->data, table->len * size);
+}
+
+/* Runs the whole database through the parser once, to build the index */
+static GString *mbpi_compile(const struct stat *st, GError **error)
+{
+	struct compile_data data;
+	struct mbpi_index_header header;
+	GString *index = NULL;
+	GArray *cdma;
+	guint i;
+
+	memset(&data, 0, sizeof(data));
+	data.gsm = g_array_new(FALSE, FALSE, sizeof(struct mbpi_index_gsm));
+	data.apns = g_array_new(FALSE, FALSE, sizeof(struct mbpi_index_apn));
+	data.cdma = g_array_new(FALSE, FALSE, sizeof(struct mbpi_index_cdma));
+	data.network_ids = g_array_new(FALSE, FALSE,
+					sizeof(struct mbpi_index_gsm));
+	data.sids = g_array_new(FALSE, FALSE, sizeof(struct mbpi_index_cdma));
+	data.strings = g_string_new(NULL);
+	g_string_append_c(data.strings, '\0');
+
+	if (mbpi_parse(&compile_parser, &data, error) == FALSE)
+		goto out;
+
+	qsort(data.gsm->data, data.gsm->len, sizeof(struct mbpi_index_gsm),
+		compare_gsm);
+	qsort(data.cdma->data, data.cdma->len,
+		sizeof(struct mbpi_index_cdma), compare_cdma);
+
+	/* Only the first provider with a given SID is ever returned */
+	cdma = g_array_new(FALSE, FALSE, sizeof(struct mbpi_index_cdma));
+
+	for (i = 0; i < data.cdma->len; i++) {
+		struct mbpi_index_cdma *key = &g_array_index(data.cdma,
+						struct mbpi_index_cdma, i);
+
+		if (i > 0 && memcmp(key->sid, (key - 1)->sid,
+						sizeof(key->sid)) == 0)
+			continue;
+
+		g_array_append_vals(cdma, key, 1);
+	}
+
+	g_array_free(data.cdma, TRUE);
+	data.cdma = cdma;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MBPI_INDEX_MAGIC, sizeof(MBPI_INDEX_MAGIC));
+	header.version = MBPI_INDEX_VERSION;
+	header.db_mtime = st->st_mtim.tv_sec;
+	header.db_mtime_nsec = st->st_mtim.tv_nsec;
+	header.db_size = st->st_size;
+	header.db_ino = st->st_ino;
+	header.num_gsm = data.gsm->len;
+	header.num_apns = data.apns->len;
+	header.num_cdma = data.cdma->len;
+
+	index = g_string_sized_new(sizeof(header) + data.strings->len +
+			data.gsm->len * sizeof(struct mbpi_index_gsm) +
+			data.apns->len * sizeof(struct mbpi_index_apn) +
+			data.cdma->len * sizeof(struct mbpi_index_cdma));
+
+	g_string_append_len(index, (const char *) &header, sizeof(header));
+	append_table(index, &header.gsm_offset, data.gsm,
+			sizeof(struct mbpi_index_gsm));
+	append_table(index, &header.apn_offset, data.apns,
+			sizeof(struct mbpi_index_apn));
+	append_table(index, &header.cdma_offset, data.cdma,
+			sizeof(struct mbpi_index_cdma));
+
+	header.strings_offset = index->len;
+	header.strings_size = data.strings->len;
+	g_string_append_len(index, data.strings->str, data.strings->len);
+
+	header.size = index->len;
+	memcpy(index->str, &header, sizeof(header));
+
+out:
+	g_array_free(data.gsm, TRUE);
+	g_array_free(data.apns, TRUE);
+	g_array_free(data.cdma, TRUE);
+	g_array_free(data.network_ids, TRUE);
+	g_array_free(data.sids, TRUE);
+	g_string_free(data.strings, TRUE);
+
+	return index;
+}
+
+static const struct mbpi_index_header *index_header(void)
+{
+	return (const struct mbpi_index_header *) mbpi_index.data;
+}
+
+static gboolean index_valid(const char *data, size_t size,
+				const struct stat *st)
+{
+	const struct mbpi_index_header *header = (const void *) data;
+
+	if (size < sizeof(*header))
+		return FALSE;
+
+	if (memcmp(header->magic, MBPI_INDEX_MAGIC,
+					sizeof(MBPI_INDEX_MAGIC)) != 0)
+		return FALSE;
+
+	if (header->version != MBPI_INDEX_VERSION || header->size != size)
+		return FALSE;
+
+	if (header->db_mtime != st->st_mtim.tv_sec ||
+			header->db_mtime_nsec != st->st_mtim.tv_nsec ||
+			header->db_size != st->st_size ||
+			header->db_ino != st->st_ino)
+		return FALSE;
+
+	if (header->gsm_offset + (uint64_t) header->num_gsm *
+			sizeof(struct mbpi_index_gsm) > size)
+		return FALSE;
+
+	if (header->apn_offset + (uint64_t) header->num_apns *
+			sizeof(struct mbpi_index_apn) > size)
+		return FALSE;
+
+	if (header->cdma_offset + (uint64_t) header->num_cdma *
+			sizeof(struct mbpi_index_cdma) > size)
+		return FALSE;
+
+	/* The string table must be terminated, lookups rely on it */
+	if (header->strings_size == 0 || (uint64_t) header->strings_offset +
+			header->strings_size > size ||
+			data[header->strings_offset +
+				header->strings_size - 1] != '\0')
+		return FALSE;
+
+	return TRUE;
+}
+
+static void index_close(void)
+{
+	if (mbpi_index.data == NULL)
+		return;
+
+	if (mbpi_index.mapped)
+		munmap(mbpi_index.data, mbpi_index.size);
+	else
+		g_free(mbpi_index.data);
+
+	mbpi_index.data = NULL;
+	mbpi_index.size = 0;
+}
+
+static gboolean index_map(const struct stat *db_st)
+{
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open(index_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return FALSE;
+
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return FALSE;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return FALSE;
+
+	if (index_valid(data, st.st_size, db_st) == FALSE) {
+		munmap(data, st.st_size);
+		return FALSE;
+	}
+
+	mbpi_index.data = data;
+	mbpi_index.size = st.st_size;
+	mbpi_index.mapped = TRUE;
+
+	return TRUE;
+}
+
+/*
+ * Makes sure the index matches the current database, compiling it when
+ * the database changed.  Returns FALSE if the XML has to be parsed, the
+ * lookup then reports the same errors it always did.
+ */
+static gboolean index_open(void)
+{
+	static struct stat failed_st;
+	struct stat st;
+	GString *index;
+
+	if (index_path == NULL)
+		return FALSE;
+
+	if (stat(MBPI_DATABASE, &st) < 0) {
+		index_close();
+		return FALSE;
+	}
+
+	if (mbpi_index.data && index_valid(mbpi_index.data,
+						mbpi_index.size, &st))
+		return TRUE;
+
+	index_close();
+
+	if (index_map(&st) == TRUE)
+		return TRUE;
+
+	/* Don't parse a broken database twice for each lookup */
+	if (failed_st.st_ino == st.st_ino &&
+			failed_st.st_size == st.st_size &&
+			failed_st.st_mtim.tv_sec == st.st_mtim.tv_sec &&
+			failed_st.st_mtim.tv_nsec == st.st_mtim.tv_nsec)
+		return FALSE;
+
+	index = mbpi_compile(&st, NULL);
+	if (index == NULL) {
+		failed_st = st;
+		return FALSE;
+	}
+
+	if (g_file_set_contents(index_path, index->str, index->len, NULL) &&
+			index_map(&st) == TRUE) {
+		g_string_free(index, TRUE);
+		return TRUE;
+	}
+
+	/* Not writable, keep the index for the lifetime of the process */
+	mbpi_index.size = index->len;
+	mbpi_index.data = g_string_free(index, FALSE);
+	mbpi_index.mapped = FALSE;
+
+	return TRUE;
+}
+
+static char *index_string(uint32_t offset)
+{
+	const struct mbpi_index_header *header = index_header();
+
+	if (offset == 0 || offset >= header->strings_size)
+		return NULL;
+
+	return g_strdup(mbpi_index.data + header->strings_offset + offset);
+}
+
+static gboolean index_lookup_apn(const char *mcc, const char *mnc,
+					gboolean allow_duplicates,
+					GSList **apns, GError **error)
+{
+	const struct mbpi_index_header *header = index_header();
+	const struct mbpi_index_gsm *gsm = (const void *)
+				(mbpi_index.data + header->gsm_offset);
+	const struct mbpi_index_apn *table = (const void *)
+				(mbpi_index.data + header->apn_offset);
+	struct mbpi_index_gsm key;
+	uint32_t lo = 0;
+	uint32_t hi = header->num_gsm;
+	uint32_t mid;
+
+	if (strlen(mcc) >= sizeof(key.mcc) || strlen(mnc) >= sizeof(key.mnc))
+		return TRUE;
+
+	memset(&key, 0, sizeof(key));
+	strcpy(key.mcc, mcc);
+	strcpy(key.mnc, mnc);
+
+	/* Find the first entry for the network */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+
+		if (memcmp(gsm[mid].mcc, key.mcc, sizeof(key.mcc) +
+						sizeof(key.mnc)) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo < header->num_gsm; lo++) {
+		const struct mbpi_index_apn *entry;
+		struct ofono_gprs_provision_data *ap;
+		GSList *l;
+
+		if (memcmp(gsm[lo].mcc, key.mcc, sizeof(key.mcc) +
+						sizeof(key.mnc)) != 0)
+			break;
+
+		if (gsm[lo].apn >= header->num_apns)
+			break;
+
+		entry = &table[gsm[lo].apn];
+
+		for (l = *apns; l && allow_duplicates == FALSE; l = l->next) {
+			struct ofono_gprs_provision_data *pd = l->data;
+
+			if (pd->type != entry->type)
+				continue;
+
+			g_set_error(error, mbpi_error_quark(),
+					MBPI_ERROR_DUPLICATE,
+					"%s:%d Duplicate context detected",
+					MBPI_DATABASE, entry->line);
+			return FALSE;
+		}
+
+		ap = g_new0(struct ofono_gprs_provision_data, 1);
+		ap->type = entry->type;
+		ap->proto = OFONO_GPRS_PROTO_IP;
+		ap->name = index_string(entry->name);
+		ap->apn = index_string(entry->apn);
+		ap->username = index_string(entry->username);
+		ap->password = index_string(entry->password);
+
+		*apns = g_slist_append(*apns, ap);
+	}
+
+	return TRUE;
+}
+
+static char *index_lookup_cdma(const char *sid)
+{
+	const struct mbpi_index_header *header = index_header();
+	const struct mbpi_index_cdma *cdma = (const void *)
+				(mbpi_index.data + header->cdma_offset);
+	struct mbpi_index_cdma key;
+	uint32_t lo = 0;
+	uint32_t hi = header->num_cdma;
+	uint32_t mid;
+	int r;
+
+	if (strlen(sid) >= sizeof(key.sid))
+		return NULL;
+
+	memset(&key, 0, sizeof(key));
+	strcpy(key.sid, sid);
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		r = memcmp(cdma[mid].sid, key.sid, sizeof(key.sid));
+
+		if (r == 0)
+			return index_string(cdma[mid].name);
+
+		if (r < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+void mbpi_set_index(const char *path)
+{
+	index_close();
+	index_path = path;
+}
+
 GSList *mbpi_lookup_apn(const char *mcc, const char *mnc,
 			gboolean allow_duplicates, GError **error)
 {
 	struct gsm_data gsm;
 	GSList *l;
 
+	if (index_open() == TRUE) {
+		GSList *apns = NULL;
+
+		if (index_lookup_apn(mcc, mnc, allow_duplicates,
+						&apns, error) == TRUE)
+			return apns;
+
+		g_slist_free_full(apns, (GDestroyNotify) mbpi_ap_free);
+		return NULL;
+	}
+
 	memset(&gsm, 0, sizeof(gsm));
 	gsm.match_mcc = mcc;
 	gsm.match_mnc = mnc;
@@ -590,6 +1302,9 @@ char *mbpi_lookup_cdma_provider_name(const char *sid, GError **error)
 {
 	struct cdma_data cdma;
 
+	if (index_open() == TRUE)
+		return index_lookup_cdma(sid);
+
 	memset(&cdma, 0, sizeof(cdma));
 	cdma.match_sid = sid;
 
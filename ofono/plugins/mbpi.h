@@ -27,3 +27,9 @@ GSList *mbpi_lookup_apn(const char *mcc, const char *mnc,
 			gboolean allow_duplicates, GError **error);
 
 char *mbpi_lookup_cdma_provider_name(const char *sid, GError **error);
+
+/*
+ * Lookups use a compiled index of the database, stored at path.  It is
+ * rebuilt whenever the database changes.  NULL parses the XML instead.
+ */
+void mbpi_set_index(const char *path);
@@ -0,0 +1,276 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gatchat.h>
+#include <gattty.h>
+
+#define OFONO_API_SUBJECT_TO_CHANGE
+#include <ofono/plugin.h>
+#include <ofono/log.h>
+#include <ofono/modem.h>
+#include <ofono/devinfo.h>
+#include <ofono/sim.h>
+#include <ofono/sms.h>
+#include <ofono/netreg.h>
+
+#include <drivers/atmodem/atutil.h>
+
+#include "ofono.h"
+
+/* Created by tools/modem-bench, see modem-sim.h */
+#define MODEMBENCH_TTY		"/tmp/ofono-modembench"
+#define MODEMBENCH_QMI		"/tmp/ofono-modembench-qmi"
+
+static struct ofono_modem *modembench;
+static struct ofono_modem *qmibench;
+static guint qmi_source;
+
+static const char *none_prefix[] = { NULL };
+
+struct modembench_data {
+	GAtChat *chat;
+};
+
+static int modembench_probe(struct ofono_modem *modem)
+{
+	struct modembench_data *data;
+
+	DBG("%p", modem);
+
+	data = g_try_new0(struct modembench_data, 1);
+	if (data == NULL)
+		return -ENOMEM;
+
+	ofono_modem_set_data(modem, data);
+
+	return 0;
+}
+
+static void modembench_remove(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+
+	DBG("%p", modem);
+
+	g_free(data);
+	ofono_modem_set_data(modem, NULL);
+}
+
+static void modembench_debug(const char *str, void *prefix)
+{
+	ofono_info("%s%s", (const char *) prefix, str);
+}
+
+static void modembench_disconnected(gpointer user_data)
+{
+	struct ofono_modem *modem = user_data;
+	struct modembench_data *data = ofono_modem_get_data(modem);
+
+	DBG("");
+
+	ofono_modem_set_powered(modem, FALSE);
+
+	g_at_chat_unref(data->chat);
+	data->chat = NULL;
+}
+
+static int modembench_enable(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+	GIOChannel *io;
+	GAtSyntax *syntax;
+
+	DBG("%p", modem);
+
+	io = g_at_tty_open(MODEMBENCH_TTY, NULL);
+	if (io == NULL)
+		return -EIO;
+
+	syntax = g_at_syntax_new_gsmv1();
+	data->chat = g_at_chat_new(io, syntax);
+	g_at_syntax_unref(syntax);
+	g_io_channel_unref(io);
+
+	if (data->chat == NULL)
+		return -ENOMEM;
+
+	if (getenv("OFONO_AT_DEBUG"))
+		g_at_chat_set_debug(data->chat, modembench_debug, "");
+
+	g_at_chat_set_disconnect_function(data->chat,
+						modembench_disconnected, modem);
+
+	g_at_chat_send(data->chat, "ATE0 +CMEE=1", none_prefix,
+						NULL, NULL, NULL);
+
+	return 0;
+}
+
+static void set_online_cb(gboolean ok, GAtResult *result, gpointer user_data)
+{
+	struct cb_data *cbd = user_data;
+	ofono_modem_online_cb_t callback = cbd->cb;
+	struct ofono_error error;
+
+	decode_at_error(&error, g_at_result_final_response(result));
+
+	callback(&error, cbd->data);
+}
+
+static void modembench_set_online(struct ofono_modem *modem,
+				ofono_bool_t online,
+				ofono_modem_online_cb_t cb, void *user_data)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+	struct cb_data *cbd = cb_data_new(cb, user_data);
+	char buf[64];
+
+	DBG("%p", modem);
+
+	snprintf(buf, sizeof(buf), "AT+CFUN=%d", online ? 1 : 4);
+
+	if (g_at_chat_send(data->chat, buf, none_prefix,
+				set_online_cb, cbd, g_free) > 0)
+		return;
+
+	CALLBACK_WITH_FAILURE(cb, user_data);
+}
+
+static int modembench_disable(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+
+	DBG("%p", modem);
+
+	g_at_chat_unref(data->chat);
+	data->chat = NULL;
+
+	return 0;
+}
+
+static void modembench_pre_sim(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+	struct ofono_sim *sim;
+
+	DBG("%p", modem);
+
+	ofono_devinfo_create(modem, 0, "atmodem", data->chat);
+	sim = ofono_sim_create(modem, 0, "atmodem", data->chat);
+
+	if (sim)
+		ofono_sim_inserted_notify(sim, TRUE);
+}
+
+static void modembench_post_sim(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+
+	DBG("%p", modem);
+
+	ofono_sms_create(modem, 0, "atmodem", data->chat);
+}
+
+static void modembench_post_online(struct ofono_modem *modem)
+{
+	struct modembench_data *data = ofono_modem_get_data(modem);
+
+	DBG("%p", modem);
+
+	ofono_netreg_create(modem, 0, "atmodem", data->chat);
+}
+
+static struct ofono_modem_driver modembench_driver = {
+	.modem_type	= OFONO_MODEM_TYPE_TEST,
+	.name		= "modembench",
+	.probe		= modembench_probe,
+	.remove		= modembench_remove,
+	.enable		= modembench_enable,
+	.disable	= modembench_disable,
+	.set_online	= modembench_set_online,
+	.pre_sim	= modembench_pre_sim,
+	.post_sim	= modembench_post_sim,
+	.post_online	= modembench_post_online,
+};
+
+/*
+ * A QMI session replayed by modem-bench is driven through the gobi driver,
+ * as if udev had found the device.  Wait until all plugins are up.
+ */
+static gboolean create_qmibench(gpointer user_data)
+{
+	qmi_source = 0;
+
+	if (g_file_test(MODEMBENCH_QMI, G_FILE_TEST_EXISTS) == FALSE)
+		return FALSE;
+
+	qmibench = ofono_modem_create("qmibench", "gobi");
+	if (qmibench == NULL)
+		return FALSE;
+
+	ofono_modem_set_string(qmibench, "Device", MODEMBENCH_QMI);
+
+	if (ofono_modem_register(qmibench) < 0) {
+		ofono_modem_remove(qmibench);
+		qmibench = NULL;
+	}
+
+	return FALSE;
+}
+
+static int modembench_init(void)
+{
+	int err;
+
+	err = ofono_modem_driver_register(&modembench_driver);
+	if (err < 0)
+		return err;
+
+	modembench = ofono_modem_create("modembench", "modembench");
+	ofono_modem_register(modembench);
+
+	qmi_source = g_idle_add(create_qmibench, NULL);
+
+	return 0;
+}
+
+static void modembench_exit(void)
+{
+	if (qmi_source)
+		g_source_remove(qmi_source);
+
+	if (qmibench)
+		ofono_modem_remove(qmibench);
+
+	ofono_modem_remove(modembench);
+	ofono_modem_driver_unregister(&modembench_driver);
+}
+
+OFONO_PLUGIN_DEFINE(modembench, "Modem benchmark driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, modembench_init, modembench_exit)
@@ -282,5 +282,5 @@ static void nokia_exit(void)
 	ofono_modem_driver_unregister(&nokia_driver);
 }
 
-OFONO_PLUGIN_DEFINE(nokia, "Nokia Datacard modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, nokia_init, nokia_exit)
+OFONO_MODEM_PLUGIN_DEFINE(nokia, "Nokia Datacard modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, nokia_init, nokia_exit, "nokia")
@@ -273,5 +273,6 @@ static void sierra_exit(void)
 	ofono_modem_driver_unregister(&sierra_driver);
 }
 
-OFONO_PLUGIN_DEFINE(sierra, "Sierra Wireless modem driver", VERSION,
-			OFONO_PLUGIN_PRIORITY_DEFAULT, sierra_init, sierra_exit)
+OFONO_MODEM_PLUGIN_DEFINE(sierra, "Sierra Wireless modem driver", VERSION,
+			OFONO_PLUGIN_PRIORITY_DEFAULT, sierra_init, sierra_exit,
+			"sierra")
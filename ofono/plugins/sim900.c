@@ -237,7 +237,8 @@ static void sim900_post_online(struct ofono_modem *modem)
 
 	ofono_netreg_create(modem, OFONO_VENDOR_SIMCOM, "atmodem", data->modem);
 	ofono_ussd_create(modem, 0, "atmodem", data->modem);
-	ofono_voicecall_create(modem, 0, "atmodem", data->modem);
+	ofono_voicecall_create(modem, OFONO_VENDOR_SIMCOM, "atmodem",
+							data->modem);
 }
 
 static struct ofono_modem_driver sim900_driver = {
@@ -261,5 +262,6 @@ static void sim900_exit(void)
 	ofono_modem_driver_unregister(&sim900_driver);
 }
 
-OFONO_PLUGIN_DEFINE(sim900, "SIM900 modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, sim900_init, sim900_exit)
+OFONO_MODEM_PLUGIN_DEFINE(sim900, "SIM900 modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, sim900_init, sim900_exit,
+		"sim900")
@@ -420,5 +420,6 @@ static void speedup_exit(void)
 	ofono_modem_driver_unregister(&speedup_driver);
 }
 
-OFONO_PLUGIN_DEFINE(speedup, "Speed Up modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, speedup_init, speedup_exit)
+OFONO_MODEM_PLUGIN_DEFINE(speedup, "Speed Up modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, speedup_init, speedup_exit,
+		"speedup")
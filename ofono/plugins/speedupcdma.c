@@ -242,6 +242,7 @@ static void speedupcdma_exit(void)
 	ofono_modem_driver_unregister(&speedupcdma_driver);
 }
 
-OFONO_PLUGIN_DEFINE(speedupcdma, "Speed Up CDMA modem driver", VERSION,
+OFONO_MODEM_PLUGIN_DEFINE(speedupcdma, "Speed Up CDMA modem driver", VERSION,
 				OFONO_PLUGIN_PRIORITY_DEFAULT,
-				speedupcdma_init, speedupcdma_exit)
+				speedupcdma_init, speedupcdma_exit,
+				"speedupcdma")
@@ -287,7 +287,7 @@ static void get_modems(void)
 
 	dbus_message_set_auto_start(message, FALSE);
 
-	if (!dbus_connection_send_with_reply(connection, message, &call,
+	if (!g_dbus_send_message_with_reply(connection, message, &call,
 						GET_MODEMS_TIMEOUT)) {
 		ofono_error("Sending D-Bus message failed");
 		goto error;
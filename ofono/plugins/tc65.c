@@ -241,5 +241,5 @@ static void tc65_exit(void)
 	ofono_modem_driver_unregister(&tc65_driver);
 }
 
-OFONO_PLUGIN_DEFINE(tc65, "Cinterion TC65 driver plugin", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, tc65_init, tc65_exit)
+OFONO_MODEM_PLUGIN_DEFINE(tc65, "Cinterion TC65 driver plugin", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, tc65_init, tc65_exit, "tc65")
@@ -555,7 +555,8 @@ static void telit_pre_sim(struct ofono_modem *modem)
 	ofono_devinfo_create(modem, 0, "atmodem", data->chat);
 	data->sim = ofono_sim_create(modem, OFONO_VENDOR_TELIT, "atmodem",
 					data->chat);
-	ofono_voicecall_create(modem, 0, "atmodem", data->chat);
+	ofono_voicecall_create(modem, OFONO_VENDOR_TELIT, "atmodem",
+							data->chat);
 }
 
 static void telit_post_sim(struct ofono_modem *modem)
@@ -688,5 +689,5 @@ static void telit_exit(void)
 	ofono_modem_driver_unregister(&telit_driver);
 }
 
-OFONO_PLUGIN_DEFINE(telit, "telit driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, telit_init, telit_exit)
+OFONO_MODEM_PLUGIN_DEFINE(telit, "telit driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, telit_init, telit_exit, "telit")
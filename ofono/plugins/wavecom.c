@@ -202,5 +202,6 @@ static void wavecom_exit(void)
 	ofono_modem_driver_unregister(&wavecom_driver);
 }
 
-OFONO_PLUGIN_DEFINE(wavecom, "Wavecom driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, wavecom_init, wavecom_exit)
+OFONO_MODEM_PLUGIN_DEFINE(wavecom, "Wavecom driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, wavecom_init, wavecom_exit,
+		"wavecom")
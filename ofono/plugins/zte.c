@@ -401,5 +401,5 @@ static void zte_exit(void)
 	ofono_modem_driver_unregister(&zte_driver);
 }
 
-OFONO_PLUGIN_DEFINE(zte, "ZTE modem driver", VERSION,
-		OFONO_PLUGIN_PRIORITY_DEFAULT, zte_init, zte_exit)
+OFONO_MODEM_PLUGIN_DEFINE(zte, "ZTE modem driver", VERSION,
+		OFONO_PLUGIN_PRIORITY_DEFAULT, zte_init, zte_exit, "zte")
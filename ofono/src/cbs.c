@@ -978,16 +978,26 @@ out:
 	return FALSE;
 }
 
-static void cbs_location_changed(int status, int lac, int ci, int tech,
-					const char *mcc, const char *mnc,
+static void cbs_location_changed(const struct ofono_netreg_update *update,
 					void *data)
 {
 	struct ofono_cbs *cbs = data;
+	const char *mcc = update->mcc;
+	const char *mnc = update->mnc;
+	int lac = update->lac;
+	int ci = update->ci;
 	gboolean plmn_changed = FALSE;
 	gboolean lac_changed = FALSE;
 	gboolean ci_changed = FALSE;
 
-	DBG("%d, %d, %d, %d, %s%s", status, lac, ci, tech, mcc, mnc);
+	if (!(update->changed & (OFONO_NETREG_UPDATE_STATUS |
+					OFONO_NETREG_UPDATE_LOCATION |
+					OFONO_NETREG_UPDATE_CELLID |
+					OFONO_NETREG_UPDATE_OPERATOR)))
+		return;
+
+	DBG("%d, %d, %d, %d, %s%s", update->status, lac, ci, update->tech,
+								mcc, mnc);
 
 	if (mcc == NULL || mnc == NULL) {
 		if (cbs->mcc[0] == '\0' && cbs->mnc[0] == '\0')
@@ -28,9 +28,6 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
-#include <net/if.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -76,39 +73,16 @@ static void cdma_connman_settings_free(struct cdma_connman_settings *settings)
 
 static void cdma_connman_ifupdown(const char *interface, ofono_bool_t active)
 {
-	struct ifreq ifr;
-	int sk;
+	struct ofono_rtnl_batch *batch;
 
 	DBG("");
 
-	if (interface == NULL)
+	batch = __ofono_rtnl_batch_new(interface);
+	if (batch == NULL)
 		return;
 
-	sk = socket(PF_INET, SOCK_DGRAM, 0);
-	if (sk < 0)
-		return;
-
-	memset(&ifr, 0, sizeof(ifr));
-	strncpy(ifr.ifr_name, interface, IFNAMSIZ);
-
-	if (ioctl(sk, SIOCGIFFLAGS, &ifr) < 0)
-		goto done;
-
-	if (active == TRUE) {
-		if (ifr.ifr_flags & IFF_UP)
-			goto done;
-		ifr.ifr_flags |= IFF_UP;
-	} else {
-		if (!(ifr.ifr_flags & IFF_UP))
-			goto done;
-		ifr.ifr_flags &= ~IFF_UP;
-	}
-
-	if (ioctl(sk, SIOCSIFFLAGS, &ifr) < 0)
-		ofono_error("Failed to change interface flags");
-
-done:
-	close(sk);
+	__ofono_rtnl_batch_set_link(batch, active, 0);
+	__ofono_rtnl_batch_commit(batch);
 }
 
 static void cdma_connman_settings_append_variant(
@@ -187,6 +187,9 @@ static gboolean cdma_sms_decode_teleservice(const guint8 *buf, guint8 len,
 {
 	enum cdma_sms_teleservice_id *id = data;
 
+	if (len != 2)
+		return FALSE;
+
 	*id = bit_field_unpack(buf, 0, 8) << 8 |
 				bit_field_unpack(buf, 8, 8);
 
@@ -215,6 +218,10 @@ static gboolean cdma_sms_decode_addr(const guint8 *buf, guint8 len,
 	guint16 total_num_bits = len * 8;
 	guint8  index;
 
+	/* The digit and number modes and the number type are in octet 0 */
+	if (len == 0)
+		return FALSE;
+
 	addr->digit_mode = bit_field_unpack(buf, bit_offset, 1);
 	bit_offset += 1;
 
@@ -718,6 +725,9 @@ static gboolean cdma_sms_p2p_decode(const guint8 *pdu, guint8 len,
 gboolean cdma_sms_decode(const guint8 *pdu, guint8 len,
 				struct cdma_sms *incoming)
 {
+	if (len == 0)
+		return FALSE;
+
 	incoming->type = bit_field_unpack(pdu, 0, 8);
 	pdu += 1;
 	len -= 1;
@@ -32,6 +32,24 @@
 
 static DBusConnection *g_connection;
 
+/*
+ * PropertyChanged signals are queued and sent once per main loop
+ * iteration; a property changing again before that only replaces the
+ * queued value.  GetProperties replies may be cached until the next
+ * change of the interface.
+ */
+struct pending_signal {
+	DBusConnection *conn;
+	char *key;
+	DBusMessage *signal;
+	GList link;
+};
+
+static GHashTable *pending_signals;
+static GQueue pending_order = G_QUEUE_INIT;
+static guint pending_source;
+static GHashTable *properties_cache;
+
 struct error_mapping_entry {
 	int error;
 	DBusMessage *(*ofono_error_func)(DBusMessage *);
@@ -196,6 +214,109 @@ void ofono_dbus_dict_append_dict(DBusMessageIter *dict, const char *key,
 	dbus_message_iter_close_container(dict, &entry);
 }
 
+static char *properties_key(const char *path, const char *interface)
+{
+	return g_strconcat(path, " ", interface, NULL);
+}
+
+static void pending_signal_free(struct pending_signal *pending)
+{
+	if (pending->signal != NULL)
+		dbus_message_unref(pending->signal);
+
+	g_free(pending->key);
+	g_free(pending);
+}
+
+static void flush_pending_signals(DBusConnection *conn)
+{
+	GList *l = pending_order.head;
+
+	if (l == NULL)
+		return;
+
+	/* Sending calls back into here, so detach the queue first */
+	g_queue_init(&pending_order);
+	g_hash_table_remove_all(pending_signals);
+
+	if (pending_source > 0) {
+		g_source_remove(pending_source);
+		pending_source = 0;
+	}
+
+	while (l) {
+		struct pending_signal *pending = l->data;
+
+		l = l->next;
+
+		g_dbus_send_message(pending->conn, pending->signal);
+		pending->signal = NULL;
+
+		pending_signal_free(pending);
+	}
+}
+
+static gboolean pending_signals_idle(gpointer user_data)
+{
+	pending_source = 0;
+
+	flush_pending_signals(NULL);
+
+	return FALSE;
+}
+
+static int queue_property_changed(DBusConnection *conn, const char *path,
+					const char *interface,
+					const char *name, DBusMessage *signal)
+{
+	struct pending_signal *pending;
+	char *key;
+
+	if (properties_cache != NULL) {
+		key = properties_key(path, interface);
+		g_hash_table_remove(properties_cache, key);
+		g_free(key);
+	}
+
+	if (pending_signals == NULL)
+		return g_dbus_send_message(conn, signal);
+
+	key = g_strconcat(path, " ", interface, " ", name, NULL);
+
+	/*
+	 * A replaced value moves to the tail, so that it is not sent ahead
+	 * of changes that were queued after the value it replaces.
+	 */
+	pending = g_hash_table_lookup(pending_signals, key);
+	if (pending != NULL) {
+		dbus_message_unref(pending->signal);
+		pending->signal = signal;
+		g_free(key);
+
+		g_queue_unlink(&pending_order, &pending->link);
+		g_queue_push_tail_link(&pending_order, &pending->link);
+
+		return TRUE;
+	}
+
+	pending = g_new0(struct pending_signal, 1);
+	pending->conn = conn;
+	pending->key = key;
+	pending->signal = signal;
+	pending->link.data = pending;
+
+	g_hash_table_insert(pending_signals, pending->key, pending);
+	g_queue_push_tail_link(&pending_order, &pending->link);
+
+	/* Same priority as I/O, so a busy modem can not hold it back */
+	if (pending_source == 0)
+		pending_source = g_idle_add_full(G_PRIORITY_DEFAULT,
+						pending_signals_idle,
+						NULL, NULL);
+
+	return TRUE;
+}
+
 int ofono_dbus_signal_property_changed(DBusConnection *conn,
 					const char *path,
 					const char *interface,
@@ -218,7 +339,7 @@ int ofono_dbus_signal_property_changed(DBusConnection *conn,
 
 	append_variant(&iter, type, value);
 
-	return g_dbus_send_message(conn, signal);
+	return queue_property_changed(conn, path, interface, name, signal);
 }
 
 int ofono_dbus_signal_array_property_changed(DBusConnection *conn,
@@ -244,7 +365,7 @@ int ofono_dbus_signal_array_property_changed(DBusConnection *conn,
 
 	append_array_variant(&iter, type, value);
 
-	return g_dbus_send_message(conn, signal);
+	return queue_property_changed(conn, path, interface, name, signal);
 }
 
 int ofono_dbus_signal_dict_property_changed(DBusConnection *conn,
@@ -270,7 +391,7 @@ int ofono_dbus_signal_dict_property_changed(DBusConnection *conn,
 
 	append_dict_variant(&iter, type, value);
 
-	return g_dbus_send_message(conn, signal);
+	return queue_property_changed(conn, path, interface, name, signal);
 }
 
 DBusMessage *__ofono_error_invalid_args(DBusMessage *msg)
@@ -454,6 +575,58 @@ void __ofono_dbus_pending_reply(DBusMessage **msg, DBusMessage *reply)
 	*msg = NULL;
 }
 
+DBusMessage *__ofono_dbus_cached_properties(DBusMessage *msg,
+						const char *interface)
+{
+	DBusMessage *cached;
+	DBusMessage *reply;
+	char *key;
+
+	if (properties_cache == NULL)
+		return NULL;
+
+	key = properties_key(dbus_message_get_path(msg), interface);
+	cached = g_hash_table_lookup(properties_cache, key);
+	g_free(key);
+
+	if (cached == NULL)
+		return NULL;
+
+	/* A copy only needs to be readdressed, not serialized again */
+	reply = dbus_message_copy(cached);
+	if (reply == NULL)
+		return NULL;
+
+	dbus_message_set_reply_serial(reply, dbus_message_get_serial(msg));
+	dbus_message_set_destination(reply, dbus_message_get_sender(msg));
+
+	return reply;
+}
+
+void __ofono_dbus_cache_properties(DBusMessage *msg, const char *interface,
+					DBusMessage *reply)
+{
+	if (properties_cache == NULL || reply == NULL)
+		return;
+
+	g_hash_table_replace(properties_cache,
+			properties_key(dbus_message_get_path(msg), interface),
+			dbus_message_ref(reply));
+}
+
+void __ofono_dbus_invalidate_properties(const char *path,
+					const char *interface)
+{
+	char *key;
+
+	if (properties_cache == NULL)
+		return;
+
+	key = properties_key(path, interface);
+	g_hash_table_remove(properties_cache, key);
+	g_free(key);
+}
+
 gboolean __ofono_dbus_valid_object_path(const char *path)
 {
 	unsigned int i;
@@ -515,6 +688,13 @@ int __ofono_dbus_init(DBusConnection *conn)
 {
 	dbus_gsm_set_connection(conn);
 
+	pending_signals = g_hash_table_new(g_str_hash, g_str_equal);
+	properties_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+					g_free,
+					(GDestroyNotify) dbus_message_unref);
+
+	g_dbus_set_flush_function(flush_pending_signals);
+
 	return 0;
 }
 
@@ -522,6 +702,15 @@ void __ofono_dbus_cleanup(void)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
 
+	flush_pending_signals(conn);
+	g_dbus_set_flush_function(NULL);
+
+	g_hash_table_destroy(pending_signals);
+	pending_signals = NULL;
+
+	g_hash_table_destroy(properties_cache);
+	properties_cache = NULL;
+
 	if (conn == NULL || !dbus_connection_get_is_connected(conn))
 		return;
 
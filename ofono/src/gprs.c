@@ -28,12 +28,6 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
-#include <sys/ioctl.h>
-#include <sys/socket.h>
-#include <net/if.h>
-#include <net/route.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -57,6 +51,7 @@
 #define MAX_MESSAGE_CENTER_LENGTH 255
 #define MAX_CONTEXTS 256
 #define SUSPEND_TIMEOUT 8
+#define MAX_STATS_INTERVAL 86400
 
 /* 27.007 Section 7.29 */
 enum packet_bearer {
@@ -96,6 +91,11 @@ struct ofono_gprs {
 	void *driver_data;
 	struct ofono_atom *atom;
 	unsigned int spn_watch;
+	guint stats_source;
+	unsigned int stats_period;
+	gint64 lost_time;
+	gint64 registered_time;
+	gint64 reattached_time;
 };
 
 struct ipv4_settings {
@@ -124,14 +124,22 @@ struct ofono_gprs_context {
 	struct ofono_gprs *gprs;
 	enum ofono_gprs_context_type type;
 	ofono_bool_t inuse;
+	struct pri_context *waiting;
 	const struct ofono_gprs_context_driver *driver;
 	void *driver_data;
 	struct context_settings *settings;
 	struct ofono_atom *atom;
 };
 
+struct activation_batch {
+	DBusMessage *msg;
+	unsigned int outstanding;
+	unsigned int failed;
+};
+
 struct pri_context {
 	ofono_bool_t active;
+	ofono_bool_t deactivating;
 	enum ofono_gprs_context_type type;
 	char name[MAX_CONTEXT_NAME_LENGTH + 1];
 	char message_proxy[MAX_MESSAGE_PROXY_LENGTH + 1];
@@ -142,13 +150,24 @@ struct pri_context {
 	char *proxy_host;
 	uint16_t proxy_port;
 	DBusMessage *pending;
+	struct activation_batch *batch;
 	struct ofono_gprs_primary_context context;
 	struct ofono_gprs_context *context_driver;
 	struct ofono_gprs *gprs;
+	struct ofono_rtnl_stats stats_base;
+	struct ofono_rtnl_stats stats;
+	unsigned int stats_interval;
+	gint64 stats_due;
+	gint64 request_time;
+	unsigned int activation_time;
+	unsigned int deactivation_time;
 };
 
 static void gprs_netreg_update(struct ofono_gprs *gprs);
 static void gprs_deactivate_next(struct ofono_gprs *gprs);
+static void gprs_stats_schedule(struct ofono_gprs *gprs);
+static gboolean pri_activate(struct pri_context *ctx);
+static void pri_context_reply(struct pri_context *ctx, DBusMessage *reply);
 
 static GSList *g_drivers = NULL;
 static GSList *g_context_drivers = NULL;
@@ -274,6 +293,22 @@ static void gprs_cid_release(struct ofono_gprs *gprs, unsigned int id)
 	idmap_put(gprs->cid_map, id);
 }
 
+static gboolean context_driver_usable(struct ofono_gprs_context *gc,
+					struct pri_context *ctx)
+{
+	if (gc->driver == NULL)
+		return FALSE;
+
+	if (gc->driver->activate_primary == NULL ||
+			gc->driver->deactivate_primary == NULL)
+		return FALSE;
+
+	if (gc->type != OFONO_GPRS_CONTEXT_TYPE_ANY && gc->type != ctx->type)
+		return FALSE;
+
+	return TRUE;
+}
+
 static gboolean assign_context(struct pri_context *ctx)
 {
 	struct idmap *cidmap = ctx->gprs->cid_map;
@@ -292,15 +327,7 @@ static gboolean assign_context(struct pri_context *ctx)
 		if (gc->inuse == TRUE)
 			continue;
 
-		if (gc->driver == NULL)
-			continue;
-
-		if (gc->driver->activate_primary == NULL ||
-				gc->driver->deactivate_primary == NULL)
-			continue;
-
-		if (gc->type != OFONO_GPRS_CONTEXT_TYPE_ANY &&
-				gc->type != ctx->type)
+		if (context_driver_usable(gc, ctx) == FALSE)
 			continue;
 
 		ctx->context_driver = gc;
@@ -317,19 +344,87 @@ static gboolean assign_context(struct pri_context *ctx)
 		return TRUE;
 	}
 
+	gprs_cid_release(ctx->gprs, ctx->context.cid);
+	ctx->context.cid = 0;
+
+	return FALSE;
+}
+
+/*
+ * When every suitable context driver is taken, a request may wait for
+ * one whose context is already being deactivated instead of failing.
+ * Each driver holds at most one waiting context, since nothing else
+ * is guaranteed to free the driver a second time.
+ */
+static gboolean queue_context(struct pri_context *ctx)
+{
+	GSList *l;
+
+	for (l = ctx->gprs->contexts; l; l = l->next) {
+		struct pri_context *owner = l->data;
+		struct ofono_gprs_context *gc = owner->context_driver;
+
+		if (owner->deactivating == FALSE || gc == NULL)
+			continue;
+
+		if (gc->waiting != NULL)
+			continue;
+
+		if (context_driver_usable(gc, ctx) == FALSE)
+			continue;
+
+		DBG("%s waits for %s", ctx->path, owner->path);
+		gc->waiting = ctx;
+
+		return TRUE;
+	}
+
 	return FALSE;
 }
 
+static void fail_waiting_context(struct ofono_gprs_context *gc)
+{
+	struct pri_context *ctx = gc->waiting;
+
+	if (ctx == NULL)
+		return;
+
+	gc->waiting = NULL;
+	ctx->request_time = 0;
+	pri_context_reply(ctx, __ofono_error_failed(ctx->pending));
+}
+
 static void release_context(struct pri_context *ctx)
 {
+	struct ofono_gprs_context *gc;
+	struct pri_context *next;
+
 	if (ctx == NULL || ctx->gprs == NULL || ctx->context_driver == NULL)
 		return;
 
+	gc = ctx->context_driver;
+	next = gc->waiting;
+
 	gprs_cid_release(ctx->gprs, ctx->context.cid);
 	ctx->context.cid = 0;
-	ctx->context_driver->inuse = FALSE;
+	gc->inuse = FALSE;
+	gc->waiting = NULL;
 	ctx->context_driver = NULL;
 	ctx->active = FALSE;
+	ctx->deactivating = FALSE;
+	ctx->request_time = 0;
+
+	gprs_stats_schedule(ctx->gprs);
+
+	if (next == NULL)
+		return;
+
+	DBG("%s takes over from %s", next->path, ctx->path);
+
+	if (ctx->gprs->attached == FALSE || pri_activate(next) == FALSE) {
+		next->request_time = 0;
+		pri_context_reply(next, __ofono_error_failed(next->pending));
+	}
 }
 
 static struct pri_context *gprs_context_by_path(struct ofono_gprs *gprs,
@@ -559,6 +654,206 @@ static void pri_context_signal_settings(struct pri_context *ctx,
 				context_settings_append_ipv6);
 }
 
+static unsigned int pri_request_elapsed(struct pri_context *ctx)
+{
+	gint64 elapsed;
+
+	if (ctx->request_time == 0)
+		return 0;
+
+	elapsed = g_get_monotonic_time() - ctx->request_time;
+	ctx->request_time = 0;
+
+	/* Milliseconds, with 0 reserved for "not measured" */
+	return MAX(elapsed / 1000, 1);
+}
+
+static void pri_update_stats(struct pri_context *ctx, const char *interface)
+{
+	struct ofono_rtnl_stats now;
+	struct ofono_rtnl_stats *base = &ctx->stats_base;
+
+	if (__ofono_rtnl_get_stats(interface, &now) < 0)
+		return;
+
+	ctx->stats.rx_packets = now.rx_packets - base->rx_packets;
+	ctx->stats.tx_packets = now.tx_packets - base->tx_packets;
+	ctx->stats.rx_bytes = now.rx_bytes - base->rx_bytes;
+	ctx->stats.tx_bytes = now.tx_bytes - base->tx_bytes;
+	ctx->stats.rx_errors = now.rx_errors - base->rx_errors;
+	ctx->stats.tx_errors = now.tx_errors - base->tx_errors;
+	ctx->stats.rx_dropped = now.rx_dropped - base->rx_dropped;
+	ctx->stats.tx_dropped = now.tx_dropped - base->tx_dropped;
+}
+
+static void pri_reset_stats(struct pri_context *ctx, const char *interface)
+{
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+
+	/*
+	 * Interfaces such as usb0 outlive the context, so count from
+	 * whatever the link has seen up to now.
+	 */
+	if (__ofono_rtnl_get_stats(interface, &ctx->stats_base) < 0)
+		memset(&ctx->stats_base, 0, sizeof(ctx->stats_base));
+
+	ctx->stats_due = g_get_monotonic_time() +
+				(gint64) ctx->stats_interval * G_USEC_PER_SEC;
+}
+
+static void append_context_stats(struct pri_context *ctx,
+					DBusMessageIter *dict)
+{
+	ofono_dbus_dict_append(dict, "ReceivedBytes", DBUS_TYPE_UINT64,
+				&ctx->stats.rx_bytes);
+	ofono_dbus_dict_append(dict, "TransmittedBytes", DBUS_TYPE_UINT64,
+				&ctx->stats.tx_bytes);
+	ofono_dbus_dict_append(dict, "ReceivedPackets", DBUS_TYPE_UINT64,
+				&ctx->stats.rx_packets);
+	ofono_dbus_dict_append(dict, "TransmittedPackets", DBUS_TYPE_UINT64,
+				&ctx->stats.tx_packets);
+	ofono_dbus_dict_append(dict, "ReceiveErrors", DBUS_TYPE_UINT64,
+				&ctx->stats.rx_errors);
+	ofono_dbus_dict_append(dict, "TransmitErrors", DBUS_TYPE_UINT64,
+				&ctx->stats.tx_errors);
+	ofono_dbus_dict_append(dict, "ReceiveDropped", DBUS_TYPE_UINT64,
+				&ctx->stats.rx_dropped);
+	ofono_dbus_dict_append(dict, "TransmitDropped", DBUS_TYPE_UINT64,
+				&ctx->stats.tx_dropped);
+
+	if (ctx->activation_time)
+		ofono_dbus_dict_append(dict, "ActivationTime",
+					DBUS_TYPE_UINT32,
+					&ctx->activation_time);
+
+	if (ctx->deactivation_time)
+		ofono_dbus_dict_append(dict, "DeactivationTime",
+					DBUS_TYPE_UINT32,
+					&ctx->deactivation_time);
+}
+
+static void append_context_stats_dict(struct pri_context *ctx,
+					DBusMessageIter *dict)
+{
+	DBusMessageIter entry;
+	DBusMessageIter variant;
+	DBusMessageIter array;
+	const char *key = "Statistics";
+
+	dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY,
+						NULL, &entry);
+
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT,
+					"a" OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&variant);
+
+	dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&array);
+
+	append_context_stats(ctx, &array);
+
+	dbus_message_iter_close_container(&variant, &array);
+	dbus_message_iter_close_container(&entry, &variant);
+	dbus_message_iter_close_container(dict, &entry);
+}
+
+static void pri_signal_stats(struct pri_context *ctx)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	DBusMessage *signal;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+
+	signal = dbus_message_new_signal(ctx->path,
+					OFONO_CONNECTION_CONTEXT_INTERFACE,
+					"Statistics");
+	if (signal == NULL)
+		return;
+
+	dbus_message_iter_init_append(signal, &iter);
+
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+	append_context_stats(ctx, &dict);
+	dbus_message_iter_close_container(&iter, &dict);
+
+	g_dbus_send_message(conn, signal);
+}
+
+static gboolean gprs_stats_timeout(gpointer user_data)
+{
+	struct ofono_gprs *gprs = user_data;
+	gint64 now = g_get_monotonic_time();
+	struct context_settings *settings;
+	GSList *l;
+
+	for (l = gprs->contexts; l; l = l->next) {
+		struct pri_context *ctx = l->data;
+
+		if (ctx->active == FALSE || ctx->stats_interval == 0)
+			continue;
+
+		/* Allow for the slack of the coalesced second timer */
+		if (ctx->stats_due > now + G_USEC_PER_SEC / 2)
+			continue;
+
+		ctx->stats_due = now +
+				(gint64) ctx->stats_interval * G_USEC_PER_SEC;
+
+		settings = ctx->context_driver->settings;
+		pri_update_stats(ctx, settings->interface);
+		pri_signal_stats(ctx);
+	}
+
+	return TRUE;
+}
+
+/*
+ * All contexts of an atom share one timer.  It ticks at the greatest
+ * common divisor of the requested intervals, so that every context
+ * gets its signal on time and one wakeup serves all of them.
+ */
+static void gprs_stats_schedule(struct ofono_gprs *gprs)
+{
+	unsigned int period = 0;
+	GSList *l;
+
+	for (l = gprs->contexts; l; l = l->next) {
+		struct pri_context *ctx = l->data;
+		unsigned int a, b, t;
+
+		if (ctx->active == FALSE || ctx->stats_interval == 0)
+			continue;
+
+		for (a = period, b = ctx->stats_interval; b; a = b, b = t)
+			t = a % b;
+
+		period = a;
+	}
+
+	if (period == gprs->stats_period)
+		return;
+
+	DBG("statistics period %u", period);
+
+	if (gprs->stats_source) {
+		g_source_remove(gprs->stats_source);
+		gprs->stats_source = 0;
+	}
+
+	gprs->stats_period = period;
+
+	if (period == 0)
+		return;
+
+	gprs->stats_source = g_timeout_add_seconds(period,
+						gprs_stats_timeout, gprs);
+}
+
 static void pri_parse_proxy(struct pri_context *ctx, const char *proxy)
 {
 	char *scheme, *host, *port, *path;
@@ -606,127 +901,57 @@ static void pri_parse_proxy(struct pri_context *ctx, const char *proxy)
 	g_free(scheme);
 }
 
-static void pri_ifupdown(const char *interface, ofono_bool_t active)
+/*
+ * Link state, addresses and routes are queued up and applied to the
+ * interface in a single rtnetlink transaction.  Addresses are only
+ * managed for MMS contexts, where nobody else configures the interface.
+ */
+static void pri_ifupdown(const char *interface, ofono_bool_t active,
+				const struct context_settings *settings,
+				const char *proxy)
 {
-	struct ifreq ifr;
-	int sk;
-
-	if (interface == NULL)
-		return;
+	struct ofono_rtnl_batch *batch;
 
-	sk = socket(PF_INET, SOCK_DGRAM, 0);
-	if (sk < 0)
+	batch = __ofono_rtnl_batch_new(interface);
+	if (batch == NULL)
 		return;
 
-	memset(&ifr, 0, sizeof(ifr));
-	strncpy(ifr.ifr_name, interface, IFNAMSIZ);
+	if (active == TRUE)
+		__ofono_rtnl_batch_set_link(batch, TRUE, 0);
 
-	if (ioctl(sk, SIOCGIFFLAGS, &ifr) < 0)
-		goto done;
-
-	if (active == TRUE) {
-		if (ifr.ifr_flags & IFF_UP)
-			goto done;
-		ifr.ifr_flags |= IFF_UP;
-	} else {
-		if (!(ifr.ifr_flags & IFF_UP))
-			goto done;
-		ifr.ifr_flags &= ~IFF_UP;
+	if (settings && settings->ipv4 && settings->ipv4->ip) {
+		if (active == TRUE)
+			__ofono_rtnl_batch_add_address(batch,
+						settings->ipv4->ip, 32);
+		else
+			__ofono_rtnl_batch_del_address(batch,
+						settings->ipv4->ip, 32);
 	}
 
-	if (ioctl(sk, SIOCSIFFLAGS, &ifr) < 0)
-		ofono_error("Failed to change interface flags");
-
-done:
-	close(sk);
-}
-
-static void pri_set_ipv4_addr(const char *interface, const char *address)
-{
-	struct ifreq ifr;
-	struct sockaddr_in addr;
-	int sk;
-
-	if (interface == NULL)
-		return;
-
-	sk = socket(PF_INET, SOCK_DGRAM, 0);
-	if (sk < 0)
-		return;
-
-	memset(&ifr, 0, sizeof(ifr));
-	strncpy(ifr.ifr_name, interface, IFNAMSIZ);
-
-	if (ioctl(sk, SIOCGIFFLAGS, &ifr) < 0)
-		goto done;
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = address ? inet_addr(address) : INADDR_ANY;
-	memcpy(&ifr.ifr_addr, &addr, sizeof(ifr.ifr_addr));
-
-	if (ioctl(sk, SIOCSIFADDR, &ifr) < 0) {
-		ofono_error("Failed to set interface address");
-		goto done;
+	if (settings && settings->ipv6 && settings->ipv6->ip) {
+		if (active == TRUE)
+			__ofono_rtnl_batch_add_address(batch,
+						settings->ipv6->ip,
+						settings->ipv6->prefix_len);
+		else
+			__ofono_rtnl_batch_del_address(batch,
+						settings->ipv6->ip,
+						settings->ipv6->prefix_len);
 	}
 
-	if (address == NULL)
-		goto done;
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = inet_addr("255.255.255.255");
-	memcpy(&ifr.ifr_netmask, &addr, sizeof(ifr.ifr_netmask));
+	if (active == TRUE && proxy != NULL)
+		__ofono_rtnl_batch_add_host_route(batch, proxy);
 
-	if (ioctl(sk, SIOCSIFNETMASK, &ifr) < 0)
-		ofono_error("Failed to set interface netmask");
+	if (active == FALSE)
+		__ofono_rtnl_batch_set_link(batch, FALSE, 0);
 
-done:
-	close(sk);
-}
-
-static void pri_setproxy(const char *interface, const char *proxy)
-{
-	struct rtentry rt;
-	struct sockaddr_in addr;
-	int sk;
-
-	if (interface == NULL)
-		return;
-
-	sk = socket(PF_INET, SOCK_DGRAM, 0);
-	if (sk < 0)
-		return;
-
-	memset(&rt, 0, sizeof(rt));
-	rt.rt_flags = RTF_UP | RTF_HOST;
-	rt.rt_dev = (char *) interface;
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = inet_addr(proxy);
-	memcpy(&rt.rt_dst, &addr, sizeof(rt.rt_dst));
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = INADDR_ANY;
-	memcpy(&rt.rt_gateway, &addr, sizeof(rt.rt_gateway));
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_addr.s_addr = INADDR_ANY;
-	memcpy(&rt.rt_genmask, &addr, sizeof(rt.rt_genmask));
-
-	if (ioctl(sk, SIOCADDRT, &rt) < 0)
-		ofono_error("Failed to add proxy host route");
-
-	close(sk);
+	__ofono_rtnl_batch_commit(batch);
 }
 
 static void pri_reset_context_settings(struct pri_context *ctx)
 {
 	struct context_settings *settings;
-	char *interface;
+	struct context_settings old;
 	gboolean signal_ipv4;
 	gboolean signal_ipv6;
 
@@ -735,27 +960,39 @@ static void pri_reset_context_settings(struct pri_context *ctx)
 
 	settings = ctx->context_driver->settings;
 
-	interface = settings->interface;
-	settings->interface = NULL;
+	if (ctx->request_time)
+		ctx->deactivation_time = pri_request_elapsed(ctx);
+
+	if (settings->interface != NULL) {
+		pri_update_stats(ctx, settings->interface);
+
+		if (ctx->stats_interval)
+			pri_signal_stats(ctx);
+	}
 
 	signal_ipv4 = settings->ipv4 != NULL;
 	signal_ipv6 = settings->ipv6 != NULL;
 
-	context_settings_free(settings);
+	/*
+	 * Keep the addresses around until the interface is down, but let
+	 * clients know the settings are gone before that happens.
+	 */
+	old = *settings;
+	memset(settings, 0, sizeof(*settings));
 
 	pri_context_signal_settings(ctx, signal_ipv4, signal_ipv6);
 
-	if (ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS) {
-		pri_set_ipv4_addr(interface, NULL);
+	pri_ifupdown(old.interface, FALSE,
+			ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS ?
+			&old : NULL, NULL);
+
+	context_settings_free(&old);
 
+	if (ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS) {
 		g_free(ctx->proxy_host);
 		ctx->proxy_host = NULL;
 		ctx->proxy_port = 0;
 	}
-
-	pri_ifupdown(interface, FALSE);
-
-	g_free(interface);
 }
 
 static void pri_update_mms_context_settings(struct pri_context *ctx)
@@ -763,17 +1000,12 @@ static void pri_update_mms_context_settings(struct pri_context *ctx)
 	struct ofono_gprs_context *gc = ctx->context_driver;
 	struct context_settings *settings = gc->settings;
 
-	if (ctx->message_proxy)
+	if (ctx->message_proxy[0] != '\0' && settings->ipv4)
 		settings->ipv4->proxy = g_strdup(ctx->message_proxy);
 
 	pri_parse_proxy(ctx, ctx->message_proxy);
 
 	DBG("proxy %s port %u", ctx->proxy_host, ctx->proxy_port);
-
-	pri_set_ipv4_addr(settings->interface, settings->ipv4->ip);
-
-	if (ctx->proxy_host)
-		pri_setproxy(settings->interface, ctx->proxy_host);
 }
 
 static void append_context_properties(struct pri_context *ctx,
@@ -824,6 +1056,11 @@ static void append_context_properties(struct pri_context *ctx,
 
 	context_settings_append_ipv4_dict(settings, dict);
 	context_settings_append_ipv6_dict(settings, dict);
+
+	append_context_stats_dict(ctx, dict);
+
+	ofono_dbus_dict_append(dict, "StatisticsInterval", DBUS_TYPE_UINT32,
+				&ctx->stats_interval);
 }
 
 static DBusMessage *pri_get_properties(DBusConnection *conn,
@@ -849,6 +1086,37 @@ static DBusMessage *pri_get_properties(DBusConnection *conn,
 	return reply;
 }
 
+static void pri_context_reply(struct pri_context *ctx, DBusMessage *reply)
+{
+	struct activation_batch *batch = ctx->batch;
+
+	if (batch == NULL) {
+		__ofono_dbus_pending_reply(&ctx->pending, reply);
+		return;
+	}
+
+	ctx->batch = NULL;
+	dbus_message_unref(ctx->pending);
+	ctx->pending = NULL;
+
+	if (dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR)
+		batch->failed += 1;
+
+	dbus_message_unref(reply);
+
+	batch->outstanding -= 1;
+	if (batch->outstanding > 0)
+		return;
+
+	if (batch->failed > 0)
+		reply = __ofono_error_failed(batch->msg);
+	else
+		reply = dbus_message_new_method_return(batch->msg);
+
+	__ofono_dbus_pending_reply(&batch->msg, reply);
+	g_free(batch);
+}
+
 static void pri_activate_callback(const struct ofono_error *error, void *data)
 {
 	struct pri_context *ctx = data;
@@ -861,26 +1129,42 @@ static void pri_activate_callback(const struct ofono_error *error, void *data)
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		DBG("Activating context failed with error: %s",
 				telephony_error_to_str(error));
-		__ofono_dbus_pending_reply(&ctx->pending,
-					__ofono_error_failed(ctx->pending));
+		pri_context_reply(ctx, __ofono_error_failed(ctx->pending));
 		context_settings_free(ctx->context_driver->settings);
 		release_context(ctx);
 		return;
 	}
 
 	ctx->active = TRUE;
-	__ofono_dbus_pending_reply(&ctx->pending,
-				dbus_message_new_method_return(ctx->pending));
+	ctx->activation_time = pri_request_elapsed(ctx);
+	ctx->deactivation_time = 0;
 
-	if (gc->settings->interface != NULL) {
-		pri_ifupdown(gc->settings->interface, TRUE);
+	if (ctx->gprs->reattached_time) {
+		ofono_info("%s: first context active %d ms after attach loss",
+				ctx->path, (int) ((g_get_monotonic_time() -
+					ctx->gprs->lost_time) / 1000));
+
+		ctx->gprs->lost_time = 0;
+		ctx->gprs->reattached_time = 0;
+	}
 
-		if (ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS &&
-				gc->settings->ipv4)
+	pri_context_reply(ctx, dbus_message_new_method_return(ctx->pending));
+
+	if (gc->settings->interface != NULL) {
+		if (ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS) {
 			pri_update_mms_context_settings(ctx);
+			pri_ifupdown(gc->settings->interface, TRUE,
+					gc->settings, ctx->proxy_host);
+		} else {
+			pri_ifupdown(gc->settings->interface, TRUE,
+					NULL, NULL);
+		}
 
 		pri_context_signal_settings(ctx, gc->settings->ipv4 != NULL,
 						gc->settings->ipv6 != NULL);
+
+		pri_reset_stats(ctx, gc->settings->interface);
+		gprs_stats_schedule(ctx->gprs);
 	}
 
 	value = ctx->active;
@@ -889,6 +1173,28 @@ static void pri_activate_callback(const struct ofono_error *error, void *data)
 					"Active", DBUS_TYPE_BOOLEAN, &value);
 }
 
+static gboolean pri_activate(struct pri_context *ctx)
+{
+	struct ofono_gprs_context *gc;
+
+	if (assign_context(ctx) == FALSE)
+		return queue_context(ctx);
+
+	gc = ctx->context_driver;
+	gc->driver->activate_primary(gc, &ctx->context,
+					pri_activate_callback, ctx);
+
+	return TRUE;
+}
+
+static void pri_deactivate_failed(struct pri_context *ctx)
+{
+	ctx->deactivating = FALSE;
+	ctx->request_time = 0;
+
+	fail_waiting_context(ctx->context_driver);
+}
+
 static void pri_deactivate_callback(const struct ofono_error *error, void *data)
 {
 	struct pri_context *ctx = data;
@@ -900,6 +1206,7 @@ static void pri_deactivate_callback(const struct ofono_error *error, void *data)
 				telephony_error_to_str(error));
 		__ofono_dbus_pending_reply(&ctx->pending,
 					__ofono_error_failed(ctx->pending));
+		pri_deactivate_failed(ctx);
 		return;
 	}
 
@@ -915,6 +1222,30 @@ static void pri_deactivate_callback(const struct ofono_error *error, void *data)
 					"Active", DBUS_TYPE_BOOLEAN, &value);
 }
 
+static DBusMessage *pri_set_stats_interval(struct pri_context *ctx,
+						DBusConnection *conn,
+						DBusMessage *msg,
+						unsigned int interval)
+{
+	if (ctx->stats_interval == interval)
+		return dbus_message_new_method_return(msg);
+
+	ctx->stats_interval = interval;
+	ctx->stats_due = g_get_monotonic_time() +
+				(gint64) interval * G_USEC_PER_SEC;
+
+	gprs_stats_schedule(ctx->gprs);
+
+	g_dbus_send_reply(conn, msg, DBUS_TYPE_INVALID);
+
+	ofono_dbus_signal_property_changed(conn, ctx->path,
+					OFONO_CONNECTION_CONTEXT_INTERFACE,
+					"StatisticsInterval", DBUS_TYPE_UINT32,
+					&interval);
+
+	return NULL;
+}
+
 static DBusMessage *pri_set_apn(struct pri_context *ctx, DBusConnection *conn,
 				DBusMessage *msg, const char *apn)
 {
@@ -1196,23 +1527,42 @@ static DBusMessage *pri_set_property(DBusConnection *conn,
 		if (ctx->gprs->flags & GPRS_FLAG_ATTACHING)
 			return __ofono_error_attach_in_progress(msg);
 
-		if (value && assign_context(ctx) == FALSE)
-			return __ofono_error_not_implemented(msg);
+		ctx->pending = dbus_message_ref(msg);
+		ctx->request_time = g_get_monotonic_time();
 
-		gc = ctx->context_driver;
+		if (value) {
+			if (pri_activate(ctx) == TRUE)
+				return NULL;
 
-		ctx->pending = dbus_message_ref(msg);
+			dbus_message_unref(ctx->pending);
+			ctx->pending = NULL;
+			ctx->request_time = 0;
 
-		if (value)
-			gc->driver->activate_primary(gc, &ctx->context,
-						pri_activate_callback, ctx);
-		else
-			gc->driver->deactivate_primary(gc, ctx->context.cid,
+			return __ofono_error_not_implemented(msg);
+		}
+
+		gc = ctx->context_driver;
+		ctx->deactivating = TRUE;
+		gc->driver->deactivate_primary(gc, ctx->context.cid,
 						pri_deactivate_callback, ctx);
 
 		return NULL;
 	}
 
+	if (g_str_equal(property, "StatisticsInterval")) {
+		dbus_uint32_t interval;
+
+		if (dbus_message_iter_get_arg_type(&var) != DBUS_TYPE_UINT32)
+			return __ofono_error_invalid_args(msg);
+
+		dbus_message_iter_get_basic(&var, &interval);
+
+		if (interval > MAX_STATS_INTERVAL)
+			return __ofono_error_invalid_format(msg);
+
+		return pri_set_stats_interval(ctx, conn, msg, interval);
+	}
+
 	/* All other properties are read-only when context is active */
 	if (ctx->active == TRUE)
 		return __ofono_error_in_use(msg);
@@ -1296,6 +1646,8 @@ static const GDBusMethodTable context_methods[] = {
 static const GDBusSignalTable context_signals[] = {
 	{ GDBUS_SIGNAL("PropertyChanged",
 			GDBUS_ARGS({ "name", "s" }, { "value", "v" })) },
+	{ GDBUS_SIGNAL("Statistics",
+			GDBUS_ARGS({ "statistics", "a{sv}" })) },
 	{ }
 };
 
@@ -1365,13 +1717,12 @@ static gboolean context_dbus_unregister(struct pri_context *ctx)
 	char path[256];
 
 	if (ctx->active == TRUE) {
-		const char *interface =
-			ctx->context_driver->settings->interface;
-
-		if (ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS)
-			pri_set_ipv4_addr(interface, NULL);
+		struct context_settings *settings =
+			ctx->context_driver->settings;
 
-		pri_ifupdown(interface, FALSE);
+		pri_ifupdown(settings->interface, FALSE,
+				ctx->type == OFONO_GPRS_CONTEXT_TYPE_MMS ?
+				settings : NULL, NULL);
 	}
 
 	strcpy(path, ctx->path);
@@ -1510,6 +1861,26 @@ static void gprs_attached_update(struct ofono_gprs *gprs)
 
 	gprs->attached = attached;
 
+	if (attached == FALSE && gprs->powered) {
+		gprs->lost_time = g_get_monotonic_time();
+		gprs->registered_time = 0;
+		gprs->reattached_time = 0;
+	} else if (attached == TRUE && gprs->lost_time) {
+		int registered = -1;
+		int reattached;
+
+		gprs->reattached_time = g_get_monotonic_time();
+		reattached = (gprs->reattached_time - gprs->lost_time) / 1000;
+
+		if (gprs->registered_time)
+			registered = (gprs->registered_time -
+						gprs->lost_time) / 1000;
+
+		ofono_info("%s: reattached after %d ms (registered at %d ms)",
+				__ofono_atom_get_path(gprs->atom),
+				reattached, registered);
+	}
+
 	path = __ofono_atom_get_path(gprs->atom);
 	value = attached;
 	ofono_dbus_signal_property_changed(conn, path,
@@ -1583,6 +1954,10 @@ static void gprs_netreg_update(struct ofono_gprs *gprs)
 
 	attach = attach && gprs->powered;
 
+	/* A detach asked for by the user is not a loss worth timing */
+	if (gprs->powered == FALSE)
+		gprs->lost_time = 0;
+
 	if (gprs->driver_attached == attach)
 		return;
 
@@ -1597,11 +1972,14 @@ static void gprs_netreg_update(struct ofono_gprs *gprs)
 	gprs->driver_attached = attach;
 }
 
-static void netreg_status_changed(int status, int lac, int ci, int tech,
-					const char *mcc, const char *mnc,
+static void netreg_status_changed(const struct ofono_netreg_update *update,
 					void *data)
 {
 	struct ofono_gprs *gprs = data;
+	int status = update->status;
+
+	if (!(update->changed & OFONO_NETREG_UPDATE_STATUS))
+		return;
 
 	DBG("%d", status);
 
@@ -1610,6 +1988,11 @@ static void netreg_status_changed(int status, int lac, int ci, int tech,
 
 	gprs->netreg_status = status;
 
+	if (gprs->lost_time && gprs->registered_time == 0 &&
+			(status == NETWORK_REGISTRATION_STATUS_REGISTERED ||
+			status == NETWORK_REGISTRATION_STATUS_ROAMING))
+		gprs->registered_time = g_get_monotonic_time();
+
 	gprs_netreg_update(gprs);
 }
 
@@ -1622,6 +2005,11 @@ static DBusMessage *gprs_get_properties(DBusConnection *conn,
 	DBusMessageIter dict;
 	dbus_bool_t value;
 
+	reply = __ofono_dbus_cached_properties(msg,
+					OFONO_CONNECTION_MANAGER_INTERFACE);
+	if (reply != NULL)
+		return reply;
+
 	reply = dbus_message_new_method_return(msg);
 	if (reply == NULL)
 		return NULL;
@@ -1657,6 +2045,9 @@ static DBusMessage *gprs_get_properties(DBusConnection *conn,
 
 	dbus_message_iter_close_container(&iter, &dict);
 
+	__ofono_dbus_cache_properties(msg, OFONO_CONNECTION_MANAGER_INTERFACE,
+					reply);
+
 	return reply;
 }
 
@@ -1881,6 +2272,7 @@ static void gprs_deactivate_for_remove(const struct ofono_error *error,
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		DBG("Removing context failed with error: %s",
 				telephony_error_to_str(error));
+		pri_deactivate_failed(ctx);
 
 		__ofono_dbus_pending_reply(&gprs->pending,
 					__ofono_error_failed(gprs->pending));
@@ -1938,14 +2330,16 @@ static DBusMessage *gprs_remove_context(DBusConnection *conn,
 	if (ctx == NULL)
 		return __ofono_error_not_found(msg);
 
+	/* This context is already being messed with */
+	if (ctx->pending)
+		return __ofono_error_busy(msg);
+
 	if (ctx->active) {
 		struct ofono_gprs_context *gc = ctx->context_driver;
 
-		/* This context is already being messed with */
-		if (ctx->pending)
-			return __ofono_error_busy(msg);
-
 		gprs->pending = dbus_message_ref(msg);
+		ctx->request_time = g_get_monotonic_time();
+		ctx->deactivating = TRUE;
 		gc->driver->deactivate_primary(gc, ctx->context.cid,
 					gprs_deactivate_for_remove, ctx);
 		return NULL;
@@ -1979,6 +2373,7 @@ static void gprs_deactivate_for_all(const struct ofono_error *error,
 	dbus_bool_t value;
 
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
+		pri_deactivate_failed(ctx);
 		__ofono_dbus_pending_reply(&gprs->pending,
 					__ofono_error_failed(gprs->pending));
 		return;
@@ -2009,6 +2404,8 @@ static void gprs_deactivate_next(struct ofono_gprs *gprs)
 			continue;
 
 		gc = ctx->context_driver;
+		ctx->request_time = g_get_monotonic_time();
+		ctx->deactivating = TRUE;
 		gc->driver->deactivate_primary(gc, ctx->context.cid,
 					gprs_deactivate_for_all, ctx);
 
@@ -2046,6 +2443,97 @@ static DBusMessage *gprs_deactivate_all(DBusConnection *conn,
 	return NULL;
 }
 
+static DBusMessage *gprs_activate_contexts(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	struct ofono_gprs *gprs = data;
+	struct activation_batch *batch;
+	struct pri_context *ctx;
+	DBusMessageIter iter;
+	DBusMessageIter array;
+	GSList *contexts = NULL;
+	GSList *l;
+	DBusMessage *reply;
+
+	if (gprs->pending)
+		return __ofono_error_busy(msg);
+
+	if (!dbus_message_iter_init(msg, &iter))
+		return __ofono_error_invalid_args(msg);
+
+	if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY ||
+			dbus_message_iter_get_element_type(&iter) !=
+							DBUS_TYPE_OBJECT_PATH)
+		return __ofono_error_invalid_args(msg);
+
+	if (!gprs->attached)
+		return __ofono_error_not_attached(msg);
+
+	if (gprs->flags & GPRS_FLAG_ATTACHING)
+		return __ofono_error_attach_in_progress(msg);
+
+	dbus_message_iter_recurse(&iter, &array);
+
+	while (dbus_message_iter_get_arg_type(&array) ==
+						DBUS_TYPE_OBJECT_PATH) {
+		const char *path;
+
+		dbus_message_iter_get_basic(&array, &path);
+		dbus_message_iter_next(&array);
+
+		ctx = gprs_context_by_path(gprs, path);
+		if (ctx == NULL) {
+			reply = __ofono_error_not_found(msg);
+			goto error;
+		}
+
+		if (ctx->pending) {
+			reply = __ofono_error_busy(msg);
+			goto error;
+		}
+
+		if (ctx->active || g_slist_find(contexts, ctx))
+			continue;
+
+		contexts = g_slist_prepend(contexts, ctx);
+	}
+
+	if (contexts == NULL)
+		return dbus_message_new_method_return(msg);
+
+	contexts = g_slist_reverse(contexts);
+
+	batch = g_new0(struct activation_batch, 1);
+	batch->msg = dbus_message_ref(msg);
+	batch->outstanding = g_slist_length(contexts);
+
+	/*
+	 * Every context goes to its own driver straight away, so the
+	 * modem round trips overlap instead of running one after another.
+	 */
+	for (l = contexts; l; l = l->next) {
+		ctx = l->data;
+
+		ctx->pending = dbus_message_ref(msg);
+		ctx->batch = batch;
+		ctx->request_time = g_get_monotonic_time();
+
+		if (pri_activate(ctx) == FALSE) {
+			ctx->request_time = 0;
+			pri_context_reply(ctx,
+				__ofono_error_not_implemented(ctx->pending));
+		}
+	}
+
+	g_slist_free(contexts);
+
+	return NULL;
+
+error:
+	g_slist_free(contexts);
+	return reply;
+}
+
 static DBusMessage *gprs_get_contexts(DBusConnection *conn,
 					DBusMessage *msg, void *data)
 {
@@ -2114,6 +2602,9 @@ static const GDBusMethodTable manager_methods[] = {
 			gprs_remove_context) },
 	{ GDBUS_ASYNC_METHOD("DeactivateAll", NULL, NULL,
 			gprs_deactivate_all) },
+	{ GDBUS_ASYNC_METHOD("ActivateContexts",
+			GDBUS_ARGS({ "contexts", "ao" }), NULL,
+			gprs_activate_contexts) },
 	{ GDBUS_METHOD("GetContexts", NULL,
 			GDBUS_ARGS({ "contexts_with_properties", "a(oa{sv})" }),
 			gprs_get_contexts) },
@@ -2206,6 +2697,8 @@ static void gprs_context_unregister(struct ofono_atom *atom)
 	if (gc->gprs == NULL)
 		goto done;
 
+	fail_waiting_context(gc);
+
 	for (l = gc->gprs->contexts; l; l = l->next) {
 		ctx = l->data;
 
@@ -2213,7 +2706,7 @@ static void gprs_context_unregister(struct ofono_atom *atom)
 			continue;
 
 		if (ctx->pending != NULL)
-			__ofono_dbus_pending_reply(&ctx->pending,
+			pri_context_reply(ctx,
 					__ofono_error_failed(ctx->pending));
 
 		if (ctx->active == FALSE)
@@ -2565,9 +3058,22 @@ static void gprs_unregister(struct ofono_atom *atom)
 	struct ofono_gprs *gprs = __ofono_atom_get_data(atom);
 	struct ofono_modem *modem = __ofono_atom_get_modem(atom);
 	const char *path = __ofono_atom_get_path(atom);
+	GSList *l;
 
 	DBG("%p", gprs);
 
+	__ofono_dbus_invalidate_properties(path,
+					OFONO_CONNECTION_MANAGER_INTERFACE);
+
+	for (l = gprs->context_drivers; l; l = l->next)
+		fail_waiting_context(l->data);
+
+	if (gprs->stats_source) {
+		g_source_remove(gprs->stats_source);
+		gprs->stats_source = 0;
+		gprs->stats_period = 0;
+	}
+
 	free_contexts(gprs);
 
 	if (gprs->cid_map) {
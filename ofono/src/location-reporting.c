@@ -25,9 +25,14 @@
 #include <config.h>
 #endif
 
+#define _GNU_SOURCE
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -39,16 +44,31 @@
 #define DBUS_TYPE_UNIX_FD -1
 #endif
 
+#define PUMP_CHUNK_SIZE 4096
+
 static GSList *g_drivers = NULL;
 
+struct location_client {
+	struct ofono_location_reporting *lr;
+	char *owner;
+	guint disconnect_watch;
+	int fd;
+};
+
 struct ofono_location_reporting {
 	DBusMessage *pending;
 	const struct ofono_location_reporting_driver *driver;
 	void *driver_data;
 	struct ofono_atom *atom;
 	ofono_bool_t enabled;
-	char *client_owner;
-	guint disconnect_watch;
+	ofono_bool_t stopping;
+	GSList *clients;
+	int device_fd;
+	int source_fd;
+	int source_in_fd;
+	int null_fd;
+	guint device_watch;
+	guint source_watch;
 };
 
 static const char *location_reporting_type_to_string(
@@ -93,16 +113,40 @@ static DBusMessage *location_reporting_get_properties(DBusConnection *conn,
 	return reply;
 }
 
-static void client_remove(struct ofono_location_reporting *lr)
+static void client_free(struct location_client *client)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
 
-	if (lr->disconnect_watch) {
-		g_dbus_remove_watch(conn, lr->disconnect_watch);
-		lr->disconnect_watch = 0;
+	if (client->disconnect_watch)
+		g_dbus_remove_watch(conn, client->disconnect_watch);
+
+	close(client->fd);
+	g_free(client->owner);
+	g_free(client);
+}
+
+static void client_remove(struct ofono_location_reporting *lr,
+				struct location_client *client)
+{
+	DBG("%s", client->owner);
+
+	lr->clients = g_slist_remove(lr->clients, client);
+	client_free(client);
+}
+
+static struct location_client *client_find(struct ofono_location_reporting *lr,
+						const char *owner)
+{
+	GSList *l;
+
+	for (l = lr->clients; l; l = l->next) {
+		struct location_client *client = l->data;
+
+		if (g_str_equal(client->owner, owner))
+			return client;
 	}
 
-	g_free(lr->client_owner);
+	return NULL;
 }
 
 static void signal_enabled(const struct ofono_location_reporting *lr)
@@ -116,29 +160,302 @@ static void signal_enabled(const struct ofono_location_reporting *lr)
 					"Enabled", DBUS_TYPE_BOOLEAN, &value);
 }
 
+static void stream_stop(struct ofono_location_reporting *lr)
+{
+	if (lr->device_watch) {
+		g_source_remove(lr->device_watch);
+		lr->device_watch = 0;
+	}
+
+	if (lr->source_watch) {
+		g_source_remove(lr->source_watch);
+		lr->source_watch = 0;
+	}
+
+	if (lr->device_fd >= 0) {
+		close(lr->device_fd);
+		lr->device_fd = -1;
+	}
+
+	if (lr->source_in_fd >= 0) {
+		close(lr->source_in_fd);
+		lr->source_in_fd = -1;
+	}
+
+	if (lr->source_fd >= 0) {
+		close(lr->source_fd);
+		lr->source_fd = -1;
+	}
+
+	if (lr->null_fd >= 0) {
+		close(lr->null_fd);
+		lr->null_fd = -1;
+	}
+}
+
 static void client_exited_disable_cb(const struct ofono_error *error,
 								void *data)
 {
 	struct ofono_location_reporting *lr = data;
 
+	lr->stopping = FALSE;
+
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		ofono_error("Disabling location-reporting failed");
 		return;
 	}
 
-	client_remove(lr);
+	stream_stop(lr);
 	lr->enabled = FALSE;
 
 	signal_enabled(lr);
 }
 
+static void location_reporting_stop(struct ofono_location_reporting *lr)
+{
+	if (lr->stopping || lr->pending != NULL)
+		return;
+
+	lr->stopping = TRUE;
+	lr->driver->disable(lr, client_exited_disable_cb, lr);
+}
+
 static void client_exited(DBusConnection *conn, void *data)
+{
+	struct location_client *client = data;
+	struct ofono_location_reporting *lr = client->lr;
+
+	client->disconnect_watch = 0;
+	client_remove(lr, client);
+
+	if (lr->clients == NULL)
+		location_reporting_stop(lr);
+}
+
+static void drop_all_clients(struct ofono_location_reporting *lr)
+{
+	g_slist_free_full(lr->clients, (GDestroyNotify) client_free);
+	lr->clients = NULL;
+}
+
+static void source_discard(struct ofono_location_reporting *lr, int len)
+{
+	char buf[PUMP_CHUNK_SIZE];
+	ssize_t n;
+
+	if (lr->null_fd >= 0) {
+		n = splice(lr->source_fd, NULL, lr->null_fd, NULL, len,
+					SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (n == len)
+			return;
+
+		if (n > 0)
+			len -= n;
+	}
+
+	while (len > 0) {
+		n = read(lr->source_fd, buf, MIN(len, (int) sizeof(buf)));
+		if (n <= 0)
+			break;
+
+		len -= n;
+	}
+}
+
+/*
+ * Every client owns a pipe of its own.  Whatever is queued in the
+ * source pipe is duplicated into each of them with tee(), which only
+ * takes extra references on the pipe pages, and is then thrown away.
+ * A client that cannot take a whole chunk is dropped, its reader sees
+ * end of file, so one stuck consumer never holds back the others.
+ */
+static gboolean source_event(GIOChannel *channel, GIOCondition cond,
+							gpointer data)
 {
 	struct ofono_location_reporting *lr = data;
+	GSList *l;
+	int len;
 
-	lr->disconnect_watch = 0;
+	if (cond & G_IO_IN) {
+		if (ioctl(lr->source_fd, FIONREAD, &len) < 0)
+			len = 0;
+	} else {
+		len = -1;
+	}
 
-	lr->driver->disable(lr, client_exited_disable_cb, lr);
+	if (len < 0) {
+		DBG("NMEA source closed");
+
+		lr->source_watch = 0;
+		drop_all_clients(lr);
+		location_reporting_stop(lr);
+
+		return FALSE;
+	}
+
+	if (len == 0)
+		return TRUE;
+
+	for (l = lr->clients; l;) {
+		struct location_client *client = l->data;
+		ssize_t n;
+
+		l = l->next;
+
+		n = tee(lr->source_fd, client->fd, len, SPLICE_F_NONBLOCK);
+		if (n == len)
+			continue;
+
+		ofono_warn("Dropping slow NMEA client %s", client->owner);
+		client_remove(lr, client);
+	}
+
+	source_discard(lr, len);
+
+	if (lr->clients == NULL)
+		location_reporting_stop(lr);
+
+	return TRUE;
+}
+
+/*
+ * The source has to be a pipe for tee() to work.  Drivers that hand
+ * out a tty are pumped into one, with splice() when the tty supports
+ * it and a plain read() and write() otherwise.
+ */
+static gboolean device_event(GIOChannel *channel, GIOCondition cond,
+							gpointer data)
+{
+	struct ofono_location_reporting *lr = data;
+	char buf[PUMP_CHUNK_SIZE];
+	ssize_t n = 0;
+
+	if (cond & G_IO_IN) {
+		n = splice(lr->device_fd, NULL, lr->source_in_fd, NULL,
+				PUMP_CHUNK_SIZE,
+				SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+		if (n < 0 && errno == EINVAL) {
+			n = read(lr->device_fd, buf, sizeof(buf));
+			if (n > 0 && write(lr->source_in_fd, buf, n) < 0)
+				ofono_warn("NMEA data lost: %s",
+							strerror(errno));
+		}
+
+		if (n > 0 || (n < 0 && errno == EAGAIN))
+			return TRUE;
+	}
+
+	DBG("NMEA device closed");
+
+	lr->device_watch = 0;
+
+	/* Let the source watch drain what is left and notice the end */
+	close(lr->source_in_fd);
+	lr->source_in_fd = -1;
+
+	return FALSE;
+}
+
+static guint add_fd_watch(int fd, GIOFunc func, gpointer data)
+{
+	GIOChannel *channel;
+	guint id;
+
+	channel = g_io_channel_unix_new(fd);
+	g_io_channel_set_encoding(channel, NULL, NULL);
+	g_io_channel_set_buffered(channel, FALSE);
+
+	id = g_io_add_watch(channel,
+				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				func, data);
+
+	g_io_channel_unref(channel);
+
+	return id;
+}
+
+static int stream_start(struct ofono_location_reporting *lr, int fd)
+{
+	struct stat st;
+	int pipefd[2];
+
+	/* The driver closes its own descriptor once we return */
+	fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0 ||
+			fstat(fd, &st) < 0) {
+		close(fd);
+		return -errno;
+	}
+
+	if (S_ISFIFO(st.st_mode)) {
+		lr->source_fd = fd;
+	} else {
+		if (pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) < 0) {
+			close(fd);
+			return -errno;
+		}
+
+		lr->device_fd = fd;
+		lr->source_fd = pipefd[0];
+		lr->source_in_fd = pipefd[1];
+		lr->device_watch = add_fd_watch(lr->device_fd, device_event,
+							lr);
+	}
+
+	lr->null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+	lr->source_watch = add_fd_watch(lr->source_fd, source_event, lr);
+
+	return 0;
+}
+
+static DBusMessage *client_new(struct ofono_location_reporting *lr,
+				DBusMessage *msg)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	struct location_client *client;
+	DBusMessage *reply;
+	int pipefd[2];
+
+	if (pipe2(pipefd, O_NONBLOCK | O_CLOEXEC) < 0)
+		return __ofono_error_failed(msg);
+
+	/* Only our end must never block, the reader may well want to */
+	fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) & ~O_NONBLOCK);
+
+	reply = dbus_message_new_method_return(msg);
+	if (reply == NULL)
+		goto error;
+
+	if (!dbus_message_append_args(reply, DBUS_TYPE_UNIX_FD, &pipefd[0],
+							DBUS_TYPE_INVALID)) {
+		dbus_message_unref(reply);
+		goto error;
+	}
+
+	close(pipefd[0]);
+
+	client = g_new0(struct location_client, 1);
+	client->lr = lr;
+	client->fd = pipefd[1];
+	client->owner = g_strdup(dbus_message_get_sender(msg));
+	client->disconnect_watch = g_dbus_add_disconnect_watch(conn,
+				client->owner, client_exited, client, NULL);
+
+	lr->clients = g_slist_prepend(lr->clients, client);
+
+	DBG("%s, %u clients", client->owner, g_slist_length(lr->clients));
+
+	return reply;
+
+error:
+	close(pipefd[0]);
+	close(pipefd[1]);
+
+	return __ofono_error_failed(msg);
 }
 
 static void location_reporting_disable_cb(const struct ofono_error *error,
@@ -155,7 +472,7 @@ static void location_reporting_disable_cb(const struct ofono_error *error,
 		return;
 	}
 
-	client_remove(lr);
+	stream_stop(lr);
 	lr->enabled = FALSE;
 
 	reply = dbus_message_new_method_return(lr->pending);
@@ -168,7 +485,6 @@ static void location_reporting_enable_cb(const struct ofono_error *error,
 							int fd,	void *data)
 {
 	struct ofono_location_reporting *lr = data;
-	DBusConnection *conn = ofono_dbus_get_connection();
 	DBusMessage *reply;
 
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
@@ -180,17 +496,20 @@ static void location_reporting_enable_cb(const struct ofono_error *error,
 	}
 
 	lr->enabled = TRUE;
-	lr->client_owner = g_strdup(dbus_message_get_sender(lr->pending));
-	lr->disconnect_watch = g_dbus_add_disconnect_watch(conn,
-				lr->client_owner, client_exited, lr, NULL);
 
-	reply = dbus_message_new_method_return(lr->pending);
-	dbus_message_append_args(reply, DBUS_TYPE_UNIX_FD, &fd,
-							DBUS_TYPE_INVALID);
+	if (stream_start(lr, fd) < 0) {
+		ofono_error("Unable to set up the NMEA stream");
+		reply = __ofono_error_failed(lr->pending);
+	} else {
+		reply = client_new(lr, lr->pending);
+	}
 
 	__ofono_dbus_pending_reply(&lr->pending, reply);
 
 	signal_enabled(lr);
+
+	if (lr->clients == NULL)
+		location_reporting_stop(lr);
 }
 
 static DBusMessage *location_reporting_request(DBusConnection *conn,
@@ -198,12 +517,16 @@ static DBusMessage *location_reporting_request(DBusConnection *conn,
 {
 	struct ofono_location_reporting *lr = data;
 
-	if (lr->pending != NULL)
+	if (lr->pending != NULL || lr->stopping)
 		return __ofono_error_busy(msg);
 
-	if (lr->enabled)
+	if (client_find(lr, dbus_message_get_sender(msg)))
 		return __ofono_error_in_use(msg);
 
+	/* The stream is already flowing, just hook up another pipe */
+	if (lr->enabled)
+		return client_new(lr, msg);
+
 	lr->pending = dbus_message_ref(msg);
 
 	lr->driver->enable(lr, location_reporting_enable_cb, lr);
@@ -215,23 +538,29 @@ static DBusMessage *location_reporting_release(DBusConnection *conn,
 						DBusMessage *msg, void *data)
 {
 	struct ofono_location_reporting *lr = data;
-	const char *caller = dbus_message_get_sender(msg);
+	struct location_client *client;
 
 	/*
 	 * Avoid a race by not trying to release the device if there is a
-	 * pending message or client already signaled it's exiting. In the
+	 * pending message or the last client already went away. In the
 	 * later case, the device will eventually be released in
 	 * client_exited_disable_cb().
 	 */
-	if (lr->pending != NULL || (lr->enabled && !lr->disconnect_watch))
+	if (lr->pending != NULL || lr->stopping)
 		return __ofono_error_busy(msg);
 
 	if (lr->enabled == FALSE)
 		return __ofono_error_not_available(msg);
 
-	if (g_strcmp0(caller, lr->client_owner))
+	client = client_find(lr, dbus_message_get_sender(msg));
+	if (client == NULL)
 		return __ofono_error_access_denied(msg);
 
+	client_remove(lr, client);
+
+	if (lr->clients != NULL)
+		return dbus_message_new_method_return(msg);
+
 	lr->pending = dbus_message_ref(msg);
 
 	lr->driver->disable(lr, location_reporting_disable_cb, lr);
@@ -294,6 +623,9 @@ static void location_reporting_unregister(struct ofono_atom *atom)
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct ofono_modem *modem = __ofono_atom_get_modem(lr->atom);
 
+	drop_all_clients(lr);
+	stream_stop(lr);
+
 	ofono_modem_remove_interface(modem, OFONO_LOCATION_REPORTING_INTERFACE);
 	g_dbus_unregister_interface(conn, path,
 					OFONO_LOCATION_REPORTING_INTERFACE);
@@ -333,6 +665,11 @@ struct ofono_location_reporting *ofono_location_reporting_create(
 	if (lr == NULL)
 		return NULL;
 
+	lr->device_fd = -1;
+	lr->source_fd = -1;
+	lr->source_in_fd = -1;
+	lr->null_fd = -1;
+
 	lr->atom = __ofono_modem_add_atom(modem,
 					OFONO_ATOM_TYPE_LOCATION_REPORTING,
 					location_reporting_remove, lr);
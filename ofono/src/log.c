@@ -30,14 +30,130 @@
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <errno.h>
+#include <stdint.h>
 #include <execinfo.h>
 #include <dlfcn.h>
 
 #include "ofono.h"
+#include "logring.h"
+
+struct log_site {
+	char *format;
+	unsigned int id;		/* In the log ring */
+	char *signature;
+	gint64 window;
+	unsigned int count;
+	unsigned int suppressed;
+};
 
 static const char *program_exec;
 static const char *program_path;
 
+static struct log_ring *log_ring;
+static unsigned int rate_limit;
+static GHashTable *log_sites;
+
+/* Serializes the callsite table and the log ring between threads */
+G_LOCK_DEFINE_STATIC(log_sites);
+
+static void log_site_free(gpointer data)
+{
+	struct log_site *site = data;
+
+	g_free(site->format);
+	g_free(site->signature);
+	g_free(site);
+}
+
+static struct log_site *log_site_get(const char *format)
+{
+	struct log_site *site;
+
+	/*
+	 * Callsites are told apart by the address of their format string.
+	 * Formats built at runtime may reuse an address, so the contents
+	 * are checked as well.
+	 */
+	site = g_hash_table_lookup(log_sites, format);
+	if (site != NULL && strcmp(site->format, format) == 0)
+		return site;
+
+	site = g_new0(struct log_site, 1);
+	site->format = g_strdup(format);
+
+	if (log_ring != NULL) {
+		site->id = log_ring_add_site(log_ring, format);
+		site->signature = log_ring_signature(format);
+	}
+
+	g_hash_table_replace(log_sites, (gpointer) format, site);
+
+	return site;
+}
+
+/* Allows up to rate_limit messages per second and callsite */
+static gboolean log_site_allow(struct log_site *site)
+{
+	gint64 now = g_get_monotonic_time();
+
+	if (now - site->window >= G_USEC_PER_SEC) {
+		site->window = now;
+		site->count = 0;
+	}
+
+	if (site->count >= rate_limit) {
+		site->suppressed++;
+		return FALSE;
+	}
+
+	site->count++;
+
+	return TRUE;
+}
+
+static void log_message(int priority, const char *format, va_list ap)
+{
+	struct log_site *site;
+	unsigned int suppressed;
+	va_list aq;
+
+	if (log_sites == NULL) {
+		vsyslog(priority, format, ap);
+		return;
+	}
+
+	G_LOCK(log_sites);
+
+	site = log_site_get(format);
+
+	if (rate_limit > 0 && log_site_allow(site) == FALSE) {
+		G_UNLOCK(log_sites);
+		return;
+	}
+
+	suppressed = site->suppressed;
+	site->suppressed = 0;
+
+	if (log_ring != NULL) {
+		va_copy(aq, ap);
+		log_ring_write(log_ring, site->id, site->signature, priority,
+				suppressed, aq);
+		va_end(aq);
+	}
+
+	G_UNLOCK(log_sites);
+
+	/* Debug output is left to the log ring reader */
+	if (log_ring != NULL && priority == LOG_DEBUG)
+		return;
+
+	if (suppressed > 0)
+		syslog(priority, "%u messages suppressed", suppressed);
+
+	vsyslog(priority, format, ap);
+}
+
 /**
  * ofono_info:
  * @format: format string
@@ -51,7 +167,7 @@ void ofono_info(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_INFO, format, ap);
+	log_message(LOG_INFO, format, ap);
 
 	va_end(ap);
 }
@@ -69,7 +185,7 @@ void ofono_warn(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_WARNING, format, ap);
+	log_message(LOG_WARNING, format, ap);
 
 	va_end(ap);
 }
@@ -87,7 +203,7 @@ void ofono_error(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_ERR, format, ap);
+	log_message(LOG_ERR, format, ap);
 
 	va_end(ap);
 }
@@ -108,7 +224,7 @@ void ofono_debug(const char *format, ...)
 
 	va_start(ap, format);
 
-	vsyslog(LOG_DEBUG, format, ap);
+	log_message(LOG_DEBUG, format, ap);
 
 	va_end(ap);
 }
@@ -226,30 +342,128 @@ static void print_backtrace(unsigned int offset)
 extern struct ofono_debug_desc __start___debug[];
 extern struct ofono_debug_desc __stop___debug[];
 
-static gchar **enabled = NULL;
+struct debug_section {
+	struct ofono_debug_desc *start;
+	struct ofono_debug_desc *stop;
+};
+
+/* Compiled -d and D-Bus patterns, newest first; the first match wins */
+struct debug_pattern {
+	char *pattern;
+	GPatternSpec *spec;
+	ofono_bool_t enable;
+};
+
+static GSList *debug_patterns = NULL;
+static GSList *debug_sections = NULL;
+
+static void debug_pattern_free(gpointer data)
+{
+	struct debug_pattern *pattern = data;
+
+	g_pattern_spec_free(pattern->spec);
+	g_free(pattern->pattern);
+	g_free(pattern);
+}
+
+static ofono_bool_t debug_pattern_match(struct debug_pattern *pattern,
+					struct ofono_debug_desc *desc)
+{
+	if (desc->name != NULL &&
+			g_pattern_match_string(pattern->spec, desc->name))
+		return TRUE;
+
+	if (desc->file != NULL &&
+			g_pattern_match_string(pattern->spec, desc->file))
+		return TRUE;
+
+	return FALSE;
+}
 
 static ofono_bool_t is_enabled(struct ofono_debug_desc *desc)
 {
-	int i;
+	GSList *l;
 
-	if (enabled == NULL)
-		return FALSE;
+	for (l = debug_patterns; l; l = l->next) {
+		struct debug_pattern *pattern = l->data;
 
-	for (i = 0; enabled[i] != NULL; i++) {
-		if (desc->name != NULL && g_pattern_match_simple(enabled[i],
-							desc->name) == TRUE)
-			return TRUE;
-		if (desc->file != NULL && g_pattern_match_simple(enabled[i],
-							desc->file) == TRUE)
-			return TRUE;
+		if (debug_pattern_match(pattern, desc) == TRUE)
+			return pattern->enable;
 	}
 
 	return FALSE;
 }
 
+static void debug_pattern_apply(struct debug_pattern *pattern)
+{
+	struct debug_section *section;
+	struct ofono_debug_desc *desc;
+	GSList *l;
+
+	for (l = debug_sections; l; l = l->next) {
+		section = l->data;
+
+		for (desc = section->start; desc < section->stop; desc++) {
+			if (debug_pattern_match(pattern, desc) == FALSE)
+				continue;
+
+			if (pattern->enable == TRUE)
+				desc->flags |= OFONO_DEBUG_FLAG_PRINT;
+			else
+				desc->flags &= ~OFONO_DEBUG_FLAG_PRINT;
+		}
+	}
+}
+
+/* Returns the new patterns, oldest first */
+static GSList *debug_patterns_add(const char *debug, ofono_bool_t enable)
+{
+	struct debug_pattern *pattern;
+	GSList *added = NULL;
+	gchar **patterns;
+	GSList *l;
+	int i;
+
+	if (debug == NULL)
+		return NULL;
+
+	patterns = g_strsplit_set(debug, ":, ", 0);
+
+	for (i = 0; patterns[i] != NULL; i++) {
+		if (patterns[i][0] == '\0')
+			continue;
+
+		/* A repeated pattern only takes over the new precedence */
+		for (l = debug_patterns; l; l = l->next) {
+			pattern = l->data;
+
+			if (g_str_equal(pattern->pattern, patterns[i]))
+				break;
+		}
+
+		if (l != NULL) {
+			debug_patterns = g_slist_delete_link(debug_patterns, l);
+			debug_pattern_free(pattern);
+		}
+
+		pattern = g_new0(struct debug_pattern, 1);
+		pattern->pattern = g_strdup(patterns[i]);
+		pattern->spec = g_pattern_spec_new(patterns[i]);
+		pattern->enable = enable;
+
+		debug_patterns = g_slist_prepend(debug_patterns, pattern);
+		added = g_slist_append(added, pattern);
+	}
+
+	g_strfreev(patterns);
+
+	return added;
+}
+
 void __ofono_log_enable(struct ofono_debug_desc *start,
 					struct ofono_debug_desc *stop)
 {
+	struct debug_section *section;
 	struct ofono_debug_desc *desc;
 	const char *name = NULL, *file = NULL;
 
@@ -268,10 +482,86 @@ void __ofono_log_enable(struct ofono_debug_desc *start,
 		if (is_enabled(desc) == TRUE)
 			desc->flags |= OFONO_DEBUG_FLAG_PRINT;
 	}
+
+	section = g_new0(struct debug_section, 1);
+	section->start = start;
+	section->stop = stop;
+
+	debug_sections = g_slist_prepend(debug_sections, section);
+}
+
+void __ofono_log_set_debug(const char *debug)
+{
+	struct debug_section *section;
+	struct ofono_debug_desc *desc;
+	GSList *l;
+
+	g_slist_free_full(debug_patterns, debug_pattern_free);
+	debug_patterns = NULL;
+
+	g_slist_free(debug_patterns_add(debug, TRUE));
+
+	for (l = debug_sections; l; l = l->next) {
+		section = l->data;
+
+		for (desc = section->start; desc < section->stop; desc++) {
+			if (is_enabled(desc) == TRUE)
+				desc->flags |= OFONO_DEBUG_FLAG_PRINT;
+			else
+				desc->flags &= ~OFONO_DEBUG_FLAG_PRINT;
+		}
+	}
+
+	syslog(LOG_INFO, "Debug patterns set to \"%s\"",
+					debug != NULL ? debug : "");
+}
+
+void __ofono_log_enable_debug(const char *debug, ofono_bool_t enable)
+{
+	GSList *added;
+	GSList *l;
+
+	added = debug_patterns_add(debug, enable);
+
+	/*
+	 * The new patterns take precedence over all older ones, so only
+	 * the sites they match need to change.
+	 */
+	for (l = added; l; l = l->next)
+		debug_pattern_apply(l->data);
+
+	g_slist_free(added);
+
+	syslog(LOG_INFO, "Debug %s for \"%s\"",
+			enable ? "enabled" : "disabled", debug);
+}
+
+void __ofono_log_foreach_debug(const char *match,
+				ofono_log_debug_func_t func, void *user_data)
+{
+	struct debug_section *section;
+	struct ofono_debug_desc *desc;
+	struct debug_pattern pattern;
+	GSList *l;
+
+	pattern.spec = g_pattern_spec_new(match != NULL && *match != '\0' ?
+								match : "*");
+
+	for (l = debug_sections; l; l = l->next) {
+		section = l->data;
+
+		for (desc = section->start; desc < section->stop; desc++) {
+			if (debug_pattern_match(&pattern, desc) == TRUE)
+				func(desc, user_data);
+		}
+	}
+
+	g_pattern_spec_free(pattern.spec);
 }
 
 int __ofono_log_init(const char *program, const char *debug,
-						ofono_bool_t detach)
+			ofono_bool_t detach, unsigned int ring_size,
+			unsigned int rate)
 {
 	static char path[PATH_MAX];
 	int option = LOG_NDELAY | LOG_PID;
@@ -279,8 +569,7 @@ int __ofono_log_init(const char *program, const char *debug,
 	program_exec = program;
 	program_path = getcwd(path, sizeof(path));
 
-	if (debug != NULL)
-		enabled = g_strsplit_set(debug, ":, ", 0);
+	g_slist_free(debug_patterns_add(debug, TRUE));
 
 	__ofono_log_enable(__start___debug, __stop___debug);
 
@@ -291,6 +580,19 @@ int __ofono_log_init(const char *program, const char *debug,
 
 	syslog(LOG_INFO, "oFono version %s", VERSION);
 
+	if (ring_size > 0) {
+		log_ring = log_ring_new(ring_size);
+		if (log_ring == NULL)
+			syslog(LOG_ERR, "Unable to create the log ring: %s",
+							strerror(errno));
+	}
+
+	rate_limit = rate;
+
+	if (log_ring != NULL || rate_limit > 0)
+		log_sites = g_hash_table_new_full(g_direct_hash, NULL, NULL,
+							log_site_free);
+
 	return 0;
 }
 
@@ -300,5 +602,17 @@ void __ofono_log_cleanup(void)
 
 	closelog();
 
-	g_strfreev(enabled);
+	if (log_sites != NULL) {
+		g_hash_table_destroy(log_sites);
+		log_sites = NULL;
+	}
+
+	log_ring_free(log_ring);
+	log_ring = NULL;
+
+	g_slist_free_full(debug_sections, g_free);
+	debug_sections = NULL;
+
+	g_slist_free_full(debug_patterns, debug_pattern_free);
+	debug_patterns = NULL;
 }
@@ -0,0 +1,438 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <glib.h>
+
+#include "logring.h"
+
+#define LOG_RING_SIZE_MIN (64 * 1024)
+#define LOG_RING_SIZE_MAX (256 * 1024 * 1024)
+
+struct log_ring {
+	struct log_ring_header *header;
+	unsigned char *data;
+	char *path;
+};
+
+char *log_ring_signature(const char *format)
+{
+	GString *signature = g_string_sized_new(8);
+	const char *p = format;
+	char length;
+
+	while ((p = strchr(p, '%')) != NULL) {
+		p++;
+
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+
+		p += strspn(p, "-+ #0'");
+
+		if (*p == '*') {
+			g_string_append_c(signature, 'i');
+			p++;
+		} else
+			p += strspn(p, "0123456789");
+
+		if (*p == '.') {
+			p++;
+
+			if (*p == '*') {
+				g_string_append_c(signature, 'i');
+				p++;
+			} else
+				p += strspn(p, "0123456789");
+		}
+
+		length = 0;
+
+		switch (*p) {
+		case 'h':
+			p += p[1] == 'h' ? 2 : 1;
+			break;
+		case 'l':
+			length = p[1] == 'l' ? 'q' : 'l';
+			p += p[1] == 'l' ? 2 : 1;
+			break;
+		case 'q':
+		case 'L':
+		case 'j':
+		case 'z':
+		case 't':
+			length = *p == 'L' ? 'q' : *p;
+			p++;
+			break;
+		}
+
+		switch (*p) {
+		case 'd':
+		case 'i':
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c':
+			g_string_append_c(signature, length ? length : 'i');
+			break;
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			g_string_append_c(signature, length == 'q' ? 'D' : 'd');
+			break;
+		case 's':
+		case 'p':
+		case 'm':
+		case 'n':
+			g_string_append_c(signature, *p);
+			break;
+		default:
+			/* Unknown conversion, give up on the rest */
+			return g_string_free(signature, FALSE);
+		}
+
+		p++;
+	}
+
+	return g_string_free(signature, FALSE);
+}
+
+static size_t page_align(size_t size)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	return (size + page - 1) & ~(page - 1);
+}
+
+static struct log_ring_header *map_ring(int fd, size_t offset, size_t size,
+						gboolean writable)
+{
+	int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+	unsigned char *addr;
+	void *lower;
+	void *upper;
+
+	/* Reserve the address space for the ring and its mirror first */
+	addr = mmap(NULL, offset + 2 * size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	lower = mmap(addr, offset + size, prot, MAP_SHARED | MAP_FIXED,
+			fd, 0);
+	upper = mmap(addr + offset + size, size, prot,
+			MAP_SHARED | MAP_FIXED, fd, offset);
+
+	if (lower == MAP_FAILED || upper == MAP_FAILED) {
+		munmap(addr, offset + 2 * size);
+		return NULL;
+	}
+
+	return (struct log_ring_header *) addr;
+}
+
+struct log_ring_header *log_ring_map(int fd, gboolean writable)
+{
+	struct log_ring_header header;
+	size_t size;
+
+	if (pread(fd, &header, sizeof(header), 0) != sizeof(header))
+		return NULL;
+
+	if (memcmp(header.magic, LOG_RING_MAGIC, sizeof(header.magic)) ||
+			header.version != LOG_RING_VERSION)
+		return NULL;
+
+	size = header.ring_size;
+
+	if (size < LOG_RING_SIZE_MIN || size > LOG_RING_SIZE_MAX ||
+			(size & (size - 1)) != 0)
+		return NULL;
+
+	return map_ring(fd, header.ring_offset, size, writable);
+}
+
+void log_ring_unmap(struct log_ring_header *header)
+{
+	munmap(header, header->ring_offset + 2 * header->ring_size);
+}
+
+unsigned char *log_ring_data(struct log_ring_header *header)
+{
+	return (unsigned char *) header + header->ring_offset;
+}
+
+struct log_ring *log_ring_new(size_t size)
+{
+	struct log_ring_header *header;
+	struct log_ring *ring;
+	size_t real_size = LOG_RING_SIZE_MIN;
+	size_t offset;
+	int fd;
+
+	/* Find the next power of two for size */
+	while (real_size < size && real_size < LOG_RING_SIZE_MAX)
+		real_size = real_size << 1;
+
+	offset = page_align(sizeof(struct log_ring_header)) +
+						LOG_RING_SITES_SIZE;
+
+	ring = g_try_new0(struct log_ring, 1);
+	if (ring == NULL)
+		return NULL;
+
+	ring->path = g_strdup_printf(LOG_RING_PATH, (int) getpid());
+
+	fd = open(ring->path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0)
+		goto error;
+
+	if (ftruncate(fd, offset + real_size) < 0)
+		goto error_close;
+
+	header = map_ring(fd, offset, real_size, TRUE);
+	if (header == NULL)
+		goto error_close;
+
+	/* The mappings keep the memory alive */
+	close(fd);
+
+	header->version = LOG_RING_VERSION;
+	header->pid = getpid();
+	header->sites_offset = page_align(sizeof(struct log_ring_header));
+	header->sites_size = LOG_RING_SITES_SIZE;
+	header->ring_offset = offset;
+	header->ring_size = real_size;
+
+	/* Readers check the magic, so it goes in last */
+	__sync_synchronize();
+	memcpy(header->magic, LOG_RING_MAGIC, sizeof(header->magic));
+
+	ring->header = header;
+	ring->data = log_ring_data(header);
+
+	return ring;
+
+error_close:
+	close(fd);
+	unlink(ring->path);
+
+error:
+	g_free(ring->path);
+	g_free(ring);
+
+	return NULL;
+}
+
+void log_ring_free(struct log_ring *ring)
+{
+	if (ring == NULL)
+		return;
+
+	/*
+	 * Only a clean exit removes the ring; after a crash it stays
+	 * around for the reader.
+	 */
+	log_ring_unmap(ring->header);
+	unlink(ring->path);
+
+	g_free(ring->path);
+	g_free(ring);
+}
+
+unsigned int log_ring_add_site(struct log_ring *ring, const char *format)
+{
+	struct log_ring_header *header = ring->header;
+	unsigned char *sites = (unsigned char *) header + header->sites_offset;
+	struct log_ring_site site;
+	size_t len = MIN(strlen(format), G_MAXUINT16);
+
+	site.id = header->nsites + 1;
+	site.len = len;
+
+	/* Once the table is full, readers show the bare site id */
+	if (header->sites_used + sizeof(site) + len <= header->sites_size) {
+		memcpy(sites + header->sites_used, &site, sizeof(site));
+		memcpy(sites + header->sites_used + sizeof(site), format, len);
+
+		__sync_synchronize();
+		header->sites_used += sizeof(site) + len;
+	}
+
+	header->nsites = site.id;
+
+	return site.id;
+}
+
+static gboolean put_value(unsigned char *buf, size_t *len, const void *value,
+				size_t size)
+{
+	if (*len + size > LOG_RING_RECORD_MAX)
+		return FALSE;
+
+	memcpy(buf + *len, value, size);
+	*len += size;
+
+	return TRUE;
+}
+
+static gboolean put_integer(unsigned char *buf, size_t *len, int64_t value)
+{
+	return put_value(buf, len, &value, sizeof(value));
+}
+
+static gboolean put_string(unsigned char *buf, size_t *len, const char *str)
+{
+	uint16_t slen;
+
+	if (str == NULL)
+		str = "(null)";
+
+	slen = strnlen(str, LOG_RING_STRING_MAX);
+
+	if (*len + sizeof(slen) + slen > LOG_RING_RECORD_MAX)
+		slen = LOG_RING_RECORD_MAX - MIN(LOG_RING_RECORD_MAX,
+						*len + sizeof(slen));
+
+	if (put_value(buf, len, &slen, sizeof(slen)) == FALSE)
+		return FALSE;
+
+	return put_value(buf, len, str, slen);
+}
+
+static size_t encode_args(unsigned char *buf, size_t len,
+				const char *signature, int err, va_list ap)
+{
+	const char *s;
+	gboolean ok = TRUE;
+	double d;
+
+	for (s = signature; *s != '\0' && ok; s++) {
+		switch (*s) {
+		case 'i':
+			ok = put_integer(buf, &len, va_arg(ap, int));
+			break;
+		case 'l':
+			ok = put_integer(buf, &len, va_arg(ap, long));
+			break;
+		case 'q':
+			ok = put_integer(buf, &len, va_arg(ap, long long));
+			break;
+		case 'z':
+			ok = put_integer(buf, &len, va_arg(ap, size_t));
+			break;
+		case 'j':
+			ok = put_integer(buf, &len, va_arg(ap, intmax_t));
+			break;
+		case 't':
+			ok = put_integer(buf, &len, va_arg(ap, ptrdiff_t));
+			break;
+		case 'p':
+			ok = put_integer(buf, &len,
+					(uintptr_t) va_arg(ap, void *));
+			break;
+		case 'd':
+			d = va_arg(ap, double);
+			ok = put_value(buf, &len, &d, sizeof(d));
+			break;
+		case 'D':
+			d = va_arg(ap, long double);
+			ok = put_value(buf, &len, &d, sizeof(d));
+			break;
+		case 's':
+			ok = put_string(buf, &len, va_arg(ap, const char *));
+			break;
+		case 'm':
+			ok = put_string(buf, &len, strerror(err));
+			break;
+		case 'n':
+			va_arg(ap, void *);
+			break;
+		}
+	}
+
+	return len;
+}
+
+void log_ring_write(struct log_ring *ring, unsigned int site,
+			const char *signature, int level,
+			unsigned int suppressed, va_list ap)
+{
+	struct log_ring_header *header = ring->header;
+	uint64_t mask = header->ring_size - 1;
+	unsigned char buf[LOG_RING_RECORD_MAX];
+	struct log_ring_record *record = (void *) buf;
+	uint64_t head = header->head;
+	uint64_t tail = header->tail;
+	int err = errno;
+	size_t len;
+
+	len = encode_args(buf, sizeof(*record), signature, err, ap);
+
+	record->size = (len + 7) & ~7;
+	memset(buf + len, 0, record->size - len);
+
+	record->site = site;
+	record->time = g_get_real_time();
+	record->suppressed = suppressed;
+	record->level = level;
+
+	/* Drop the oldest records until the new one fits */
+	while (head + record->size - tail > header->ring_size) {
+		struct log_ring_record *old = (void *)
+						(ring->data + (tail & mask));
+
+		tail += old->size;
+	}
+
+	/*
+	 * Readers discard whatever lies before the tail, so it has to move
+	 * before the old records get overwritten.
+	 */
+	header->tail = tail;
+	__sync_synchronize();
+
+	memcpy(ring->data + (head & mask), buf, record->size);
+
+	__sync_synchronize();
+	header->head = head + record->size;
+
+	errno = err;
+}
@@ -0,0 +1,90 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Binary log ring shared with external readers.
+ *
+ * The file starts with a header, followed by the table of callsites and
+ * then the ring itself.  Records in the ring hold the callsite id and the
+ * raw arguments only; the reader formats them with the callsite format.
+ * Both the writer and the reader map the ring twice back to back, so a
+ * record is always contiguous in memory.
+ */
+
+#define LOG_RING_PATH "/dev/shm/ofonod-%d.log"
+#define LOG_RING_MAGIC "OFONOLOG"
+#define LOG_RING_VERSION 1
+
+#define LOG_RING_SITES_SIZE (64 * 1024)
+#define LOG_RING_RECORD_MAX 2048
+#define LOG_RING_STRING_MAX 512
+
+struct log_ring_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t pid;
+	uint32_t sites_offset;
+	uint32_t sites_size;
+	uint32_t sites_used;		/* Bytes of the site table in use */
+	uint32_t nsites;
+	uint64_t ring_offset;
+	uint64_t ring_size;		/* Power of two */
+	uint64_t head;			/* Bytes ever written */
+	uint64_t tail;			/* Position of the oldest record */
+};
+
+/* Followed by the format, without the terminating NUL */
+struct log_ring_site {
+	uint32_t id;
+	uint16_t len;
+} __attribute__((packed));
+
+/* Followed by the arguments, as described by the format signature */
+struct log_ring_record {
+	uint32_t size;			/* Including padding to 8 bytes */
+	uint32_t site;
+	uint64_t time;			/* Microseconds since the epoch */
+	uint32_t suppressed;		/* Records dropped before this one */
+	uint32_t level;			/* syslog priority */
+};
+
+/*
+ * Signature characters, one per argument consumed by the format:
+ *   i int, l long, q long long, z size_t, j intmax_t, t ptrdiff_t,
+ *   d double, D long double, s string, p pointer, m errno string.
+ * Integers and doubles take 8 bytes, strings a 16 bit length followed
+ * by the characters.
+ */
+char *log_ring_signature(const char *format);
+
+struct log_ring;
+
+struct log_ring *log_ring_new(size_t size);
+void log_ring_free(struct log_ring *ring);
+
+unsigned int log_ring_add_site(struct log_ring *ring, const char *format);
+void log_ring_write(struct log_ring *ring, unsigned int site,
+			const char *signature, int level,
+			unsigned int suppressed, va_list ap);
+
+struct log_ring_header *log_ring_map(int fd, gboolean writable);
+void log_ring_unmap(struct log_ring_header *header);
+unsigned char *log_ring_data(struct log_ring_header *header);
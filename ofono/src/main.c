@@ -131,6 +131,12 @@ static void system_bus_disconnected(DBusConnection *conn, void *user_data)
 static gchar *option_debug = NULL;
 static gchar *option_plugin = NULL;
 static gchar *option_noplugin = NULL;
+static gchar *option_defer = NULL;
+static gboolean option_startup_trace = FALSE;
+static gint option_log_ring = 0;
+static gint option_log_rate = 0;
+static gint option_strength_hysteresis = 5;
+static gint option_netreg_interval = 1000;
 static gboolean option_detach = TRUE;
 static gboolean option_version = FALSE;
 
@@ -153,6 +159,25 @@ static GOptionEntry options[] = {
 				"Specify plugins to load", "NAME,..," },
 	{ "noplugin", 'P', 0, G_OPTION_ARG_STRING, &option_noplugin,
 				"Specify plugins not to load", "NAME,..." },
+	{ "defer", 0, 0, G_OPTION_ARG_STRING, &option_defer,
+				"Specify modem plugins to initialize only "
+				"when their modem appears", "NAME,..." },
+	{ "startup-trace", 0, 0, G_OPTION_ARG_NONE, &option_startup_trace,
+				"Log the time spent in each startup step" },
+	{ "log-ring", 0, 0, G_OPTION_ARG_INT, &option_log_ring,
+				"Write binary log records to a shared "
+				"memory ring of this size", "KB" },
+	{ "log-rate", 0, 0, G_OPTION_ARG_INT, &option_log_rate,
+				"Limit the messages logged per second "
+				"by each callsite", "N" },
+	{ "strength-hysteresis", 0, 0, G_OPTION_ARG_INT,
+				&option_strength_hysteresis,
+				"Ignore signal strength changes smaller "
+				"than this", "PERCENT" },
+	{ "netreg-interval", 0, 0, G_OPTION_ARG_INT,
+				&option_netreg_interval,
+				"Report signal strength and cell changes "
+				"at most once per interval", "MS" },
 	{ "nodetach", 'n', G_OPTION_FLAG_REVERSE,
 				G_OPTION_ARG_NONE, &option_detach,
 				"Don't run as daemon in background" },
@@ -168,6 +193,7 @@ int main(int argc, char **argv)
 	DBusConnection *conn;
 	DBusError error;
 	guint signal;
+	gint64 start = g_get_monotonic_time();
 
 #ifdef NEED_THREADS
 	if (g_thread_supported() == FALSE)
@@ -213,7 +239,9 @@ int main(int argc, char **argv)
 
 	signal = setup_signalfd();
 
-	__ofono_log_init(argv[0], option_debug, option_detach);
+	__ofono_log_init(argv[0], option_debug, option_detach,
+				MAX(option_log_ring, 0) * 1024,
+				MAX(option_log_rate, 0));
 
 	dbus_error_init(&error);
 
@@ -230,19 +258,38 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (option_startup_trace)
+		ofono_info("Startup: D-Bus name acquired after %d us",
+				(int) (g_get_monotonic_time() - start));
+
 	g_dbus_set_disconnect_function(conn, system_bus_disconnected,
 					NULL, NULL);
 
 	__ofono_dbus_init(conn);
 
+	__ofono_netreg_set_update_filter(MAX(option_strength_hysteresis, 0),
+					MAX(option_netreg_interval, 0));
+
+	/* Without it no context interface can be brought up */
+	if (__ofono_rtnl_init() < 0) {
+		ofono_error("Unable to open rtnetlink socket");
+		goto cleanup_dbus;
+	}
+
 	__ofono_modemwatch_init();
 
 	__ofono_manager_init();
 
-	__ofono_plugin_init(option_plugin, option_noplugin);
+	__ofono_plugin_init(option_plugin, option_noplugin, option_defer,
+				option_startup_trace);
+
+	if (option_startup_trace)
+		ofono_info("Startup: plugins initialized after %d us",
+				(int) (g_get_monotonic_time() - start));
 
 	g_free(option_plugin);
 	g_free(option_noplugin);
+	g_free(option_defer);
 
 	g_main_loop_run(event_loop);
 
@@ -252,6 +299,9 @@ int main(int argc, char **argv)
 
 	__ofono_modemwatch_cleanup();
 
+	__ofono_rtnl_cleanup();
+
+cleanup_dbus:
 	__ofono_dbus_cleanup();
 	dbus_connection_unref(conn);
 
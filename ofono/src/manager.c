@@ -80,10 +80,113 @@ static DBusMessage *manager_get_modems(DBusConnection *conn,
 	return reply;
 }
 
+static DBusMessage *manager_set_debug(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	const char *patterns;
+
+	if (dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &patterns,
+					DBUS_TYPE_INVALID) == FALSE)
+		return __ofono_error_invalid_args(msg);
+
+	__ofono_log_set_debug(patterns);
+
+	return dbus_message_new_method_return(msg);
+}
+
+static DBusMessage *manager_toggle_debug(DBusMessage *msg,
+						ofono_bool_t enable)
+{
+	const char *patterns;
+
+	if (dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &patterns,
+					DBUS_TYPE_INVALID) == FALSE)
+		return __ofono_error_invalid_args(msg);
+
+	__ofono_log_enable_debug(patterns, enable);
+
+	return dbus_message_new_method_return(msg);
+}
+
+static DBusMessage *manager_enable_debug(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	return manager_toggle_debug(msg, TRUE);
+}
+
+static DBusMessage *manager_disable_debug(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	return manager_toggle_debug(msg, FALSE);
+}
+
+static void append_debug_site(struct ofono_debug_desc *desc, void *userdata)
+{
+	DBusMessageIter *array = userdata;
+	DBusMessageIter entry;
+	const char *file = desc->file ? desc->file : "";
+	const char *name = desc->name ? desc->name : "";
+	dbus_bool_t enabled = desc->flags & OFONO_DEBUG_FLAG_PRINT;
+	dbus_uint32_t hits = desc->hits;
+
+	dbus_message_iter_open_container(array, DBUS_TYPE_STRUCT,
+						NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &file);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_BOOLEAN, &enabled);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &hits);
+	dbus_message_iter_close_container(array, &entry);
+}
+
+static DBusMessage *manager_get_debug_sites(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	DBusMessage *reply;
+	DBusMessageIter iter;
+	DBusMessageIter array;
+	const char *pattern;
+
+	if (dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &pattern,
+					DBUS_TYPE_INVALID) == FALSE)
+		return __ofono_error_invalid_args(msg);
+
+	reply = dbus_message_new_method_return(msg);
+	if (reply == NULL)
+		return NULL;
+
+	dbus_message_iter_init_append(reply, &iter);
+
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+					DBUS_TYPE_STRING_AS_STRING
+					DBUS_TYPE_STRING_AS_STRING
+					DBUS_TYPE_BOOLEAN_AS_STRING
+					DBUS_TYPE_UINT32_AS_STRING
+					DBUS_STRUCT_END_CHAR_AS_STRING,
+					&array);
+	__ofono_log_foreach_debug(pattern, append_debug_site, &array);
+	dbus_message_iter_close_container(&iter, &array);
+
+	return reply;
+}
+
 static const GDBusMethodTable manager_methods[] = {
 	{ GDBUS_METHOD("GetModems",
 				NULL, GDBUS_ARGS({ "modems", "a(oa{sv})" }),
 				manager_get_modems) },
+	{ GDBUS_METHOD("SetDebug",
+				GDBUS_ARGS({ "patterns", "s" }), NULL,
+				manager_set_debug) },
+	{ GDBUS_METHOD("EnableDebug",
+				GDBUS_ARGS({ "patterns", "s" }), NULL,
+				manager_enable_debug) },
+	{ GDBUS_METHOD("DisableDebug",
+				GDBUS_ARGS({ "patterns", "s" }), NULL,
+				manager_disable_debug) },
+	{ GDBUS_METHOD("GetDebugSites",
+				GDBUS_ARGS({ "pattern", "s" }),
+				GDBUS_ARGS({ "sites", "a(ssbu)" }),
+				manager_get_debug_sites) },
 	{ }
 };
 
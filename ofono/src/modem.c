@@ -45,6 +45,12 @@ static int modems_remaining = 0;
 
 static struct ofono_watchlist *g_modemwatches = NULL;
 
+/*
+ * Atom watches are kept in one list per atom type.  The type is part of
+ * the watch id, so a watch can be removed without knowing its type.
+ */
+#define ATOM_WATCH_ID(type, id) ((id) * OFONO_ATOM_TYPE_COUNT + (type))
+
 enum property_type {
 	PROPERTY_TYPE_INVALID = 0,
 	PROPERTY_TYPE_STRING,
@@ -63,7 +69,8 @@ struct ofono_modem {
 	char			*path;
 	enum modem_state	modem_state;
 	GSList			*atoms;
-	struct ofono_watchlist	*atom_watches;
+	GSList			*atoms_by_type[OFONO_ATOM_TYPE_COUNT];
+	struct ofono_watchlist	*atom_watches[OFONO_ATOM_TYPE_COUNT];
 	GSList			*interface_list;
 	GSList			*feature_list;
 	unsigned int		call_ids;
@@ -110,11 +117,6 @@ struct ofono_atom {
 	struct ofono_modem *modem;
 };
 
-struct atom_watch {
-	struct ofono_watchlist_item item;
-	enum ofono_atom_type type;
-};
-
 struct modem_property {
 	enum property_type type;
 	void *value;
@@ -203,6 +205,8 @@ struct ofono_atom *__ofono_modem_add_atom(struct ofono_modem *modem,
 	atom->modem = modem;
 
 	modem->atoms = g_slist_prepend(modem->atoms, atom);
+	modem->atoms_by_type[type] = g_slist_prepend(modem->atoms_by_type[type],
+							atom);
 
 	return atom;
 }
@@ -240,19 +244,16 @@ static void call_watches(struct ofono_atom *atom,
 				enum ofono_atom_watch_condition cond)
 {
 	struct ofono_modem *modem = atom->modem;
-	GSList *atom_watches = modem->atom_watches->items;
+	GSList *atom_watches = modem->atom_watches[atom->type]->items;
 	GSList *l;
-	struct atom_watch *watch;
+	struct ofono_watchlist_item *item;
 	ofono_atom_watch_func notify;
 
 	for (l = atom_watches; l; l = l->next) {
-		watch = l->data;
-
-		if (watch->type != atom->type)
-			continue;
+		item = l->data;
 
-		notify = watch->item.notify;
-		notify(atom, cond, watch->item.notify_data);
+		notify = item->notify;
+		notify(atom, cond, item->notify_data);
 	}
 }
 
@@ -288,7 +289,7 @@ unsigned int __ofono_modem_add_atom_watch(struct ofono_modem *modem,
 					ofono_atom_watch_func notify,
 					void *data, ofono_destroy_func destroy)
 {
-	struct atom_watch *watch;
+	struct ofono_watchlist_item *item;
 	unsigned int id;
 	GSList *l;
 	struct ofono_atom *atom;
@@ -296,32 +297,33 @@ unsigned int __ofono_modem_add_atom_watch(struct ofono_modem *modem,
 	if (notify == NULL)
 		return 0;
 
-	watch = g_new0(struct atom_watch, 1);
+	item = g_new0(struct ofono_watchlist_item, 1);
 
-	watch->type = type;
-	watch->item.notify = notify;
-	watch->item.destroy = destroy;
-	watch->item.notify_data = data;
+	item->notify = notify;
+	item->destroy = destroy;
+	item->notify_data = data;
 
-	id = __ofono_watchlist_add_item(modem->atom_watches,
-					(struct ofono_watchlist_item *)watch);
+	id = __ofono_watchlist_add_item(modem->atom_watches[type], item);
 
-	for (l = modem->atoms; l; l = l->next) {
+	for (l = modem->atoms_by_type[type]; l; l = l->next) {
 		atom = l->data;
 
-		if (atom->type != type || atom->unregister == NULL)
+		if (atom->unregister == NULL)
 			continue;
 
 		notify(atom, OFONO_ATOM_WATCH_CONDITION_REGISTERED, data);
 	}
 
-	return id;
+	return ATOM_WATCH_ID(type, id);
 }
 
 gboolean __ofono_modem_remove_atom_watch(struct ofono_modem *modem,
 						unsigned int id)
 {
-	return __ofono_watchlist_remove_item(modem->atom_watches, id);
+	enum ofono_atom_type type = id % OFONO_ATOM_TYPE_COUNT;
+
+	return __ofono_watchlist_remove_item(modem->atom_watches[type],
+						id / OFONO_ATOM_TYPE_COUNT);
 }
 
 struct ofono_atom *__ofono_modem_find_atom(struct ofono_modem *modem,
@@ -333,10 +335,10 @@ struct ofono_atom *__ofono_modem_find_atom(struct ofono_modem *modem,
 	if (modem == NULL)
 		return NULL;
 
-	for (l = modem->atoms; l; l = l->next) {
+	for (l = modem->atoms_by_type[type]; l; l = l->next) {
 		atom = l->data;
 
-		if (atom->type == type && atom->unregister != NULL)
+		if (atom->unregister != NULL)
 			return atom;
 	}
 
@@ -353,12 +355,9 @@ void __ofono_modem_foreach_atom(struct ofono_modem *modem,
 	if (modem == NULL)
 		return;
 
-	for (l = modem->atoms; l; l = l->next) {
+	for (l = modem->atoms_by_type[type]; l; l = l->next) {
 		atom = l->data;
 
-		if (atom->type != type)
-			continue;
-
 		callback(atom, data);
 	}
 }
@@ -374,12 +373,9 @@ void __ofono_modem_foreach_registered_atom(struct ofono_modem *modem,
 	if (modem == NULL)
 		return;
 
-	for (l = modem->atoms; l; l = l->next) {
+	for (l = modem->atoms_by_type[type]; l; l = l->next) {
 		atom = l->data;
 
-		if (atom->type != type)
-			continue;
-
 		if (atom->unregister == NULL)
 			continue;
 
@@ -392,6 +388,8 @@ void __ofono_atom_free(struct ofono_atom *atom)
 	struct ofono_modem *modem = atom->modem;
 
 	modem->atoms = g_slist_remove(modem->atoms, atom);
+	modem->atoms_by_type[atom->type] =
+		g_slist_remove(modem->atoms_by_type[atom->type], atom);
 
 	__ofono_atom_unregister(atom);
 
@@ -426,6 +424,8 @@ static void flush_atoms(struct ofono_modem *modem, enum modem_state new_state)
 		if (atom->destruct)
 			atom->destruct(atom);
 
+		modem->atoms_by_type[atom->type] =
+			g_slist_remove(modem->atoms_by_type[atom->type], atom);
 		g_free(atom);
 
 		if (prev)
@@ -583,17 +583,7 @@ void __ofono_modem_remove_powered_watch(struct ofono_modem *modem,
 
 static gboolean modem_has_sim(struct ofono_modem *modem)
 {
-	GSList *l;
-	struct ofono_atom *atom;
-
-	for (l = modem->atoms; l; l = l->next) {
-		atom = l->data;
-
-		if (atom->type == OFONO_ATOM_TYPE_SIM)
-			return TRUE;
-	}
-
-	return FALSE;
+	return modem->atoms_by_type[OFONO_ATOM_TYPE_SIM] != NULL;
 }
 
 static void common_online_cb(const struct ofono_error *error, void *data)
@@ -1957,10 +1947,30 @@ ofono_bool_t ofono_modem_is_registered(struct ofono_modem *modem)
 	return TRUE;
 }
 
+static const struct ofono_modem_driver *probe_driver(
+						struct ofono_modem *modem)
+{
+	GSList *l;
+
+	for (l = g_driver_list; l; l = l->next) {
+		const struct ofono_modem_driver *drv = l->data;
+
+		if (g_strcmp0(drv->name, modem->driver_type))
+			continue;
+
+		if (drv->probe(modem) < 0)
+			continue;
+
+		return drv;
+	}
+
+	return NULL;
+}
+
 int ofono_modem_register(struct ofono_modem *modem)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
-	GSList *l;
+	int i;
 
 	DBG("%p", modem);
 
@@ -1973,18 +1983,12 @@ int ofono_modem_register(struct ofono_modem *modem)
 	if (modem->driver != NULL)
 		return -EALREADY;
 
-	for (l = g_driver_list; l; l = l->next) {
-		const struct ofono_modem_driver *drv = l->data;
+	modem->driver = probe_driver(modem);
 
-		if (g_strcmp0(drv->name, modem->driver_type))
-			continue;
-
-		if (drv->probe(modem) < 0)
-			continue;
-
-		modem->driver = drv;
-		break;
-	}
+	/* The driver may come from a plugin that is initialized on demand */
+	if (modem->driver == NULL &&
+			__ofono_plugin_init_deferred(modem->driver_type))
+		modem->driver = probe_driver(modem);
 
 	if (modem->driver == NULL)
 		return -ENODEV;
@@ -2006,7 +2010,9 @@ int ofono_modem_register(struct ofono_modem *modem)
 	g_free(modem->driver_type);
 	modem->driver_type = NULL;
 
-	modem->atom_watches = __ofono_watchlist_new(g_free);
+	for (i = 0; i < OFONO_ATOM_TYPE_COUNT; i++)
+		modem->atom_watches[i] = __ofono_watchlist_new(g_free);
+
 	modem->online_watches = __ofono_watchlist_new(g_free);
 	modem->powered_watches = __ofono_watchlist_new(g_free);
 
@@ -2035,14 +2041,17 @@ static void emit_modem_removed(struct ofono_modem *modem)
 static void modem_unregister(struct ofono_modem *modem)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
+	int i;
 
 	DBG("%p", modem);
 
 	if (modem->powered == TRUE)
 		set_powered(modem, FALSE);
 
-	__ofono_watchlist_free(modem->atom_watches);
-	modem->atom_watches = NULL;
+	for (i = 0; i < OFONO_ATOM_TYPE_COUNT; i++) {
+		__ofono_watchlist_free(modem->atom_watches[i]);
+		modem->atom_watches[i] = NULL;
+	}
 
 	__ofono_watchlist_free(modem->online_watches);
 	modem->online_watches = NULL;
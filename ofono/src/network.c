@@ -71,6 +71,13 @@ struct ofono_netreg {
 	int flags;
 	DBusMessage *pending;
 	int signal_strength;
+	int pending_strength;
+	int pending_location;
+	int pending_cellid;
+	gint64 strength_time;
+	gint64 cell_time;
+	guint strength_source;
+	guint cell_source;
 	struct sim_spdi *spdi;
 	struct sim_eons *eons;
 	struct ofono_sim *sim;
@@ -97,6 +104,15 @@ struct network_operator_data {
 
 static GSList *g_drivers = NULL;
 
+/*
+ * Strength changes smaller than strength_hysteresis percent are dropped,
+ * and Strength, LocationAreaCode and CellId are reported at most once per
+ * update_interval milliseconds.  Registration status and technology
+ * changes are always reported right away.
+ */
+static int strength_hysteresis = 0;
+static int update_interval = 0;
+
 static const char *registration_mode_to_string(int mode)
 {
 	switch (mode) {
@@ -423,6 +439,13 @@ static char *get_operator_display_name(struct ofono_netreg *netreg)
 	return name;
 }
 
+/* For changes that GetProperties shows without a PropertyChanged */
+static void netreg_properties_changed(struct ofono_netreg *netreg)
+{
+	__ofono_dbus_invalidate_properties(__ofono_atom_get_path(netreg->atom),
+					OFONO_NETWORK_REGISTRATION_INTERFACE);
+}
+
 static void netreg_emit_operator_display_name(struct ofono_netreg *netreg)
 {
 	const char *operator = get_operator_display_name(netreg);
@@ -784,6 +807,11 @@ static DBusMessage *network_get_properties(DBusConnection *conn,
 	const char *operator;
 	const char *mode = registration_mode_to_string(netreg->mode);
 
+	reply = __ofono_dbus_cached_properties(msg,
+					OFONO_NETWORK_REGISTRATION_INTERFACE);
+	if (reply != NULL)
+		return reply;
+
 	reply = dbus_message_new_method_return(msg);
 	if (reply == NULL)
 		return NULL;
@@ -847,6 +875,9 @@ static DBusMessage *network_get_properties(DBusConnection *conn,
 
 	dbus_message_iter_close_container(&iter, &dict);
 
+	__ofono_dbus_cache_properties(msg,
+				OFONO_NETWORK_REGISTRATION_INTERFACE, reply);
+
 	return reply;
 }
 
@@ -1069,8 +1100,10 @@ static void set_registration_location(struct ofono_netreg *netreg, int lac)
 
 	netreg->location = lac;
 
-	if (netreg->location == -1)
+	if (netreg->location == -1) {
+		netreg_properties_changed(netreg);
 		return;
+	}
 
 	ofono_dbus_signal_property_changed(conn, path,
 					OFONO_NETWORK_REGISTRATION_INTERFACE,
@@ -1086,8 +1119,10 @@ static void set_registration_cellid(struct ofono_netreg *netreg, int ci)
 
 	netreg->cellid = ci;
 
-	if (netreg->cellid == -1)
+	if (netreg->cellid == -1) {
+		netreg_properties_changed(netreg);
 		return;
+	}
 
 	ofono_dbus_signal_property_changed(conn, path,
 					OFONO_NETWORK_REGISTRATION_INTERFACE,
@@ -1102,8 +1137,10 @@ static void set_registration_technology(struct ofono_netreg *netreg, int tech)
 
 	netreg->technology = tech;
 
-	if (netreg->technology == -1)
+	if (netreg->technology == -1) {
+		netreg_properties_changed(netreg);
 		return;
+	}
 
 	ofono_dbus_signal_property_changed(conn, path,
 					OFONO_NETWORK_REGISTRATION_INTERFACE,
@@ -1132,8 +1169,10 @@ void __ofono_netreg_set_base_station_name(struct ofono_netreg *netreg,
 		 * We just got unregistered, set name to NULL
 		 * but don't emit signal
 		 */
-		if (netreg->current_operator == NULL)
+		if (netreg->current_operator == NULL) {
+			netreg_properties_changed(netreg);
 			return;
+		}
 	} else {
 		netreg->base_station = g_strdup(name);
 	}
@@ -1175,28 +1214,60 @@ gboolean __ofono_netreg_remove_status_watch(struct ofono_netreg *netreg,
 	return __ofono_watchlist_remove_item(netreg->status_watches, id);
 }
 
-static void notify_status_watches(struct ofono_netreg *netreg)
+static void notify_status_watches(struct ofono_netreg *netreg,
+					unsigned int changed)
 {
 	struct ofono_watchlist_item *item;
 	GSList *l;
 	ofono_netreg_status_notify_cb_t notify;
-	const char *mcc = NULL;
-	const char *mnc = NULL;
+	struct ofono_netreg_update update;
+
+	if (changed == 0)
+		return;
+
+	update.changed = changed;
+	update.status = netreg->status;
+	update.lac = netreg->location;
+	update.ci = netreg->cellid;
+	update.tech = netreg->technology;
+	update.strength = netreg->signal_strength;
+	update.mcc = NULL;
+	update.mnc = NULL;
 
 	if (netreg->current_operator) {
-		mcc = netreg->current_operator->mcc;
-		mnc = netreg->current_operator->mnc;
+		update.mcc = netreg->current_operator->mcc;
+		update.mnc = netreg->current_operator->mnc;
 	}
 
 	for (l = netreg->status_watches->items; l; l = l->next) {
 		item = l->data;
 		notify = item->notify;
 
-		notify(netreg->status, netreg->location, netreg->cellid,
-			netreg->technology, mcc, mnc, item->notify_data);
+		notify(&update, item->notify_data);
 	}
 }
 
+void __ofono_netreg_set_update_filter(int hysteresis, int interval_ms)
+{
+	strength_hysteresis = hysteresis;
+	update_interval = interval_ms;
+}
+
+/* Returns the ms left before another update may go out, 0 if none */
+static guint update_holdoff(gint64 last)
+{
+	gint64 elapsed;
+
+	if (update_interval <= 0 || last == 0)
+		return 0;
+
+	elapsed = (g_get_monotonic_time() - last) / 1000;
+	if (elapsed >= update_interval)
+		return 0;
+
+	return update_interval - elapsed;
+}
+
 static void reset_available(struct network_operator_data *old,
 				const struct ofono_network_operator *new)
 {
@@ -1207,12 +1278,11 @@ static void reset_available(struct network_operator_data *old,
 		set_network_operator_status(old, OPERATOR_STATUS_AVAILABLE);
 }
 
-static void current_operator_callback(const struct ofono_error *error,
-				const struct ofono_network_operator *current,
-				void *data)
+/* Returns OFONO_NETREG_UPDATE_OPERATOR if the current operator changed */
+static unsigned int set_current_operator(struct ofono_netreg *netreg,
+				const struct ofono_network_operator *current)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
-	struct ofono_netreg *netreg = data;
 	const char *path = __ofono_atom_get_path(netreg->atom);
 	GSList *op = NULL;
 
@@ -1227,13 +1297,8 @@ static void current_operator_callback(const struct ofono_error *error,
 			netreg->status != NETWORK_REGISTRATION_STATUS_ROAMING)
 		current = NULL;
 
-	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
-		DBG("Error during current operator");
-		return;
-	}
-
 	if (netreg->current_operator == NULL && current == NULL)
-		return;
+		return 0;
 
 	/* We got a new network operator, reset the previous one's status */
 	/* It will be updated properly later */
@@ -1256,7 +1321,7 @@ static void current_operator_callback(const struct ofono_error *error,
 		set_network_operator_name(opd, current->name);
 
 		if (netreg->current_operator == op->data)
-			return;
+			return 0;
 
 		netreg->current_operator = op->data;
 		goto emit;
@@ -1270,7 +1335,7 @@ static void current_operator_callback(const struct ofono_error *error,
 		if (opd->mcc[0] != '\0' && opd->mnc[0] != '\0' &&
 				!network_operator_dbus_register(netreg, opd)) {
 			g_free(opd);
-			return;
+			return 0;
 		} else
 			opd->netreg = netreg;
 
@@ -1304,7 +1369,21 @@ emit:
 		}
 	}
 
-	notify_status_watches(netreg);
+	return OFONO_NETREG_UPDATE_OPERATOR;
+}
+
+static void current_operator_callback(const struct ofono_error *error,
+				const struct ofono_network_operator *current,
+				void *data)
+{
+	struct ofono_netreg *netreg = data;
+
+	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
+		DBG("Error during current operator");
+		return;
+	}
+
+	notify_status_watches(netreg, set_current_operator(netreg, current));
 }
 
 static void signal_strength_callback(const struct ofono_error *error,
@@ -1339,19 +1418,149 @@ static void notify_emulator_status(struct ofono_atom *atom, void *data)
 	}
 }
 
+static void notify_emulator_strength(struct ofono_atom *atom, void *data)
+{
+	struct ofono_emulator *em = __ofono_atom_get_data(atom);
+	int val = 0;
+
+	if (GPOINTER_TO_INT(data) > 0)
+		val = (GPOINTER_TO_INT(data) - 1) / 20 + 1;
+
+	ofono_emulator_set_indicator(em, OFONO_EMULATOR_IND_SIGNAL, val);
+}
+
+static void set_signal_strength(struct ofono_netreg *netreg, int strength)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	struct ofono_modem *modem;
+
+	netreg->signal_strength = strength;
+	netreg->strength_time = g_get_monotonic_time();
+
+	if (strength != -1) {
+		const char *path = __ofono_atom_get_path(netreg->atom);
+		unsigned char strength_byte = netreg->signal_strength;
+
+		ofono_dbus_signal_property_changed(conn, path,
+					OFONO_NETWORK_REGISTRATION_INTERFACE,
+					"Strength", DBUS_TYPE_BYTE,
+					&strength_byte);
+	}
+
+	modem = __ofono_atom_get_modem(netreg->atom);
+	__ofono_modem_foreach_registered_atom(modem,
+				OFONO_ATOM_TYPE_EMULATOR_HFP,
+				notify_emulator_strength,
+				GINT_TO_POINTER(netreg->signal_strength));
+
+	notify_status_watches(netreg, OFONO_NETREG_UPDATE_STRENGTH);
+}
+
+static gboolean strength_update_timeout(gpointer user_data)
+{
+	struct ofono_netreg *netreg = user_data;
+
+	netreg->strength_source = 0;
+	set_signal_strength(netreg, netreg->pending_strength);
+
+	return FALSE;
+}
+
+static void cancel_pending_strength(struct ofono_netreg *netreg)
+{
+	if (netreg->strength_source == 0)
+		return;
+
+	g_source_remove(netreg->strength_source);
+	netreg->strength_source = 0;
+}
+
+static unsigned int set_registration_cell(struct ofono_netreg *netreg,
+						int lac, int ci)
+{
+	unsigned int changed = 0;
+
+	if (netreg->location != lac) {
+		set_registration_location(netreg, lac);
+
+		if (netreg->location == lac)
+			changed |= OFONO_NETREG_UPDATE_LOCATION;
+	}
+
+	if (netreg->cellid != ci) {
+		set_registration_cellid(netreg, ci);
+		changed |= OFONO_NETREG_UPDATE_CELLID;
+	}
+
+	if (changed)
+		netreg->cell_time = g_get_monotonic_time();
+
+	return changed;
+}
+
+static gboolean cell_update_timeout(gpointer user_data)
+{
+	struct ofono_netreg *netreg = user_data;
+	unsigned int changed;
+
+	netreg->cell_source = 0;
+
+	changed = set_registration_cell(netreg, netreg->pending_location,
+						netreg->pending_cellid);
+	notify_status_watches(netreg, changed);
+
+	return FALSE;
+}
+
+static void cancel_pending_cell(struct ofono_netreg *netreg)
+{
+	if (netreg->cell_source == 0)
+		return;
+
+	g_source_remove(netreg->cell_source);
+	netreg->cell_source = 0;
+}
+
 void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 			int lac, int ci, int tech)
 {
+	unsigned int changed = 0;
+	guint holdoff = 0;
+
 	if (netreg == NULL)
 		return;
 
 	DBG("%s status %d tech %d", __ofono_atom_get_path(netreg->atom),
 							status, tech);
 
+	/*
+	 * At cell edges the modem may hop between cells several times a
+	 * second.  When only the cell changed, report the latest one once
+	 * the holdoff has passed, or nothing if we are back where we were.
+	 */
+	if (netreg->status == status && netreg->technology == tech &&
+			(netreg->location != lac || netreg->cellid != ci))
+		holdoff = update_holdoff(netreg->cell_time);
+
+	if (holdoff > 0) {
+		netreg->pending_location = lac;
+		netreg->pending_cellid = ci;
+
+		if (netreg->cell_source == 0)
+			netreg->cell_source = g_timeout_add(holdoff,
+							cell_update_timeout,
+							netreg);
+
+		lac = netreg->location;
+		ci = netreg->cellid;
+	} else
+		cancel_pending_cell(netreg);
+
 	if (netreg->status != status) {
 		struct ofono_modem *modem;
 
 		set_registration_status(netreg, status);
+		changed |= OFONO_NETREG_UPDATE_STATUS;
 
 		modem = __ofono_atom_get_modem(netreg->atom);
 		__ofono_modem_foreach_registered_atom(modem,
@@ -1360,14 +1569,12 @@ void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 					GINT_TO_POINTER(netreg->status));
 	}
 
-	if (netreg->location != lac)
-		set_registration_location(netreg, lac);
-
-	if (netreg->cellid != ci)
-		set_registration_cellid(netreg, ci);
+	changed |= set_registration_cell(netreg, lac, ci);
 
-	if (netreg->technology != tech)
+	if (netreg->technology != tech) {
 		set_registration_technology(netreg, tech);
+		changed |= OFONO_NETREG_UPDATE_TECHNOLOGY;
+	}
 
 	if (netreg->status == NETWORK_REGISTRATION_STATUS_REGISTERED ||
 		netreg->status == NETWORK_REGISTRATION_STATUS_ROAMING) {
@@ -1379,18 +1586,21 @@ void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 			netreg->driver->strength(netreg,
 					signal_strength_callback, netreg);
 	} else {
-		struct ofono_error error;
+		changed |= set_current_operator(netreg, NULL);
+		__ofono_netreg_set_base_station_name(netreg, NULL);
 
-		error.type = OFONO_ERROR_TYPE_NO_ERROR;
-		error.error = 0;
+		cancel_pending_strength(netreg);
+		netreg->strength_time = 0;
 
-		current_operator_callback(&error, NULL, netreg);
-		__ofono_netreg_set_base_station_name(netreg, NULL);
+		if (netreg->signal_strength != -1) {
+			netreg->signal_strength = -1;
+			changed |= OFONO_NETREG_UPDATE_STRENGTH;
+		}
 
-		netreg->signal_strength = -1;
+		netreg_properties_changed(netreg);
 	}
 
-	notify_status_watches(netreg);
+	notify_status_watches(netreg, changed);
 }
 
 void ofono_netreg_time_notify(struct ofono_netreg *netreg,
@@ -1506,24 +1716,9 @@ static void init_registration_status(const struct ofono_error *error,
 	}
 }
 
-static void notify_emulator_strength(struct ofono_atom *atom, void *data)
-{
-	struct ofono_emulator *em = __ofono_atom_get_data(atom);
-	int val = 0;
-
-	if (GPOINTER_TO_INT(data) > 0)
-		val = (GPOINTER_TO_INT(data) - 1) / 20 + 1;
-
-	ofono_emulator_set_indicator(em, OFONO_EMULATOR_IND_SIGNAL, val);
-}
-
 void ofono_netreg_strength_notify(struct ofono_netreg *netreg, int strength)
 {
-	DBusConnection *conn = ofono_dbus_get_connection();
-	struct ofono_modem *modem;
-
-	if (netreg->signal_strength == strength)
-		return;
+	guint holdoff;
 
 	/*
 	 * Theoretically we can get signal strength even when not registered
@@ -1533,25 +1728,30 @@ void ofono_netreg_strength_notify(struct ofono_netreg *netreg, int strength)
 			netreg->status != NETWORK_REGISTRATION_STATUS_ROAMING)
 		return;
 
+	/* Back inside the band around the reported value, nothing to send */
+	if (netreg->signal_strength == strength ||
+			(strength != -1 && netreg->signal_strength != -1 &&
+			ABS(strength - netreg->signal_strength) <
+						strength_hysteresis)) {
+		cancel_pending_strength(netreg);
+		return;
+	}
+
 	DBG("strength %d", strength);
 
-	netreg->signal_strength = strength;
+	holdoff = update_holdoff(netreg->strength_time);
+	if (holdoff > 0) {
+		netreg->pending_strength = strength;
 
-	if (strength != -1) {
-		const char *path = __ofono_atom_get_path(netreg->atom);
-		unsigned char strength_byte = netreg->signal_strength;
-
-		ofono_dbus_signal_property_changed(conn, path,
-					OFONO_NETWORK_REGISTRATION_INTERFACE,
-					"Strength", DBUS_TYPE_BYTE,
-					&strength_byte);
+		if (netreg->strength_source == 0)
+			netreg->strength_source = g_timeout_add(holdoff,
+						strength_update_timeout,
+						netreg);
+		return;
 	}
 
-	modem = __ofono_atom_get_modem(netreg->atom);
-	__ofono_modem_foreach_registered_atom(modem,
-				OFONO_ATOM_TYPE_EMULATOR_HFP,
-				notify_emulator_strength,
-				GINT_TO_POINTER(netreg->signal_strength));
+	cancel_pending_strength(netreg);
+	set_signal_strength(netreg, strength);
 }
 
 static void sim_opl_read_cb(int ok, int length, int record,
@@ -1793,9 +1993,15 @@ static void netreg_unregister(struct ofono_atom *atom)
 
 	__ofono_modem_remove_atom_watch(modem, netreg->hfp_watch);
 
+	cancel_pending_strength(netreg);
+	cancel_pending_cell(netreg);
+
 	__ofono_watchlist_free(netreg->status_watches);
 	netreg->status_watches = NULL;
 
+	__ofono_dbus_invalidate_properties(path,
+					OFONO_NETWORK_REGISTRATION_INTERFACE);
+
 	for (l = netreg->operator_list; l; l = l->next) {
 		struct network_operator_data *opd = l->data;
 
@@ -35,10 +35,19 @@ void __ofono_modem_shutdown(void);
 #include <ofono/log.h>
 
 int __ofono_log_init(const char *program, const char *debug,
-						ofono_bool_t detach);
+			ofono_bool_t detach, unsigned int ring_size,
+			unsigned int rate);
 void __ofono_log_cleanup(void);
 void __ofono_log_enable(struct ofono_debug_desc *start,
 					struct ofono_debug_desc *stop);
+void __ofono_log_set_debug(const char *debug);
+void __ofono_log_enable_debug(const char *debug, ofono_bool_t enable);
+
+typedef void (*ofono_log_debug_func_t)(struct ofono_debug_desc *desc,
+					void *user_data);
+
+void __ofono_log_foreach_debug(const char *match,
+				ofono_log_debug_func_t func, void *user_data);
 
 #include <ofono/dbus.h>
 
@@ -73,6 +82,13 @@ DBusMessage *__ofono_error_from_error(const struct ofono_error *error,
 
 void __ofono_dbus_pending_reply(DBusMessage **msg, DBusMessage *reply);
 
+DBusMessage *__ofono_dbus_cached_properties(DBusMessage *msg,
+						const char *interface);
+void __ofono_dbus_cache_properties(DBusMessage *msg, const char *interface,
+					DBusMessage *reply);
+void __ofono_dbus_invalidate_properties(const char *path,
+					const char *interface);
+
 gboolean __ofono_dbus_valid_object_path(const char *path);
 
 struct ofono_watchlist_item {
@@ -97,7 +113,9 @@ void __ofono_watchlist_free(struct ofono_watchlist *watchlist);
 
 #include <ofono/plugin.h>
 
-int __ofono_plugin_init(const char *pattern, const char *exclude);
+int __ofono_plugin_init(const char *pattern, const char *exclude,
+				const char *defer, gboolean trace);
+gboolean __ofono_plugin_init_deferred(const char *driver);
 void __ofono_plugin_cleanup(void);
 
 #include <ofono/modem.h>
@@ -148,6 +166,7 @@ enum ofono_atom_type {
 	OFONO_ATOM_TYPE_CDMA_SMS,
 	OFONO_ATOM_TYPE_CDMA_NETREG,
 	OFONO_ATOM_TYPE_HANDSFREE,
+	OFONO_ATOM_TYPE_COUNT, /* number of atom types, not a type */
 };
 
 enum ofono_atom_watch_condition {
@@ -219,6 +238,38 @@ unsigned int __ofono_modemwatch_add(ofono_modemwatch_cb_t cb, void *user,
 					ofono_destroy_func destroy);
 gboolean __ofono_modemwatch_remove(unsigned int id);
 
+struct ofono_rtnl_stats {
+	guint64 rx_packets;
+	guint64 tx_packets;
+	guint64 rx_bytes;
+	guint64 tx_bytes;
+	guint64 rx_errors;
+	guint64 tx_errors;
+	guint64 rx_dropped;
+	guint64 tx_dropped;
+};
+
+struct ofono_rtnl_batch;
+
+int __ofono_rtnl_init(void);
+void __ofono_rtnl_cleanup(void);
+
+struct ofono_rtnl_batch *__ofono_rtnl_batch_new(const char *interface);
+void __ofono_rtnl_batch_set_link(struct ofono_rtnl_batch *batch,
+					ofono_bool_t up, unsigned int mtu);
+void __ofono_rtnl_batch_add_address(struct ofono_rtnl_batch *batch,
+					const char *address,
+					unsigned char prefixlen);
+void __ofono_rtnl_batch_del_address(struct ofono_rtnl_batch *batch,
+					const char *address,
+					unsigned char prefixlen);
+void __ofono_rtnl_batch_add_host_route(struct ofono_rtnl_batch *batch,
+					const char *destination);
+int __ofono_rtnl_batch_commit(struct ofono_rtnl_batch *batch);
+
+int __ofono_rtnl_get_stats(const char *interface,
+				struct ofono_rtnl_stats *stats);
+
 typedef void (*ofono_modem_online_notify_func)(struct ofono_modem *modem,
 						ofono_bool_t online,
 						void *data);
@@ -427,9 +478,33 @@ void __ofono_ussd_initiate_cancel(struct ofono_ussd *ussd);
 
 #include <ofono/netreg.h>
 
-typedef void (*ofono_netreg_status_notify_cb_t)(int status, int lac, int ci,
-			int tech, const char *mcc, const char *mnc,
-			void *data);
+enum ofono_netreg_update_flag {
+	OFONO_NETREG_UPDATE_STATUS =		0x01,
+	OFONO_NETREG_UPDATE_LOCATION =		0x02,
+	OFONO_NETREG_UPDATE_CELLID =		0x04,
+	OFONO_NETREG_UPDATE_TECHNOLOGY =	0x08,
+	OFONO_NETREG_UPDATE_OPERATOR =		0x10,
+	OFONO_NETREG_UPDATE_STRENGTH =		0x20,
+};
+
+/*
+ * Everything that changed in one registration report, with the current
+ * value of every field.  changed is a mask of ofono_netreg_update_flag.
+ */
+struct ofono_netreg_update {
+	unsigned int changed;
+	int status;
+	int lac;
+	int ci;
+	int tech;
+	int strength;
+	const char *mcc;
+	const char *mnc;
+};
+
+typedef void (*ofono_netreg_status_notify_cb_t)(
+				const struct ofono_netreg_update *update,
+				void *data);
 
 unsigned int __ofono_netreg_add_status_watch(struct ofono_netreg *netreg,
 				ofono_netreg_status_notify_cb_t cb,
@@ -441,6 +516,9 @@ gboolean __ofono_netreg_remove_status_watch(struct ofono_netreg *netreg,
 void __ofono_netreg_set_base_station_name(struct ofono_netreg *netreg,
 						const char *name);
 
+void __ofono_netreg_set_update_filter(int strength_hysteresis,
+					int interval_ms);
+
 #include <ofono/history.h>
 
 void __ofono_history_probe_drivers(struct ofono_modem *modem);
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -36,12 +37,22 @@
 #include "ofono.h"
 
 #include "common.h"
+#include "simutil.h"
+#include "storage.h"
 
 #define LEN_MAX 128
 #define TYPE_INTERNATIONAL 145
+#define LINE_DELIMIT 75
+
+/* Room for a few hundred entries, enough for most SIMs without growing */
+#define VCARDS_SIZE_HINT 65536
+/* Size above which streamed vCards are sent out */
+#define VCARDS_CHUNK_SIZE 16384
 
 #define PHONEBOOK_FLAG_CACHED 0x1
 
+#define SNAPSHOT_STORE "phonebook"
+
 static GSList *g_drivers = NULL;
 
 enum phonebook_number_type {
@@ -57,7 +68,17 @@ struct ofono_phonebook {
 	int storage_index; /* go through all supported storage */
 	int flags;
 	GString *vcards; /* entries with vcard 3.0 format */
+	GString *chunk; /* entries not yet streamed, NULL if not streaming */
 	GSList *merge_list; /* cache the entries that may need a merge */
+	GHashTable *merge_table; /* merge_list entries by name */
+	struct ofono_sim *sim;
+	struct ofono_sim_context *sim_context;
+	char *counters; /* EFpsc and EFcc of the SIM phonebooks, NULL if none */
+	GString *counters_read; /* counters read so far */
+	unsigned int counters_path; /* phonebook whose counters are read */
+	gboolean counters_found; /* any phonebook had counters */
+	char psc[9]; /* EFpsc of the phonebook being read */
+	gsize sm_start; /* where the SM entries start in vcards */
 	const struct ofono_phonebook_driver *driver;
 	void *driver_data;
 	struct ofono_atom *atom;
@@ -79,28 +100,32 @@ struct phonebook_person {
 };
 
 static const char *storage_support[] = { "SM", "ME", NULL };
+
+/*
+ * Depending on the modem, the SM storage is either the phonebook in
+ * DFtelecom or the one local to the USIM application.  Each DFphonebook
+ * holds change counters of its own.
+ */
+static const unsigned char phonebook_paths[][6] = {
+	{ 0x3F, 0x00, 0x7F, 0x10, 0x5F, 0x3A },
+	{ 0x3F, 0x00, 0x7F, 0xFF, 0x5F, 0x3A },
+};
+
 static void export_phonebook(struct ofono_phonebook *pb);
 
 /* according to RFC 2425, the output string may need folding */
 static void vcard_printf(GString *str, const char *fmt, ...)
 {
-	char buf[1024];
+	gsize pos = str->len + LINE_DELIMIT;
 	va_list ap;
-	int len_temp, line_number, i;
-	unsigned int line_delimit = 75;
 
 	va_start(ap, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, ap);
+	g_string_append_vprintf(str, fmt, ap);
 	va_end(ap);
 
-	line_number = strlen(buf) / line_delimit + 1;
-
-	for (i = 0; i < line_number; i++) {
-		len_temp = MIN(line_delimit, strlen(buf) - line_delimit * i);
-		g_string_append_len(str,  buf + line_delimit * i, len_temp);
-		if (i != line_number - 1)
-			g_string_append(str, "\r\n ");
-	}
+	/* Fold in place, only the line just printed is moved */
+	for (; pos < str->len; pos += LINE_DELIMIT + 3)
+		g_string_insert_len(str, pos, "\r\n ", 3);
 
 	g_string_append(str, "\r\n");
 }
@@ -270,6 +295,42 @@ static void destroy_merged_entry(struct phonebook_person *person)
 	g_free(person);
 }
 
+static GString *phonebook_output(struct ofono_phonebook *pb)
+{
+	return pb->chunk ? pb->chunk : pb->vcards;
+}
+
+static void phonebook_stream(struct ofono_phonebook *pb, gboolean last)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	const char *path = __ofono_atom_get_path(pb->atom);
+	DBusMessage *signal;
+
+	if (pb->chunk == NULL)
+		return;
+
+	if (pb->chunk->len < VCARDS_CHUNK_SIZE &&
+			(last == FALSE || pb->chunk->len == 0))
+		return;
+
+	signal = dbus_message_new_signal(path, OFONO_PHONEBOOK_INTERFACE,
+						"ImportChunk");
+	if (signal == NULL)
+		goto out;
+
+	/* The entries are private, don't broadcast them to the whole bus */
+	dbus_message_set_destination(signal,
+				dbus_message_get_sender(pb->pending));
+
+	dbus_message_append_args(signal, DBUS_TYPE_STRING, &pb->chunk->str,
+					DBUS_TYPE_INVALID);
+
+	g_dbus_send_message(conn, signal);
+
+out:
+	g_string_truncate(pb->chunk, 0);
+}
+
 static DBusMessage *generate_export_entries_reply(struct ofono_phonebook *pb,
 							DBusMessage *msg)
 {
@@ -351,6 +412,8 @@ void ofono_phonebook_entry(struct ofono_phonebook *phonebook, int index,
 				const char *secondtext, const char *email,
 				const char *sip_uri, const char *tel_uri)
 {
+	GString *vcards;
+
 	/* There's really nothing to do */
 	if ((number == NULL || number[0] == '\0') &&
 			(text == NULL || text[0] == '\0'))
@@ -363,23 +426,21 @@ void ofono_phonebook_entry(struct ofono_phonebook *phonebook, int index,
 	 * are deemed as entries of one person.
 	 */
 	if (need_merge(text)) {
-		GSList *l;
 		size_t len_text = strlen(text) - 2;
+		char *name = g_strndup(text, len_text);
 		struct phonebook_person *person;
 
-		for (l = phonebook->merge_list; l; l = l->next) {
-			person = l->data;
-			if (!strncmp(text, person->text, len_text) &&
-					(strlen(person->text) == len_text))
-				break;
-		}
+		person = g_hash_table_lookup(phonebook->merge_table, name);
 
-		if (l == NULL) {
+		if (person == NULL) {
 			person = g_new0(struct phonebook_person, 1);
 			phonebook->merge_list =
 				g_slist_prepend(phonebook->merge_list, person);
-			person->text = g_strndup(text, len_text);
-		}
+			person->text = name;
+			g_hash_table_insert(phonebook->merge_table,
+						person->text, person);
+		} else
+			g_free(name);
 
 		merge_field_number(&(person->number_list), number, type,
 					text[len_text + 1]);
@@ -393,20 +454,95 @@ void ofono_phonebook_entry(struct ofono_phonebook *phonebook, int index,
 		return;
 	}
 
-	vcard_printf_begin(phonebook->vcards);
+	vcards = phonebook_output(phonebook);
+
+	vcard_printf_begin(vcards);
 
 	if (text == NULL || text[0] == '\0')
-		vcard_printf_text(phonebook->vcards, number);
+		vcard_printf_text(vcards, number);
 	else
-		vcard_printf_text(phonebook->vcards, text);
+		vcard_printf_text(vcards, text);
 
-	vcard_printf_number(phonebook->vcards, number, type, TEL_TYPE_OTHER);
-	vcard_printf_number(phonebook->vcards, adnumber, adtype,
-				TEL_TYPE_OTHER);
-	vcard_printf_group(phonebook->vcards, group);
-	vcard_printf_email(phonebook->vcards, email);
-	vcard_printf_sip_uri(phonebook->vcards, sip_uri);
-	vcard_printf_end(phonebook->vcards);
+	vcard_printf_number(vcards, number, type, TEL_TYPE_OTHER);
+	vcard_printf_number(vcards, adnumber, adtype, TEL_TYPE_OTHER);
+	vcard_printf_group(vcards, group);
+	vcard_printf_email(vcards, email);
+	vcard_printf_sip_uri(vcards, sip_uri);
+	vcard_printf_end(vcards);
+
+	phonebook_stream(phonebook, FALSE);
+}
+
+/*
+ * The SIM entries are kept per ICCID, together with the change counters
+ * they were read with.  As long as the counters are the same, nothing was
+ * written to the SIM phonebook and the entries can be used as they are.
+ */
+static gboolean phonebook_restore(struct ofono_phonebook *pb)
+{
+	const char *iccid = ofono_sim_get_iccid(pb->sim);
+	GKeyFile *snapshot;
+	char *counters;
+	char *entries;
+	gboolean restored = FALSE;
+
+	if (pb->counters == NULL || iccid == NULL)
+		return FALSE;
+
+	snapshot = storage_open(iccid, SNAPSHOT_STORE);
+	if (snapshot == NULL)
+		return FALSE;
+
+	counters = g_key_file_get_string(snapshot, "SM", "ChangeCounters",
+						NULL);
+	entries = g_key_file_get_string(snapshot, "SM", "Entries", NULL);
+
+	if (entries && g_strcmp0(counters, pb->counters) == 0) {
+		DBG("SIM entries restored, counters: %s", counters);
+
+		g_string_append(phonebook_output(pb), entries);
+		phonebook_stream(pb, FALSE);
+		restored = TRUE;
+	}
+
+	g_free(entries);
+	g_free(counters);
+	storage_close(iccid, SNAPSHOT_STORE, snapshot, FALSE);
+
+	return restored;
+}
+
+/* The snapshot holds the subscriber's contacts, only we may read it */
+static void phonebook_save(struct ofono_phonebook *pb)
+{
+	const char *iccid = ofono_sim_get_iccid(pb->sim);
+	GKeyFile *snapshot;
+	char *entries;
+	char *data;
+	gsize length = 0;
+
+	/* Streamed entries are not kept around */
+	if (pb->counters == NULL || iccid == NULL || pb->chunk)
+		return;
+
+	snapshot = storage_open(iccid, SNAPSHOT_STORE);
+	if (snapshot == NULL)
+		return;
+
+	entries = g_strndup(pb->vcards->str + pb->sm_start,
+				pb->vcards->len - pb->sm_start);
+
+	g_key_file_set_string(snapshot, "SM", "ChangeCounters", pb->counters);
+	g_key_file_set_string(snapshot, "SM", "Entries", entries);
+	g_free(entries);
+
+	data = g_key_file_to_data(snapshot, &length, NULL);
+	if (data)
+		write_file((unsigned char *) data, length, S_IRUSR | S_IWUSR,
+				STORAGEDIR "/%s/" SNAPSHOT_STORE, iccid);
+
+	g_free(data);
+	storage_close(iccid, SNAPSHOT_STORE, snapshot, FALSE);
 }
 
 static void export_phonebook_cb(const struct ofono_error *error, void *data)
@@ -420,12 +556,19 @@ static void export_phonebook_cb(const struct ofono_error *error, void *data)
 	/* convert the collected entries that are already merged to vcard */
 	phonebook->merge_list = g_slist_reverse(phonebook->merge_list);
 	g_slist_foreach(phonebook->merge_list, (GFunc) print_merged_entry,
-				phonebook->vcards);
+				phonebook_output(phonebook));
+	g_hash_table_remove_all(phonebook->merge_table);
 	g_slist_foreach(phonebook->merge_list, (GFunc) destroy_merged_entry,
 				NULL);
 	g_slist_free(phonebook->merge_list);
 	phonebook->merge_list = NULL;
 
+	phonebook_stream(phonebook, FALSE);
+
+	if (error->type == OFONO_ERROR_TYPE_NO_ERROR &&
+			phonebook->storage_index == 0)
+		phonebook_save(phonebook);
+
 	phonebook->storage_index++;
 	export_phonebook(phonebook);
 	return;
@@ -436,12 +579,29 @@ static void export_phonebook(struct ofono_phonebook *phonebook)
 	DBusMessage *reply;
 	const char *pb = storage_support[phonebook->storage_index];
 
+	if (phonebook->storage_index == 0 && phonebook_restore(phonebook))
+		pb = storage_support[++phonebook->storage_index];
+
 	if (pb) {
+		if (phonebook->storage_index == 0)
+			phonebook->sm_start = phonebook_output(phonebook)->len;
+
 		phonebook->driver->export_entries(phonebook, pb,
 						export_phonebook_cb, phonebook);
 		return;
 	}
 
+	if (phonebook->chunk) {
+		phonebook_stream(phonebook, TRUE);
+		g_string_free(phonebook->chunk, TRUE);
+		phonebook->chunk = NULL;
+
+		__ofono_dbus_pending_reply(&phonebook->pending,
+				dbus_message_new_method_return(
+							phonebook->pending));
+		return;
+	}
+
 	reply = generate_export_entries_reply(phonebook, phonebook->pending);
 	if (reply == NULL) {
 		dbus_message_unref(phonebook->pending);
@@ -452,6 +612,107 @@ static void export_phonebook(struct ofono_phonebook *phonebook)
 	phonebook->flags |= PHONEBOOK_FLAG_CACHED;
 }
 
+static void read_counters(struct ofono_phonebook *pb);
+
+static void next_counters(struct ofono_phonebook *pb, const char *counters)
+{
+	if (pb->counters_path > 0)
+		g_string_append_c(pb->counters_read, ',');
+
+	if (counters) {
+		g_string_append(pb->counters_read, counters);
+		pb->counters_found = TRUE;
+	} else
+		g_string_append_c(pb->counters_read, '-');
+
+	pb->counters_path++;
+	read_counters(pb);
+}
+
+static void cc_read_cb(int ok, int length, int record,
+			const unsigned char *data, int record_length,
+			void *userdata)
+{
+	struct ofono_phonebook *pb = userdata;
+	char *counters = NULL;
+
+	if (ok && length >= 2)
+		counters = g_strdup_printf("%s%02hhX%02hhX", pb->psc,
+							data[0], data[1]);
+
+	next_counters(pb, counters);
+	g_free(counters);
+}
+
+static void psc_read_cb(int ok, int length, int record,
+			const unsigned char *data, int record_length,
+			void *userdata)
+{
+	struct ofono_phonebook *pb = userdata;
+
+	if (!ok || length < 4)
+		goto out;
+
+	snprintf(pb->psc, sizeof(pb->psc), "%02hhX%02hhX%02hhX%02hhX",
+					data[0], data[1], data[2], data[3]);
+
+	if (ofono_sim_read_bytes(pb->sim_context, SIM_EFCC_FILEID, 0, 2,
+					phonebook_paths[pb->counters_path],
+					sizeof(phonebook_paths[0]),
+					cc_read_cb, pb) == 0)
+		return;
+
+out:
+	next_counters(pb, NULL);
+}
+
+/*
+ * The counters of every DFphonebook are kept.  A SIM without any, like
+ * a 2G SIM, is always read.
+ */
+static void read_counters(struct ofono_phonebook *pb)
+{
+	if (pb->counters_path == G_N_ELEMENTS(phonebook_paths)) {
+		if (pb->counters_found)
+			pb->counters = g_string_free(pb->counters_read, FALSE);
+		else
+			g_string_free(pb->counters_read, TRUE);
+
+		pb->counters_read = NULL;
+
+		DBG("counters: %s", pb->counters);
+		export_phonebook(pb);
+		return;
+	}
+
+	if (ofono_sim_read_bytes(pb->sim_context, SIM_EFPSC_FILEID, 0, 4,
+					phonebook_paths[pb->counters_path],
+					sizeof(phonebook_paths[0]),
+					psc_read_cb, pb) == 0)
+		return;
+
+	next_counters(pb, NULL);
+}
+
+static void start_export(struct ofono_phonebook *pb)
+{
+	g_free(pb->counters);
+	pb->counters = NULL;
+
+	pb->storage_index = 0;
+
+	if (pb->sim_context == NULL || ofono_sim_get_iccid(pb->sim) == NULL) {
+		export_phonebook(pb);
+		return;
+	}
+
+	pb->counters_read = g_string_new(NULL);
+	pb->counters_path = 0;
+	pb->counters_found = FALSE;
+
+	read_counters(pb);
+}
+
 static DBusMessage *import_entries(DBusConnection *conn, DBusMessage *msg,
 					void *data)
 {
@@ -470,11 +731,33 @@ static DBusMessage *import_entries(DBusConnection *conn, DBusMessage *msg,
 		return NULL;
 	}
 
+	/* Most of the time the phonebook is only imported once */
+	if (phonebook->vcards->allocated_len < VCARDS_SIZE_HINT) {
+		g_string_free(phonebook->vcards, TRUE);
+		phonebook->vcards = g_string_sized_new(VCARDS_SIZE_HINT);
+	}
+
 	g_string_set_size(phonebook->vcards, 0);
-	phonebook->storage_index = 0;
 
 	phonebook->pending = dbus_message_ref(msg);
-	export_phonebook(phonebook);
+	start_export(phonebook);
+
+	return NULL;
+}
+
+static DBusMessage *import_entries_streamed(DBusConnection *conn,
+						DBusMessage *msg, void *data)
+{
+	struct ofono_phonebook *phonebook = data;
+
+	if (phonebook->pending)
+		return __ofono_error_busy(msg);
+
+	/* The cache is left untouched, the SIM snapshot is still used */
+	phonebook->chunk = g_string_sized_new(VCARDS_CHUNK_SIZE * 2);
+
+	phonebook->pending = dbus_message_ref(msg);
+	start_export(phonebook);
 
 	return NULL;
 }
@@ -483,10 +766,13 @@ static const GDBusMethodTable phonebook_methods[] = {
 	{ GDBUS_ASYNC_METHOD("Import",
 			NULL, GDBUS_ARGS({ "entries", "s" }),
 			import_entries) },
+	{ GDBUS_ASYNC_METHOD("ImportStreamed", NULL, NULL,
+			import_entries_streamed) },
 	{ }
 };
 
 static const GDBusSignalTable phonebook_signals[] = {
+	{ GDBUS_SIGNAL("ImportChunk", GDBUS_ARGS({ "entries", "s" })) },
 	{ }
 };
 
@@ -516,6 +802,13 @@ static void phonebook_unregister(struct ofono_atom *atom)
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct ofono_modem *modem = __ofono_atom_get_modem(pb->atom);
 
+	if (pb->sim_context) {
+		ofono_sim_context_free(pb->sim_context);
+		pb->sim_context = NULL;
+	}
+
+	pb->sim = NULL;
+
 	ofono_modem_remove_interface(modem, OFONO_PHONEBOOK_INTERFACE);
 	g_dbus_unregister_interface(conn, path, OFONO_PHONEBOOK_INTERFACE);
 }
@@ -532,7 +825,16 @@ static void phonebook_remove(struct ofono_atom *atom)
 	if (pb->driver && pb->driver->remove)
 		pb->driver->remove(pb);
 
+	if (pb->chunk)
+		g_string_free(pb->chunk, TRUE);
+
+	g_hash_table_destroy(pb->merge_table);
 	g_string_free(pb->vcards, TRUE);
+	g_free(pb->counters);
+
+	if (pb->counters_read)
+		g_string_free(pb->counters_read, TRUE);
+
 	g_free(pb);
 }
 
@@ -552,6 +854,7 @@ struct ofono_phonebook *ofono_phonebook_create(struct ofono_modem *modem,
 		return NULL;
 
 	pb->vcards = g_string_new(NULL);
+	pb->merge_table = g_hash_table_new(g_str_hash, g_str_equal);
 	pb->atom = __ofono_modem_add_atom(modem, OFONO_ATOM_TYPE_PHONEBOOK,
 						phonebook_remove, pb);
 
@@ -588,6 +891,10 @@ void ofono_phonebook_register(struct ofono_phonebook *pb)
 
 	ofono_modem_add_interface(modem, OFONO_PHONEBOOK_INTERFACE);
 
+	pb->sim = __ofono_atom_find(OFONO_ATOM_TYPE_SIM, modem);
+	if (pb->sim)
+		pb->sim_context = ofono_sim_context_create(pb->sim);
+
 	__ofono_atom_register(pb->atom, phonebook_unregister);
 }
 
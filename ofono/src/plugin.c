@@ -30,10 +30,13 @@
 #include "ofono.h"
 
 static GSList *plugins = NULL;
+static gboolean startup_trace = FALSE;
 
 struct ofono_plugin {
 	void *handle;
 	gboolean active;
+	gboolean deferred; /* initialized when a modem of its type appears */
+	gint64 load_time; /* time spent in dlopen, in microseconds */
 	struct ofono_plugin_desc *desc;
 };
 
@@ -45,22 +48,23 @@ static gint compare_priority(gconstpointer a, gconstpointer b)
 	return plugin2->desc->priority - plugin1->desc->priority;
 }
 
-static gboolean add_plugin(void *handle, struct ofono_plugin_desc *desc)
+static struct ofono_plugin *add_plugin(void *handle,
+					struct ofono_plugin_desc *desc)
 {
 	struct ofono_plugin *plugin;
 
 	if (desc->init == NULL)
-		return FALSE;
+		return NULL;
 
 	if (g_str_equal(desc->version, OFONO_VERSION) == FALSE) {
 		ofono_error("Invalid version %s for %s", desc->version,
 							desc->description);
-		return FALSE;
+		return NULL;
 	}
 
 	plugin = g_try_new0(struct ofono_plugin, 1);
 	if (plugin == NULL)
-		return FALSE;
+		return NULL;
 
 	plugin->handle = handle;
 	plugin->active = FALSE;
@@ -70,7 +74,7 @@ static gboolean add_plugin(void *handle, struct ofono_plugin_desc *desc)
 
 	plugins = g_slist_insert_sorted(plugins, plugin, compare_priority);
 
-	return TRUE;
+	return plugin;
 }
 
 static gboolean check_plugin(struct ofono_plugin_desc *desc,
@@ -99,26 +103,127 @@ static gboolean check_plugin(struct ofono_plugin_desc *desc,
 	return TRUE;
 }
 
+static gboolean match_plugin(struct ofono_plugin_desc *desc, char **patterns)
+{
+	if (patterns == NULL)
+		return FALSE;
+
+	for (; *patterns; patterns++)
+		if (g_pattern_match_simple(*patterns, desc->name))
+			return TRUE;
+
+	return FALSE;
+}
+
+static gboolean defer_plugin(struct ofono_plugin *plugin, char **defers)
+{
+	if (match_plugin(plugin->desc, defers) == FALSE)
+		return FALSE;
+
+	/* Only plugins that just register modem drivers can wait */
+	if (plugin->desc->modem_drivers == NULL) {
+		ofono_warn("Plugin %s can't be deferred", plugin->desc->name);
+		return FALSE;
+	}
+
+	DBG("Deferring %s", plugin->desc->name);
+	plugin->deferred = TRUE;
+
+	return TRUE;
+}
+
+static void init_plugin(struct ofono_plugin *plugin)
+{
+	gint64 start = g_get_monotonic_time();
+	int err;
+
+	err = plugin->desc->init();
+
+	if (startup_trace)
+		ofono_info("Plugin %s: load %d us, init %d us%s",
+				plugin->desc->name, (int) plugin->load_time,
+				(int) (g_get_monotonic_time() - start),
+				err < 0 ? " (failed)" : "");
+
+	if (err < 0)
+		return;
+
+	plugin->active = TRUE;
+}
+
+static gboolean provides_driver(struct ofono_plugin_desc *desc,
+					const char *driver)
+{
+	const char **drivers;
+
+	for (drivers = desc->modem_drivers; *drivers; drivers++)
+		if (g_str_equal(*drivers, driver))
+			return TRUE;
+
+	return FALSE;
+}
+
+/*
+ * Initialize the deferred plugin providing a modem driver on first use.
+ * Returns TRUE if a plugin was initialized, so that the caller can look
+ * again for the modem driver.
+ */
+gboolean __ofono_plugin_init_deferred(const char *driver)
+{
+	GSList *list;
+
+	if (driver == NULL)
+		return FALSE;
+
+	for (list = plugins; list; list = list->next) {
+		struct ofono_plugin *plugin = list->data;
+
+		if (plugin->deferred == FALSE)
+			continue;
+
+		if (provides_driver(plugin->desc, driver) == FALSE)
+			continue;
+
+		DBG("%s for %s", plugin->desc->name, driver);
+
+		plugin->deferred = FALSE;
+		init_plugin(plugin);
+
+		return plugin->active;
+	}
+
+	return FALSE;
+}
+
 #include "builtin.h"
 
-int __ofono_plugin_init(const char *pattern, const char *exclude)
+int __ofono_plugin_init(const char *pattern, const char *exclude,
+				const char *defer, gboolean trace)
 {
 	gchar **patterns = NULL;
 	gchar **excludes = NULL;
+	gchar **defers = NULL;
 	GSList *list;
 	GDir *dir;
 	const gchar *file;
 	gchar *filename;
 	unsigned int i;
+	gint64 start = g_get_monotonic_time();
+	gint64 loaded;
 
 	DBG("");
 
+	startup_trace = trace;
+
 	if (pattern)
 		patterns = g_strsplit_set(pattern, ":, ", -1);
 
 	if (exclude)
 		excludes = g_strsplit_set(exclude, ":, ", -1);
 
+	if (defer)
+		defers = g_strsplit_set(defer, ":, ", -1);
+
 	for (i = 0; __ofono_builtin[i]; i++) {
 		if (check_plugin(__ofono_builtin[i],
 					patterns, excludes) == FALSE)
@@ -132,6 +237,8 @@ int __ofono_plugin_init(const char *pattern, const char *exclude)
 		while ((file = g_dir_read_name(dir)) != NULL) {
 			void *handle;
 			struct ofono_plugin_desc *desc;
+			struct ofono_plugin *plugin;
+			gint64 opened = g_get_monotonic_time();
 
 			if (g_str_has_prefix(file, "lib") == TRUE ||
 					g_str_has_suffix(file, ".so") == FALSE)
@@ -162,24 +269,37 @@ int __ofono_plugin_init(const char *pattern, const char *exclude)
 				continue;
 			}
 
-			if (add_plugin(handle, desc) == FALSE)
+			plugin = add_plugin(handle, desc);
+			if (plugin == NULL) {
 				dlclose(handle);
+				continue;
+			}
+
+			plugin->load_time = g_get_monotonic_time() - opened;
 		}
 
 		g_dir_close(dir);
 	}
 
+	loaded = g_get_monotonic_time();
+
 	for (list = plugins; list; list = list->next) {
 		struct ofono_plugin *plugin = list->data;
 
-		if (plugin->desc->init() < 0)
+		if (defer_plugin(plugin, defers) == TRUE)
 			continue;
 
-		plugin->active = TRUE;
+		init_plugin(plugin);
 	}
 
+	if (startup_trace)
+		ofono_info("Plugins: load %d us, init %d us",
+				(int) (loaded - start),
+				(int) (g_get_monotonic_time() - loaded));
+
 	g_strfreev(patterns);
 	g_strfreev(excludes);
+	g_strfreev(defers);
 
 	return 0;
 }
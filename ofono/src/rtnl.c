@@ -0,0 +1,631 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#include <glib.h>
+
+#include "ofono.h"
+
+#define RTNL_BUFFER_SIZE 4096
+#define RTNL_MAX_OPS 16
+
+struct rtnl_op {
+	const char *what;
+	int ignore;		/* errno that counts as success */
+};
+
+struct ofono_rtnl_batch {
+	char *interface;
+	int index;
+	unsigned int n_ops;
+	struct rtnl_op ops[RTNL_MAX_OPS];
+	gboolean overflow;
+	size_t last;
+	size_t len;
+	unsigned char buf[RTNL_BUFFER_SIZE];
+};
+
+struct rtnl_request {
+	const char *interface;
+	uint32_t seq;
+	unsigned int n_ops;
+	const struct rtnl_op *ops;
+	unsigned int acked;
+	int err;
+	int index;
+	struct ofono_rtnl_stats *stats;
+};
+
+static int rtnl_fd = -1;
+static guint rtnl_watch;
+static uint32_t rtnl_portid;
+static uint32_t rtnl_seq;
+static GHashTable *index_cache;
+
+static void cache_remove_index(int index)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	g_hash_table_iter_init(&iter, index_cache);
+
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		if (GPOINTER_TO_INT(value) == index)
+			g_hash_table_iter_remove(&iter);
+}
+
+static void parse_link(struct nlmsghdr *nlh, struct rtnl_request *req)
+{
+	struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+	int len = IFLA_PAYLOAD(nlh);
+	struct rtattr *rta;
+	const char *name = NULL;
+	const struct rtnl_link_stats64 *stats64 = NULL;
+
+	if (nlh->nlmsg_type == RTM_DELLINK) {
+		cache_remove_index(ifi->ifi_index);
+		return;
+	}
+
+	for (rta = IFLA_RTA(ifi); RTA_OK(rta, len);
+					rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case IFLA_IFNAME:
+			name = RTA_DATA(rta);
+			break;
+		case IFLA_STATS64:
+			if (RTA_PAYLOAD(rta) >= sizeof(*stats64))
+				stats64 = RTA_DATA(rta);
+			break;
+		}
+	}
+
+	/*
+	 * Only interfaces we have been asked about are worth caching.  Any
+	 * other name for a cached index means the interface was renamed.
+	 */
+	if (name != NULL && (g_hash_table_lookup(index_cache, name) ||
+				(req && g_str_equal(name, req->interface)))) {
+		cache_remove_index(ifi->ifi_index);
+		g_hash_table_replace(index_cache, g_strdup(name),
+					GINT_TO_POINTER(ifi->ifi_index));
+	} else if (name != NULL)
+		cache_remove_index(ifi->ifi_index);
+
+	if (req == NULL || nlh->nlmsg_pid != rtnl_portid ||
+			nlh->nlmsg_seq < req->seq ||
+			nlh->nlmsg_seq >= req->seq + req->n_ops)
+		return;
+
+	req->index = ifi->ifi_index;
+
+	if (req->stats == NULL || stats64 == NULL)
+		return;
+
+	req->stats->rx_packets = stats64->rx_packets;
+	req->stats->tx_packets = stats64->tx_packets;
+	req->stats->rx_bytes = stats64->rx_bytes;
+	req->stats->tx_bytes = stats64->tx_bytes;
+	req->stats->rx_errors = stats64->rx_errors;
+	req->stats->tx_errors = stats64->tx_errors;
+	req->stats->rx_dropped = stats64->rx_dropped;
+	req->stats->tx_dropped = stats64->tx_dropped;
+}
+
+static void parse_ack(struct nlmsghdr *nlh, struct rtnl_request *req)
+{
+	struct nlmsgerr *err = NLMSG_DATA(nlh);
+	const struct rtnl_op *op;
+
+	if (req == NULL || nlh->nlmsg_seq < req->seq ||
+			nlh->nlmsg_seq >= req->seq + req->n_ops)
+		return;
+
+	req->acked += 1;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*err)) || err->error == 0)
+		return;
+
+	op = &req->ops[nlh->nlmsg_seq - req->seq];
+
+	if (-err->error == op->ignore)
+		return;
+
+	ofono_error("%s: failed to %s: %s (%d)", req->interface, op->what,
+					strerror(-err->error), -err->error);
+
+	if (req->err == 0)
+		req->err = err->error;
+}
+
+static void rtnl_parse(void *buf, size_t len, struct rtnl_request *req)
+{
+	struct nlmsghdr *nlh;
+
+	for (nlh = buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+		switch (nlh->nlmsg_type) {
+		case NLMSG_ERROR:
+			parse_ack(nlh, req);
+			break;
+		case RTM_NEWLINK:
+		case RTM_DELLINK:
+			parse_link(nlh, req);
+			break;
+		}
+	}
+}
+
+static gboolean rtnl_event(GIOChannel *channel, GIOCondition cond,
+							gpointer user_data)
+{
+	unsigned char buf[RTNL_BUFFER_SIZE];
+	ssize_t len;
+
+	if (cond & (G_IO_NVAL | G_IO_HUP | G_IO_ERR)) {
+		rtnl_watch = 0;
+		return FALSE;
+	}
+
+	while ((len = recv(rtnl_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+		rtnl_parse(buf, len, NULL);
+
+	/*
+	 * Link notifications were lost, so the cached indexes can no
+	 * longer be trusted to follow renames and hotplug.
+	 */
+	if (len < 0 && errno == ENOBUFS)
+		g_hash_table_remove_all(index_cache);
+
+	return TRUE;
+}
+
+/*
+ * Send every message of the batch with a single send() and collect the
+ * acknowledgements.  The kernel handles rtnetlink requests synchronously
+ * from within the sending syscall, so all replies are already queued on
+ * the socket by the time send() returns.
+ */
+static int rtnl_transact(const void *buf, size_t len,
+					struct rtnl_request *req)
+{
+	unsigned char reply[RTNL_BUFFER_SIZE];
+	ssize_t n;
+
+	if (rtnl_fd < 0)
+		return -ENOTCONN;
+
+	if (send(rtnl_fd, buf, len, 0) < 0) {
+		int err = -errno;
+
+		ofono_error("%s: rtnetlink send failed: %s (%d)",
+					req->interface, strerror(-err), -err);
+		return err;
+	}
+
+	while (req->acked < req->n_ops) {
+		n = recv(rtnl_fd, reply, sizeof(reply), MSG_DONTWAIT);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno == ENOBUFS) {
+				g_hash_table_remove_all(index_cache);
+				continue;
+			}
+
+			ofono_error("%s: missing rtnetlink replies: %s (%d)",
+					req->interface, strerror(errno), errno);
+			return -errno;
+		}
+
+		rtnl_parse(reply, n, req);
+	}
+
+	return req->err;
+}
+
+static void *batch_put(struct ofono_rtnl_batch *batch, uint16_t type,
+			uint16_t flags, size_t len, const char *what,
+			int ignore)
+{
+	struct nlmsghdr *nlh;
+
+	if (batch->n_ops == RTNL_MAX_OPS ||
+			batch->len + NLMSG_SPACE(len) > sizeof(batch->buf)) {
+		batch->overflow = TRUE;
+		return NULL;
+	}
+
+	nlh = (struct nlmsghdr *) (batch->buf + batch->len);
+	memset(nlh, 0, NLMSG_SPACE(len));
+	nlh->nlmsg_len = NLMSG_LENGTH(len);
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+	nlh->nlmsg_seq = batch->n_ops;
+
+	batch->ops[batch->n_ops].what = what;
+	batch->ops[batch->n_ops].ignore = ignore;
+	batch->n_ops += 1;
+	batch->last = batch->len;
+	batch->len += NLMSG_ALIGN(nlh->nlmsg_len);
+
+	return NLMSG_DATA(nlh);
+}
+
+static void batch_put_attr(struct ofono_rtnl_batch *batch, uint16_t type,
+				const void *data, size_t len)
+{
+	struct nlmsghdr *nlh;
+	struct rtattr *rta;
+
+	if (batch->overflow == TRUE || batch->n_ops == 0)
+		return;
+
+	/* Attributes always go to the most recently queued message */
+	nlh = (struct nlmsghdr *) (batch->buf + batch->last);
+
+	if (batch->len + RTA_SPACE(len) > sizeof(batch->buf)) {
+		batch->overflow = TRUE;
+		return;
+	}
+
+	rta = (struct rtattr *) (batch->buf + batch->len);
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_SPACE(len);
+	batch->len += RTA_SPACE(len);
+}
+
+static int parse_address(const char *address, void *addr)
+{
+	if (inet_pton(AF_INET, address, addr) == 1)
+		return AF_INET;
+
+	if (inet_pton(AF_INET6, address, addr) == 1)
+		return AF_INET6;
+
+	return AF_UNSPEC;
+}
+
+static int get_link(const char *interface, struct ofono_rtnl_stats *stats)
+{
+	struct {
+		struct nlmsghdr nlh;
+		struct ifinfomsg ifi;
+		unsigned char attrs[RTA_SPACE(IFNAMSIZ)];
+	} msg;
+	struct rtattr *rta;
+	struct rtnl_op op = { "look up interface", 0 };
+	struct rtnl_request req;
+	int err;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(msg.ifi));
+	msg.nlh.nlmsg_type = RTM_GETLINK;
+	msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	msg.nlh.nlmsg_seq = ++rtnl_seq;
+	msg.ifi.ifi_family = AF_UNSPEC;
+
+	rta = (struct rtattr *) ((unsigned char *) &msg +
+					NLMSG_ALIGN(msg.nlh.nlmsg_len));
+	rta->rta_type = IFLA_IFNAME;
+	rta->rta_len = RTA_LENGTH(strlen(interface) + 1);
+	strcpy(RTA_DATA(rta), interface);
+	msg.nlh.nlmsg_len = NLMSG_ALIGN(msg.nlh.nlmsg_len) +
+					RTA_ALIGN(rta->rta_len);
+
+	memset(&req, 0, sizeof(req));
+	req.interface = interface;
+	req.seq = msg.nlh.nlmsg_seq;
+	req.n_ops = 1;
+	req.ops = &op;
+	req.stats = stats;
+
+	err = rtnl_transact(&msg, msg.nlh.nlmsg_len, &req);
+	if (err < 0)
+		return err;
+
+	return req.index > 0 ? req.index : -ENODEV;
+}
+
+static int resolve_index(const char *interface)
+{
+	gpointer value;
+
+	value = g_hash_table_lookup(index_cache, interface);
+	if (value != NULL)
+		return GPOINTER_TO_INT(value);
+
+	return get_link(interface, NULL);
+}
+
+struct ofono_rtnl_batch *__ofono_rtnl_batch_new(const char *interface)
+{
+	struct ofono_rtnl_batch *batch;
+	int index;
+
+	if (interface == NULL || rtnl_fd < 0)
+		return NULL;
+
+	if (strlen(interface) >= IFNAMSIZ)
+		return NULL;
+
+	index = resolve_index(interface);
+	if (index < 0)
+		return NULL;
+
+	batch = g_try_new0(struct ofono_rtnl_batch, 1);
+	if (batch == NULL)
+		return NULL;
+
+	batch->interface = g_strdup(interface);
+	batch->index = index;
+
+	return batch;
+}
+
+void __ofono_rtnl_batch_set_link(struct ofono_rtnl_batch *batch,
+					ofono_bool_t up, unsigned int mtu)
+{
+	struct ifinfomsg *ifi;
+
+	ifi = batch_put(batch, RTM_NEWLINK, 0, sizeof(*ifi),
+			up ? "bring interface up" : "bring interface down", 0);
+	if (ifi == NULL)
+		return;
+
+	ifi->ifi_family = AF_UNSPEC;
+	ifi->ifi_index = batch->index;
+	ifi->ifi_flags = up ? IFF_UP : 0;
+	ifi->ifi_change = IFF_UP;
+
+	if (mtu > 0)
+		batch_put_attr(batch, IFLA_MTU, &mtu, sizeof(mtu));
+}
+
+static void batch_address(struct ofono_rtnl_batch *batch, uint16_t type,
+				uint16_t flags, const char *address,
+				unsigned char prefixlen, const char *what,
+				int ignore)
+{
+	struct ifaddrmsg *ifa;
+	struct in6_addr addr;
+	int family;
+	size_t len;
+
+	family = parse_address(address, &addr);
+	if (family == AF_UNSPEC) {
+		ofono_error("%s: invalid address %s", batch->interface,
+								address);
+		return;
+	}
+
+	len = family == AF_INET ? sizeof(struct in_addr) : sizeof(addr);
+
+	if (prefixlen == 0 || prefixlen > len * 8)
+		prefixlen = len * 8;
+
+	ifa = batch_put(batch, type, flags, sizeof(*ifa), what, ignore);
+	if (ifa == NULL)
+		return;
+
+	ifa->ifa_family = family;
+	ifa->ifa_prefixlen = prefixlen;
+	ifa->ifa_scope = RT_SCOPE_UNIVERSE;
+	ifa->ifa_index = batch->index;
+
+	batch_put_attr(batch, IFA_LOCAL, &addr, len);
+	batch_put_attr(batch, IFA_ADDRESS, &addr, len);
+}
+
+void __ofono_rtnl_batch_add_address(struct ofono_rtnl_batch *batch,
+					const char *address,
+					unsigned char prefixlen)
+{
+	batch_address(batch, RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE,
+			address, prefixlen, "set interface address", 0);
+}
+
+void __ofono_rtnl_batch_del_address(struct ofono_rtnl_batch *batch,
+					const char *address,
+					unsigned char prefixlen)
+{
+	batch_address(batch, RTM_DELADDR, 0, address, prefixlen,
+			"remove interface address", EADDRNOTAVAIL);
+}
+
+void __ofono_rtnl_batch_add_host_route(struct ofono_rtnl_batch *batch,
+					const char *destination)
+{
+	struct rtmsg *rtm;
+	struct in6_addr addr;
+	int family;
+	size_t len;
+
+	family = parse_address(destination, &addr);
+	if (family == AF_UNSPEC) {
+		ofono_error("%s: invalid route destination %s",
+					batch->interface, destination);
+		return;
+	}
+
+	len = family == AF_INET ? sizeof(struct in_addr) : sizeof(addr);
+
+	rtm = batch_put(batch, RTM_NEWROUTE, NLM_F_CREATE | NLM_F_EXCL,
+				sizeof(*rtm), "add host route", EEXIST);
+	if (rtm == NULL)
+		return;
+
+	rtm->rtm_family = family;
+	rtm->rtm_dst_len = len * 8;
+	rtm->rtm_table = RT_TABLE_MAIN;
+	rtm->rtm_protocol = RTPROT_BOOT;
+	rtm->rtm_scope = RT_SCOPE_LINK;
+	rtm->rtm_type = RTN_UNICAST;
+
+	batch_put_attr(batch, RTA_DST, &addr, len);
+	batch_put_attr(batch, RTA_OIF, &batch->index, sizeof(batch->index));
+}
+
+int __ofono_rtnl_batch_commit(struct ofono_rtnl_batch *batch)
+{
+	struct rtnl_request req;
+	struct nlmsghdr *nlh;
+	size_t offset;
+	int err;
+
+	if (batch->overflow == TRUE) {
+		ofono_error("%s: too many interface changes in one batch",
+							batch->interface);
+		err = -ENOSPC;
+		goto done;
+	}
+
+	err = 0;
+
+	if (batch->n_ops == 0)
+		goto done;
+
+	memset(&req, 0, sizeof(req));
+	req.interface = batch->interface;
+	req.seq = rtnl_seq + 1;
+	req.n_ops = batch->n_ops;
+	req.ops = batch->ops;
+
+	for (offset = 0; offset < batch->len;
+				offset += NLMSG_ALIGN(nlh->nlmsg_len)) {
+		nlh = (struct nlmsghdr *) (batch->buf + offset);
+		nlh->nlmsg_seq += req.seq;
+	}
+
+	rtnl_seq += batch->n_ops;
+
+	DBG("%s: %u changes in %zu bytes", batch->interface,
+						batch->n_ops, batch->len);
+
+	err = rtnl_transact(batch->buf, batch->len, &req);
+
+done:
+	g_free(batch->interface);
+	g_free(batch);
+
+	return err;
+}
+
+int __ofono_rtnl_get_stats(const char *interface,
+				struct ofono_rtnl_stats *stats)
+{
+	int err;
+
+	if (interface == NULL || rtnl_fd < 0)
+		return -EINVAL;
+
+	if (strlen(interface) >= IFNAMSIZ)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+
+	err = get_link(interface, stats);
+	if (err < 0)
+		return err;
+
+	return 0;
+}
+
+int __ofono_rtnl_init(void)
+{
+	struct sockaddr_nl addr;
+	socklen_t addrlen = sizeof(addr);
+	GIOChannel *channel;
+	int fd;
+
+	DBG("");
+
+	fd = socket(PF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return -errno;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = RTMGRP_LINK;
+
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+			getsockname(fd, (struct sockaddr *) &addr,
+							&addrlen) < 0) {
+		int err = -errno;
+
+		close(fd);
+		return err;
+	}
+
+	rtnl_fd = fd;
+	rtnl_portid = addr.nl_pid;
+	index_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+							g_free, NULL);
+
+	channel = g_io_channel_unix_new(fd);
+	g_io_channel_set_encoding(channel, NULL, NULL);
+	g_io_channel_set_buffered(channel, FALSE);
+
+	rtnl_watch = g_io_add_watch(channel,
+				G_IO_IN | G_IO_NVAL | G_IO_HUP | G_IO_ERR,
+				rtnl_event, NULL);
+
+	g_io_channel_unref(channel);
+
+	return 0;
+}
+
+void __ofono_rtnl_cleanup(void)
+{
+	DBG("");
+
+	if (rtnl_fd < 0)
+		return;
+
+	if (rtnl_watch > 0)
+		g_source_remove(rtnl_watch);
+
+	rtnl_watch = 0;
+
+	g_hash_table_destroy(index_cache);
+	index_cache = NULL;
+
+	close(rtnl_fd);
+	rtnl_fd = -1;
+}
@@ -94,6 +94,7 @@ struct ofono_sim {
 
 	enum ofono_sim_state state;
 	struct ofono_watchlist *state_watches;
+	gint64 init_start;
 
 	char *spn;
 	char *spn_dc;
@@ -1418,6 +1419,9 @@ static void sim_set_ready(struct ofono_sim *sim)
 
 	sim->state = OFONO_SIM_STATE_READY;
 
+	DBG("SIM ready %d ms after initialization started",
+		(int) ((g_get_monotonic_time() - sim->init_start) / 1000));
+
 	sim_fs_check_version(sim->simfs);
 
 	call_state_watches(sim);
@@ -2122,6 +2126,8 @@ static void sim_initialize(struct ofono_sim *sim)
 	 * in the EFust
 	 */
 
+	sim->init_start = g_get_monotonic_time();
+
 	if (sim->early_context == NULL)
 		sim->early_context = ofono_sim_context_create(sim);
 
@@ -2218,6 +2224,14 @@ const char *ofono_sim_get_imsi(struct ofono_sim *sim)
 	return sim->imsi;
 }
 
+const char *ofono_sim_get_iccid(struct ofono_sim *sim)
+{
+	if (sim == NULL)
+		return NULL;
+
+	return sim->iccid;
+}
+
 const char *ofono_sim_get_mcc(struct ofono_sim *sim)
 {
 	if (sim == NULL)
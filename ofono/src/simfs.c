@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/mman.h>
 
 #include "ofono.h"
 
@@ -45,19 +46,55 @@
 #define SIM_CACHE_BASEPATH STORAGEDIR "/%s-%i"
 #define SIM_CACHE_VERSION SIM_CACHE_BASEPATH "/version"
 #define SIM_CACHE_PATH SIM_CACHE_BASEPATH "/%04x"
+#define SIM_CACHE_LEGACY_FILE SIM_CACHE_BASEPATH "/cache"
+#define SIM_CACHE_FILE STORAGEDIR "/%s/simfs"
 #define SIM_CACHE_HEADER_SIZE 39
+#define SIM_CACHE_MAX_FILES 128
 #define SIM_FILE_INFO_SIZE 7
 #define SIM_IMAGE_CACHE_BASEPATH STORAGEDIR "/%s-%i/images"
 #define SIM_IMAGE_CACHE_PATH SIM_IMAGE_CACHE_BASEPATH "/%d.xpm"
 
-#define SIM_FS_VERSION 2
+#define SIM_FS_VERSION 4
 
 static gboolean sim_fs_op_next(gpointer user_data);
 static gboolean sim_fs_op_read_record(gpointer user);
 static gboolean sim_fs_op_read_block(gpointer user_data);
 
+/*
+ * Files needed to reach the SIM ready state and to register come first,
+ * bulky files such as images and phonebooks last.
+ */
+enum sim_fs_priority {
+	SIM_FS_PRIORITY_HIGH = 0,
+	SIM_FS_PRIORITY_NORMAL,
+	SIM_FS_PRIORITY_LOW,
+};
+
+/*
+ * All cached EFs of a SIM live in a single memory mapped file, keyed by
+ * the ICCID so that the files read before the IMSI is known are cached
+ * too.  It starts with an index of fixed size, each entry holding the
+ * EF's file info and the bitmap of cached blocks or records, followed by
+ * the EF contents.  The space reserved for an EF can be larger than its
+ * contents when it was taken over from a dropped EF.
+ */
+struct sim_cache_entry {
+	guint16 id;
+	guint32 offset;
+	guint32 capacity;
+	unsigned char header[SIM_CACHE_HEADER_SIZE];
+};
+
+struct sim_cache_index {
+	guint32 version;
+	guint32 phase;
+	guint32 size;
+	struct sim_cache_entry entries[SIM_CACHE_MAX_FILES];
+};
+
 struct sim_fs_op {
 	int id;
+	enum sim_fs_priority priority;
 	unsigned char *buffer;
 	enum ofono_sim_file_structure structure;
 	unsigned short offset;
@@ -70,26 +107,460 @@ struct sim_fs_op {
 	unsigned char path_len;
 	gconstpointer cb;
 	gboolean is_read;
+	gboolean revalidate;
 	void *userdata;
 	struct ofono_sim_context *context;
+	GSList *dups;
+	gint64 queued;
+	gint64 started;
 };
 
 static void sim_fs_op_free(struct sim_fs_op *node)
 {
+	g_slist_free_full(node->dups, g_free);
 	g_free(node->buffer);
 	g_free(node);
 }
 
+static enum sim_fs_priority sim_fs_file_priority(int id)
+{
+	switch (id) {
+	case SIM_EF_ICCID_FILEID:
+	case SIM_EFLI_FILEID:
+	case SIM_EFPL_FILEID:
+	case SIM_EFECC_FILEID:
+	case SIM_EFPHASE_FILEID:
+	case SIM_EFAD_FILEID:
+	case SIM_EFSST_FILEID: /* same as EFust */
+	case SIM_EFEST_FILEID:
+	case SIM_EFIMSI_FILEID:
+	case SIM_EF_CPHS_INFORMATION_FILEID:
+	case SIM_EFSPN_FILEID:
+		return SIM_FS_PRIORITY_HIGH;
+	case SIM_EFADN_FILEID:
+	case SIM_EFBDN_FILEID:
+	case SIM_EFSDN_FILEID:
+	case SIM_EFEXT1_FILEID:
+		return SIM_FS_PRIORITY_LOW;
+	}
+
+	/* EFimg, image instances and the USIM phonebook live in 4Fxx */
+	if ((id & 0xff00) == 0x4f00)
+		return SIM_FS_PRIORITY_LOW;
+
+	return SIM_FS_PRIORITY_NORMAL;
+}
+
+/* Returns TRUE if no requester is interested in the result anymore */
+static gboolean sim_fs_op_cancelled(struct sim_fs_op *op)
+{
+	GSList *l;
+
+	if (op->cb != NULL)
+		return FALSE;
+
+	for (l = op->dups; l; l = l->next) {
+		struct sim_fs_op *dup = l->data;
+
+		if (dup->cb != NULL)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void sim_fs_op_cancel(struct sim_fs_op *op,
+				struct ofono_sim_context *context)
+{
+	GSList *l;
+
+	if (op->context == context)
+		op->cb = NULL;
+
+	for (l = op->dups; l; l = l->next) {
+		struct sim_fs_op *dup = l->data;
+
+		if (dup->context == context)
+			dup->cb = NULL;
+	}
+}
+
+static void sim_fs_op_read_notify(struct sim_fs_op *op, int ok,
+					int total_length, int record,
+					const unsigned char *data,
+					int record_length)
+{
+	GSList *l;
+
+	if (op->cb)
+		((ofono_sim_file_read_cb_t) op->cb)(ok, total_length, record,
+							data, record_length,
+							op->userdata);
+
+	for (l = op->dups; l; l = l->next) {
+		struct sim_fs_op *dup = l->data;
+
+		if (dup->cb == NULL)
+			continue;
+
+		((ofono_sim_file_read_cb_t) dup->cb)(ok, total_length, record,
+							data, record_length,
+							dup->userdata);
+	}
+}
+
+static void sim_fs_op_info_notify(struct sim_fs_op *op, int ok,
+					unsigned char file_status,
+					int length, int record_length)
+{
+	GSList *l;
+
+	if (op->cb)
+		((sim_fs_read_info_cb_t) op->cb)(ok, file_status, length,
+							record_length,
+							op->userdata);
+
+	for (l = op->dups; l; l = l->next) {
+		struct sim_fs_op *dup = l->data;
+
+		if (dup->cb == NULL)
+			continue;
+
+		((sim_fs_read_info_cb_t) dup->cb)(ok, file_status, length,
+							record_length,
+							dup->userdata);
+	}
+}
+
 struct sim_fs {
 	GQueue *op_q;
 	gint op_source;
-	unsigned char bitmap[32];
-	int fd;
+	int cache_fd;
+	char *cache_path;
+	unsigned char *cache;
+	size_t cache_len;
+	struct sim_cache_entry *entry;
+	unsigned int cache_hits;
+	unsigned int cache_misses;
+	unsigned int cache_stale;
+	unsigned int revalidate_pending;
 	struct ofono_sim *sim;
 	const struct ofono_sim_driver *driver;
 	GSList *contexts;
 };
 
+static void sim_fs_cache_close(struct sim_fs *fs)
+{
+	fs->entry = NULL;
+
+	if (fs->cache != NULL) {
+		munmap(fs->cache, fs->cache_len);
+		fs->cache = NULL;
+		fs->cache_len = 0;
+	}
+
+	if (fs->cache_fd != -1) {
+		TFR(close(fs->cache_fd));
+		fs->cache_fd = -1;
+	}
+
+	g_free(fs->cache_path);
+	fs->cache_path = NULL;
+}
+
+static gboolean sim_fs_cache_map(struct sim_fs *fs, size_t len)
+{
+	void *map;
+
+	if (fs->cache != NULL) {
+		munmap(fs->cache, fs->cache_len);
+		fs->cache = NULL;
+		fs->cache_len = 0;
+	}
+
+	map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+			fs->cache_fd, 0);
+	if (map == MAP_FAILED)
+		return FALSE;
+
+	fs->cache = map;
+	fs->cache_len = len;
+
+	return TRUE;
+}
+
+static gboolean sim_fs_cache_truncate(struct sim_fs *fs, size_t size)
+{
+	if (ftruncate(fs->cache_fd, size) != 0)
+		return FALSE;
+
+	return sim_fs_cache_map(fs, size);
+}
+
+static gboolean sim_fs_cache_reset(struct sim_fs *fs)
+{
+	struct sim_cache_index *index;
+
+	if (sim_fs_cache_truncate(fs, sizeof(struct sim_cache_index)) == FALSE)
+		return FALSE;
+
+	index = (struct sim_cache_index *) fs->cache;
+	memset(index, 0, sizeof(struct sim_cache_index));
+	index->version = SIM_FS_VERSION;
+	index->phase = OFONO_SIM_PHASE_UNKNOWN;
+	index->size = sizeof(struct sim_cache_index);
+
+	return TRUE;
+}
+
+static int sim_cache_entry_length(const struct sim_cache_entry *entry)
+{
+	return (entry->header[1] << 8) | entry->header[2];
+}
+
+static gint sim_cache_entry_compare(gconstpointer a, gconstpointer b)
+{
+	const struct sim_cache_entry *ea = *(struct sim_cache_entry **) a;
+	const struct sim_cache_entry *eb = *(struct sim_cache_entry **) b;
+
+	if (ea->offset < eb->offset)
+		return -1;
+
+	return ea->offset > eb->offset;
+}
+
+/*
+ * Space of dropped EFs is only reused by EFs that fit into it, so once
+ * more of the file is unused than used, move the cached EFs together and
+ * give the rest back.
+ */
+static gboolean sim_fs_cache_compact(struct sim_fs *fs)
+{
+	struct sim_cache_index *index = (struct sim_cache_index *) fs->cache;
+	struct sim_cache_entry *live[SIM_CACHE_MAX_FILES];
+	size_t used = 0;
+	size_t size;
+	int n = 0;
+	int i;
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		struct sim_cache_entry *entry = &index->entries[i];
+
+		if (entry->id == 0 || entry->offset == 0)
+			continue;
+
+		if (entry->offset < sizeof(struct sim_cache_index) ||
+				entry->offset + entry->capacity > index->size ||
+				sim_cache_entry_length(entry) >
+					(int) entry->capacity)
+			return sim_fs_cache_reset(fs);
+
+		live[n++] = entry;
+		used += sim_cache_entry_length(entry);
+	}
+
+	if (index->size - sizeof(struct sim_cache_index) <= 2 * used)
+		return TRUE;
+
+	DBG("Compacting %u bytes of SIM cache to %zu", index->size, used);
+
+	qsort(live, n, sizeof(live[0]), sim_cache_entry_compare);
+
+	size = sizeof(struct sim_cache_index);
+
+	for (i = 0; i < n; i++) {
+		guint32 length = sim_cache_entry_length(live[i]);
+
+		memmove(fs->cache + size, fs->cache + live[i]->offset, length);
+		live[i]->offset = size;
+		live[i]->capacity = length;
+		size += length;
+	}
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		struct sim_cache_entry *entry = &index->entries[i];
+
+		if (entry->id != 0)
+			continue;
+
+		entry->offset = 0;
+		entry->capacity = 0;
+	}
+
+	index->size = size;
+
+	return sim_fs_cache_truncate(fs, size);
+}
+
+/*
+ * Maps the cache of the current SIM, all of it is paged in ahead of the
+ * reads so that the boot time reads of a known SIM do not block on I/O.
+ */
+static struct sim_cache_index *sim_fs_cache_open(struct sim_fs *fs)
+{
+	const char *iccid = ofono_sim_get_iccid(fs->sim);
+	struct sim_cache_index *index;
+	struct stat st;
+	char *path;
+
+	if (iccid == NULL)
+		return NULL;
+
+	path = g_strdup_printf(SIM_CACHE_FILE, iccid);
+
+	if (fs->cache != NULL && g_str_equal(path, fs->cache_path)) {
+		g_free(path);
+		return (struct sim_cache_index *) fs->cache;
+	}
+
+	sim_fs_cache_close(fs);
+	fs->cache_path = path;
+
+	if (create_dirs(path, SIM_CACHE_MODE | S_IXUSR) != 0)
+		goto error;
+
+	fs->cache_fd = TFR(open(path, O_RDWR | O_CREAT, SIM_CACHE_MODE));
+	if (fs->cache_fd == -1)
+		goto error;
+
+	if (fstat(fs->cache_fd, &st) != 0)
+		goto error;
+
+	if ((size_t) st.st_size < sizeof(struct sim_cache_index)) {
+		if (ftruncate(fs->cache_fd,
+				sizeof(struct sim_cache_index)) != 0)
+			goto error;
+
+		st.st_size = sizeof(struct sim_cache_index);
+	}
+
+	if (sim_fs_cache_map(fs, st.st_size) == FALSE)
+		goto error;
+
+	madvise(fs->cache, fs->cache_len, MADV_WILLNEED);
+
+	index = (struct sim_cache_index *) fs->cache;
+
+	if (index->version != SIM_FS_VERSION ||
+			index->size < sizeof(struct sim_cache_index) ||
+			index->size > fs->cache_len) {
+		if (sim_fs_cache_reset(fs) == FALSE)
+			goto error;
+	} else if (sim_fs_cache_compact(fs) == FALSE)
+		goto error;
+
+	return (struct sim_cache_index *) fs->cache;
+
+error:
+	DBG("Error %i opening cache file %s", errno, path);
+	sim_fs_cache_close(fs);
+
+	return NULL;
+}
+
+static struct sim_cache_entry *sim_fs_cache_lookup(struct sim_fs *fs,
+							int id)
+{
+	struct sim_cache_index *index = sim_fs_cache_open(fs);
+	int i;
+
+	if (index == NULL)
+		return NULL;
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		struct sim_cache_entry *entry = &index->entries[i];
+
+		if (entry->id != id)
+			continue;
+
+		if (sim_cache_entry_length(entry) > (int) entry->capacity ||
+				entry->offset + entry->capacity > index->size)
+			return NULL;
+
+		return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Finds room for the contents of an EF, reusing the smallest space of a
+ * dropped EF that fits and growing the file otherwise.
+ */
+static struct sim_cache_entry *sim_fs_cache_alloc(struct sim_fs *fs,
+							int id, int length)
+{
+	struct sim_cache_index *index = sim_fs_cache_open(fs);
+	struct sim_cache_entry *entry;
+	struct sim_cache_entry *best = NULL;
+	int unused = -1;
+	size_t size;
+	int i;
+
+	if (index == NULL)
+		return NULL;
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		entry = &index->entries[i];
+
+		if (entry->id != id)
+			continue;
+
+		if (entry->capacity >= (guint32) length)
+			return entry;
+
+		entry->id = 0;
+		break;
+	}
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		entry = &index->entries[i];
+
+		if (entry->id != 0)
+			continue;
+
+		if (entry->offset == 0) {
+			if (unused == -1)
+				unused = i;
+
+			continue;
+		}
+
+		if (entry->capacity < (guint32) length)
+			continue;
+
+		if (best == NULL || entry->capacity < best->capacity)
+			best = entry;
+	}
+
+	if (best != NULL) {
+		best->id = id;
+		return best;
+	}
+
+	if (unused == -1)
+		return NULL;
+
+	size = index->size + length;
+
+	if (size > fs->cache_len) {
+		if (sim_fs_cache_truncate(fs, size) == FALSE) {
+			sim_fs_cache_close(fs);
+			return NULL;
+		}
+
+		index = (struct sim_cache_index *) fs->cache;
+	}
+
+	entry = &index->entries[unused];
+	entry->id = id;
+	entry->offset = index->size;
+	entry->capacity = length;
+	index->size = size;
+
+	return entry;
+}
+
 void sim_fs_free(struct sim_fs *fs)
 {
 	if (fs == NULL)
@@ -113,6 +584,8 @@ void sim_fs_free(struct sim_fs *fs)
 	while (fs->contexts)
 		sim_fs_context_free(fs->contexts->data);
 
+	sim_fs_cache_close(fs);
+
 	g_free(fs);
 }
 
@@ -137,7 +610,7 @@ struct sim_fs *sim_fs_new(struct ofono_sim *sim,
 
 	fs->sim = sim;
 	fs->driver = driver;
-	fs->fd = -1;
+	fs->cache_fd = -1;
 
 	return fs;
 }
@@ -164,14 +637,10 @@ void sim_fs_context_free(struct ofono_sim_context *context)
 
 	if (fs->op_q) {
 		while ((op = g_queue_peek_nth(fs->op_q, n)) != NULL) {
-			if (op->context != context) {
-				n += 1;
-				continue;
-			}
-
-			if (n == 0) {
-				op->cb = NULL;
+			sim_fs_op_cancel(op, context);
 
+			/* The operation at the head is in progress */
+			if (n == 0 || !sim_fs_op_cancelled(op)) {
 				n += 1;
 				continue;
 			}
@@ -226,6 +695,9 @@ void sim_fs_notify_file_watches(struct sim_fs *fs, int id)
 		struct ofono_sim_context *context = l->data;
 		GSList *k;
 
+		if (context->file_watches == NULL)
+			continue;
+
 		for (k = context->file_watches->items; k; k = k->next) {
 			struct file_watch *w = k->data;
 			ofono_sim_file_changed_cb_t notify = w->item.notify;
@@ -241,15 +713,15 @@ static void sim_fs_end_current(struct sim_fs *fs)
 {
 	struct sim_fs_op *op = g_queue_pop_head(fs->op_q);
 
+	DBG("%04x priority %d waited %d ms, took %d ms, %u pending", op->id,
+		op->priority, (int) ((op->started - op->queued) / 1000),
+		(int) ((g_get_monotonic_time() - op->started) / 1000),
+		g_queue_get_length(fs->op_q));
+
 	if (g_queue_get_length(fs->op_q) > 0)
 		fs->op_source = g_idle_add(sim_fs_op_next, fs);
 
-	if (fs->fd != -1) {
-		TFR(close(fs->fd));
-		fs->fd = -1;
-	}
-
-	memset(fs->bitmap, 0, sizeof(fs->bitmap));
+	fs->entry = NULL;
 
 	sim_fs_op_free(op);
 }
@@ -258,17 +730,15 @@ static void sim_fs_op_error(struct sim_fs *fs)
 {
 	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return;
 	}
 
 	if (op->info_only == TRUE)
-		((sim_fs_read_info_cb_t) op->cb)
-			(0, 0, 0, 0, op->userdata);
+		sim_fs_op_info_notify(op, 0, 0, 0, 0);
 	else if (op->is_read == TRUE)
-		((ofono_sim_file_read_cb_t) op->cb)
-			(0, 0, 0, 0, 0, op->userdata);
+		sim_fs_op_read_notify(op, 0, 0, 0, 0, 0);
 	else
 		((ofono_sim_file_write_cb_t) op->cb)
 			(0, op->userdata);
@@ -279,41 +749,32 @@ static void sim_fs_op_error(struct sim_fs *fs)
 static gboolean cache_block(struct sim_fs *fs, int block, int block_len,
 				const unsigned char *data, int num_bytes)
 {
-	int offset;
-	int bit;
-	ssize_t r;
-	unsigned char b;
-
-	if (fs->fd == -1)
-		return FALSE;
+	struct sim_cache_entry *entry = fs->entry;
+	int length;
 
-	if (lseek(fs->fd, block * block_len +
-				SIM_CACHE_HEADER_SIZE, SEEK_SET) == (off_t) -1)
+	if (entry == NULL)
 		return FALSE;
 
-	r = TFR(write(fs->fd, data, num_bytes));
+	length = sim_cache_entry_length(entry);
 
-	if (r != num_bytes)
+	if (block * block_len + num_bytes > length)
 		return FALSE;
 
-	/* update present bit for this block */
-	offset = block / 8;
-	bit = block % 8;
-
-	/* lseek to correct byte (skip file info) */
-	lseek(fs->fd, offset + SIM_FILE_INFO_SIZE, SEEK_SET);
+	memcpy(fs->cache + entry->offset + block * block_len, data, num_bytes);
 
-	b = fs->bitmap[offset];
-	b |= 1 << bit;
+	/* update present bit for this block */
+	entry->header[SIM_FILE_INFO_SIZE + block / 8] |= 1 << (block % 8);
 
-	r = TFR(write(fs->fd, &b, sizeof(b)));
+	return TRUE;
+}
 
-	if (r != sizeof(b))
+static gboolean sim_fs_cache_cached(struct sim_fs *fs, int block)
+{
+	if (fs->entry == NULL)
 		return FALSE;
 
-	fs->bitmap[offset] = b;
-
-	return TRUE;
+	return fs->entry->header[SIM_FILE_INFO_SIZE + block / 8] &
+			(1 << (block % 8));
 }
 
 static void sim_fs_op_write_cb(const struct ofono_error *error, void *data)
@@ -373,7 +834,7 @@ static void sim_fs_op_read_block_cb(const struct ofono_error *error,
 	memcpy(op->buffer + bufoff, data + dataoff, tocopy);
 	cache_block(fs, op->current, 256, data, len);
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return;
 	}
@@ -381,10 +842,8 @@ static void sim_fs_op_read_block_cb(const struct ofono_error *error,
 	op->current++;
 
 	if (op->current > end_block) {
-		ofono_sim_file_read_cb_t cb = op->cb;
-
-		cb(1, op->num_bytes, 0, op->buffer,
-				op->record_length, op->userdata);
+		sim_fs_op_read_notify(op, 1, op->num_bytes, 0, op->buffer,
+					op->record_length);
 
 		sim_fs_end_current(fs);
 	} else {
@@ -402,7 +861,7 @@ static gboolean sim_fs_op_read_block(gpointer user_data)
 
 	fs->op_source = 0;
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return FALSE;
 	}
@@ -419,46 +878,36 @@ static gboolean sim_fs_op_read_block(gpointer user_data)
 		}
 	}
 
-	while (fs->fd != -1 && op->current <= end_block) {
-		int offset = op->current / 8;
-		int bit = 1 << op->current % 8;
+	while (op->current <= end_block &&
+			sim_fs_cache_cached(fs, op->current)) {
 		int bufoff;
 		int seekoff;
 		int toread;
 
-		if ((fs->bitmap[offset] & bit) == 0)
-			break;
-
 		if (op->current == start_block) {
 			bufoff = 0;
-			seekoff = SIM_CACHE_HEADER_SIZE + op->current * 256 +
-				op->offset % 256;
+			seekoff = op->current * 256 + op->offset % 256;
 			toread = MIN(256 - op->offset % 256,
 					op->num_bytes - op->current * 256);
 		} else {
 			bufoff = (op->current - start_block - 1) * 256 +
 					op->offset % 256;
-			seekoff = SIM_CACHE_HEADER_SIZE + op->current * 256;
+			seekoff = op->current * 256;
 			toread = MIN(256, op->num_bytes - op->current * 256);
 		}
 
 		DBG("bufoff: %d, seekoff: %d, toread: %d",
 				bufoff, seekoff, toread);
 
-		if (lseek(fs->fd, seekoff, SEEK_SET) == (off_t) -1)
-			break;
-
-		if (TFR(read(fs->fd, op->buffer + bufoff, toread)) != toread)
-			break;
+		memcpy(op->buffer + bufoff,
+			fs->cache + fs->entry->offset + seekoff, toread);
 
 		op->current += 1;
 	}
 
 	if (op->current > end_block) {
-		ofono_sim_file_read_cb_t cb = op->cb;
-
-		cb(1, op->num_bytes, 0, op->buffer,
-				op->record_length, op->userdata);
+		sim_fs_op_read_notify(op, 1, op->num_bytes, 0, op->buffer,
+					op->record_length);
 
 		sim_fs_end_current(fs);
 
@@ -488,7 +937,6 @@ static void sim_fs_op_retrieve_cb(const struct ofono_error *error,
 	struct sim_fs *fs = user;
 	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
 	int total = op->length / op->record_length;
-	ofono_sim_file_read_cb_t cb = op->cb;
 
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		sim_fs_op_error(fs);
@@ -498,12 +946,13 @@ static void sim_fs_op_retrieve_cb(const struct ofono_error *error,
 	cache_block(fs, op->current - 1, op->record_length,
 			data, op->record_length);
 
-	if (cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return;
 	}
 
-	cb(1, op->length, op->current, data, op->record_length, op->userdata);
+	sim_fs_op_read_notify(op, 1, op->length, op->current, data,
+				op->record_length);
 
 	if (op->current < total) {
 		op->current += 1;
@@ -519,33 +968,21 @@ static gboolean sim_fs_op_read_record(gpointer user)
 	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
 	const struct ofono_sim_driver *driver = fs->driver;
 	int total = op->length / op->record_length;
-	unsigned char buf[256];
 
 	fs->op_source = 0;
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return FALSE;
 	}
 
-	while (fs->fd != -1 && op->current <= total) {
-		int offset = (op->current - 1) / 8;
-		int bit = 1 << ((op->current - 1) % 8);
-		ofono_sim_file_read_cb_t cb = op->cb;
+	while (op->current <= total &&
+			sim_fs_cache_cached(fs, op->current - 1)) {
+		const unsigned char *buf = fs->cache + fs->entry->offset +
+					(op->current - 1) * op->record_length;
 
-		if ((fs->bitmap[offset] & bit) == 0)
-			break;
-
-		if (lseek(fs->fd, (op->current - 1) * op->record_length +
-				SIM_CACHE_HEADER_SIZE, SEEK_SET) == (off_t) -1)
-			break;
-
-		if (TFR(read(fs->fd, buf, op->record_length)) !=
-				op->record_length)
-			break;
-
-		cb(1, op->length, op->current,
-				buf, op->record_length, op->userdata);
+		sim_fs_op_read_notify(op, 1, op->length, op->current,
+					buf, op->record_length);
 
 		op->current += 1;
 	}
@@ -595,14 +1032,11 @@ static void sim_fs_op_cache_fileinfo(struct sim_fs *fs,
 					unsigned char file_status)
 {
 	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
-	const char *imsi = ofono_sim_get_imsi(fs->sim);
-	enum ofono_sim_phase phase = ofono_sim_get_phase(fs->sim);
+	struct sim_cache_entry *entry;
 	enum sim_file_access update;
 	enum sim_file_access invalidate;
 	enum sim_file_access rehabilitate;
-	unsigned char fileinfo[SIM_CACHE_HEADER_SIZE];
 	gboolean cache;
-	char *path;
 
 	/* TS 11.11, Section 9.3 */
 	update = file_access_condition_decode(access[0] & 0xf);
@@ -617,32 +1051,28 @@ static void sim_fs_op_cache_fileinfo(struct sim_fs *fs,
 			(rehabilitate == SIM_FILE_ACCESS_ADM ||
 				rehabilitate == SIM_FILE_ACCESS_NEVER);
 
-	if (imsi == NULL || phase == OFONO_SIM_PHASE_UNKNOWN || cache == FALSE)
+	if (cache == FALSE)
 		return;
 
-	memset(fileinfo, 0, SIM_CACHE_HEADER_SIZE);
-
-	fileinfo[0] = error->type;
-	fileinfo[1] = length >> 8;
-	fileinfo[2] = length & 0xff;
-	fileinfo[3] = structure;
-	fileinfo[4] = record_length >> 8;
-	fileinfo[5] = record_length & 0xff;
-	fileinfo[6] = file_status;
-
-	path = g_strdup_printf(SIM_CACHE_PATH, imsi, phase, op->id);
-	fs->fd = TFR(open(path, O_WRONLY | O_CREAT | O_TRUNC, SIM_CACHE_MODE));
-	g_free(path);
-
-	if (fs->fd == -1)
+	/* The cache is looked up by the ICCID, keep reading it from the card */
+	if (op->id == SIM_EF_ICCID_FILEID)
 		return;
 
-	if (TFR(write(fs->fd, fileinfo, SIM_CACHE_HEADER_SIZE)) ==
-			SIM_CACHE_HEADER_SIZE)
+	entry = sim_fs_cache_alloc(fs, op->id, length);
+	if (entry == NULL)
 		return;
 
-	TFR(close(fs->fd));
-	fs->fd = -1;
+	memset(entry->header, 0, SIM_CACHE_HEADER_SIZE);
+
+	entry->header[0] = error->type;
+	entry->header[1] = length >> 8;
+	entry->header[2] = length & 0xff;
+	entry->header[3] = structure;
+	entry->header[4] = record_length >> 8;
+	entry->header[5] = record_length & 0xff;
+	entry->header[6] = file_status;
+
+	fs->entry = entry;
 }
 
 static void sim_fs_op_info_cb(const struct ofono_error *error, int length,
@@ -660,8 +1090,10 @@ static void sim_fs_op_info_cb(const struct ofono_error *error, int length,
 		return;
 	}
 
-	sim_fs_op_cache_fileinfo(fs, error, length, structure, record_length,
-					access, file_status);
+	if (op->revalidate == FALSE)
+		sim_fs_op_cache_fileinfo(fs, error, length, structure,
+						record_length, access,
+						file_status);
 
 	if (structure != op->structure) {
 		ofono_error("Requested file structure differs from SIM: %x",
@@ -670,7 +1102,7 @@ static void sim_fs_op_info_cb(const struct ofono_error *error, int length,
 		return;
 	}
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return;
 	}
@@ -700,10 +1132,8 @@ static void sim_fs_op_info_cb(const struct ofono_error *error, int length,
 		 * It's an info-only request, so there is no need to request
 		 * actual contents of the EF. Just return the EF-info.
 		 */
-		sim_fs_read_info_cb_t cb = op->cb;
-
-		cb(1, file_status, op->length,
-			op->record_length, op->userdata);
+		sim_fs_op_info_notify(op, 1, file_status, op->length,
+					op->record_length);
 
 		sim_fs_end_current(fs);
 	}
@@ -711,61 +1141,39 @@ static void sim_fs_op_info_cb(const struct ofono_error *error, int length,
 
 static gboolean sim_fs_op_check_cached(struct sim_fs *fs)
 {
-	const char *imsi = ofono_sim_get_imsi(fs->sim);
-	enum ofono_sim_phase phase = ofono_sim_get_phase(fs->sim);
 	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
-	char *path;
-	int fd;
-	ssize_t len;
-	unsigned char fileinfo[SIM_CACHE_HEADER_SIZE];
+	struct sim_cache_entry *entry;
 	int error_type;
 	int file_length;
 	enum ofono_sim_file_structure structure;
 	int record_length;
 	unsigned char file_status;
 
-	if (imsi == NULL || phase == OFONO_SIM_PHASE_UNKNOWN)
-		return FALSE;
-
-	path = g_strdup_printf(SIM_CACHE_PATH, imsi, phase, op->id);
-
-	if (path == NULL)
-		return FALSE;
-
-	fd = TFR(open(path, O_RDWR));
-	g_free(path);
-
-	if (fd == -1) {
-		if (errno != ENOENT)
-			DBG("Error %i opening cache file for "
-					"fileid %04x, IMSI %s",
-					errno, op->id, imsi);
-
+	entry = sim_fs_cache_lookup(fs, op->id);
+	if (entry == NULL) {
+		fs->cache_misses += 1;
 		return FALSE;
 	}
 
-	len = TFR(read(fd, fileinfo, SIM_CACHE_HEADER_SIZE));
-
-	if (len != SIM_CACHE_HEADER_SIZE)
-		goto error;
-
-	error_type = fileinfo[0];
-	file_length = (fileinfo[1] << 8) | fileinfo[2];
-	structure = fileinfo[3];
-	record_length = (fileinfo[4] << 8) | fileinfo[5];
-	file_status = fileinfo[6];
+	error_type = entry->header[0];
+	file_length = (entry->header[1] << 8) | entry->header[2];
+	structure = entry->header[3];
+	record_length = (entry->header[4] << 8) | entry->header[5];
+	file_status = entry->header[6];
 
 	if (structure == OFONO_SIM_FILE_STRUCTURE_TRANSPARENT)
 		record_length = file_length;
 
-	if (record_length == 0 || file_length < record_length)
-		goto error;
+	if (record_length == 0 || file_length < record_length) {
+		fs->cache_misses += 1;
+		return FALSE;
+	}
+
+	fs->cache_hits += 1;
 
 	op->length = file_length;
 	op->record_length = record_length;
-	memcpy(fs->bitmap, fileinfo + SIM_FILE_INFO_SIZE,
-			SIM_CACHE_HEADER_SIZE - SIM_FILE_INFO_SIZE);
-	fs->fd = fd;
+	fs->entry = entry;
 
 	if (error_type != OFONO_ERROR_TYPE_NO_ERROR ||
 			structure != op->structure) {
@@ -778,10 +1186,8 @@ static gboolean sim_fs_op_check_cached(struct sim_fs *fs)
 		 * It's an info-only request, so there is no need to request
 		 * actual contents of the EF. Just return the EF-info.
 		 */
-		sim_fs_read_info_cb_t cb = op->cb;
-
-		cb(1, file_status, op->length,
-			op->record_length, op->userdata);
+		sim_fs_op_info_notify(op, 1, file_status, op->length,
+					op->record_length);
 
 		sim_fs_end_current(fs);
 	} else if (structure == OFONO_SIM_FILE_STRUCTURE_TRANSPARENT) {
@@ -796,10 +1202,6 @@ static gboolean sim_fs_op_check_cached(struct sim_fs *fs)
 	}
 
 	return TRUE;
-
-error:
-	TFR(close(fd));
-	return FALSE;
 }
 
 static gboolean sim_fs_op_next(gpointer user_data)
@@ -814,14 +1216,15 @@ static gboolean sim_fs_op_next(gpointer user_data)
 		return FALSE;
 
 	op = g_queue_peek_head(fs->op_q);
+	op->started = g_get_monotonic_time();
 
-	if (op->cb == NULL) {
+	if (sim_fs_op_cancelled(op)) {
 		sim_fs_end_current(fs);
 		return FALSE;
 	}
 
 	if (op->is_read == TRUE) {
-		if (sim_fs_op_check_cached(fs))
+		if (op->revalidate == FALSE && sim_fs_op_check_cached(fs))
 			return FALSE;
 
 		driver->read_file_info(fs->sim, op->id,
@@ -857,6 +1260,70 @@ static gboolean sim_fs_op_next(gpointer user_data)
 	return FALSE;
 }
 
+static gboolean sim_fs_op_same_read(const struct sim_fs_op *a,
+					const struct sim_fs_op *b)
+{
+	return a->is_read == TRUE && b->is_read == TRUE &&
+		a->info_only == b->info_only &&
+		a->revalidate == b->revalidate && a->id == b->id &&
+		a->structure == b->structure && a->offset == b->offset &&
+		a->num_bytes == b->num_bytes && a->path_len == b->path_len &&
+		memcmp(a->path, b->path, a->path_len) == 0;
+}
+
+static void sim_fs_op_enqueue(struct sim_fs *fs, struct sim_fs_op *op)
+{
+	GList *l;
+
+	if (op->revalidate == TRUE)
+		op->priority = SIM_FS_PRIORITY_LOW;
+	else
+		op->priority = sim_fs_file_priority(op->id);
+	op->queued = g_get_monotonic_time();
+
+	if (fs->op_q == NULL)
+		fs->op_q = g_queue_new();
+
+	if (g_queue_get_length(fs->op_q) == 0) {
+		g_queue_push_tail(fs->op_q, op);
+		fs->op_source = g_idle_add(sim_fs_op_next, fs);
+		return;
+	}
+
+	/*
+	 * Piggyback on an identical read that has not been started yet.
+	 * The one at the head might already have delivered some records,
+	 * and one ahead of a write to the EF would return the old contents.
+	 */
+	for (l = fs->op_q->tail; l != fs->op_q->head; l = l->prev) {
+		struct sim_fs_op *queued = l->data;
+
+		if (queued->is_read == FALSE && queued->id == op->id)
+			break;
+
+		if (!sim_fs_op_same_read(queued, op))
+			continue;
+
+		DBG("%04x coalesced with a pending read", op->id);
+		queued->dups = g_slist_append(queued->dups, op);
+		return;
+	}
+
+	/*
+	 * Queue behind everything of the same or higher priority.  Never
+	 * overtake the operation in progress, nor one on the same file so
+	 * that reads and writes of an EF stay in order.
+	 */
+	for (l = fs->op_q->tail; l != fs->op_q->head; l = l->prev) {
+		struct sim_fs_op *queued = l->data;
+
+		if (queued->priority <= op->priority || queued->id == op->id)
+			break;
+	}
+
+	g_queue_insert_after(fs->op_q, l, op);
+}
+
 int sim_fs_read_info(struct ofono_sim_context *context, int id,
 			enum ofono_sim_file_structure expected_type,
 			sim_fs_read_info_cb_t cb, void *data)
@@ -873,9 +1340,6 @@ int sim_fs_read_info(struct ofono_sim_context *context, int id,
 	if (fs->driver->read_file_info == NULL)
 		return -ENOSYS;
 
-	if (fs->op_q == NULL)
-		fs->op_q = g_queue_new();
-
 	op = g_try_new0(struct sim_fs_op, 1);
 	if (op == NULL)
 		return -ENOMEM;
@@ -888,10 +1352,7 @@ int sim_fs_read_info(struct ofono_sim_context *context, int id,
 	op->info_only = TRUE;
 	op->context = context;
 
-	g_queue_push_tail(fs->op_q, op);
-
-	if (g_queue_get_length(fs->op_q) == 1)
-		fs->op_source = g_idle_add(sim_fs_op_next, fs);
+	sim_fs_op_enqueue(fs, op);
 
 	return 0;
 }
@@ -916,9 +1377,6 @@ int sim_fs_read(struct ofono_sim_context *context, int id,
 		return -ENOSYS;
 	}
 
-	if (fs->op_q == NULL)
-		fs->op_q = g_queue_new();
-
 	op = g_try_new0(struct sim_fs_op, 1);
 	if (op == NULL)
 		return -ENOMEM;
@@ -935,10 +1393,7 @@ int sim_fs_read(struct ofono_sim_context *context, int id,
 	memcpy(op->path, path, path_len);
 	op->path_len = path_len;
 
-	g_queue_push_tail(fs->op_q, op);
-
-	if (g_queue_get_length(fs->op_q) == 1)
-		fs->op_source = g_idle_add(sim_fs_op_next, fs);
+	sim_fs_op_enqueue(fs, op);
 
 	return 0;
 }
@@ -975,9 +1430,6 @@ int sim_fs_write(struct ofono_sim_context *context, int id,
 	if (fn == NULL)
 		return -ENOSYS;
 
-	if (fs->op_q == NULL)
-		fs->op_q = g_queue_new();
-
 	op = g_try_new0(struct sim_fs_op, 1);
 	if (op == NULL)
 		return -ENOMEM;
@@ -992,10 +1444,7 @@ int sim_fs_write(struct ofono_sim_context *context, int id,
 	op->current = record;
 	op->context = context;
 
-	g_queue_push_tail(fs->op_q, op);
-
-	if (g_queue_get_length(fs->op_q) == 1)
-		fs->op_source = g_idle_add(sim_fs_op_next, fs);
+	sim_fs_op_enqueue(fs, op);
 
 	return 0;
 }
@@ -1105,33 +1554,180 @@ static void remove_imagefile(const char *imsi, enum ofono_sim_phase phase,
 	g_free(path);
 }
 
-void sim_fs_check_version(struct sim_fs *fs)
+static gboolean sim_cache_entry_matches(const struct sim_cache_entry *entry,
+					unsigned char file_status,
+					int length, int record_length)
 {
-	const char *imsi = ofono_sim_get_imsi(fs->sim);
-	enum ofono_sim_phase phase = ofono_sim_get_phase(fs->sim);
-	unsigned char version;
+	if (length != sim_cache_entry_length(entry))
+		return FALSE;
 
-	if (imsi == NULL || phase == OFONO_SIM_PHASE_UNKNOWN)
+	if (file_status != entry->header[6])
+		return FALSE;
+
+	if (entry->header[3] == OFONO_SIM_FILE_STRUCTURE_TRANSPARENT)
+		return TRUE;
+
+	return record_length == ((entry->header[4] << 8) | entry->header[5]);
+}
+
+static void sim_fs_reread_cb(int ok, int total_length, int record,
+				const unsigned char *data,
+				int record_length, void *userdata)
+{
+	struct sim_fs *fs = userdata;
+	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
+
+	/* Wait for the last record, transparent EFs come in one go */
+	if (ok && record > 0 && record_length > 0 &&
+			record < total_length / record_length)
+		return;
+
+	/* Users have been served the stale contents, let them read again */
+	sim_fs_notify_file_watches(fs, op->id);
+}
+
+static void sim_fs_reread(struct sim_fs *fs, int id,
+				enum ofono_sim_file_structure structure)
+{
+	struct sim_fs_op *op;
+
+	op = g_try_new0(struct sim_fs_op, 1);
+	if (op == NULL)
+		return;
+
+	op->id = id;
+	op->structure = structure;
+	op->cb = sim_fs_reread_cb;
+	op->userdata = fs;
+	op->is_read = TRUE;
+
+	sim_fs_op_enqueue(fs, op);
+}
+
+static void sim_fs_revalidate_cb(int ok, unsigned char file_status,
+					int length, int record_length,
+					void *userdata)
+{
+	struct sim_fs *fs = userdata;
+	struct sim_fs_op *op = g_queue_peek_head(fs->op_q);
+	struct sim_cache_entry *entry = sim_fs_cache_lookup(fs, op->id);
+
+	fs->revalidate_pending -= 1;
+
+	if (entry != NULL && (!ok || !sim_cache_entry_matches(entry,
+					file_status, length, record_length))) {
+		DBG("Dropping stale cache entry for %04x", op->id);
+		entry->id = 0;
+		fs->cache_stale += 1;
+
+		sim_fs_reread(fs, op->id, entry->header[3]);
+	}
+
+	if (fs->revalidate_pending > 0)
+		return;
+
+	DBG("SIM cache revalidated: %u hits, %u misses, %u stale",
+		fs->cache_hits, fs->cache_misses, fs->cache_stale);
+}
+
+/*
+ * Cached EFs are served without asking the SIM, so check in the
+ * background, once everything else has been read, that the files still
+ * look the same on the card.
+ */
+static void sim_fs_cache_revalidate(struct sim_fs *fs)
+{
+	struct sim_cache_index *index;
+	int i;
+
+	if (fs->driver->read_file_info == NULL)
+		return;
+
+	index = sim_fs_cache_open(fs);
+	if (index == NULL)
 		return;
 
-	if (read_file(&version, 1, SIM_CACHE_VERSION, imsi, phase) == 1)
-		if (version == SIM_FS_VERSION)
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		struct sim_cache_entry *entry = &index->entries[i];
+		struct sim_fs_op *op;
+
+		if (entry->id == 0)
+			continue;
+
+		op = g_try_new0(struct sim_fs_op, 1);
+		if (op == NULL)
 			return;
 
-	sim_fs_cache_flush(fs);
+		op->id = entry->id;
+		op->structure = entry->header[3];
+		op->cb = sim_fs_revalidate_cb;
+		op->userdata = fs;
+		op->is_read = TRUE;
+		op->info_only = TRUE;
+		op->revalidate = TRUE;
 
-	version = SIM_FS_VERSION;
-	write_file(&version, 1, SIM_CACHE_MODE, SIM_CACHE_VERSION, imsi, phase);
+		fs->revalidate_pending += 1;
+		sim_fs_op_enqueue(fs, op);
+	}
 }
 
-void sim_fs_cache_flush(struct sim_fs *fs)
+/*
+ * The EFs cached before the SIM phase was known were possibly read from
+ * a different application of the same card, drop them and have their
+ * users read them again.
+ */
+static void sim_fs_cache_check_phase(struct sim_fs *fs,
+					struct sim_cache_index *index,
+					enum ofono_sim_phase phase)
+{
+	int i;
+
+	if (index->phase == (guint32) phase)
+		return;
+
+	if (index->phase == OFONO_SIM_PHASE_UNKNOWN) {
+		index->phase = phase;
+		return;
+	}
+
+	DBG("SIM phase changed from %u to %d", index->phase, phase);
+
+	index->phase = phase;
+	fs->entry = NULL;
+
+	for (i = 0; i < SIM_CACHE_MAX_FILES; i++) {
+		struct sim_cache_entry *entry = &index->entries[i];
+		int id = entry->id;
+
+		if (id == 0)
+			continue;
+
+		entry->id = 0;
+		sim_fs_notify_file_watches(fs, id);
+	}
+}
+
+/*
+ * Removes what is stored by the IMSI: the images and the EF cache files
+ * of older versions.
+ */
+static void sim_fs_legacy_cache_flush(struct sim_fs *fs)
 {
 	const char *imsi = ofono_sim_get_imsi(fs->sim);
 	enum ofono_sim_phase phase = ofono_sim_get_phase(fs->sim);
-	char *path = g_strdup_printf(SIM_CACHE_BASEPATH, imsi, phase);
 	struct dirent **entries;
-	int len = scandir(path, &entries, NULL, alphasort);
+	char *path;
+	int len;
 
+	if (imsi == NULL || phase == OFONO_SIM_PHASE_UNKNOWN)
+		return;
+
+	path = g_strdup_printf(SIM_CACHE_LEGACY_FILE, imsi, phase);
+	remove(path);
+	g_free(path);
+
+	path = g_strdup_printf(SIM_CACHE_BASEPATH, imsi, phase);
+	len = scandir(path, &entries, NULL, alphasort);
 	g_free(path);
 
 	if (len > 0) {
@@ -1147,14 +1743,60 @@ void sim_fs_cache_flush(struct sim_fs *fs)
 	sim_fs_image_cache_flush(fs);
 }
 
-void sim_fs_cache_flush_file(struct sim_fs *fs, int id)
+void sim_fs_check_version(struct sim_fs *fs)
 {
 	const char *imsi = ofono_sim_get_imsi(fs->sim);
 	enum ofono_sim_phase phase = ofono_sim_get_phase(fs->sim);
-	char *path = g_strdup_printf(SIM_CACHE_PATH, imsi, phase, id);
+	struct sim_cache_index *index;
+	unsigned char version;
 
-	remove(path);
-	g_free(path);
+	if (imsi == NULL || phase == OFONO_SIM_PHASE_UNKNOWN)
+		return;
+
+	if (read_file(&version, 1, SIM_CACHE_VERSION, imsi, phase) != 1 ||
+			version != SIM_FS_VERSION) {
+		sim_fs_legacy_cache_flush(fs);
+
+		version = SIM_FS_VERSION;
+		write_file(&version, 1, SIM_CACHE_MODE, SIM_CACHE_VERSION,
+				imsi, phase);
+	}
+
+	index = sim_fs_cache_open(fs);
+	if (index == NULL)
+		return;
+
+	sim_fs_cache_check_phase(fs, index, phase);
+	sim_fs_cache_revalidate(fs);
+}
+
+void sim_fs_cache_flush(struct sim_fs *fs)
+{
+	const char *iccid = ofono_sim_get_iccid(fs->sim);
+	char *path;
+
+	sim_fs_cache_close(fs);
+
+	if (iccid != NULL) {
+		path = g_strdup_printf(SIM_CACHE_FILE, iccid);
+		remove(path);
+		g_free(path);
+	}
+
+	sim_fs_legacy_cache_flush(fs);
+}
+
+void sim_fs_cache_flush_file(struct sim_fs *fs, int id)
+{
+	struct sim_cache_entry *entry = sim_fs_cache_lookup(fs, id);
+
+	if (entry == NULL)
+		return;
+
+	if (fs->entry == entry)
+		fs->entry = NULL;
+
+	entry->id = 0;
 }
 
 void sim_fs_image_cache_flush(struct sim_fs *fs)
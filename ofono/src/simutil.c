@@ -25,6 +25,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include <glib.h>
 
@@ -36,6 +37,8 @@
 struct sim_eons {
 	struct sim_eons_operator_info *pnn_list;
 	GSList *opl_list;
+	GHashTable *opl_plmns;
+	GSList *opl_wildcards;
 	gboolean pnn_valid;
 	int pnn_max;
 };
@@ -51,6 +54,22 @@ struct opl_operator {
 	guint16 lac_tac_low;
 	guint16 lac_tac_high;
 	guint8 id;
+	int index;
+};
+
+/* A LAC/TAC range and the first OPL record of the PLMN covering it */
+struct opl_range {
+	guint16 low;
+	guint16 high;
+	const struct opl_operator *opl;
+};
+
+/* OPL records of one PLMN without wildcard digits */
+struct opl_plmn {
+	const struct opl_operator *any;
+	struct opl_range *ranges;
+	int num_ranges;
+	GSList *pending;
 };
 
 #define MF	1
@@ -1046,6 +1065,26 @@ static struct opl_operator *opl_operator_alloc(const guint8 *record)
 	return oper;
 }
 
+static void opl_plmn_free(gpointer data)
+{
+	struct opl_plmn *plmn = data;
+
+	g_slist_free(plmn->pending);
+	g_free(plmn->ranges);
+	g_free(plmn);
+}
+
+static void sim_eons_index_free(struct sim_eons *eons)
+{
+	if (eons->opl_plmns) {
+		g_hash_table_destroy(eons->opl_plmns);
+		eons->opl_plmns = NULL;
+	}
+
+	g_slist_free(eons->opl_wildcards);
+	eons->opl_wildcards = NULL;
+}
+
 void sim_eons_add_opl_record(struct sim_eons *eons,
 				const guint8 *contents, int length)
 {
@@ -1058,12 +1097,158 @@ void sim_eons_add_opl_record(struct sim_eons *eons,
 		return;
 	}
 
+	sim_eons_index_free(eons);
+
 	eons->opl_list = g_slist_prepend(eons->opl_list, oper);
 }
 
+/* Whether the PLMN of the record can only be matched digit by digit */
+static gboolean opl_operator_is_wildcard(const struct opl_operator *opl)
+{
+	if (strlen(opl->mcc) != OFONO_MAX_MCC_LENGTH)
+		return TRUE;
+
+	if (strlen(opl->mnc) < OFONO_MAX_MNC_LENGTH - 1)
+		return TRUE;
+
+	return strchr(opl->mcc, 'b') != NULL || strchr(opl->mnc, 'b') != NULL;
+}
+
+static gboolean opl_operator_is_any_lac(const struct opl_operator *opl)
+{
+	return opl->lac_tac_low == 0 && opl->lac_tac_high == 0xfffe;
+}
+
+static int compare_guint32(gconstpointer a, gconstpointer b)
+{
+	guint32 ua = *(const guint32 *) a;
+	guint32 ub = *(const guint32 *) b;
+
+	return ua < ub ? -1 : ua > ub;
+}
+
+/*
+ * Splits the LAC/TAC space into disjoint ranges, each resolved to the
+ * first OPL record covering it.  Records that come after a record
+ * covering the whole PLMN can never match and are left out.
+ */
+static void opl_plmn_compile(struct opl_plmn *plmn)
+{
+	int max_points = 2 * g_slist_length(plmn->pending);
+	guint32 *points;
+	int num_points = 0;
+	GSList *l;
+	int i;
+
+	if (max_points == 0)
+		return;
+
+	points = g_new(guint32, max_points);
+
+	for (l = plmn->pending; l; l = l->next) {
+		const struct opl_operator *opl = l->data;
+
+		points[num_points++] = opl->lac_tac_low;
+		points[num_points++] = opl->lac_tac_high + 1;
+	}
+
+	qsort(points, num_points, sizeof(guint32), compare_guint32);
+
+	plmn->ranges = g_new(struct opl_range, num_points);
+
+	for (i = 0; i + 1 < num_points; i++) {
+		guint32 low = points[i];
+		guint32 high = points[i + 1] - 1;
+		struct opl_range *last;
+
+		if (points[i] == points[i + 1])
+			continue;
+
+		for (l = plmn->pending; l; l = l->next) {
+			const struct opl_operator *opl = l->data;
+
+			if (opl->lac_tac_low <= low && opl->lac_tac_high >= high)
+				break;
+		}
+
+		if (l == NULL)
+			continue;
+
+		last = plmn->num_ranges ?
+				&plmn->ranges[plmn->num_ranges - 1] : NULL;
+
+		if (last && last->opl == l->data && last->high + 1 == low) {
+			last->high = high;
+			continue;
+		}
+
+		plmn->ranges[plmn->num_ranges].low = low;
+		plmn->ranges[plmn->num_ranges].high = high;
+		plmn->ranges[plmn->num_ranges].opl = l->data;
+		plmn->num_ranges += 1;
+	}
+
+	g_free(points);
+
+	g_slist_free(plmn->pending);
+	plmn->pending = NULL;
+}
+
 void sim_eons_optimize(struct sim_eons *eons)
 {
+	GHashTableIter iter;
+	gpointer value;
+	GSList *l;
+	int index = 0;
+
 	eons->opl_list = g_slist_reverse(eons->opl_list);
+
+	sim_eons_index_free(eons);
+
+	eons->opl_plmns = g_hash_table_new_full(g_str_hash, g_str_equal,
+						g_free, opl_plmn_free);
+
+	for (l = eons->opl_list; l; l = l->next) {
+		struct opl_operator *opl = l->data;
+		struct opl_plmn *plmn;
+		char *key;
+
+		opl->index = index++;
+
+		if (opl_operator_is_wildcard(opl)) {
+			eons->opl_wildcards = g_slist_prepend(
+						eons->opl_wildcards, opl);
+			continue;
+		}
+
+		key = g_strdup_printf("%s-%s", opl->mcc, opl->mnc);
+		plmn = g_hash_table_lookup(eons->opl_plmns, key);
+
+		if (plmn == NULL) {
+			plmn = g_new0(struct opl_plmn, 1);
+			g_hash_table_insert(eons->opl_plmns, key, plmn);
+		} else
+			g_free(key);
+
+		if (plmn->any != NULL)
+			continue;
+
+		if (opl_operator_is_any_lac(opl))
+			plmn->any = opl;
+		else
+			plmn->pending = g_slist_prepend(plmn->pending, opl);
+	}
+
+	eons->opl_wildcards = g_slist_reverse(eons->opl_wildcards);
+
+	g_hash_table_iter_init(&iter, eons->opl_plmns);
+
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		struct opl_plmn *plmn = value;
+
+		plmn->pending = g_slist_reverse(plmn->pending);
+		opl_plmn_compile(plmn);
+	}
 }
 
 void sim_eons_free(struct sim_eons *eons)
@@ -1078,6 +1263,8 @@ void sim_eons_free(struct sim_eons *eons)
 
 	g_free(eons->pnn_list);
 
+	sim_eons_index_free(eons);
+
 	g_slist_foreach(eons->opl_list, (GFunc)g_free, NULL);
 	g_slist_free(eons->opl_list);
 
@@ -1171,47 +1358,102 @@ const char *sim_fileid_to_string(int fileid)
 
 }
 
+static gboolean opl_operator_match(const struct opl_operator *opl,
+					const char *mcc, const char *mnc,
+					gboolean have_lac, guint16 lac)
+{
+	int i;
+
+	for (i = 0; i < OFONO_MAX_MCC_LENGTH; i++)
+		if (mcc[i] != opl->mcc[i] &&
+				!(opl->mcc[i] == 'b' && mcc[i]))
+			return FALSE;
+
+	for (i = 0; i < OFONO_MAX_MNC_LENGTH; i++)
+		if (mnc[i] != opl->mnc[i] &&
+				!(opl->mnc[i] == 'b' && mnc[i]))
+			return FALSE;
+
+	if (opl_operator_is_any_lac(opl))
+		return TRUE;
+
+	if (have_lac == FALSE)
+		return FALSE;
+
+	return lac >= opl->lac_tac_low && lac <= opl->lac_tac_high;
+}
+
+static const struct opl_operator *opl_plmn_lookup(const struct opl_plmn *plmn,
+						gboolean have_lac,
+						guint16 lac)
+{
+	int low = 0;
+	int high = plmn->num_ranges - 1;
+
+	if (have_lac == FALSE)
+		return plmn->any;
+
+	while (low <= high) {
+		int mid = (low + high) / 2;
+		const struct opl_range *range = &plmn->ranges[mid];
+
+		if (lac < range->low)
+			high = mid - 1;
+		else if (lac > range->high)
+			low = mid + 1;
+		else if (plmn->any && plmn->any->index < range->opl->index)
+			return plmn->any;
+		else
+			return range->opl;
+	}
+
+	return plmn->any;
+}
+
 static const struct sim_eons_operator_info *
 	sim_eons_lookup_common(struct sim_eons *eons,
 				const char *mcc, const char *mnc,
 				gboolean have_lac, guint16 lac)
 {
+	char key[OFONO_MAX_MCC_LENGTH + OFONO_MAX_MNC_LENGTH + 2];
+	const struct opl_operator *opl = NULL;
+	const struct opl_plmn *plmn;
 	GSList *l;
-	const struct opl_operator *opl;
-	int i;
-
-	for (l = eons->opl_list; l; l = l->next) {
-		opl = l->data;
 
-		for (i = 0; i < OFONO_MAX_MCC_LENGTH; i++)
-			if (mcc[i] != opl->mcc[i] &&
-					!(opl->mcc[i] == 'b' && mcc[i]))
+	/* Records added since the last sim_eons_optimize are not indexed */
+	if (eons->opl_plmns == NULL) {
+		for (l = eons->opl_list; l; l = l->next)
+			if (opl_operator_match(l->data, mcc, mnc,
+							have_lac, lac))
 				break;
-		if (i < OFONO_MAX_MCC_LENGTH)
-			continue;
 
-		for (i = 0; i < OFONO_MAX_MNC_LENGTH; i++)
-			if (mnc[i] != opl->mnc[i] &&
-					!(opl->mnc[i] == 'b' && mnc[i]))
-				break;
-		if (i < OFONO_MAX_MNC_LENGTH)
-			continue;
+		opl = l ? l->data : NULL;
+		goto done;
+	}
 
-		if (opl->lac_tac_low == 0 && opl->lac_tac_high == 0xfffe)
-			break;
+	snprintf(key, sizeof(key), "%.3s-%.3s", mcc, mnc);
 
-		if (have_lac == FALSE)
-			continue;
+	plmn = g_hash_table_lookup(eons->opl_plmns, key);
+	if (plmn)
+		opl = opl_plmn_lookup(plmn, have_lac, lac);
 
-		if ((lac >= opl->lac_tac_low) && (lac <= opl->lac_tac_high))
+	/* The first matching record wins, be it a wildcard one or not */
+	for (l = eons->opl_wildcards; l; l = l->next) {
+		const struct opl_operator *wildcard = l->data;
+
+		if (opl && wildcard->index > opl->index)
 			break;
+
+		if (opl_operator_match(wildcard, mcc, mnc, have_lac, lac)) {
+			opl = wildcard;
+			break;
+		}
 	}
 
-	if (l == NULL)
+done:
+	if (opl == NULL)
 		return NULL;
 
-	opl = l->data;
-
 	/* 0 is not a valid record id */
 	if (opl->id == 0)
 		return NULL;
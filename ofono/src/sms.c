@@ -773,12 +773,8 @@ static gboolean tx_next(gpointer user_data)
 	return FALSE;
 }
 
-static void netreg_status_watch(int status, int lac, int ci, int tech,
-					const char *mcc, const char *mnc,
-					void *data)
+static void netreg_status_update(struct ofono_sms *sms, int status)
 {
-	struct ofono_sms *sms = data;
-
 	switch (status) {
 	case NETWORK_REGISTRATION_STATUS_REGISTERED:
 	case NETWORK_REGISTRATION_STATUS_ROAMING:
@@ -802,6 +798,15 @@ static void netreg_status_watch(int status, int lac, int ci, int tech,
 		sms->tx_source = g_timeout_add(0, tx_next, sms);
 }
 
+static void netreg_status_watch(const struct ofono_netreg_update *update,
+					void *data)
+{
+	struct ofono_sms *sms = data;
+
+	if (update->changed & OFONO_NETREG_UPDATE_STATUS)
+		netreg_status_update(sms, update->status);
+}
+
 static void netreg_watch(struct ofono_atom *atom,
 				enum ofono_atom_watch_condition cond,
 				void *data)
@@ -821,7 +826,7 @@ static void netreg_watch(struct ofono_atom *atom,
 					netreg_status_watch, sms, NULL);
 
 	status = ofono_netreg_get_status(sms->netreg);
-	netreg_status_watch(status, 0, 0, 0, NULL, NULL, sms);
+	netreg_status_update(sms, status);
 }
 
 
@@ -301,7 +301,7 @@ int sms_agent_dispatch_datagram(struct sms_agent *agent, const char *method,
 
 	dbus_message_iter_close_container(&iter, &dict);
 
-	if (!dbus_connection_send_with_reply(conn, req->msg, &req->call, -1)) {
+	if (!g_dbus_send_message_with_reply(conn, req->msg, &req->call, -1)) {
 		ofono_error("Sending D-Bus method failed");
 		sms_agent_request_free(req);
 		return -EIO;
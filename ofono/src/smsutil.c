@@ -634,6 +634,10 @@ gboolean sms_decode_address_field(const unsigned char *pdu, int len,
 	if ((len - *offset) < byte_len)
 		return FALSE;
 
+	/* 23.040 9.1.2.5: at most 10 octets of address value */
+	if (byte_len > 10)
+		return FALSE;
+
 	out->number_type = bit_field(addr_type, 4, 3);
 	out->numbering_plan = bit_field(addr_type, 0, 4);
 
@@ -2261,7 +2265,7 @@ char *sms_decode_text(GSList *sms_list)
 				continue;
 
 			/* Take care of improperly split fragments */
-			if (buf[written-1] == 0x1b)
+			if (written > 0 && buf[written-1] == 0x1b)
 				written = written - 1;
 
 			sms_extract_language_variant(sms, &locking_shift,
@@ -2479,7 +2483,7 @@ static void sms_assembly_backup_free(struct sms_assembly *assembly,
 
 	for (seq = 0; seq < node->max_fragments; seq++) {
 		int offset = seq / 32;
-		int bit = 1 << (seq % 32);
+		unsigned int bit = 1U << (seq % 32);
 
 		if (node->bitmap[offset] & bit) {
 			path = g_strdup_printf(SMS_BACKUP_PATH_FILE,
@@ -2558,7 +2562,7 @@ static GSList *sms_assembly_add_fragment_backup(struct sms_assembly *assembly,
 					gboolean backup)
 {
 	unsigned int offset = seq / 32;
-	unsigned int bit = 1 << (seq % 32);
+	unsigned int bit = 1U << (seq % 32);
 	GSList *l;
 	GSList *prev;
 	struct sms *newsms;
@@ -2606,7 +2610,7 @@ static GSList *sms_assembly_add_fragment_backup(struct sms_assembly *assembly,
 		position = 0;
 		for (i = 0; i < offset; i++)
 			for (j = 0; j < 32; j++)
-				if (node->bitmap[i] & (1 << j))
+				if (node->bitmap[i] & (1U << j))
 					position += 1;
 
 		for (j = 1; j < bit; j = j << 1)
@@ -4108,12 +4112,13 @@ char *cbs_decode_text(GSList *cbs_list, char *iso639_lang)
 			 */
 			for (; i < written; i++, bufsize++) {
 				if (unpacked[i] == '\r') {
-					int t;
+					int t = i;
 
-					t = strspn((const char *) unpacked + i,
-							"\r");
+					/* unpacked is not NUL terminated */
+					while (t < written && unpacked[t] == '\r')
+						t++;
 
-					if (t + i == written)
+					if (t == written)
 						break;
 				}
 
@@ -365,7 +365,7 @@ int stk_agent_request_selection(struct stk_agent *agent,
 	append_menu_items(&iter, menu->items);
 	dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT16, &default_item);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -435,7 +435,7 @@ int stk_agent_display_text(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BOOLEAN, &priority,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -504,7 +504,7 @@ int stk_agent_request_confirmation(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -583,7 +583,7 @@ int stk_agent_request_digit(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -616,7 +616,7 @@ int stk_agent_request_quick_digit(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -685,7 +685,7 @@ int stk_agent_request_key(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -783,7 +783,7 @@ int stk_agent_request_digits(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BOOLEAN, &hidden_val,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -874,7 +874,7 @@ int stk_agent_request_input(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BOOLEAN, &hidden_val,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -943,7 +943,7 @@ int stk_agent_confirm_call(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -1002,7 +1002,7 @@ int stk_agent_play_tone(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -1036,7 +1036,7 @@ int stk_agent_loop_tone(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -1090,7 +1090,7 @@ int stk_agent_display_action_info(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 					DBUS_TIMEOUT_INFINITE) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -1156,7 +1156,7 @@ int stk_agent_confirm_launch_browser(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_STRING, &url,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 						agent->call == NULL)
 		return -EIO;
@@ -1217,7 +1217,7 @@ int stk_agent_display_action(struct stk_agent *agent,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 					DBUS_TIMEOUT_INFINITE) == FALSE ||
 			agent->call == NULL)
 		return -EIO;
@@ -1284,7 +1284,7 @@ int stk_agent_confirm_open_channel(struct stk_agent *agent, const char *text,
 					DBUS_TYPE_BYTE, &icon->id,
 					DBUS_TYPE_INVALID);
 
-	if (dbus_connection_send_with_reply(conn, agent->msg, &agent->call,
+	if (g_dbus_send_message_with_reply(conn, agent->msg, &agent->call,
 						timeout) == FALSE ||
 						agent->call == NULL)
 		return -EIO;
@@ -24,6 +24,7 @@
 #endif
 
 #include <string.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
 
@@ -40,6 +41,7 @@ enum stk_data_object_flag {
 	DATAOBJ_FLAG_MINIMUM =		2,
 	DATAOBJ_FLAG_CR =		4,
 	DATAOBJ_FLAG_LIST =		8,
+	DATAOBJ_FLAG_SCRATCH =		16,
 };
 
 struct stk_file_iter {
@@ -651,6 +653,8 @@ static gboolean parse_dataobj_file_list(struct comprehension_tlv_iter *iter,
 error:
 	g_slist_foreach(*fl, (GFunc) g_free, NULL);
 	g_slist_free(*fl);
+	*fl = NULL;
+
 	return FALSE;
 }
 
@@ -1368,7 +1372,14 @@ static gboolean parse_dataobj_other_address(
 
 	data = comprehension_tlv_iter_get_data(iter);
 
-	if (data[0] != STK_ADDRESS_IPV4 && data[0] != STK_ADDRESS_IPV6)
+	/* The length has to match the address type */
+	if (data[0] == STK_ADDRESS_IPV4) {
+		if (len != 5)
+			return FALSE;
+	} else if (data[0] == STK_ADDRESS_IPV6) {
+		if (len != 17)
+			return FALSE;
+	} else
 		return FALSE;
 
 	oa->type = data[0];
@@ -2253,54 +2264,104 @@ static dataobj_handler handler_for_type(enum stk_data_object_type type)
 	}
 }
 
-static void destroy_stk_item(struct stk_item *item)
-{
-	g_free(item->text);
-	g_free(item);
-}
-
+/*
+ * Menu items are stored in a single block: the list nodes, followed by
+ * the items, followed by the item texts.  The list head is the start of
+ * the block, so the whole list is released with a single g_free.
+ */
 static gboolean parse_item_list(struct comprehension_tlv_iter *iter,
 				void *data)
 {
 	GSList **out = data;
 	unsigned short tag = STK_DATA_OBJECT_TYPE_ITEM;
 	struct comprehension_tlv_iter iter_old;
-	struct stk_item item;
-	GSList *list = NULL;
+	struct comprehension_tlv_iter walk;
 	unsigned int count = 0;
+	unsigned int max_items = 0;
+	gsize text_size = 0;
 	gboolean has_empty = FALSE;
+	GSList *nodes;
+	struct stk_item *items;
+	char *text;
+	unsigned int i;
+	unsigned int n;
+
+	comprehension_tlv_iter_copy(iter, &walk);
 
 	do {
+		unsigned int len = comprehension_tlv_iter_get_length(iter);
+
 		comprehension_tlv_iter_copy(iter, &iter_old);
-		memset(&item, 0, sizeof(item));
 		count++;
 
-		if (parse_dataobj_item(iter, &item) == TRUE) {
-			if (item.id == 0) {
-				has_empty = TRUE;
-				continue;
-			}
-
-			list = g_slist_prepend(list,
-						g_memdup(&item, sizeof(item)));
+		if (len == 0) {
+			has_empty = TRUE;
+			continue;
 		}
+
+		if (len == 1 || comprehension_tlv_iter_get_data(iter)[0] == 0)
+			continue;
+
+		/* Each SIM string octet expands to at most 3 UTF-8 octets */
+		max_items++;
+		text_size += (len - 1) * 3 + 1;
 	} while (comprehension_tlv_iter_next(iter) == TRUE &&
 			comprehension_tlv_iter_get_tag(iter) == tag);
 
 	comprehension_tlv_iter_copy(&iter_old, iter);
 
-	if (!has_empty) {
-		*out = g_slist_reverse(list);
-		return TRUE;
+	if (has_empty) {
+		/* A lone empty item is valid, it removes the menu */
+		if (count == 1)
+			return TRUE;
+
+		return FALSE;
 	}
 
-	if (count == 1)
+	if (max_items == 0)
 		return TRUE;
 
-	g_slist_foreach(list, (GFunc) destroy_stk_item, NULL);
-	g_slist_free(list);
-	return FALSE;
+	nodes = g_malloc(max_items * (sizeof(GSList) + sizeof(struct stk_item))
+				+ text_size);
+	items = (struct stk_item *) (nodes + max_items);
+	text = (char *) (items + max_items);
+
+	for (i = 0, n = 0; i < count; i++) {
+		struct stk_item item;
+		gsize len;
+
+		if (i > 0)
+			comprehension_tlv_iter_next(&walk);
+
+		memset(&item, 0, sizeof(item));
 
+		if (parse_dataobj_item(&walk, &item) == FALSE)
+			continue;
+
+		len = strlen(item.text) + 1;
+		memcpy(text, item.text, len);
+		g_free(item.text);
+
+		items[n].id = item.id;
+		items[n].text = text;
+		text += len;
+
+		nodes[n].data = &items[n];
+		nodes[n].next = NULL;
+
+		if (n > 0)
+			nodes[n - 1].next = &nodes[n];
+
+		n++;
+	}
+
+	if (n == 0) {
+		g_free(nodes);
+		return TRUE;
+	}
+
+	*out = nodes;
+	return TRUE;
 }
 
 static gboolean parse_provisioning_list(struct comprehension_tlv_iter *iter,
@@ -2341,88 +2402,83 @@ static dataobj_handler list_handler_for_type(enum stk_data_object_type type)
 	}
 }
 
-struct dataobj_handler_entry {
+/*
+ * Describes one data object expected by a proactive command.  The offset
+ * is into struct stk_command, or into a caller supplied scratch area if
+ * DATAOBJ_FLAG_SCRATCH is set.  Tables are terminated by an entry of type
+ * STK_DATA_OBJECT_TYPE_INVALID.
+ */
+struct dataobj_desc {
 	enum stk_data_object_type type;
-	int flags;
-	void *data;
+	unsigned short flags;
+	unsigned short offset;
 };
 
+#define DATAOBJ(type, flags, member)				\
+	{ STK_DATA_OBJECT_TYPE_##type, flags,			\
+		offsetof(struct stk_command, member) }
+
+#define DATAOBJ_SCRATCH(type, flags, scratch_type, member)	\
+	{ STK_DATA_OBJECT_TYPE_##type, (flags) | DATAOBJ_FLAG_SCRATCH,	\
+		offsetof(scratch_type, member) }
+
 static enum stk_command_parse_result parse_dataobj(
 					struct comprehension_tlv_iter *iter,
-					enum stk_data_object_type type, ...)
+					const struct dataobj_desc *desc,
+					struct stk_command *command,
+					void *scratch)
 {
-	GSList *entries = NULL;
-	GSList *l;
-	va_list args;
+	const struct dataobj_desc *d = desc;
 	gboolean minimum_set = TRUE;
 	gboolean parse_error = FALSE;
 
-	va_start(args, type);
-
-	while (type != STK_DATA_OBJECT_TYPE_INVALID) {
-		struct dataobj_handler_entry *entry;
-
-		entry = g_new0(struct dataobj_handler_entry, 1);
-
-		entry->type = type;
-		entry->flags = va_arg(args, int);
-		entry->data = va_arg(args, void *);
-
-		type = va_arg(args, enum stk_data_object_type);
-		entries = g_slist_prepend(entries, entry);
-	}
-
-	va_end(args);
-
-	entries = g_slist_reverse(entries);
-
-	l = entries;
 	while (comprehension_tlv_iter_next(iter) == TRUE) {
+		unsigned short tag = comprehension_tlv_iter_get_tag(iter);
+		const struct dataobj_desc *entry;
 		dataobj_handler handler;
-		struct dataobj_handler_entry *entry;
-		GSList *l2;
+		void *data;
 
-		for (l2 = l; l2; l2 = l2->next) {
-			entry = l2->data;
-
-			if (comprehension_tlv_iter_get_tag(iter) == entry->type)
+		for (entry = d; entry->type != STK_DATA_OBJECT_TYPE_INVALID;
+				entry++) {
+			if (tag == entry->type)
 				break;
 
 			/* Can't skip over mandatory objects */
 			if (entry->flags & DATAOBJ_FLAG_MANDATORY) {
-				l2 = NULL;
+				entry = NULL;
 				break;
 			}
 		}
 
-		if (l2 == NULL) {
+		if (entry == NULL ||
+				entry->type == STK_DATA_OBJECT_TYPE_INVALID) {
 			if (comprehension_tlv_get_cr(iter) == TRUE)
 				parse_error = TRUE;
 
 			continue;
 		}
 
+		if (entry->flags & DATAOBJ_FLAG_SCRATCH)
+			data = (char *) scratch + entry->offset;
+		else
+			data = (char *) command + entry->offset;
+
 		if (entry->flags & DATAOBJ_FLAG_LIST)
 			handler = list_handler_for_type(entry->type);
 		else
 			handler = handler_for_type(entry->type);
 
-		if (handler(iter, entry->data) == FALSE)
+		if (handler(iter, data) == FALSE)
 			parse_error = TRUE;
 
-		l = l2->next;
+		d = entry + 1;
 	}
 
-	for (; l; l = l->next) {
-		struct dataobj_handler_entry *entry = l->data;
-
-		if (entry->flags & DATAOBJ_FLAG_MANDATORY)
+	for (; d->type != STK_DATA_OBJECT_TYPE_INVALID; d++) {
+		if (d->flags & DATAOBJ_FLAG_MANDATORY)
 			minimum_set = FALSE;
 	}
 
-	g_slist_foreach(entries, (GFunc) g_free, NULL);
-	g_slist_free(entries);
-
 	if (minimum_set == FALSE)
 		return STK_PARSE_RESULT_MISSING_VALUE;
 	if (parse_error == TRUE)
@@ -2436,6 +2492,17 @@ static void destroy_display_text(struct stk_command *command)
 	g_free(command->display_text.text);
 }
 
+static const struct dataobj_desc display_text_dataobjs[] = {
+	DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			display_text.text),
+	DATAOBJ(ICON_ID, 0, display_text.icon_id),
+	DATAOBJ(IMMEDIATE_RESPONSE, 0, display_text.immediate_response),
+	DATAOBJ(DURATION, 0, display_text.duration),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, display_text.text_attr),
+	DATAOBJ(FRAME_ID, 0, display_text.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_display_text(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2451,20 +2518,7 @@ static enum stk_command_parse_result parse_display_text(
 
 	command->destructor = destroy_display_text;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE, 0,
-				&obj->immediate_response,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, display_text_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2476,6 +2530,16 @@ static void destroy_get_inkey(struct stk_command *command)
 	g_free(command->get_inkey.text);
 }
 
+static const struct dataobj_desc get_inkey_dataobjs[] = {
+	DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_inkey.text),
+	DATAOBJ(ICON_ID, 0, get_inkey.icon_id),
+	DATAOBJ(DURATION, 0, get_inkey.duration),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, get_inkey.text_attr),
+	DATAOBJ(FRAME_ID, 0, get_inkey.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_get_inkey(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2491,18 +2555,7 @@ static enum stk_command_parse_result parse_get_inkey(
 
 	command->destructor = destroy_get_inkey;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, get_inkey_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2515,6 +2568,18 @@ static void destroy_get_input(struct stk_command *command)
 	g_free(command->get_input.default_text);
 }
 
+static const struct dataobj_desc get_input_dataobjs[] = {
+	DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_input.text),
+	DATAOBJ(RESPONSE_LENGTH, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_input.resp_len),
+	DATAOBJ(DEFAULT_TEXT, 0, get_input.default_text),
+	DATAOBJ(ICON_ID, 0, get_input.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, get_input.text_attr),
+	DATAOBJ(FRAME_ID, 0, get_input.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_get_input(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2530,21 +2595,7 @@ static enum stk_command_parse_result parse_get_input(
 
 	command->destructor = destroy_get_input;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_RESPONSE_LENGTH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->resp_len,
-				STK_DATA_OBJECT_TYPE_DEFAULT_TEXT, 0,
-				&obj->default_text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, get_input_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2569,6 +2620,16 @@ static void destroy_play_tone(struct stk_command *command)
 	g_free(command->play_tone.alpha_id);
 }
 
+static const struct dataobj_desc play_tone_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, play_tone.alpha_id),
+	DATAOBJ(TONE, 0, play_tone.tone),
+	DATAOBJ(DURATION, 0, play_tone.duration),
+	DATAOBJ(ICON_ID, 0, play_tone.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, play_tone.text_attr),
+	DATAOBJ(FRAME_ID, 0, play_tone.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_play_tone(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2584,50 +2645,51 @@ static enum stk_command_parse_result parse_play_tone(
 
 	command->destructor = destroy_play_tone;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_TONE, 0,
-				&obj->tone,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, play_tone_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
 	return status;
 }
 
+static const struct dataobj_desc poll_interval_dataobjs[] = {
+	DATAOBJ(DURATION, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			poll_interval.duration),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_poll_interval(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_poll_interval *obj = &command->poll_interval;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_DURATION,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, poll_interval_dataobjs, command, NULL);
 }
 
 static void destroy_setup_menu(struct stk_command *command)
 {
 	g_free(command->setup_menu.alpha_id);
-	g_slist_foreach(command->setup_menu.items,
-				(GFunc) destroy_stk_item, NULL);
-	g_slist_free(command->setup_menu.items);
-}
+	g_free(command->setup_menu.items);
+}
+
+static const struct dataobj_desc setup_menu_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			setup_menu.alpha_id),
+	DATAOBJ(ITEM,
+		DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
+		DATAOBJ_FLAG_LIST, setup_menu.items),
+	DATAOBJ(ITEMS_NEXT_ACTION_INDICATOR, 0, setup_menu.next_act),
+	DATAOBJ(ICON_ID, 0, setup_menu.icon_id),
+	DATAOBJ(ITEM_ICON_ID_LIST, 0, setup_menu.item_icon_id_list),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, setup_menu.text_attr),
+	DATAOBJ(ITEM_TEXT_ATTRIBUTE_LIST, 0, setup_menu.item_text_attr_list),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
 
 static enum stk_command_parse_result parse_setup_menu(
 					struct stk_command *command,
@@ -2644,24 +2706,7 @@ static enum stk_command_parse_result parse_setup_menu(
 
 	command->destructor = destroy_setup_menu;
 
-	status = parse_dataobj(iter,
-			STK_DATA_OBJECT_TYPE_ALPHA_ID,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-			&obj->alpha_id,
-			STK_DATA_OBJECT_TYPE_ITEM,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
-			DATAOBJ_FLAG_LIST, &obj->items,
-			STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR, 0,
-			&obj->next_act,
-			STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-			&obj->icon_id,
-			STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST, 0,
-			&obj->item_icon_id_list,
-			STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-			&obj->text_attr,
-			STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST, 0,
-			&obj->item_text_attr_list,
-			STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, setup_menu_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -2671,10 +2716,23 @@ static enum stk_command_parse_result parse_setup_menu(
 static void destroy_select_item(struct stk_command *command)
 {
 	g_free(command->select_item.alpha_id);
-	g_slist_foreach(command->select_item.items,
-				(GFunc) destroy_stk_item, NULL);
-	g_slist_free(command->select_item.items);
-}
+	g_free(command->select_item.items);
+}
+
+static const struct dataobj_desc select_item_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, select_item.alpha_id),
+	DATAOBJ(ITEM,
+		DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
+		DATAOBJ_FLAG_LIST, select_item.items),
+	DATAOBJ(ITEMS_NEXT_ACTION_INDICATOR, 0, select_item.next_act),
+	DATAOBJ(ITEM_ID, 0, select_item.item_id),
+	DATAOBJ(ICON_ID, 0, select_item.icon_id),
+	DATAOBJ(ITEM_ICON_ID_LIST, 0, select_item.item_icon_id_list),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, select_item.text_attr),
+	DATAOBJ(ITEM_TEXT_ATTRIBUTE_LIST, 0, select_item.item_text_attr_list),
+	DATAOBJ(FRAME_ID, 0, select_item.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
 
 static enum stk_command_parse_result parse_select_item(
 					struct stk_command *command,
@@ -2689,27 +2747,7 @@ static enum stk_command_parse_result parse_select_item(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	status = parse_dataobj(iter,
-			STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-			&obj->alpha_id,
-			STK_DATA_OBJECT_TYPE_ITEM,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
-			DATAOBJ_FLAG_LIST, &obj->items,
-			STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR, 0,
-			&obj->next_act,
-			STK_DATA_OBJECT_TYPE_ITEM_ID, 0,
-			&obj->item_id,
-			STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-			&obj->icon_id,
-			STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST, 0,
-			&obj->item_icon_id_list,
-			STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-			&obj->text_attr,
-			STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST, 0,
-			&obj->item_text_attr_list,
-			STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-			&obj->frame_id,
-			STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, select_item_dataobjs, command, NULL);
 
 	command->destructor = destroy_select_item;
 
@@ -2721,20 +2759,38 @@ static enum stk_command_parse_result parse_select_item(
 	return status;
 }
 
+/* Objects of Send SMS which are decoded further before being stored */
+struct send_sms_scratch {
+	struct stk_address sc_address;
+	struct gsm_sms_tpdu gsm_tpdu;
+};
+
 static void destroy_send_sms(struct stk_command *command)
 {
 	g_free(command->send_sms.alpha_id);
 	g_free(command->send_sms.cdma_sms.array);
 }
 
+static const struct dataobj_desc send_sms_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, send_sms.alpha_id),
+	DATAOBJ_SCRATCH(ADDRESS, 0, struct send_sms_scratch, sc_address),
+	DATAOBJ_SCRATCH(GSM_SMS_TPDU, 0, struct send_sms_scratch, gsm_tpdu),
+	DATAOBJ(CDMA_SMS_TPDU, 0, send_sms.cdma_sms),
+	DATAOBJ(ICON_ID, 0, send_sms.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, send_sms.text_attr),
+	DATAOBJ(FRAME_ID, 0, send_sms.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_send_sms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
 	struct stk_command_send_sms *obj = &command->send_sms;
 	enum stk_command_parse_result status;
-	struct gsm_sms_tpdu gsm_tpdu;
-	struct stk_address sc_address = { 0, NULL };
+	struct send_sms_scratch scratch;
+	struct gsm_sms_tpdu *gsm_tpdu = &scratch.gsm_tpdu;
+	struct stk_address *sc_address = &scratch.sc_address;
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2742,22 +2798,8 @@ static enum stk_command_parse_result parse_send_sms(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_NETWORK)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	memset(&gsm_tpdu, 0, sizeof(gsm_tpdu));
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ADDRESS, 0,
-				&sc_address,
-				STK_DATA_OBJECT_TYPE_GSM_SMS_TPDU, 0,
-				&gsm_tpdu,
-				STK_DATA_OBJECT_TYPE_CDMA_SMS_TPDU, 0,
-				&obj->cdma_sms,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	memset(&scratch, 0, sizeof(scratch));
+	status = parse_dataobj(iter, send_sms_dataobjs, command, &scratch);
 
 	command->destructor = destroy_send_sms;
 
@@ -2769,12 +2811,12 @@ static enum stk_command_parse_result parse_send_sms(
 	if (status != STK_PARSE_RESULT_OK)
 		goto out;
 
-	if (gsm_tpdu.len == 0 && obj->cdma_sms.len == 0) {
+	if (gsm_tpdu->len == 0 && obj->cdma_sms.len == 0) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
 
-	if (gsm_tpdu.len > 0 && obj->cdma_sms.len > 0) {
+	if (gsm_tpdu->len > 0 && obj->cdma_sms.len > 0) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
@@ -2785,7 +2827,7 @@ static enum stk_command_parse_result parse_send_sms(
 
 	/* packing is needed */
 	if (command->qualifier & 0x01) {
-		if (sms_decode_unpacked_stk_pdu(gsm_tpdu.tpdu, gsm_tpdu.len,
+		if (sms_decode_unpacked_stk_pdu(gsm_tpdu->tpdu, gsm_tpdu->len,
 							&obj->gsm_sms) !=
 				TRUE) {
 			status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2795,8 +2837,8 @@ static enum stk_command_parse_result parse_send_sms(
 		goto set_addr;
 	}
 
-	if (sms_decode(gsm_tpdu.tpdu, gsm_tpdu.len, TRUE,
-				gsm_tpdu.len, &obj->gsm_sms) == FALSE) {
+	if (sms_decode(gsm_tpdu->tpdu, gsm_tpdu->len, TRUE,
+				gsm_tpdu->len, &obj->gsm_sms) == FALSE) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
@@ -2808,20 +2850,20 @@ static enum stk_command_parse_result parse_send_sms(
 	}
 
 set_addr:
-	if (sc_address.number == NULL)
+	if (sc_address->number == NULL)
 		goto out;
 
-	if (strlen(sc_address.number) > 20) {
+	if (strlen(sc_address->number) > 20) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
 
-	strcpy(obj->gsm_sms.sc_addr.address, sc_address.number);
-	obj->gsm_sms.sc_addr.numbering_plan = sc_address.ton_npi & 15;
-	obj->gsm_sms.sc_addr.number_type = (sc_address.ton_npi >> 4) & 7;
+	strcpy(obj->gsm_sms.sc_addr.address, sc_address->number);
+	obj->gsm_sms.sc_addr.numbering_plan = sc_address->ton_npi & 15;
+	obj->gsm_sms.sc_addr.number_type = (sc_address->ton_npi >> 4) & 7;
 
 out:
-	g_free(sc_address.number);
+	g_free(sc_address->number);
 
 	return status;
 }
@@ -2832,11 +2874,19 @@ static void destroy_send_ss(struct stk_command *command)
 	g_free(command->send_ss.ss.ss);
 }
 
+static const struct dataobj_desc send_ss_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, send_ss.alpha_id),
+	DATAOBJ(SS_STRING, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_ss.ss),
+	DATAOBJ(ICON_ID, 0, send_ss.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, send_ss.text_attr),
+	DATAOBJ(FRAME_ID, 0, send_ss.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_send_ss(struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_send_ss *obj = &command->send_ss;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -2845,18 +2895,7 @@ static enum stk_command_parse_result parse_send_ss(struct stk_command *command,
 
 	command->destructor = destroy_send_ss;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_SS_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->ss,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, send_ss_dataobjs, command, NULL);
 }
 
 static void destroy_send_ussd(struct stk_command *command)
@@ -2864,12 +2903,20 @@ static void destroy_send_ussd(struct stk_command *command)
 	g_free(command->send_ussd.alpha_id);
 }
 
+static const struct dataobj_desc send_ussd_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, send_ussd.alpha_id),
+	DATAOBJ(USSD_STRING, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_ussd.ussd_string),
+	DATAOBJ(ICON_ID, 0, send_ussd.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, send_ussd.text_attr),
+	DATAOBJ(FRAME_ID, 0, send_ussd.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_send_ussd(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_send_ussd *obj = &command->send_ussd;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -2878,18 +2925,7 @@ static enum stk_command_parse_result parse_send_ussd(
 
 	command->destructor = destroy_send_ussd;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_USSD_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->ussd_string,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, send_ussd_dataobjs, command, NULL);
 }
 
 static void destroy_setup_call(struct stk_command *command)
@@ -2899,6 +2935,22 @@ static void destroy_setup_call(struct stk_command *command)
 	g_free(command->setup_call.alpha_id_call_setup);
 }
 
+static const struct dataobj_desc setup_call_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, setup_call.alpha_id_usr_cfm),
+	DATAOBJ(ADDRESS, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			setup_call.addr),
+	DATAOBJ(CCP, 0, setup_call.ccp),
+	DATAOBJ(SUBADDRESS, 0, setup_call.subaddr),
+	DATAOBJ(DURATION, 0, setup_call.duration),
+	DATAOBJ(ICON_ID, 0, setup_call.icon_id_usr_cfm),
+	DATAOBJ(ALPHA_ID, 0, setup_call.alpha_id_call_setup),
+	DATAOBJ(ICON_ID, 0, setup_call.icon_id_call_setup),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, setup_call.text_attr_usr_cfm),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, setup_call.text_attr_call_setup),
+	DATAOBJ(FRAME_ID, 0, setup_call.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_setup_call(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2914,30 +2966,7 @@ static enum stk_command_parse_result parse_setup_call(
 
 	command->destructor = destroy_setup_call;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id_usr_cfm,
-				STK_DATA_OBJECT_TYPE_ADDRESS,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->addr,
-				STK_DATA_OBJECT_TYPE_CCP, 0,
-				&obj->ccp,
-				STK_DATA_OBJECT_TYPE_SUBADDRESS, 0,
-				&obj->subaddr,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id_usr_cfm,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id_call_setup,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id_call_setup,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr_usr_cfm,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr_call_setup,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, setup_call_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id_usr_cfm, obj->icon_id_usr_cfm.id);
 	CHECK_TEXT_AND_ICON(obj->alpha_id_call_setup,
@@ -2953,6 +2982,16 @@ static void destroy_refresh(struct stk_command *command)
 	g_free(command->refresh.alpha_id);
 }
 
+static const struct dataobj_desc refresh_dataobjs[] = {
+	DATAOBJ(FILE_LIST, 0, refresh.file_list),
+	DATAOBJ(AID, 0, refresh.aid),
+	DATAOBJ(ALPHA_ID, 0, refresh.alpha_id),
+	DATAOBJ(ICON_ID, 0, refresh.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, refresh.text_attr),
+	DATAOBJ(FRAME_ID, 0, refresh.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_refresh(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -2968,19 +3007,7 @@ static enum stk_command_parse_result parse_refresh(
 
 	command->destructor = destroy_refresh;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FILE_LIST, 0,
-				&obj->file_list,
-				STK_DATA_OBJECT_TYPE_AID, 0,
-				&obj->aid,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, refresh_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3013,30 +3040,35 @@ static enum stk_command_parse_result parse_provide_local_info(
 	return STK_PARSE_RESULT_OK;
 }
 
+static const struct dataobj_desc setup_event_list_dataobjs[] = {
+	DATAOBJ(EVENT_LIST, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			setup_event_list.event_list),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_setup_event_list(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_setup_event_list *obj = &command->setup_event_list;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_EVENT_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->event_list,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, setup_event_list_dataobjs, command, NULL);
 }
 
+static const struct dataobj_desc perform_card_apdu_dataobjs[] = {
+	DATAOBJ(C_APDU, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			perform_card_apdu.c_apdu),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_perform_card_apdu(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_perform_card_apdu *obj = &command->perform_card_apdu;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3044,10 +3076,7 @@ static enum stk_command_parse_result parse_perform_card_apdu(
 			(command->dst > STK_DEVICE_IDENTITY_TYPE_CARD_READER_7))
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_C_APDU,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->c_apdu,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, perform_card_apdu_dataobjs, command, NULL);
 }
 
 static enum stk_command_parse_result parse_power_off_card(
@@ -3103,13 +3132,25 @@ static enum stk_command_parse_result parse_get_reader_status(
 	return STK_PARSE_RESULT_OK;
 }
 
+static const struct dataobj_desc timer_mgmt_dataobjs[] = {
+	DATAOBJ(TIMER_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			timer_mgmt.timer_id),
+	DATAOBJ(TIMER_VALUE, 0, timer_mgmt.timer_value),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
+/* Starting a timer requires the Timer value */
+static const struct dataobj_desc timer_mgmt_start_dataobjs[] = {
+	DATAOBJ(TIMER_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			timer_mgmt.timer_id),
+	DATAOBJ(TIMER_VALUE, DATAOBJ_FLAG_MANDATORY, timer_mgmt.timer_value),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_timer_mgmt(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_timer_mgmt *obj = &command->timer_mgmt;
-	enum stk_data_object_flag value_flags = 0;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3117,14 +3158,10 @@ static enum stk_command_parse_result parse_timer_mgmt(
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if ((command->qualifier & 3) == 0) /* Start a timer */
-		value_flags = DATAOBJ_FLAG_MANDATORY;
+		return parse_dataobj(iter, timer_mgmt_start_dataobjs,
+					command, NULL);
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TIMER_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->timer_id,
-				STK_DATA_OBJECT_TYPE_TIMER_VALUE, value_flags,
-				&obj->timer_value,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, timer_mgmt_dataobjs, command, NULL);
 }
 
 static void destroy_setup_idle_mode_text(struct stk_command *command)
@@ -3132,6 +3169,15 @@ static void destroy_setup_idle_mode_text(struct stk_command *command)
 	g_free(command->setup_idle_mode_text.text);
 }
 
+static const struct dataobj_desc setup_idle_mode_text_dataobjs[] = {
+	DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			setup_idle_mode_text.text),
+	DATAOBJ(ICON_ID, 0, setup_idle_mode_text.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, setup_idle_mode_text.text_attr),
+	DATAOBJ(FRAME_ID, 0, setup_idle_mode_text.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_setup_idle_mode_text(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3148,16 +3194,8 @@ static enum stk_command_parse_result parse_setup_idle_mode_text(
 
 	command->destructor = destroy_setup_idle_mode_text;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, setup_idle_mode_text_dataobjs,
+						command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -3170,6 +3208,16 @@ static void destroy_run_at_command(struct stk_command *command)
 	g_free(command->run_at_command.at_command);
 }
 
+static const struct dataobj_desc run_at_command_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, run_at_command.alpha_id),
+	DATAOBJ(AT_COMMAND, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			run_at_command.at_command),
+	DATAOBJ(ICON_ID, 0, run_at_command.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, run_at_command.text_attr),
+	DATAOBJ(FRAME_ID, 0, run_at_command.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_run_at_command(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3185,18 +3233,7 @@ static enum stk_command_parse_result parse_run_at_command(
 
 	command->destructor = destroy_run_at_command;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_AT_COMMAND,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->at_command,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, run_at_command_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3209,6 +3246,16 @@ static void destroy_send_dtmf(struct stk_command *command)
 	g_free(command->send_dtmf.dtmf);
 }
 
+static const struct dataobj_desc send_dtmf_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, send_dtmf.alpha_id),
+	DATAOBJ(DTMF_STRING, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_dtmf.dtmf),
+	DATAOBJ(ICON_ID, 0, send_dtmf.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, send_dtmf.text_attr),
+	DATAOBJ(FRAME_ID, 0, send_dtmf.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_send_dtmf(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3224,40 +3271,30 @@ static enum stk_command_parse_result parse_send_dtmf(
 
 	command->destructor = destroy_send_dtmf;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_DTMF_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->dtmf,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, send_dtmf_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
 	return status;
 }
 
+static const struct dataobj_desc language_notification_dataobjs[] = {
+	DATAOBJ(LANGUAGE, 0, language_notification.language),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_language_notification(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_language_notification *obj =
-					&command->language_notification;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_LANGUAGE, 0,
-				&obj->language,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, language_notification_dataobjs,
+						command, NULL);
 }
 
 static void destroy_launch_browser(struct stk_command *command)
@@ -3274,12 +3311,28 @@ static void destroy_launch_browser(struct stk_command *command)
 	g_free(command->launch_browser.text_passwd);
 }
 
+static const struct dataobj_desc launch_browser_dataobjs[] = {
+	DATAOBJ(BROWSER_ID, 0, launch_browser.browser_id),
+	DATAOBJ(URL, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			launch_browser.url),
+	DATAOBJ(BEARER, 0, launch_browser.bearer),
+	DATAOBJ(PROVISIONING_FILE_REF, DATAOBJ_FLAG_LIST,
+			launch_browser.prov_file_refs),
+	DATAOBJ(TEXT, 0, launch_browser.text_gateway_proxy_id),
+	DATAOBJ(ALPHA_ID, 0, launch_browser.alpha_id),
+	DATAOBJ(ICON_ID, 0, launch_browser.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, launch_browser.text_attr),
+	DATAOBJ(FRAME_ID, 0, launch_browser.frame_id),
+	DATAOBJ(NETWORK_ACCESS_NAME, 0, launch_browser.network_name),
+	DATAOBJ(TEXT, 0, launch_browser.text_usr),
+	DATAOBJ(TEXT, 0, launch_browser.text_passwd),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_launch_browser(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_launch_browser *obj = &command->launch_browser;
-
 	if (command->qualifier > 3 || command->qualifier == 1)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3291,34 +3344,7 @@ static enum stk_command_parse_result parse_launch_browser(
 
 	command->destructor = destroy_launch_browser;
 
-	return parse_dataobj(iter,
-				STK_DATA_OBJECT_TYPE_BROWSER_ID, 0,
-				&obj->browser_id,
-				STK_DATA_OBJECT_TYPE_URL,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->url,
-				STK_DATA_OBJECT_TYPE_BEARER, 0,
-				&obj->bearer,
-				STK_DATA_OBJECT_TYPE_PROVISIONING_FILE_REF,
-				DATAOBJ_FLAG_LIST,
-				&obj->prov_file_refs,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_gateway_proxy_id,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME, 0,
-				&obj->network_name,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_usr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_passwd,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, launch_browser_dataobjs, command, NULL);
 }
 
 static void destroy_open_channel(struct stk_command *command)
@@ -3329,6 +3355,25 @@ static void destroy_open_channel(struct stk_command *command)
 	g_free(command->open_channel.text_passwd);
 }
 
+static const struct dataobj_desc open_channel_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, open_channel.alpha_id),
+	DATAOBJ(ICON_ID, 0, open_channel.icon_id),
+	DATAOBJ(BEARER_DESCRIPTION,
+		DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+		open_channel.bearer_desc),
+	DATAOBJ(BUFFER_SIZE, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			open_channel.buf_size),
+	DATAOBJ(NETWORK_ACCESS_NAME, 0, open_channel.apn),
+	DATAOBJ(OTHER_ADDRESS, 0, open_channel.local_addr),
+	DATAOBJ(TEXT, 0, open_channel.text_usr),
+	DATAOBJ(TEXT, 0, open_channel.text_passwd),
+	DATAOBJ(UICC_TE_INTERFACE, 0, open_channel.uti),
+	DATAOBJ(OTHER_ADDRESS, 0, open_channel.data_dest_addr),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, open_channel.text_attr),
+	DATAOBJ(FRAME_ID, 0, open_channel.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_open_channel(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3351,34 +3396,7 @@ static enum stk_command_parse_result parse_open_channel(
 	 * parse the Open Channel data objects related to packet data service
 	 * bearer
 	 */
-	status = parse_dataobj(iter,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_BEARER_DESCRIPTION,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->bearer_desc,
-				STK_DATA_OBJECT_TYPE_BUFFER_SIZE,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->buf_size,
-				STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME, 0,
-				&obj->apn,
-				STK_DATA_OBJECT_TYPE_OTHER_ADDRESS, 0,
-				&obj->local_addr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_usr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_passwd,
-				STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE, 0,
-				&obj->uti,
-				STK_DATA_OBJECT_TYPE_OTHER_ADDRESS, 0,
-				&obj->data_dest_addr,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, open_channel_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3390,6 +3408,14 @@ static void destroy_close_channel(struct stk_command *command)
 	g_free(command->close_channel.alpha_id);
 }
 
+static const struct dataobj_desc close_channel_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, close_channel.alpha_id),
+	DATAOBJ(ICON_ID, 0, close_channel.icon_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, close_channel.text_attr),
+	DATAOBJ(FRAME_ID, 0, close_channel.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_close_channel(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3406,15 +3432,7 @@ static enum stk_command_parse_result parse_close_channel(
 
 	command->destructor = destroy_close_channel;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, close_channel_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3426,6 +3444,17 @@ static void destroy_receive_data(struct stk_command *command)
 	g_free(command->receive_data.alpha_id);
 }
 
+static const struct dataobj_desc receive_data_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, receive_data.alpha_id),
+	DATAOBJ(ICON_ID, 0, receive_data.icon_id),
+	DATAOBJ(CHANNEL_DATA_LENGTH,
+		DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+		receive_data.data_len),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, receive_data.text_attr),
+	DATAOBJ(FRAME_ID, 0, receive_data.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_receive_data(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3442,18 +3471,7 @@ static enum stk_command_parse_result parse_receive_data(
 
 	command->destructor = destroy_receive_data;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_CHANNEL_DATA_LENGTH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->data_len,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, receive_data_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3466,6 +3484,16 @@ static void destroy_send_data(struct stk_command *command)
 	g_free(command->send_data.data.array);
 }
 
+static const struct dataobj_desc send_data_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, send_data.alpha_id),
+	DATAOBJ(ICON_ID, 0, send_data.icon_id),
+	DATAOBJ(CHANNEL_DATA, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_data.data),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, send_data.text_attr),
+	DATAOBJ(FRAME_ID, 0, send_data.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_send_data(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3485,18 +3513,7 @@ static enum stk_command_parse_result parse_send_data(
 
 	command->destructor = destroy_send_data;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_CHANNEL_DATA,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->data,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, send_data_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3523,12 +3540,21 @@ static void destroy_service_search(struct stk_command *command)
 	g_free(command->service_search.dev_filter.dev_filter);
 }
 
+static const struct dataobj_desc service_search_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, service_search.alpha_id),
+	DATAOBJ(ICON_ID, 0, service_search.icon_id),
+	DATAOBJ(SERVICE_SEARCH, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			service_search.serv_search),
+	DATAOBJ(DEVICE_FILTER, 0, service_search.dev_filter),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, service_search.text_attr),
+	DATAOBJ(FRAME_ID, 0, service_search.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_service_search(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_service_search *obj = &command->service_search;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3537,20 +3563,7 @@ static enum stk_command_parse_result parse_service_search(
 
 	command->destructor = destroy_service_search;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_SERVICE_SEARCH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->serv_search,
-				STK_DATA_OBJECT_TYPE_DEVICE_FILTER, 0,
-				&obj->dev_filter,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, service_search_dataobjs, command, NULL);
 }
 
 static void destroy_get_service_info(struct stk_command *command)
@@ -3559,12 +3572,20 @@ static void destroy_get_service_info(struct stk_command *command)
 	g_free(command->get_service_info.attr_info.attr_info);
 }
 
+static const struct dataobj_desc get_service_info_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, get_service_info.alpha_id),
+	DATAOBJ(ICON_ID, 0, get_service_info.icon_id),
+	DATAOBJ(ATTRIBUTE_INFO, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_service_info.attr_info),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, get_service_info.text_attr),
+	DATAOBJ(FRAME_ID, 0, get_service_info.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_get_service_info(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_get_service_info *obj = &command->get_service_info;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3573,18 +3594,7 @@ static enum stk_command_parse_result parse_get_service_info(
 
 	command->destructor = destroy_get_service_info;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_ATTRIBUTE_INFO,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->attr_info,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, get_service_info_dataobjs, command, NULL);
 }
 
 static void destroy_declare_service(struct stk_command *command)
@@ -3592,12 +3602,17 @@ static void destroy_declare_service(struct stk_command *command)
 	g_free(command->declare_service.serv_rec.serv_rec);
 }
 
+static const struct dataobj_desc declare_service_dataobjs[] = {
+	DATAOBJ(SERVICE_RECORD, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			declare_service.serv_rec),
+	DATAOBJ(UICC_TE_INTERFACE, 0, declare_service.intf),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_declare_service(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_declare_service *obj = &command->declare_service;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3606,34 +3621,28 @@ static enum stk_command_parse_result parse_declare_service(
 
 	command->destructor = destroy_declare_service;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_SERVICE_RECORD,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->serv_rec,
-				STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE, 0,
-				&obj->intf,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, declare_service_dataobjs, command, NULL);
 }
 
+static const struct dataobj_desc set_frames_dataobjs[] = {
+	DATAOBJ(FRAME_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			set_frames.frame_id),
+	DATAOBJ(FRAME_LAYOUT, 0, set_frames.frame_layout),
+	DATAOBJ(FRAME_ID, 0, set_frames.frame_id_default),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_set_frames(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_set_frames *obj = &command->set_frames;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FRAME_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_FRAME_LAYOUT, 0,
-				&obj->frame_layout,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id_default,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, set_frames_dataobjs, command, NULL);
 }
 
 static enum stk_command_parse_result parse_get_frames_status(
@@ -3657,6 +3666,21 @@ static void destroy_retrieve_mms(struct stk_command *command)
 	g_slist_free(command->retrieve_mms.mms_rec_files);
 }
 
+static const struct dataobj_desc retrieve_mms_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, retrieve_mms.alpha_id),
+	DATAOBJ(ICON_ID, 0, retrieve_mms.icon_id),
+	DATAOBJ(MMS_REFERENCE, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_ref),
+	DATAOBJ(FILE_LIST, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_rec_files),
+	DATAOBJ(MMS_CONTENT_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_content_id),
+	DATAOBJ(MMS_ID, 0, retrieve_mms.mms_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, retrieve_mms.text_attr),
+	DATAOBJ(FRAME_ID, 0, retrieve_mms.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_retrieve_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3672,26 +3696,7 @@ static enum stk_command_parse_result parse_retrieve_mms(
 
 	command->destructor = destroy_retrieve_mms;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_MMS_REFERENCE,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_ref,
-				STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_rec_files,
-				STK_DATA_OBJECT_TYPE_MMS_CONTENT_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_content_id,
-				STK_DATA_OBJECT_TYPE_MMS_ID, 0,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, retrieve_mms_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3706,6 +3711,17 @@ static void destroy_submit_mms(struct stk_command *command)
 	g_slist_free(command->submit_mms.mms_subm_files);
 }
 
+static const struct dataobj_desc submit_mms_dataobjs[] = {
+	DATAOBJ(ALPHA_ID, 0, submit_mms.alpha_id),
+	DATAOBJ(ICON_ID, 0, submit_mms.icon_id),
+	DATAOBJ(FILE_LIST, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			submit_mms.mms_subm_files),
+	DATAOBJ(MMS_ID, 0, submit_mms.mms_id),
+	DATAOBJ(TEXT_ATTRIBUTE, 0, submit_mms.text_attr),
+	DATAOBJ(FRAME_ID, 0, submit_mms.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_submit_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
@@ -3721,20 +3737,7 @@ static enum stk_command_parse_result parse_submit_mms(
 
 	command->destructor = destroy_submit_mms;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_subm_files,
-				STK_DATA_OBJECT_TYPE_MMS_ID, 0,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, submit_mms_dataobjs, command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3748,12 +3751,20 @@ static void destroy_display_mms(struct stk_command *command)
 	g_slist_free(command->display_mms.mms_subm_files);
 }
 
+static const struct dataobj_desc display_mms_dataobjs[] = {
+	DATAOBJ(FILE_LIST, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			display_mms.mms_subm_files),
+	DATAOBJ(MMS_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			display_mms.mms_id),
+	DATAOBJ(IMMEDIATE_RESPONSE, 0, display_mms.imd_resp),
+	DATAOBJ(FRAME_ID, 0, display_mms.frame_id),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_display_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_display_mms *obj = &command->display_mms;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -3762,35 +3773,27 @@ static enum stk_command_parse_result parse_display_mms(
 
 	command->destructor = destroy_display_mms;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_subm_files,
-				STK_DATA_OBJECT_TYPE_MMS_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE, 0,
-				&obj->imd_resp,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, display_mms_dataobjs, command, NULL);
 }
 
+static const struct dataobj_desc activate_dataobjs[] = {
+	DATAOBJ(ACTIVATE_DESCRIPTOR,
+		DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+		activate.actv_desc),
+	{ STK_DATA_OBJECT_TYPE_INVALID }
+};
+
 static enum stk_command_parse_result parse_activate(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_activate *obj = &command->activate;
-
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ACTIVATE_DESCRIPTOR,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->actv_desc,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, activate_dataobjs, command, NULL);
 }
 
 static enum stk_command_parse_result parse_command_body(
@@ -3988,11 +3991,30 @@ static gboolean stk_tlv_builder_open_container(struct stk_tlv_builder *iter,
 						unsigned char shorttag,
 						gboolean relocatable)
 {
+	unsigned int avail;
+
 	if (comprehension_tlv_builder_next(&iter->ctlv, cr, shorttag) != TRUE)
 		return FALSE;
 
+	if (comprehension_tlv_builder_set_length(&iter->ctlv, 0) != TRUE)
+		return FALSE;
+
+	avail = iter->ctlv.pdu + iter->ctlv.max -
+			comprehension_tlv_builder_get_data(&iter->ctlv);
+
 	iter->len = 0;
 	iter->max_len = relocatable ? 0xff : 0x7f;
+
+	/*
+	 * Don't reserve more than what is left in the buffer, keeping in
+	 * mind that lengths above 0x7f need an extra length byte.
+	 */
+	if (iter->max_len > avail)
+		iter->max_len = avail;
+
+	if (iter->max_len > 0x7f && iter->max_len == avail)
+		iter->max_len -= 1;
+
 	if (comprehension_tlv_builder_set_length(&iter->ctlv, iter->max_len) !=
 			TRUE)
 		return FALSE;
@@ -4034,94 +4056,78 @@ static gboolean stk_tlv_builder_append_short(struct stk_tlv_builder *iter,
 	return TRUE;
 }
 
+/*
+ * Space left in the PDU buffer past the end of the open container's data,
+ * may be more than the container itself can hold.
+ */
+static long stk_tlv_builder_get_room(struct stk_tlv_builder *iter)
+{
+	return iter->ctlv.pdu + iter->ctlv.max - (iter->value + iter->len);
+}
+
 static gboolean stk_tlv_builder_append_gsm_packed(struct stk_tlv_builder *iter,
 							const char *text)
 {
-	unsigned int len;
 	unsigned char *gsm;
 	long written = 0;
+	long packed = 0;
 
 	if (text == NULL)
 		return TRUE;
 
-	len = strlen(text);
-
-	gsm = convert_utf8_to_gsm(text, len, NULL, &written, 0);
-	if (gsm == NULL && len > 0)
+	if (iter->len >= iter->max_len)
 		return FALSE;
 
-	if (iter->len + (written * 7 + 7) / 8 >= iter->max_len) {
-		g_free(gsm);
+	/*
+	 * Convert the text right past the DCS byte and pack it in place,
+	 * pack_7bit_own_buf never writes ahead of the byte it reads.
+	 */
+	gsm = iter->value + iter->len + 1;
+
+	if (convert_utf8_to_gsm_own_buf(text, -1, NULL, &written, 0, gsm,
+				stk_tlv_builder_get_room(iter) - 1) == NULL)
 		return FALSE;
-	}
 
-	pack_7bit_own_buf(gsm, len, 0, FALSE, &written, 0,
-				iter->value + iter->len + 1);
-	g_free(gsm);
+	if (iter->len + (written * 7 + 7) / 8 >= iter->max_len)
+		return FALSE;
 
-	if (written < 1 && len > 0)
+	if (written > 0 && pack_7bit_own_buf(gsm, written, 0, FALSE, &packed,
+							0, gsm) == NULL)
 		return FALSE;
 
 	iter->value[iter->len++] = 0x00;
-	iter->len += written;
+	iter->len += packed;
 
 	return TRUE;
 }
 
-static gboolean stk_tlv_builder_append_gsm_unpacked(
-						struct stk_tlv_builder *iter,
+/* Appends the text in unpacked GSM 7 bit default alphabet */
+static gboolean stk_tlv_builder_append_gsm(struct stk_tlv_builder *iter,
 						const char *text)
 {
-	unsigned int len;
-	unsigned char *gsm;
 	long written = 0;
 
-	if (text == NULL)
-		return TRUE;
-
-	len = strlen(text);
-
-	gsm = convert_utf8_to_gsm(text, len, NULL, &written, 0);
-	if (gsm == NULL && len > 0)
-		return FALSE;
-
-	if (iter->len + written >= iter->max_len) {
-		g_free(gsm);
+	if (convert_utf8_to_gsm_own_buf(text, -1, NULL, &written, 0,
+					iter->value + iter->len,
+					iter->max_len - iter->len) == NULL)
 		return FALSE;
-	}
 
-	iter->value[iter->len++] = 0x04;
-	memcpy(iter->value + iter->len, gsm, written);
 	iter->len += written;
 
-	g_free(gsm);
-
 	return TRUE;
 }
 
 static gboolean stk_tlv_builder_append_ucs2(struct stk_tlv_builder *iter,
 						const char *text)
 {
-	unsigned char *ucs2;
-	gsize gwritten;
-
-	ucs2 = (unsigned char *) g_convert((const gchar *) text, -1,
-						"UCS-2BE", "UTF-8//TRANSLIT",
-						NULL, &gwritten, NULL);
-	if (ucs2 == NULL)
-		return FALSE;
+	long written = 0;
 
-	if (iter->len + gwritten >= iter->max_len) {
-		g_free(ucs2);
+	if (convert_utf8_to_ucs2_own_buf(text, -1, &written,
+					iter->value + iter->len,
+					iter->max_len - iter->len) == NULL)
 		return FALSE;
-	}
-
-	iter->value[iter->len++] = 0x08;
-
-	memcpy(iter->value + iter->len, ucs2, gwritten);
-	iter->len += gwritten;
 
-	g_free(ucs2);
+	iter->len += written;
 
 	return TRUE;
 }
@@ -4129,27 +4135,56 @@ static gboolean stk_tlv_builder_append_ucs2(struct stk_tlv_builder *iter,
 static gboolean stk_tlv_builder_append_text(struct stk_tlv_builder *iter,
 						int dcs, const char *text)
 {
-	gboolean ret;
+	unsigned int len = iter->len;
 
 	switch (dcs) {
 	case 0x00:
 		return stk_tlv_builder_append_gsm_packed(iter, text);
 	case 0x04:
-		return stk_tlv_builder_append_gsm_unpacked(iter, text);
+		if (text == NULL)
+			return TRUE;
+
+		return stk_tlv_builder_append_byte(iter, 0x04) &&
+			stk_tlv_builder_append_gsm(iter, text);
 	case 0x08:
-		return stk_tlv_builder_append_ucs2(iter, text);
+		if (text == NULL)
+			return FALSE;
+
+		return stk_tlv_builder_append_byte(iter, 0x08) &&
+			stk_tlv_builder_append_ucs2(iter, text);
 	case -1:
-		ret = stk_tlv_builder_append_gsm_unpacked(iter, text);
+		if (text == NULL)
+			return TRUE;
+
+		if (stk_tlv_builder_append_byte(iter, 0x04) &&
+				stk_tlv_builder_append_gsm(iter, text))
+			return TRUE;
 
-		if (ret == TRUE)
-			return ret;
+		iter->len = len;
 
-		return stk_tlv_builder_append_ucs2(iter, text);
+		return stk_tlv_builder_append_byte(iter, 0x08) &&
+			stk_tlv_builder_append_ucs2(iter, text);
 	}
 
 	return FALSE;
 }
 
+/* Encodes the text as a SIM string, as in TS 102.221 Annex A */
+static gboolean stk_tlv_builder_append_sim_string(struct stk_tlv_builder *iter,
+							const char *text)
+{
+	unsigned int len = iter->len;
+
+	if (stk_tlv_builder_append_gsm(iter, text))
+		return TRUE;
+
+	iter->len = len;
+
+	/* NOTE: UCS2 formats with an offset are never used */
+	return stk_tlv_builder_append_byte(iter, 0x80) &&
+		stk_tlv_builder_append_ucs2(iter, text);
+}
+
 static inline gboolean stk_tlv_builder_append_bytes(struct stk_tlv_builder *iter,
 						const unsigned char *data,
 						unsigned int length)
@@ -4189,8 +4224,6 @@ static gboolean build_dataobj_alpha_id(struct stk_tlv_builder *tlv,
 					const void *data, gboolean cr)
 {
 	unsigned char tag = STK_DATA_OBJECT_TYPE_ALPHA_ID;
-	int len;
-	unsigned char *string;
 
 	if (data == NULL)
 		return TRUE;
@@ -4199,12 +4232,8 @@ static gboolean build_dataobj_alpha_id(struct stk_tlv_builder *tlv,
 		return stk_tlv_builder_open_container(tlv, cr, tag, FALSE) &&
 			stk_tlv_builder_close_container(tlv);
 
-	string = utf8_to_sim_string(data, -1, &len);
-	if (string == NULL)
-		return FALSE;
-
 	return stk_tlv_builder_open_container(tlv, cr, tag, TRUE) &&
-		stk_tlv_builder_append_bytes(tlv, string, len) &&
+		stk_tlv_builder_append_sim_string(tlv, data) &&
 		stk_tlv_builder_close_container(tlv);
 }
 
@@ -5324,29 +5353,28 @@ static gboolean build_dataobj_registry_application_data(
 {
 	const struct stk_registry_application_data *rad = data;
 	unsigned char tag = STK_DATA_OBJECT_TYPE_REGISTRY_APPLICATION_DATA;
-	guint8 dcs, *name;
-	gsize len;
-	long gsmlen;
-
-	name = convert_utf8_to_gsm(rad->name, -1, NULL, &gsmlen, 0);
-	len = gsmlen;
-	dcs = 0x04;
-	if (name == NULL) {
-		name = (guint8 *) g_convert((const gchar *) rad->name, -1,
-						"UCS-2BE", "UTF-8//TRANSLIT",
-						NULL, &len, NULL);
-		dcs = 0x08;
-
-		if (name == NULL)
+	unsigned int len;
+
+	if (stk_tlv_builder_open_container(tlv, cr, tag, TRUE) != TRUE)
+		return FALSE;
+
+	if (stk_tlv_builder_append_short(tlv, rad->port) != TRUE)
+		return FALSE;
+
+	len = tlv->len;
+
+	if (stk_tlv_builder_append_byte(tlv, 0x04) != TRUE ||
+			stk_tlv_builder_append_byte(tlv, rad->type) != TRUE ||
+			stk_tlv_builder_append_gsm(tlv, rad->name) != TRUE) {
+		tlv->len = len;
+
+		if (stk_tlv_builder_append_byte(tlv, 0x08) != TRUE ||
+			stk_tlv_builder_append_byte(tlv, rad->type) != TRUE ||
+			stk_tlv_builder_append_ucs2(tlv, rad->name) != TRUE)
 			return FALSE;
 	}
 
-	return stk_tlv_builder_open_container(tlv, cr, tag, TRUE) &&
-		stk_tlv_builder_append_short(tlv, rad->port) &&
-		stk_tlv_builder_append_byte(tlv, dcs) &&
-		stk_tlv_builder_append_byte(tlv, rad->type) &&
-		stk_tlv_builder_append_bytes(tlv, name, len) &&
-		stk_tlv_builder_close_container(tlv);
+	return stk_tlv_builder_close_container(tlv);
 }
 
 /* Described in TS 102.223 Section 8.90 */
@@ -5687,15 +5715,22 @@ static gboolean build_send_data(struct stk_tlv_builder *builder,
 				NULL);
 }
 
-const unsigned char *stk_pdu_from_response(const struct stk_response *response,
-						unsigned int *out_length)
+/*
+ * Encodes the Terminal Response into the caller supplied buffer, no memory
+ * is allocated.  Returns a pointer to the start of the encoded data inside
+ * buf or NULL if the response could not be encoded or does not fit.
+ */
+const unsigned char *stk_pdu_from_response_own_buf(
+					const struct stk_response *response,
+					unsigned int *out_length,
+					unsigned char *pdu, unsigned int size)
 {
 	struct stk_tlv_builder builder;
 	gboolean ok = TRUE;
 	unsigned char tag;
-	static unsigned char pdu[512];
 
-	stk_tlv_builder_init(&builder, pdu, sizeof(pdu));
+	if (stk_tlv_builder_init(&builder, pdu, size) != TRUE)
+		return NULL;
 
 	/*
 	 * Encode command details, they come in order with
@@ -5853,6 +5888,15 @@ const unsigned char *stk_pdu_from_response(const struct stk_response *response,
 	return pdu;
 }
 
+const unsigned char *stk_pdu_from_response(const struct stk_response *response,
+						unsigned int *out_length)
+{
+	static unsigned char pdu[512];
+
+	return stk_pdu_from_response_own_buf(response, out_length,
+						pdu, sizeof(pdu));
+}
+
 /* Described in TS 102.223 Section 8.7 */
 static gboolean build_envelope_dataobj_device_ids(struct stk_tlv_builder *tlv,
 						const void *data, gboolean cr)
@@ -6101,16 +6145,22 @@ static gboolean build_envelope_terminal_apps(struct stk_tlv_builder *builder,
 				0, &ta->last, NULL);
 }
 
-const unsigned char *stk_pdu_from_envelope(const struct stk_envelope *envelope,
-						unsigned int *out_length)
+/*
+ * Encodes the Envelope into the caller supplied buffer, no memory is
+ * allocated.  Returns a pointer to the start of the encoded data, which
+ * is not necessarily the start of buf, or NULL on failure.
+ */
+const unsigned char *stk_pdu_from_envelope_own_buf(
+					const struct stk_envelope *envelope,
+					unsigned int *out_length,
+					unsigned char *buf, unsigned int size)
 {
 	struct ber_tlv_builder btlv;
 	struct stk_tlv_builder builder;
 	gboolean ok = TRUE;
-	static unsigned char buffer[512];
 	unsigned char *pdu;
 
-	if (ber_tlv_builder_init(&btlv, buffer, sizeof(buffer)) != TRUE)
+	if (ber_tlv_builder_init(&btlv, buf, size) != TRUE)
 		return NULL;
 
 	if (stk_tlv_builder_recurse(&builder, &btlv, envelope->type) != TRUE)
@@ -6235,6 +6285,15 @@ const unsigned char *stk_pdu_from_envelope(const struct stk_envelope *envelope,
 	return pdu;
 }
 
+const unsigned char *stk_pdu_from_envelope(const struct stk_envelope *envelope,
+						unsigned int *out_length)
+{
+	static unsigned char buffer[512];
+
+	return stk_pdu_from_envelope_own_buf(envelope, out_length,
+						buffer, sizeof(buffer));
+}
+
 static const char *html_colors[] = {
 	"#000000", /* Black */
 	"#808080", /* Dark Grey */
@@ -1779,6 +1779,14 @@ const unsigned char *stk_pdu_from_response(const struct stk_response *response,
 						unsigned int *out_length);
 const unsigned char *stk_pdu_from_envelope(const struct stk_envelope *envelope,
 						unsigned int *out_length);
+const unsigned char *stk_pdu_from_response_own_buf(
+					const struct stk_response *response,
+					unsigned int *out_length,
+					unsigned char *pdu, unsigned int size);
+const unsigned char *stk_pdu_from_envelope_own_buf(
+					const struct stk_envelope *envelope,
+					unsigned int *out_length,
+					unsigned char *buf, unsigned int size);
 char *stk_text_to_html(const char *text,
 				const unsigned short *attrs, int num_attrs);
 char *stk_image_to_xpm(const unsigned char *img, unsigned int len,
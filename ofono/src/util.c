@@ -623,7 +623,7 @@ char *convert_gsm_to_utf8_with_lang(const unsigned char *text, long len,
 
 		if (text[i] == 0x1b) {
 			++i;
-			if (i >= len)
+			if (i >= len || text[i] > 0x7f)
 				goto error;
 
 			c = gsm_single_shift_lookup(&t, text[i]);
@@ -694,21 +694,12 @@ char *convert_gsm_to_utf8(const unsigned char *text, long len,
 						GSM_DIALECT_DEFAULT);
 }
 
-/*!
- * Converts UTF-8 encoded text to GSM alphabet.  The result is unpacked,
- * with the 7th bit always 0.  If terminator is not 0, a terminator character
- * is appended to the result.  This should be in the range 0x80-0xf0
- *
- * Returns the encoded data or NULL if the data could not be encoded.  The
- * data must be freed by the caller.  If items_read is not NULL, it contains
- * the actual number of bytes read.  If items_written is not NULL, contains
- * the number of bytes written.
- */
-unsigned char *convert_utf8_to_gsm_with_lang(const char *text, long len,
+static unsigned char *utf8_to_gsm(const char *text, long len,
 					long *items_read, long *items_written,
 					unsigned char terminator,
 					enum gsm_dialect locking_lang,
-					enum gsm_dialect single_lang)
+					enum gsm_dialect single_lang,
+					unsigned char *buf, long buf_len)
 {
 	struct conversion_table t;
 	long nchars = 0;
@@ -752,7 +743,11 @@ unsigned char *convert_utf8_to_gsm_with_lang(const char *text, long len,
 		nchars += 1;
 	}
 
-	res = g_try_malloc(res_len + (terminator ? 1 : 0));
+	if (buf == NULL)
+		res = g_try_malloc(res_len + (terminator ? 1 : 0));
+	else if (res_len + (terminator ? 1 : 0) <= buf_len)
+		res = buf;
+
 	if (res == NULL)
 		goto err_out;
 
@@ -792,6 +787,26 @@ err_out:
 	return res;
 }
 
+/*!
+ * Converts UTF-8 encoded text to GSM alphabet.  The result is unpacked,
+ * with the 7th bit always 0.  If terminator is not 0, a terminator character
+ * is appended to the result.  This should be in the range 0x80-0xf0
+ *
+ * Returns the encoded data or NULL if the data could not be encoded.  The
+ * data must be freed by the caller.  If items_read is not NULL, it contains
+ * the actual number of bytes read.  If items_written is not NULL, contains
+ * the number of bytes written.
+ */
+unsigned char *convert_utf8_to_gsm_with_lang(const char *text, long len,
+					long *items_read, long *items_written,
+					unsigned char terminator,
+					enum gsm_dialect locking_lang,
+					enum gsm_dialect single_lang)
+{
+	return utf8_to_gsm(text, len, items_read, items_written, terminator,
+				locking_lang, single_lang, NULL, 0);
+}
+
 unsigned char *convert_utf8_to_gsm(const char *text, long len,
 					long *items_read, long *items_written,
 					unsigned char terminator)
@@ -803,6 +818,64 @@ unsigned char *convert_utf8_to_gsm(const char *text, long len,
 						GSM_DIALECT_DEFAULT);
 }
 
+/*!
+ * Same as convert_utf8_to_gsm, except the result is written to a caller
+ * supplied buffer of buf_len bytes.  Returns NULL if the text could not be
+ * encoded or if the result, including the optional terminator, does not
+ * fit into the buffer.
+ */
+unsigned char *convert_utf8_to_gsm_own_buf(const char *text, long len,
+					long *items_read, long *items_written,
+					unsigned char terminator,
+					unsigned char *buf, long buf_len)
+{
+	return utf8_to_gsm(text, len, items_read, items_written, terminator,
+				GSM_DIALECT_DEFAULT, GSM_DIALECT_DEFAULT,
+				buf, buf_len);
+}
+
+/*!
+ * Converts UTF-8 encoded text to big-endian UCS-2, writing the result to
+ * a caller supplied buffer of buf_len bytes.  Conversion stops at len bytes
+ * or at the first NUL character if len is negative.
+ *
+ * Returns NULL if the text is not valid UTF-8, contains characters outside
+ * of the Basic Multilingual Plane or does not fit into the buffer.  If
+ * items_written is not NULL, it contains the number of bytes written.
+ */
+unsigned char *convert_utf8_to_ucs2_own_buf(const char *text, long len,
+						long *items_written,
+						unsigned char *buf,
+						long buf_len)
+{
+	const char *in = text;
+	unsigned char *out = buf;
+
+	while ((len < 0 || text + len - in > 0) && *in) {
+		long max = len < 0 ? 6 : text + len - in;
+		gunichar c = g_utf8_get_char_validated(in, max);
+
+		if (c & 0x80000000)
+			return NULL;
+
+		if (c > 0xffff)
+			return NULL;
+
+		if (out + 2 > buf + buf_len)
+			return NULL;
+
+		*out++ = c >> 8;
+		*out++ = c & 0xff;
+
+		in = g_utf8_next_char(in);
+	}
+
+	if (items_written)
+		*items_written = out - buf;
+
+	return buf;
+}
+
 /*!
  * Converts UTF-8 encoded text to GSM alphabet. It finds an encoding
  * that uses the minimum set of GSM dialects based on the hint given.
@@ -44,6 +44,16 @@ unsigned char *convert_utf8_to_gsm_with_lang(const char *text, long len,
 					enum gsm_dialect locking_shift_lang,
 					enum gsm_dialect single_shift_lang);
 
+unsigned char *convert_utf8_to_gsm_own_buf(const char *text, long len,
+					long *items_read, long *items_written,
+					unsigned char terminator,
+					unsigned char *buf, long buf_len);
+
+unsigned char *convert_utf8_to_ucs2_own_buf(const char *text, long len,
+						long *items_written,
+						unsigned char *buf,
+						long buf_len);
+
 unsigned char *convert_utf8_to_gsm_best_lang(const char *utf8, long len,
 					long *items_read, long *items_written,
 					unsigned char terminator,
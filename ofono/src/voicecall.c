@@ -51,6 +51,7 @@ GSList *g_drivers = NULL;
 
 struct ofono_voicecall {
 	GSList *call_list;
+	GHashTable *call_table; /* call id to struct voicecall */
 	GSList *release_list;
 	GSList *multiparty_list;
 	GHashTable *en_list; /* emergency number list */
@@ -154,6 +155,26 @@ static gint call_compare(gconstpointer a, gconstpointer b)
 	return 0;
 }
 
+static struct voicecall *voicecall_lookup(struct ofono_voicecall *vc,
+						unsigned int id)
+{
+	return g_hash_table_lookup(vc->call_table, GUINT_TO_POINTER(id));
+}
+
+static void voicecall_list_add(struct ofono_voicecall *vc,
+				struct voicecall *v)
+{
+	vc->call_list = g_slist_insert_sorted(vc->call_list, v, call_compare);
+	g_hash_table_insert(vc->call_table, GUINT_TO_POINTER(v->call->id), v);
+}
+
+static void voicecall_list_remove(struct ofono_voicecall *vc,
+					struct voicecall *v)
+{
+	vc->call_list = g_slist_remove(vc->call_list, v);
+	g_hash_table_remove(vc->call_table, GUINT_TO_POINTER(v->call->id));
+}
+
 static void add_to_en_list(struct ofono_voicecall *vc, char **list)
 {
 	int i = 0;
@@ -1456,8 +1477,7 @@ static struct voicecall *dial_handle_result(struct ofono_voicecall *vc,
 	DBG("Registering new call: %d", call->id);
 	voicecall_dbus_register(v);
 
-	vc->call_list = g_slist_insert_sorted(vc->call_list, v,
-				call_compare);
+	voicecall_list_add(vc, v);
 
 	*need_to_emit = TRUE;
 
@@ -2201,17 +2221,13 @@ void ofono_voicecall_disconnected(struct ofono_voicecall *vc, int id,
 
 	__ofono_modem_callid_release(modem, id);
 
-	l = g_slist_find_custom(vc->call_list, GUINT_TO_POINTER(id),
-				call_compare_by_id);
-
-	if (l == NULL) {
+	call = voicecall_lookup(vc, id);
+	if (call == NULL) {
 		ofono_error("Plugin notified us of call disconnect for"
 				" unknown call");
 		return;
 	}
 
-	call = l->data;
-
 	ts = time(NULL);
 	prev_status = call->call->status;
 
@@ -2253,41 +2269,32 @@ void ofono_voicecall_disconnected(struct ofono_voicecall *vc, int id,
 
 	voicecalls_emit_call_removed(vc, call);
 
+	voicecall_list_remove(vc, call);
+
 	voicecall_dbus_unregister(vc, call);
+}
 
-	vc->call_list = g_slist_remove(vc->call_list, call);
+static void voicecall_update(struct voicecall *v,
+				const struct ofono_call *call)
+{
+	/* Nothing changed, spare the property setters the comparisons */
+	if (!memcmp(v->call, call, sizeof(*call)))
+		return;
+
+	voicecall_set_call_status(v, call->status);
+	voicecall_set_call_lineid(v, &call->phone_number,
+					call->clip_validity);
+	voicecall_set_call_calledid(v, &call->called_number);
+	voicecall_set_call_name(v, call->name, call->cnap_validity);
 }
 
-void ofono_voicecall_notify(struct ofono_voicecall *vc,
+static void voicecall_add(struct ofono_voicecall *vc,
 				const struct ofono_call *call)
 {
 	struct ofono_modem *modem = __ofono_atom_get_modem(vc->atom);
-	GSList *l;
 	struct voicecall *v = NULL;
 	struct ofono_call *newcall;
 
-	DBG("Got a voicecall event, status: %d, id: %u, number: %s"
-			" called_number: %s, called_name %s", call->status,
-			call->id, call->phone_number.number,
-			call->called_number.number, call->name);
-
-	l = g_slist_find_custom(vc->call_list, GUINT_TO_POINTER(call->id),
-				call_compare_by_id);
-
-	if (l) {
-		DBG("Found call with id: %d", call->id);
-		voicecall_set_call_status(l->data, call->status);
-		voicecall_set_call_lineid(l->data, &call->phone_number,
-						call->clip_validity);
-		voicecall_set_call_calledid(l->data, &call->called_number);
-		voicecall_set_call_name(l->data, call->name,
-						call->cnap_validity);
-
-		return;
-	}
-
-	DBG("Did not find a call with id: %d", call->id);
-
 	__ofono_modem_callid_hold(modem, call->id);
 
 	newcall = g_memdup(call, sizeof(struct ofono_call));
@@ -2341,7 +2348,7 @@ void ofono_voicecall_notify(struct ofono_voicecall *vc,
 		goto error;
 	}
 
-	vc->call_list = g_slist_insert_sorted(vc->call_list, v, call_compare);
+	voicecall_list_add(vc, v);
 
 	voicecalls_emit_call_added(vc, v);
 
@@ -2355,6 +2362,46 @@ error:
 		g_free(v);
 }
 
+void ofono_voicecall_notify(struct ofono_voicecall *vc,
+				const struct ofono_call *call)
+{
+	struct voicecall *v;
+
+	DBG("Got a voicecall event, status: %d, id: %u, number: %s"
+			" called_number: %s, called_name %s", call->status,
+			call->id, call->phone_number.number,
+			call->called_number.number, call->name);
+
+	v = voicecall_lookup(vc, call->id);
+	if (v == NULL) {
+		DBG("Did not find a call with id: %d", call->id);
+		voicecall_add(vc, call);
+		return;
+	}
+
+	DBG("Found call with id: %d", call->id);
+	voicecall_update(v, call);
+}
+
+void ofono_voicecall_notify_list(struct ofono_voicecall *vc,
+					const struct ofono_call *calls,
+					unsigned int num_calls)
+{
+	struct voicecall *v;
+	unsigned int i;
+
+	DBG("%u calls", num_calls);
+
+	for (i = 0; i < num_calls; i++) {
+		v = voicecall_lookup(vc, calls[i].id);
+
+		if (v == NULL)
+			voicecall_add(vc, &calls[i]);
+		else
+			voicecall_update(v, &calls[i]);
+	}
+}
+
 static void send_ciev_after_swap_callback(const struct ofono_error *error,
 								void *data)
 {
@@ -2729,6 +2776,8 @@ static void voicecall_unregister(struct ofono_atom *atom)
 	if (vc->dial_req)
 		dial_request_finish(vc);
 
+	g_hash_table_remove_all(vc->call_table);
+
 	for (l = vc->call_list; l; l = l->next)
 		voicecall_dbus_unregister(vc, l->data);
 
@@ -2766,6 +2815,8 @@ static void voicecall_remove(struct ofono_atom *atom)
 		g_queue_free(vc->toneq);
 	}
 
+	g_hash_table_destroy(vc->call_table);
+
 	g_free(vc);
 }
 
@@ -2786,6 +2837,7 @@ struct ofono_voicecall *ofono_voicecall_create(struct ofono_modem *modem,
 		return NULL;
 
 	vc->toneq = g_queue_new();
+	vc->call_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 	vc->atom = __ofono_modem_add_atom(modem, OFONO_ATOM_TYPE_VOICECALL,
 						voicecall_remove, vc);
@@ -3905,16 +3957,8 @@ static void ssn_mt_forwarded_notify(struct ofono_voicecall *vc,
 static struct voicecall *voicecall_select(struct ofono_voicecall *vc,
 						unsigned int id)
 {
-	if (id != 0) {
-		GSList *l = g_slist_find_custom(vc->call_list,
-						GUINT_TO_POINTER(id),
-						call_compare_by_id);
-
-		if (l == NULL)
-			return NULL;
-
-		return l->data;
-	}
+	if (id != 0)
+		return voicecall_lookup(vc, id);
 
 	if (g_slist_length(vc->call_list) == 1)
 		return vc->call_list->data;
@@ -0,0 +1,309 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gdbus.h>
+
+#include "ofono.h"
+
+/*
+ * Measures the atom lookup and atom watch paths of src/modem.c on a modem
+ * with every atom type registered and many plugins watching all of them.
+ * The D-Bus and the parts of the core not used by atoms are stubbed out.
+ */
+
+#define GPRS_CONTEXTS 8
+
+static unsigned int watchers = 64;
+static unsigned int iterations = 1000000;
+static unsigned long notifications;
+
+void ofono_debug(const char *format, ...)
+{
+}
+
+void ofono_error(const char *format, ...)
+{
+}
+
+void __ofono_exit(void)
+{
+}
+
+void __ofono_history_probe_drivers(struct ofono_modem *modem)
+{
+}
+
+void __ofono_nettime_probe_drivers(struct ofono_modem *modem)
+{
+}
+
+gboolean __ofono_plugin_init_deferred(const char *driver)
+{
+	return FALSE;
+}
+
+unsigned int ofono_sim_add_state_watch(struct ofono_sim *sim,
+					ofono_sim_state_event_cb_t cb,
+					void *data, ofono_destroy_func destroy)
+{
+	return 0;
+}
+
+ofono_bool_t ofono_emulator_add_handler(struct ofono_emulator *em,
+					const char *prefix,
+					ofono_emulator_request_cb_t cb,
+					void *data, ofono_destroy_func destroy)
+{
+	return TRUE;
+}
+
+enum ofono_emulator_request_type ofono_emulator_request_get_type(
+					struct ofono_emulator_request *req)
+{
+	return OFONO_EMULATOR_REQUEST_TYPE_COMMAND_ONLY;
+}
+
+void ofono_emulator_send_final(struct ofono_emulator *em,
+				const struct ofono_error *final)
+{
+}
+
+void ofono_emulator_send_info(struct ofono_emulator *em, const char *line,
+				ofono_bool_t last)
+{
+}
+
+gboolean g_dbus_register_interface(DBusConnection *connection,
+					const char *path, const char *name,
+					const GDBusMethodTable *methods,
+					const GDBusSignalTable *signals,
+					const GDBusPropertyTable *properties,
+					void *user_data,
+					GDBusDestroyFunction destroy)
+{
+	return TRUE;
+}
+
+gboolean g_dbus_unregister_interface(DBusConnection *connection,
+					const char *path, const char *name)
+{
+	return TRUE;
+}
+
+gboolean g_dbus_emit_signal(DBusConnection *connection,
+				const char *path, const char *interface,
+				const char *name, int type, ...)
+{
+	return TRUE;
+}
+
+gboolean g_dbus_send_message(DBusConnection *connection, DBusMessage *message)
+{
+	dbus_message_unref(message);
+
+	return TRUE;
+}
+
+gboolean g_dbus_send_reply(DBusConnection *connection,
+				DBusMessage *message, int type, ...)
+{
+	return TRUE;
+}
+
+DBusMessage *g_dbus_create_error(DBusMessage *message, const char *name,
+					const char *format, ...)
+{
+	return NULL;
+}
+
+guint g_dbus_add_disconnect_watch(DBusConnection *connection,
+				const char *name,
+				GDBusWatchFunction function,
+				void *user_data, GDBusDestroyFunction destroy)
+{
+	return 0;
+}
+
+gboolean g_dbus_remove_watch(DBusConnection *connection, guint tag)
+{
+	return TRUE;
+}
+
+void g_dbus_set_flush_function(GDBusFlushFunction function)
+{
+}
+
+static int bench_probe(struct ofono_modem *modem)
+{
+	return 0;
+}
+
+static struct ofono_modem_driver bench_driver = {
+	.name		= "bench",
+	.probe		= bench_probe,
+};
+
+static void atom_unregister(struct ofono_atom *atom)
+{
+}
+
+static void atom_watch(struct ofono_atom *atom,
+			enum ofono_atom_watch_condition cond, void *data)
+{
+	notifications++;
+}
+
+static void report(const char *name, GTimer *timer, unsigned long ops)
+{
+	double elapsed = g_timer_elapsed(timer, NULL);
+
+	printf("%-24s %10lu ops %8.1f ns/op\n", name, ops,
+						elapsed * 1e9 / ops);
+}
+
+static void bench_find(struct ofono_modem *modem)
+{
+	GTimer *timer = g_timer_new();
+	unsigned long found = 0;
+	unsigned int i;
+	int type;
+
+	for (i = 0; i < iterations; i++)
+		for (type = 0; type < OFONO_ATOM_TYPE_COUNT; type++)
+			if (__ofono_modem_find_atom(modem, type))
+				found++;
+
+	g_timer_stop(timer);
+	report("find_atom", timer, (unsigned long) iterations *
+						OFONO_ATOM_TYPE_COUNT);
+	g_timer_destroy(timer);
+
+	if (found == 0)
+		fprintf(stderr, "No atoms found\n");
+}
+
+static void bench_register(struct ofono_atom **atoms, int count)
+{
+	GTimer *timer = g_timer_new();
+	unsigned int rounds = iterations / 100 ? iterations / 100 : 1;
+	unsigned int i;
+	int n;
+
+	notifications = 0;
+
+	for (i = 0; i < rounds; i++) {
+		for (n = 0; n < count; n++)
+			__ofono_atom_unregister(atoms[n]);
+
+		for (n = 0; n < count; n++)
+			__ofono_atom_register(atoms[n], atom_unregister);
+	}
+
+	g_timer_stop(timer);
+	report("register/unregister", timer, (unsigned long) rounds *
+								count * 2);
+	g_timer_destroy(timer);
+
+	printf("%-24s %10lu\n", "notifications", notifications);
+}
+
+static void bench_watch(struct ofono_modem *modem)
+{
+	GTimer *timer = g_timer_new();
+	unsigned int rounds = iterations / 100 ? iterations / 100 : 1;
+	unsigned int i;
+	unsigned int id;
+
+	for (i = 0; i < rounds; i++) {
+		id = __ofono_modem_add_atom_watch(modem,
+						i % OFONO_ATOM_TYPE_COUNT,
+						atom_watch, NULL, NULL);
+		__ofono_modem_remove_atom_watch(modem, id);
+	}
+
+	g_timer_stop(timer);
+	report("add/remove watch", timer, (unsigned long) rounds * 2);
+	g_timer_destroy(timer);
+}
+
+int main(int argc, char **argv)
+{
+	struct ofono_atom *atoms[OFONO_ATOM_TYPE_COUNT + GPRS_CONTEXTS];
+	struct ofono_modem *modem;
+	unsigned int i;
+	int count = 0;
+	int type;
+
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 0);
+
+	if (argc > 2)
+		watchers = strtoul(argv[2], NULL, 0);
+
+	__ofono_modemwatch_init();
+	ofono_modem_driver_register(&bench_driver);
+
+	modem = ofono_modem_create("bench", "bench");
+	if (modem == NULL || ofono_modem_register(modem) < 0) {
+		fprintf(stderr, "Unable to create modem\n");
+		return EXIT_FAILURE;
+	}
+
+	for (type = 0; type < OFONO_ATOM_TYPE_COUNT; type++)
+		atoms[count++] = __ofono_modem_add_atom(modem, type,
+								NULL, NULL);
+
+	for (i = 0; i < GPRS_CONTEXTS; i++)
+		atoms[count++] = __ofono_modem_add_atom(modem,
+					OFONO_ATOM_TYPE_GPRS_CONTEXT,
+					NULL, NULL);
+
+	for (i = 0; i < watchers; i++)
+		for (type = 0; type < OFONO_ATOM_TYPE_COUNT; type++)
+			__ofono_modem_add_atom_watch(modem, type, atom_watch,
+							NULL, NULL);
+
+	for (i = 0; i < (unsigned int) count; i++)
+		__ofono_atom_register(atoms[i], atom_unregister);
+
+	printf("%d atoms, %u watches per atom type\n", count, watchers);
+
+	bench_find(modem);
+	bench_register(atoms, count);
+	bench_watch(modem);
+
+	for (i = 0; i < (unsigned int) count; i++)
+		__ofono_atom_free(atoms[i]);
+
+	ofono_modem_remove(modem);
+	ofono_modem_driver_unregister(&bench_driver);
+	__ofono_modemwatch_cleanup();
+
+	return EXIT_SUCCESS;
+}
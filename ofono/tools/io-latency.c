@@ -0,0 +1,590 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/eventfd.h>
+
+#include <glib.h>
+
+#include "ringbuffer.h"
+#include "spscqueue.h"
+#include "gatio.h"
+
+/*
+ * Measures how long URCs take from the modem to the main loop while the
+ * main loop is blocked from time to time, as it is by a slow D-Bus client
+ * or a storage sync.  A child process plays the modem and writes lines
+ * stamped with the monotonic clock.  Each line is timed up to the point
+ * it was split off the stream and up to its handling on the main loop.
+ *
+ * The main loop mode reads the channel through GAtIO, as ofonod does.
+ * The I/O thread mode is a prototype that ofonod does not use: a thread
+ * reads the channel, splits it into lines and hands them to the main
+ * loop through a single-producer single-consumer queue.
+ */
+
+#define BUCKETS 24
+#define MAX_LINE 64
+
+enum mode {
+	MODE_MAIN_LOOP,
+	MODE_THREAD,
+	MODE_LAST,
+};
+
+static const char *mode_names[] = { "main loop", "I/O thread" };
+
+struct line {
+	gint64 time;				/* When the line was split off */
+	gsize len;
+	char data[MAX_LINE];
+};
+
+struct reader {
+	GThread *thread;
+	int fd;					/* Channel fd */
+	int notify_fd;				/* Thread to main loop */
+	guint notify_watch;			/* Main loop watch */
+	struct spsc_queue *lines;
+	gint notified;				/* notify_fd is pending */
+	gint eof;				/* Thread is done reading */
+};
+
+struct run {
+	GAtIO *io;
+	struct reader *reader;
+	unsigned int lines;
+	gint64 *read_latency;
+	gint64 *dispatch_latency;
+	unsigned int read_hist[BUCKETS];
+	unsigned int dispatch_hist[BUCKETS];
+	gboolean done;
+};
+
+static GMainLoop *main_loop;
+
+static gint option_count = 2000;
+static gint option_interval = 1000;
+static gint option_stall = 50;
+static gint option_period = 200;
+static gboolean option_version = FALSE;
+
+static unsigned int bucket(gint64 usec)
+{
+	unsigned int i = 0;
+
+	while (usec > 1 && i < BUCKETS - 1) {
+		usec >>= 1;
+		i++;
+	}
+
+	return i;
+}
+
+static void have_line(struct run *run, const char *line, gsize len,
+							gint64 read_time)
+{
+	gint64 now = g_get_monotonic_time();
+	gint64 stamp;
+	gint64 delay;
+
+	if (len == 4 && memcmp(line, "DONE", 4) == 0) {
+		run->done = TRUE;
+		g_main_loop_quit(main_loop);
+		return;
+	}
+
+	if (len < 8 || memcmp(line, "+TICK: ", 7) != 0)
+		return;
+
+	if (run->lines == (unsigned int) option_count)
+		return;
+
+	stamp = g_ascii_strtoll(line + 7, NULL, 10);
+
+	delay = MAX(read_time - stamp, 0);
+	run->read_latency[run->lines] = delay;
+	run->read_hist[bucket(delay)] += 1;
+
+	delay = MAX(now - stamp, 0);
+	run->dispatch_latency[run->lines] = delay;
+	run->dispatch_hist[bucket(delay)] += 1;
+
+	run->lines += 1;
+}
+
+static void read_lines(struct ring_buffer *rbuf, gpointer user_data)
+{
+	struct run *run = user_data;
+	const char *data = (const char *) ring_buffer_read_ptr(rbuf, 0);
+	int len = ring_buffer_len(rbuf);
+	gint64 now = g_get_monotonic_time();
+	int start = 0;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (data[i] != '\n')
+			continue;
+
+		if (i - start > 1)
+			have_line(run, data + start, i - start - 1, now);
+
+		start = i + 1;
+	}
+
+	g_at_io_drain_ring_buffer(run->io, start);
+}
+
+static void disconnect(gpointer user_data)
+{
+	g_main_loop_quit(main_loop);
+}
+
+#ifdef NEED_THREADS
+static void notify_main_loop(struct reader *r)
+{
+	/* One wakeup covers all lines queued until the main loop runs */
+	if (g_atomic_int_compare_and_exchange(&r->notified, 0, 1))
+		eventfd_write(r->notify_fd, 1);
+}
+
+static gpointer reader_run(gpointer user_data)
+{
+	struct reader *r = user_data;
+	char buf[4096];
+	struct line *line = NULL;
+	ssize_t rbytes;
+	gint64 now;
+	ssize_t i;
+
+	while ((rbytes = read(r->fd, buf, sizeof(buf))) > 0) {
+		now = g_get_monotonic_time();
+
+		for (i = 0; i < rbytes; i++) {
+			if (line == NULL)
+				line = g_new0(struct line, 1);
+
+			if (buf[i] != '\n') {
+				if (line->len < MAX_LINE)
+					line->data[line->len++] = buf[i];
+
+				continue;
+			}
+
+			/* Drop the \r, skip the empty line before each URC */
+			if (line->len < 2) {
+				line->len = 0;
+				continue;
+			}
+
+			line->len -= 1;
+			line->time = now;
+
+			/* The queue holds every line the modem sends */
+			spsc_queue_push(r->lines, line);
+			line = NULL;
+		}
+
+		notify_main_loop(r);
+	}
+
+	g_free(line);
+
+	g_atomic_int_set(&r->eof, 1);
+	notify_main_loop(r);
+
+	return NULL;
+}
+
+static gboolean received_lines(GIOChannel *channel, GIOCondition cond,
+				gpointer user_data)
+{
+	struct run *run = user_data;
+	struct reader *r = run->reader;
+	struct line *line;
+	eventfd_t value;
+	gboolean eof;
+
+	if (cond & (G_IO_NVAL | G_IO_HUP | G_IO_ERR)) {
+		r->notify_watch = 0;
+		return FALSE;
+	}
+
+	eventfd_read(r->notify_fd, &value);
+	g_atomic_int_set(&r->notified, 0);
+
+	/* All lines split off before the thread stopped are queued by now */
+	eof = g_atomic_int_get(&r->eof);
+
+	while ((line = spsc_queue_pop(r->lines))) {
+		have_line(run, line->data, line->len, line->time);
+		g_free(line);
+	}
+
+	if (eof)
+		g_main_loop_quit(main_loop);
+
+	return TRUE;
+}
+
+static void reader_start(struct run *run, int fd)
+{
+	struct reader *r = g_new0(struct reader, 1);
+	GIOChannel *notify;
+
+	r->fd = fd;
+	r->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	r->lines = spsc_queue_new(option_count + 1);
+
+	if (r->notify_fd < 0 || r->lines == NULL) {
+		fprintf(stderr, "Can't set up the reader thread\n");
+		exit(1);
+	}
+
+	run->reader = r;
+
+	notify = g_io_channel_unix_new(r->notify_fd);
+	r->notify_watch = g_io_add_watch(notify,
+				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				received_lines, run);
+	g_io_channel_unref(notify);
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	r->thread = g_thread_new("reader", reader_run, r);
+#else
+	r->thread = g_thread_create(reader_run, r, TRUE, NULL);
+#endif
+}
+
+static void reader_stop(struct run *run)
+{
+	struct reader *r = run->reader;
+	struct line *line;
+
+	/* The modem is gone, the thread stops at the end of the stream */
+	g_thread_join(r->thread);
+
+	if (r->notify_watch > 0)
+		g_source_remove(r->notify_watch);
+
+	while ((line = spsc_queue_pop(r->lines)))
+		g_free(line);
+
+	spsc_queue_free(r->lines);
+	close(r->notify_fd);
+	close(r->fd);
+	g_free(r);
+
+	run->reader = NULL;
+}
+#else
+static inline void reader_start(struct run *run, int fd)
+{
+}
+
+static inline void reader_stop(struct run *run)
+{
+}
+#endif
+
+static gboolean stall(gpointer user_data)
+{
+	g_usleep(option_stall * 1000);
+
+	return TRUE;
+}
+
+static void write_lines(int fd)
+{
+	char line[64];
+	gsize len;
+	gssize written;
+	int i;
+
+	for (i = 0; i <= option_count; i++) {
+		if (i == option_count)
+			len = snprintf(line, sizeof(line), "\r\nDONE\r\n");
+		else
+			len = snprintf(line, sizeof(line),
+					"\r\n+TICK: %" G_GINT64_FORMAT "\r\n",
+					g_get_monotonic_time());
+
+		written = write(fd, line, len);
+		if (written != (gssize) len)
+			exit(1);
+
+		g_usleep(option_interval);
+	}
+
+	exit(0);
+}
+
+static gboolean run_mode(enum mode mode, struct run *run)
+{
+	GIOChannel *channel;
+	guint source;
+	pid_t pid;
+	int fds[2];
+
+#ifndef NEED_THREADS
+	if (mode == MODE_THREAD)
+		return FALSE;
+#endif
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+		perror("Can't create socket pair");
+		exit(1);
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		perror("Can't fork");
+		exit(1);
+	}
+
+	if (pid == 0) {
+		close(fds[0]);
+		write_lines(fds[1]);
+	}
+
+	close(fds[1]);
+
+	run->read_latency = g_new0(gint64, option_count);
+	run->dispatch_latency = g_new0(gint64, option_count);
+
+	if (mode == MODE_THREAD)
+		reader_start(run, fds[0]);
+	else {
+		channel = g_io_channel_unix_new(fds[0]);
+		g_io_channel_set_close_on_unref(channel, TRUE);
+
+		run->io = g_at_io_new(channel);
+		g_io_channel_unref(channel);
+
+		if (run->io == NULL) {
+			fprintf(stderr, "Can't create GAtIO\n");
+			exit(1);
+		}
+
+		g_at_io_set_disconnect_function(run->io, disconnect, NULL);
+		g_at_io_set_read_handler(run->io, read_lines, run);
+	}
+
+	source = g_timeout_add(option_period, stall, NULL);
+	g_main_loop_run(main_loop);
+	g_source_remove(source);
+
+	waitpid(pid, NULL, 0);
+
+	if (mode == MODE_THREAD)
+		reader_stop(run);
+	else {
+		g_at_io_unref(run->io);
+		run->io = NULL;
+	}
+
+	return run->done;
+}
+
+static int compare_latency(const void *a, const void *b)
+{
+	gint64 la = *(const gint64 *) a;
+	gint64 lb = *(const gint64 *) b;
+
+	return la < lb ? -1 : la > lb;
+}
+
+static gint64 percentile(gint64 *latency, unsigned int count,
+				unsigned int percent)
+{
+	if (count == 0)
+		return 0;
+
+	return latency[(count - 1) * percent / 100];
+}
+
+static void report(struct run *runs, gboolean *measured)
+{
+	unsigned int first = BUCKETS;
+	unsigned int last = 0;
+	unsigned int percents[] = { 50, 90, 99, 100 };
+	unsigned int i;
+	int m;
+
+	for (m = 0; m < MODE_LAST; m++) {
+		if (measured[m] == FALSE)
+			continue;
+
+		for (i = 0; i < BUCKETS; i++) {
+			if (runs[m].read_hist[i] == 0 &&
+					runs[m].dispatch_hist[i] == 0)
+				continue;
+
+			first = MIN(first, i);
+			last = MAX(last, i);
+		}
+
+		qsort(runs[m].read_latency, runs[m].lines, sizeof(gint64),
+							compare_latency);
+		qsort(runs[m].dispatch_latency, runs[m].lines,
+					sizeof(gint64), compare_latency);
+	}
+
+	printf("%d lines every %d us, main loop blocked for %d ms "
+			"every %d ms\n\n", option_count, option_interval,
+			option_stall, option_period);
+
+	printf("%-18s", "usec");
+	for (m = 0; m < MODE_LAST; m++)
+		if (measured[m])
+			printf("  %-20s", mode_names[m]);
+	printf("\n%-18s", "");
+	for (m = 0; m < MODE_LAST; m++)
+		if (measured[m])
+			printf("  %9s %10s", "read", "dispatch");
+	printf("\n");
+
+	for (i = first; i <= last && first < BUCKETS; i++) {
+		char range[32];
+
+		if (i == 0)
+			snprintf(range, sizeof(range), "< 2");
+		else
+			snprintf(range, sizeof(range), "%u - %u", 1U << i,
+							(1U << (i + 1)) - 1);
+
+		printf("%-18s", range);
+		for (m = 0; m < MODE_LAST; m++)
+			if (measured[m])
+				printf("  %9u %10u", runs[m].read_hist[i],
+						runs[m].dispatch_hist[i]);
+		printf("\n");
+	}
+
+	printf("\n");
+
+	for (i = 0; i < G_N_ELEMENTS(percents); i++) {
+		char name[16];
+
+		if (percents[i] == 100)
+			snprintf(name, sizeof(name), "max");
+		else
+			snprintf(name, sizeof(name), "p%u", percents[i]);
+
+		printf("%-18s", name);
+		for (m = 0; m < MODE_LAST; m++)
+			if (measured[m])
+				printf("  %9" G_GINT64_FORMAT
+					" %10" G_GINT64_FORMAT,
+					percentile(runs[m].read_latency,
+						runs[m].lines, percents[i]),
+					percentile(runs[m].dispatch_latency,
+						runs[m].lines, percents[i]));
+		printf("\n");
+	}
+}
+
+static GOptionEntry options[] = {
+	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
+				"Show version information and exit" },
+	{ "count", 'c', 0, G_OPTION_ARG_INT, &option_count,
+				"Number of lines to send", "N" },
+	{ "interval", 'i', 0, G_OPTION_ARG_INT, &option_interval,
+				"Time between two lines", "US" },
+	{ "stall", 's', 0, G_OPTION_ARG_INT, &option_stall,
+				"How long the main loop is blocked", "MS" },
+	{ "period", 'p', 0, G_OPTION_ARG_INT, &option_period,
+				"How often the main loop is blocked", "MS" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	struct run runs[MODE_LAST];
+	gboolean measured[MODE_LAST];
+	int m;
+
+#ifdef NEED_THREADS
+	if (g_thread_supported() == FALSE)
+		g_thread_init(NULL);
+#endif
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_version == TRUE) {
+		g_print("%s\n", VERSION);
+		exit(0);
+	}
+
+	if (option_count < 1 || option_interval < 0 || option_stall < 0 ||
+							option_period < 1) {
+		g_printerr("Invalid parameters\n");
+		exit(1);
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	main_loop = g_main_loop_new(NULL, FALSE);
+
+	memset(runs, 0, sizeof(runs));
+
+	for (m = 0; m < MODE_LAST; m++) {
+		measured[m] = run_mode(m, &runs[m]);
+
+		if (measured[m] == FALSE)
+			g_printerr("Skipping %s mode\n", mode_names[m]);
+	}
+
+	report(runs, measured);
+
+	for (m = 0; m < MODE_LAST; m++) {
+		g_free(runs[m].read_latency);
+		g_free(runs[m].dispatch_latency);
+	}
+
+	g_main_loop_unref(main_loop);
+
+	return 0;
+}
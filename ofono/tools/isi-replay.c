@@ -0,0 +1,601 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#include <glib.h>
+
+#include "gisi/modem.h"
+#include "gisi/socket.h"
+
+/*
+ * Replays ISI traffic through the receive and dispatch paths of
+ * gisi/modem.c.  The PhoNet sockets are replaced by an in-memory modem:
+ * indications are queued on the indication socket, and every request
+ * is answered with its recorded response on the request socket.
+ *
+ * The traffic is either read from an ofonod log captured with
+ * OFONO_ISI_TRACE set, or generated to resemble an idle N900.
+ *
+ * Each emulated receive costs one real system call, so that the replay
+ * reflects the number of kernel entries of the receive path.
+ * Both the batched and the single message receive functions are
+ * provided, so the harness links against either version of the GIsi
+ * modem code.
+ */
+
+#define DEFAULT_MTU 4096
+
+struct replay_event {
+	uint8_t resource;
+	uint8_t *request;	/* Without the UTID, NULL for indications */
+	size_t request_len;
+	uint8_t *response;	/* With the UTID */
+	size_t response_len;
+};
+
+struct replay_msg {
+	struct sockaddr_pn addr;
+	size_t len;
+	uint8_t data[];
+};
+
+struct replay_socket {
+	int fd;
+	GQueue queue;
+};
+
+static struct replay_socket sockets[2];
+static unsigned int nsockets;
+
+static struct replay_event *current;
+static unsigned long kernel_entries;
+static unsigned long received;
+static unsigned long notified;
+
+static gboolean option_version = FALSE;
+static gint option_iterations = 1000;
+static gint option_subscribers = 16;
+static gint option_burst = 16;
+static gint option_mtu = DEFAULT_MTU;
+static gchar *option_trace = NULL;
+
+static struct replay_socket *replay_socket(int fd)
+{
+	unsigned int i;
+
+	for (i = 0; i < nsockets; i++)
+		if (sockets[i].fd == fd)
+			return &sockets[i];
+
+	return NULL;
+}
+
+static void kernel_entry(void)
+{
+	getppid();
+	kernel_entries++;
+}
+
+static void replay_push(struct replay_socket *sock, uint8_t resource,
+				const uint8_t *data, size_t len)
+{
+	struct replay_msg *msg = g_malloc0(sizeof(*msg) + len);
+	uint64_t one = 1;
+
+	msg->addr.spn_family = AF_PHONET;
+	msg->addr.spn_resource = resource;
+	msg->len = len;
+	memcpy(msg->data, data, len);
+
+	if (g_queue_is_empty(&sock->queue) &&
+			write(sock->fd, &one, sizeof(one)) < 0)
+		perror("write");
+
+	g_queue_push_tail(&sock->queue, msg);
+}
+
+static struct replay_msg *replay_pop(struct replay_socket *sock)
+{
+	struct replay_msg *msg = g_queue_pop_head(&sock->queue);
+	uint64_t value;
+
+	if (msg != NULL && g_queue_is_empty(&sock->queue) &&
+			read(sock->fd, &value, sizeof(value)) < 0)
+		perror("read");
+
+	return msg;
+}
+
+GIOChannel *g_isi_phonet_new(unsigned int ifindex)
+{
+	GIOChannel *channel;
+	int fd;
+
+	if (nsockets == G_N_ELEMENTS(sockets))
+		return NULL;
+
+	fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	sockets[nsockets].fd = fd;
+	g_queue_init(&sockets[nsockets].queue);
+	nsockets++;
+
+	channel = g_io_channel_unix_new(fd);
+	g_io_channel_set_close_on_unref(channel, TRUE);
+
+	return channel;
+}
+
+size_t g_isi_phonet_mtu(GIOChannel *channel, unsigned int ifindex)
+{
+	return option_mtu;
+}
+
+size_t g_isi_phonet_peek_length(GIOChannel *channel)
+{
+	struct replay_socket *sock;
+	struct replay_msg *msg;
+
+	kernel_entry();
+
+	sock = replay_socket(g_io_channel_unix_get_fd(channel));
+	msg = g_queue_peek_head(&sock->queue);
+
+	return msg != NULL ? msg->len : 0;
+}
+
+ssize_t g_isi_phonet_read(GIOChannel *channel, void *restrict buf, size_t len,
+				struct sockaddr_pn *addr)
+{
+	struct replay_socket *sock;
+	struct replay_msg *msg;
+
+	kernel_entry();
+
+	sock = replay_socket(g_io_channel_unix_get_fd(channel));
+	msg = replay_pop(sock);
+	if (msg == NULL)
+		return -1;
+
+	len = MIN(len, msg->len);
+	memcpy(buf, msg->data, len);
+	*addr = msg->addr;
+	g_free(msg);
+
+	received++;
+
+	return len;
+}
+
+int g_isi_phonet_read_batch(GIOChannel *channel, struct mmsghdr *msgs,
+				unsigned int count)
+{
+	struct replay_socket *sock;
+	struct replay_msg *msg;
+	struct msghdr *hdr;
+	unsigned int i;
+
+	kernel_entry();
+
+	sock = replay_socket(g_io_channel_unix_get_fd(channel));
+
+	for (i = 0; i < count; i++) {
+		msg = replay_pop(sock);
+		if (msg == NULL)
+			break;
+
+		hdr = &msgs[i].msg_hdr;
+		msgs[i].msg_len = MIN(hdr->msg_iov->iov_len, msg->len);
+		memcpy(hdr->msg_iov->iov_base, msg->data, msgs[i].msg_len);
+		memcpy(hdr->msg_name, &msg->addr, sizeof(msg->addr));
+		hdr->msg_flags = msg->len > msgs[i].msg_len ? MSG_TRUNC : 0;
+		g_free(msg);
+	}
+
+	received += i;
+
+	return i > 0 ? (int) i : -1;
+}
+
+/*
+ * The GIsi modem code sends on the PhoNet sockets directly.  Requests
+ * are answered by the replay modem, anything else is dropped.
+ */
+ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+	const struct sockaddr_pn *dst = msg->msg_name;
+	uint8_t utid;
+	size_t i, len;
+
+	if (replay_socket(fd) == NULL)
+		return syscall(SYS_sendmsg, fd, msg, flags);
+
+	for (i = 0, len = 0; i < msg->msg_iovlen; i++)
+		len += msg->msg_iov[i].iov_len;
+
+	if (current == NULL || current->response == NULL)
+		return len;
+
+	utid = *(uint8_t *) msg->msg_iov[0].iov_base;
+	current->response[0] = utid;
+
+	replay_push(&sockets[1], dst->spn_resource, current->response,
+			current->response_len);
+
+	return len;
+}
+
+ssize_t sendto(int fd, const void *buf, size_t len, int flags,
+		const struct sockaddr *addr, socklen_t addrlen)
+{
+	if (replay_socket(fd) == NULL)
+		return syscall(SYS_sendto, fd, buf, len, flags, addr, addrlen);
+
+	return len;
+}
+
+static void ind_notify(const GIsiMessage *msg, void *data)
+{
+	notified++;
+}
+
+static void resp_notify(const GIsiMessage *msg, void *data)
+{
+	notified++;
+}
+
+static void add_event(GArray *events, uint8_t resource,
+				const uint8_t *request, size_t request_len,
+				const uint8_t *response, size_t response_len)
+{
+	struct replay_event event = {
+		.resource = resource,
+		.request = g_memdup(request, request_len),
+		.request_len = request_len,
+		.response = g_memdup(response, response_len),
+		.response_len = response_len,
+	};
+
+	g_array_append_val(events, event);
+}
+
+/* Resources used by the isimodem drivers on an N900 */
+static const uint8_t n900_resources[] = {
+	0x01,	/* PN_CALL */
+	0x02,	/* PN_SMS */
+	0x06,	/* PN_SS */
+	0x09,	/* PN_SIM */
+	0x0A,	/* PN_NETWORK */
+	0x15,	/* PN_MTC */
+	0x1B,	/* PN_PHONE_INFO */
+	0x31,	/* PN_GPDS */
+	0x32,	/* PN_GSS */
+};
+
+static void generate_events(GArray *events)
+{
+	uint8_t msg[16] = { 0 };
+	unsigned int i;
+
+	/*
+	 * Signal strength, cell and registration indications dominate,
+	 * with a request and response pair for every three indications.
+	 */
+	for (i = 0; i < 256; i++) {
+		uint8_t resource = n900_resources[i %
+					G_N_ELEMENTS(n900_resources)];
+
+		msg[1] = 0x40 + (i * 7) % option_subscribers;
+
+		if (i % 4 != 3)
+			add_event(events, resource, NULL, 0, msg, sizeof(msg));
+		else
+			add_event(events, resource, msg + 1, sizeof(msg) - 1,
+					msg, sizeof(msg));
+	}
+}
+
+static gboolean parse_hex(const char *line, GByteArray *bytes)
+{
+	const char *p = strstr(line, "    *");
+	unsigned int byte;
+	int n;
+
+	if (p == NULL)
+		return FALSE;
+
+	for (p += 5; sscanf(p, " %2x%n", &byte, &n) == 1; p += n) {
+		uint8_t b = byte;
+
+		g_byte_array_append(bytes, &b, 1);
+	}
+
+	return TRUE;
+}
+
+static void add_traced(GArray *events, int *open, uint8_t resource,
+			GByteArray *bytes)
+{
+	struct replay_event *event;
+	int key;
+
+	if (bytes->len < 2)
+		return;
+
+	if (bytes->data[0] == 0) {
+		add_event(events, resource, NULL, 0, bytes->data, bytes->len);
+		return;
+	}
+
+	/* The first message of a transaction is the request */
+	key = resource << 8 | bytes->data[0];
+
+	if (open[key] < 0) {
+		open[key] = events->len;
+		add_event(events, resource, bytes->data + 1, bytes->len - 1,
+				NULL, 0);
+		return;
+	}
+
+	event = &g_array_index(events, struct replay_event, open[key]);
+	event->response = g_memdup(bytes->data, bytes->len);
+	event->response_len = bytes->len;
+	open[key] = -1;
+}
+
+static gboolean read_trace(const char *path, GArray *events)
+{
+	GByteArray *bytes = g_byte_array_new();
+	int *open = g_new(int, 65536);
+	char line[512];
+	unsigned int resource = 0;
+	gboolean in_msg = FALSE;
+	FILE *fp;
+	int i;
+
+	fp = fopen(path, "r");
+	if (fp == NULL) {
+		perror(path);
+		g_free(open);
+		g_byte_array_free(bytes, TRUE);
+		return FALSE;
+	}
+
+	for (i = 0; i < 65536; i++)
+		open[i] = -1;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		const char *p = strstr(line, "(0x");
+
+		if (in_msg && parse_hex(line, bytes))
+			continue;
+
+		if (in_msg)
+			add_traced(events, open, resource, bytes);
+
+		in_msg = p != NULL && strstr(p, "[id=0x") != NULL &&
+				sscanf(p, "(0x%2x):", &resource) == 1;
+		g_byte_array_set_size(bytes, 0);
+	}
+
+	if (in_msg)
+		add_traced(events, open, resource, bytes);
+
+	fclose(fp);
+	g_free(open);
+	g_byte_array_free(bytes, TRUE);
+
+	return TRUE;
+}
+
+static void subscribe_events(GIsiModem *modem, GArray *events)
+{
+	static uint8_t subscribed[256][256];
+	unsigned int i;
+	int n;
+
+	/* Populate the modem like the isimodem drivers do */
+	for (i = 0; i < G_N_ELEMENTS(n900_resources); i++) {
+		uint8_t resource = n900_resources[i];
+
+		for (n = 0; n < option_subscribers; n++) {
+			subscribed[resource][0x40 + n] = 1;
+			g_isi_ind_subscribe(modem, resource, 0x40 + n,
+						ind_notify, NULL, NULL);
+		}
+	}
+
+	for (i = 0; i < events->len; i++) {
+		struct replay_event *event = &g_array_index(events,
+						struct replay_event, i);
+		uint8_t msgid;
+
+		if (event->request != NULL || event->response_len < 2)
+			continue;
+
+		msgid = event->response[1];
+
+		if (subscribed[event->resource][msgid])
+			continue;
+
+		subscribed[event->resource][msgid] = 1;
+		g_isi_ind_subscribe(modem, event->resource, msgid,
+					ind_notify, NULL, NULL);
+	}
+}
+
+static void run_until_idle(void)
+{
+	while (!g_queue_is_empty(&sockets[0].queue) ||
+			!g_queue_is_empty(&sockets[1].queue))
+		g_main_context_iteration(NULL, FALSE);
+}
+
+static void replay(GIsiModem *modem, GArray *events)
+{
+	unsigned int i;
+	int burst = 0;
+
+	for (i = 0; i < events->len; i++) {
+		struct replay_event *event = &g_array_index(events,
+						struct replay_event, i);
+
+		if (event->request == NULL) {
+			replay_push(&sockets[0], event->resource,
+					event->response, event->response_len);
+		} else {
+			current = event;
+			g_isi_request_send(modem, event->resource,
+						event->request,
+						event->request_len, 0,
+						resp_notify, NULL, NULL);
+			current = NULL;
+		}
+
+		if (++burst == option_burst) {
+			run_until_idle();
+			burst = 0;
+		}
+	}
+
+	run_until_idle();
+}
+
+static GOptionEntry options[] = {
+	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
+				"Show version information and exit" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &option_iterations,
+				"Number of times to replay the traffic", "N" },
+	{ "subscribers", 's', 0, G_OPTION_ARG_INT, &option_subscribers,
+				"Indication subscribers per resource", "N" },
+	{ "burst", 'b', 0, G_OPTION_ARG_INT, &option_burst,
+				"Messages queued per main loop wakeup", "N" },
+	{ "mtu", 'm', 0, G_OPTION_ARG_INT, &option_mtu,
+				"MTU of the emulated PhoNet link", "BYTES" },
+	{ "trace", 't', 0, G_OPTION_ARG_STRING, &option_trace,
+				"Replay an ofonod log with ISI traces", "FILE" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GArray *events;
+	GIsiModem *modem;
+	GTimer *timer;
+	unsigned long messages;
+	double elapsed;
+	unsigned int i;
+	int n;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_version == TRUE) {
+		g_print("%s\n", VERSION);
+		exit(0);
+	}
+
+	if (option_iterations < 1 || option_burst < 1 ||
+			option_subscribers < 1 || option_subscribers > 128) {
+		g_printerr("Invalid parameters\n");
+		exit(1);
+	}
+
+	events = g_array_new(FALSE, TRUE, sizeof(struct replay_event));
+
+	if (option_trace == NULL)
+		generate_events(events);
+	else if (read_trace(option_trace, events) == FALSE)
+		exit(1);
+
+	modem = g_isi_modem_create(1);
+	if (modem == NULL) {
+		g_printerr("Unable to create modem\n");
+		exit(1);
+	}
+
+	subscribe_events(modem, events);
+	run_until_idle();
+	g_main_context_iteration(NULL, FALSE);
+
+	kernel_entries = 0;
+	received = 0;
+	notified = 0;
+
+	timer = g_timer_new();
+
+	for (n = 0; n < option_iterations; n++)
+		replay(modem, events);
+
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	messages = received ? received : 1;
+
+	g_print("%u events, %lu messages received, %lu notifications\n",
+			events->len, received, notified);
+	g_print("Kernel entries:  %10.2f per message\n",
+			(double) kernel_entries / messages);
+	g_print("Receive path:    %10.1f ns per message\n",
+			elapsed * 1e9 / messages);
+
+	g_isi_modem_destroy(modem);
+
+	for (i = 0; i < events->len; i++) {
+		struct replay_event *event = &g_array_index(events,
+						struct replay_event, i);
+
+		g_free(event->request);
+		g_free(event->response);
+	}
+
+	g_array_free(events, TRUE);
+	g_free(option_trace);
+
+	return 0;
+}
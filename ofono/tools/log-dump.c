@@ -0,0 +1,400 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <syslog.h>
+
+#include <glib.h>
+
+#include "src/logring.h"
+
+struct site {
+	char *format;
+	char *signature;
+};
+
+static GPtrArray *sites;
+static unsigned int sites_read;
+
+static gboolean option_version = FALSE;
+static gboolean option_follow = FALSE;
+
+static void load_sites(struct log_ring_header *header)
+{
+	const unsigned char *table = (const unsigned char *) header +
+							header->sites_offset;
+	uint32_t used = header->sites_used;
+	struct log_ring_site entry;
+	struct site *site;
+
+	__sync_synchronize();
+
+	while (sites_read + sizeof(entry) <= used) {
+		memcpy(&entry, table + sites_read, sizeof(entry));
+		sites_read += sizeof(entry);
+
+		site = g_new0(struct site, 1);
+		site->format = g_strndup((const char *) table + sites_read,
+						entry.len);
+		site->signature = log_ring_signature(site->format);
+		sites_read += entry.len;
+
+		if (entry.id >= sites->len)
+			g_ptr_array_set_size(sites, entry.id + 1);
+
+		g_ptr_array_index(sites, entry.id) = site;
+	}
+}
+
+static void site_free(gpointer data)
+{
+	struct site *site = data;
+
+	if (site == NULL)
+		return;
+
+	g_free(site->format);
+	g_free(site->signature);
+	g_free(site);
+}
+
+static gboolean get_value(const unsigned char **args, size_t *len,
+				void *value, size_t size)
+{
+	if (*len < size)
+		return FALSE;
+
+	memcpy(value, *args, size);
+	*args += size;
+	*len -= size;
+
+	return TRUE;
+}
+
+static char *get_string(const unsigned char **args, size_t *len)
+{
+	uint16_t slen;
+	char *str;
+
+	if (get_value(args, len, &slen, sizeof(slen)) == FALSE)
+		return NULL;
+
+	slen = MIN(slen, *len);
+	str = g_strndup((const char *) *args, slen);
+	*args += slen;
+	*len -= slen;
+
+	return str;
+}
+
+/* Formats a single conversion, stars already replaced by their values */
+static void format_one(GString *out, const char *spec, char type,
+				const unsigned char **args, size_t *len)
+{
+	int64_t i = 0;
+	double d = 0;
+	char *str;
+
+	switch (type) {
+	case 's':
+	case 'm':
+		str = get_string(args, len);
+		if (type == 's')
+			g_string_append_printf(out, spec, str ? str : "");
+		else
+			g_string_append(out, str ? str : "");
+		g_free(str);
+		return;
+	case 'd':
+	case 'D':
+		get_value(args, len, &d, sizeof(d));
+
+		if (type == 'd')
+			g_string_append_printf(out, spec, d);
+		else
+			g_string_append_printf(out, spec, (long double) d);
+		return;
+	case 'n':
+		return;
+	}
+
+	get_value(args, len, &i, sizeof(i));
+
+	switch (type) {
+	case 'i':
+		g_string_append_printf(out, spec, (int) i);
+		break;
+	case 'l':
+		g_string_append_printf(out, spec, (long) i);
+		break;
+	case 'q':
+		g_string_append_printf(out, spec, (long long) i);
+		break;
+	case 'z':
+		g_string_append_printf(out, spec, (size_t) i);
+		break;
+	case 'j':
+		g_string_append_printf(out, spec, (intmax_t) i);
+		break;
+	case 't':
+		g_string_append_printf(out, spec, (ptrdiff_t) i);
+		break;
+	case 'p':
+		g_string_append_printf(out, spec, (void *) (uintptr_t) i);
+		break;
+	}
+}
+
+static void format_record(GString *out, const struct site *site,
+				const unsigned char *args, size_t len)
+{
+	const char *signature = site->signature;
+	const char *p = site->format;
+	GString *spec = g_string_new(NULL);
+	int64_t star;
+
+	while (*p != '\0') {
+		const char *start = p;
+
+		if (*p != '%') {
+			g_string_append_c(out, *p++);
+			continue;
+		}
+
+		if (p[1] == '%') {
+			g_string_append_c(out, '%');
+			p += 2;
+			continue;
+		}
+
+		if (*signature == '\0') {
+			/* Conversion the writer did not understand */
+			g_string_append(out, start);
+			break;
+		}
+
+		g_string_assign(spec, "%");
+
+		for (p++; *p != '\0' && strchr("-+ #0'123456789.*hlqLjzt",
+							*p) != NULL; p++) {
+			if (*p != '*') {
+				g_string_append_c(spec, *p);
+				continue;
+			}
+
+			star = 0;
+			get_value(&args, &len, &star, sizeof(star));
+			g_string_append_printf(spec, "%d", (int) star);
+			signature++;
+		}
+
+		if (*p == '\0')
+			break;
+
+		g_string_append_c(spec, *p++);
+		format_one(out, spec->str, *signature++, &args, &len);
+	}
+
+	g_string_free(spec, TRUE);
+}
+
+static const char *level_name(uint32_t level)
+{
+	switch (level) {
+	case LOG_ERR:
+		return "error";
+	case LOG_WARNING:
+		return "warning";
+	case LOG_INFO:
+		return "info";
+	case LOG_DEBUG:
+		return "debug";
+	}
+
+	return "unknown";
+}
+
+static void print_record(const struct log_ring_record *record)
+{
+	const unsigned char *args = (const unsigned char *) (record + 1);
+	size_t len = record->size - sizeof(*record);
+	struct site *site = NULL;
+	GString *out = g_string_sized_new(128);
+	time_t secs = record->time / G_USEC_PER_SEC;
+	char stamp[32];
+
+	if (record->site < sites->len)
+		site = g_ptr_array_index(sites, record->site);
+
+	strftime(stamp, sizeof(stamp), "%b %d %H:%M:%S", localtime(&secs));
+	g_string_printf(out, "%s.%06u %s: ", stamp,
+			(unsigned int) (record->time % G_USEC_PER_SEC),
+			level_name(record->level));
+
+	if (record->suppressed > 0)
+		g_string_append_printf(out, "(%u suppressed) ",
+						record->suppressed);
+
+	if (site != NULL)
+		format_record(out, site, args, len);
+	else
+		g_string_append_printf(out, "<site %u>", record->site);
+
+	printf("%s\n", out->str);
+	g_string_free(out, TRUE);
+}
+
+/* Prints the records written since position, returns the new position */
+static uint64_t dump(struct log_ring_header *header, uint64_t pos)
+{
+	const unsigned char *data = log_ring_data(header);
+	uint64_t mask = header->ring_size - 1;
+	unsigned char *copy;
+	uint64_t head, tail;
+	uint64_t start, p;
+
+	head = header->head;
+	tail = header->tail;
+	__sync_synchronize();
+
+	start = MAX(pos, tail);
+	if (start >= head)
+		return head;
+
+	load_sites(header);
+
+	/* The ring is mirrored, so the copy never needs to wrap */
+	copy = g_malloc(head - start);
+	memcpy(copy, data + (start & mask), head - start);
+
+	/* Whatever the writer overwrote meanwhile is lost */
+	__sync_synchronize();
+	tail = header->tail;
+
+	if (pos < tail && pos > 0)
+		printf("-- %llu bytes of records lost --\n",
+				(unsigned long long) (tail - pos));
+
+	for (p = start; p < head; ) {
+		const struct log_ring_record *record = (void *)
+							(copy + p - start);
+
+		if (record->size < sizeof(*record) || p + record->size > head)
+			break;
+
+		if (p >= tail)
+			print_record(record);
+
+		p += record->size;
+	}
+
+	g_free(copy);
+
+	return head;
+}
+
+static GOptionEntry options[] = {
+	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
+				"Show version information and exit" },
+	{ "follow", 'f', 0, G_OPTION_ARG_NONE, &option_follow,
+				"Keep printing new records" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	struct log_ring_header *header;
+	uint64_t pos = 0;
+	char *path;
+	int fd;
+
+	context = g_option_context_new("PID|FILE");
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_version == TRUE) {
+		g_print("%s\n", VERSION);
+		exit(0);
+	}
+
+	if (argc < 2) {
+		g_printerr("Missing parameters\n");
+		exit(1);
+	}
+
+	if (g_ascii_isdigit(argv[1][0]))
+		path = g_strdup_printf(LOG_RING_PATH, atoi(argv[1]));
+	else
+		path = g_strdup(argv[1]);
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		perror(path);
+		exit(1);
+	}
+
+	header = log_ring_map(fd, FALSE);
+	close(fd);
+
+	if (header == NULL) {
+		g_printerr("%s is not a log ring\n", path);
+		exit(1);
+	}
+
+	sites = g_ptr_array_new_with_free_func(site_free);
+
+	do {
+		pos = dump(header, pos);
+		fflush(stdout);
+
+		if (option_follow)
+			usleep(100000);
+	} while (option_follow);
+
+	g_ptr_array_free(sites, TRUE);
+	log_ring_unmap(header);
+	g_free(path);
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <glib.h>
+
+#define OFONO_API_SUBJECT_TO_CHANGE
+#include <ofono/modem.h>
+#include <ofono/gprs-provision.h>
+
+#include "plugins/mbpi.h"
+
+static int lookup(const char *mcc, const char *mnc, const char *sid)
+{
+	GError *error = NULL;
+	GSList *apns;
+	char *name;
+	int found;
+
+	apns = mbpi_lookup_apn(mcc, mnc, TRUE, &error);
+	if (error != NULL) {
+		g_printerr("Lookup failed: %s\n", error->message);
+		g_error_free(error);
+		exit(1);
+	}
+
+	found = g_slist_length(apns);
+	g_slist_free_full(apns, (GDestroyNotify) mbpi_ap_free);
+
+	if (sid == NULL)
+		return found;
+
+	name = mbpi_lookup_cdma_provider_name(sid, NULL);
+	if (name != NULL)
+		found++;
+
+	g_free(name);
+
+	return found;
+}
+
+static double run(const char *mcc, const char *mnc, const char *sid,
+			int iterations, int *found)
+{
+	GTimer *timer = g_timer_new();
+	double elapsed;
+	int i;
+
+	for (i = 0; i < iterations; i++)
+		*found = lookup(mcc, mnc, sid);
+
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	return elapsed * 1e6 / iterations;
+}
+
+static gboolean option_version = FALSE;
+static gint option_iterations = 20;
+static gchar *option_index = NULL;
+static gchar *option_sid = NULL;
+
+static GOptionEntry options[] = {
+	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
+				"Show version information and exit" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &option_iterations,
+				"Number of lookups of each kind", "N" },
+	{ "index", 0, 0, G_OPTION_ARG_STRING, &option_index,
+				"Where to store the compiled index", "FILE" },
+	{ "sid", 0, 0, G_OPTION_ARG_STRING, &option_sid,
+				"Also look up a CDMA provider", "SID" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GTimer *timer;
+	double xml, compile, indexed;
+	int xml_found, index_found;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_version == TRUE) {
+		g_print("%s\n", VERSION);
+		exit(0);
+	}
+
+	if (argc < 3 || option_iterations < 1) {
+		g_printerr("Missing parameters\n");
+		exit(1);
+	}
+
+	if (option_index == NULL)
+		option_index = g_strdup_printf("/tmp/mbpi-bench-%d.idx",
+							(int) getpid());
+
+	mbpi_set_index(NULL);
+	xml = run(argv[1], argv[2], option_sid, option_iterations,
+								&xml_found);
+
+	/* The first lookup compiles and writes the index */
+	unlink(option_index);
+	mbpi_set_index(option_index);
+
+	timer = g_timer_new();
+	lookup(argv[1], argv[2], option_sid);
+	compile = g_timer_elapsed(timer, NULL) * 1e6;
+	g_timer_destroy(timer);
+
+	indexed = run(argv[1], argv[2], option_sid, option_iterations * 1000,
+								&index_found);
+
+	g_print("XML parse:     %12.1f us/lookup\n", xml);
+	g_print("Index compile: %12.1f us\n", compile);
+	g_print("Index lookup:  %12.3f us/lookup\n", indexed);
+	g_print("Speedup:       %12.0fx\n", xml / indexed);
+
+	mbpi_set_index(NULL);
+	unlink(option_index);
+	g_free(option_index);
+	g_free(option_sid);
+
+	if (xml_found != index_found) {
+		g_printerr("Results differ: %d from XML, %d from index\n",
+						xml_found, index_found);
+		return 1;
+	}
+
+	return 0;
+}
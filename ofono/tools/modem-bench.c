@@ -0,0 +1,835 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#include <gdbus.h>
+#include <gatchat/gatserver.h>
+#include <gatchat/gathdlc.h>
+
+#include "modem-sim.h"
+
+#define OFONO_SERVICE	"org.ofono"
+#define OFONO_MANAGER_INTERFACE		OFONO_SERVICE ".Manager"
+#define OFONO_MODEM_INTERFACE		OFONO_SERVICE ".Modem"
+#define OFONO_SIM_MANAGER_INTERFACE	OFONO_SERVICE ".SimManager"
+#define OFONO_NETWORK_REGISTRATION_INTERFACE	\
+					OFONO_SERVICE ".NetworkRegistration"
+#define OFONO_MESSAGE_MANAGER_INTERFACE	OFONO_SERVICE ".MessageManager"
+
+/* Opened by plugins/modembench.c */
+#define MODEMBENCH_TTY		"/tmp/ofono-modembench"
+#define MODEMBENCH_QMI		"/tmp/ofono-modembench-qmi"
+#define RILD_CMD_SOCKET		"/dev/socket/rild"
+
+#define PPP_FRAME_SIZE		1500
+
+/* TS 23.040 SMS-DELIVER, 30 octets after the SMSC address */
+#define CMT_PDU	"07911326040000F0040B911346610089F60000208062917314480" \
+		"CC8F71D14969741F977FD07"
+#define CMT_TPDU_LEN	30
+
+/*
+ * Enough of a modem for devinfo, sim, sms and netreg of the atmodem
+ * drivers.  SIM files are reported missing, the IMSI is still read.
+ */
+static const char default_session[] =
+	"> +CMEE\n< OK\n"
+	"> +CFUN\n< OK\n"
+	"> +CGMI\n< Bench\n"
+	"> +CGMM\n< Replay\n"
+	"> +CGMR\n< 1.0\n"
+	"> +CGSN\n< 123456789012345\n"
+	"> +GCAP\n< +GCAP: +CGSM\n"
+	"> +CPIN?\n< +CPIN: READY\n"
+	"> +CIMI\n< 001010123456789\n"
+	"> +CRSM\n< +CRSM: 106,130\n"
+	"> +CSMS=?\n< +CSMS: (0)\n"
+	"> +CSMS=0\n< +CSMS: 1,1,1\n"
+	"> +CSMS?\n< +CSMS: 0,1,1,1\n"
+	"> +CMGF=?\n< +CMGF: (0)\n"
+	"> +CMGF\n< OK\n"
+	"> +CPMS=?\n"
+	"< +CPMS: (\"ME\",\"SM\"),(\"ME\",\"SM\"),(\"ME\",\"SM\")\n"
+	"> +CPMS\n< +CPMS: 0,10,0,10,0,10\n"
+	"> +CNMI=?\n< +CNMI: (0-2),(0-3),(0-3),(0-2),(0,1)\n"
+	"> +CNMI\n< OK\n"
+	"> +CMGL\n< OK\n"
+	"> +CMMS\n< OK\n"
+	"> +CSCA?\n< +CSCA: \"+15555550000\",145\n"
+	"> +CREG=?\n< +CREG: (0-2)\n"
+	"> +CREG=2\n< OK\n"
+	"> +CREG?\n< +CREG: 2,1,\"1A2B\",\"00000F01\"\n"
+	"> +CIND=?\n< +CIND: (\"signal\",(0-5)),(\"service\",(0-1))\n"
+	"> +CIND?\n< +CIND: 4,1\n"
+	"> +CMER=?\n< +CMER: (0-3),(0),(0),(0-2)\n"
+	"> +CMER\n< OK\n"
+	"> +COPS\n< OK\n"
+	"> +COPS?\n< +COPS: 0,2,\"00101\"\n"
+	"> +COPS?\n< +COPS: 0,0,\"Bench\"\n"
+	"> +CSQ\n< +CSQ: 20,99\n";
+
+enum bench_result {
+	BENCH_ONLINE,
+	BENCH_SIM_READY,
+	BENCH_SMS_SEND,
+	BENCH_SMS_RECEIVE,
+	BENCH_URC_STORM,
+	BENCH_PPP,
+	BENCH_LAST,
+};
+
+static const struct {
+	const char *name;
+	const char *unit;
+} bench_info[BENCH_LAST] = {
+	{ "Time to online",	"ms" },
+	{ "SIM ready",		"ms" },
+	{ "SMS send",		"msg/s" },
+	{ "SMS receive",	"msg/s" },
+	{ "URC storm",		"URC/s" },
+	{ "PPP (HDLC)",		"MB/s" },
+};
+
+static double results[BENCH_LAST];
+static gboolean measured[BENCH_LAST];
+
+static GMainLoop *main_loop;
+static DBusConnection *conn;
+static struct modem_sim *sim;
+static const char *modem_path = "/modembench";
+static GTimer *timer;
+static guint timeout_source;
+
+static gboolean sim_ready;
+static gboolean online;
+static gboolean registered;
+static gboolean has_sms;
+static gboolean sms_started;
+static unsigned int sms_sent;
+static unsigned int sms_received;
+static unsigned int cmgs_mr;
+static gboolean storm_running;
+
+static GAtHDLC *ppp_tx;
+static GAtHDLC *ppp_rx;
+static gsize ppp_received;
+static gsize ppp_total;
+static guint ppp_source;
+
+static double option_speed = 1.0;
+static int option_count = 200;
+static int option_ppp_mbytes = 64;
+static int option_timeout = 120;
+static char *option_session;
+static char *option_rild;
+static char *option_qmi;
+static gboolean option_debug;
+static gboolean option_version;
+
+static void bench_ppp(void);
+
+static void record(enum bench_result bench, double value)
+{
+	results[bench] = value;
+	measured[bench] = TRUE;
+
+	if (option_debug)
+		g_print("%s: %.1f %s\n", bench_info[bench].name, value,
+						bench_info[bench].unit);
+}
+
+static double elapsed_ms(void)
+{
+	return g_timer_elapsed(timer, NULL) * 1000.0;
+}
+
+static void report(void)
+{
+	int i;
+
+	g_print("\n%-24s %14s\n", "Benchmark", "Result");
+
+	for (i = 0; i < BENCH_LAST; i++) {
+		g_print("%-24s ", bench_info[i].name);
+
+		if (measured[i])
+			g_print("%14.1f %s\n", results[i], bench_info[i].unit);
+		else
+			g_print("%14s\n", "-");
+	}
+}
+
+static void set_property_reply(DBusPendingCall *call, void *user_data)
+{
+	DBusMessage *reply = dbus_pending_call_steal_reply(call);
+	DBusError err;
+
+	dbus_error_init(&err);
+
+	if (dbus_set_error_from_message(&err, reply) == TRUE) {
+		if (user_data == NULL)
+			g_printerr("%s: %s\n", err.name, err.message);
+
+		dbus_error_free(&err);
+	}
+
+	dbus_message_unref(reply);
+}
+
+static int set_property(const char *path, const char *interface,
+			const char *key, dbus_bool_t val, gboolean quiet)
+{
+	DBusMessage *msg;
+	DBusMessageIter iter, value;
+	DBusPendingCall *call;
+
+	msg = dbus_message_new_method_call(OFONO_SERVICE, path, interface,
+						"SetProperty");
+	if (msg == NULL)
+		return -ENOMEM;
+
+	dbus_message_set_auto_start(msg, FALSE);
+
+	dbus_message_iter_init_append(msg, &iter);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &key);
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT,
+					DBUS_TYPE_BOOLEAN_AS_STRING, &value);
+	dbus_message_iter_append_basic(&value, DBUS_TYPE_BOOLEAN, &val);
+	dbus_message_iter_close_container(&iter, &value);
+
+	if (dbus_connection_send_with_reply(conn, msg, &call, -1) == FALSE) {
+		dbus_message_unref(msg);
+		return -EIO;
+	}
+
+	dbus_message_unref(msg);
+
+	if (call == NULL)
+		return -EINVAL;
+
+	dbus_pending_call_set_notify(call, set_property_reply,
+					quiet ? GINT_TO_POINTER(1) : NULL,
+					NULL);
+	dbus_pending_call_unref(call);
+
+	return 0;
+}
+
+static void finish(void)
+{
+	if (timeout_source) {
+		g_source_remove(timeout_source);
+		timeout_source = 0;
+	}
+
+	g_main_loop_quit(main_loop);
+}
+
+static gboolean bench_timeout(gpointer user_data)
+{
+	timeout_source = 0;
+
+	g_printerr("Timed out\n");
+	finish();
+
+	return FALSE;
+}
+
+static void send_message_reply(DBusPendingCall *call, void *user_data)
+{
+	set_property_reply(call, NULL);
+}
+
+static void bench_sms_send(void)
+{
+	const char *to = "+15555551234";
+	const char *text = "modem-bench";
+	int i;
+
+	sms_started = TRUE;
+	g_timer_start(timer);
+
+	for (i = 0; i < option_count; i++) {
+		DBusMessage *msg;
+		DBusPendingCall *call;
+
+		msg = dbus_message_new_method_call(OFONO_SERVICE, modem_path,
+					OFONO_MESSAGE_MANAGER_INTERFACE,
+					"SendMessage");
+		if (msg == NULL)
+			break;
+
+		dbus_message_append_args(msg, DBUS_TYPE_STRING, &to,
+						DBUS_TYPE_STRING, &text,
+						DBUS_TYPE_INVALID);
+
+		if (dbus_connection_send_with_reply(conn, msg, &call, -1)) {
+			dbus_pending_call_set_notify(call, send_message_reply,
+							NULL, NULL);
+			dbus_pending_call_unref(call);
+		}
+
+		dbus_message_unref(msg);
+	}
+}
+
+static void bench_sms_receive(void)
+{
+	GAtServer *server = modem_sim_get_server(sim);
+	char buf[128];
+	int i;
+
+	snprintf(buf, sizeof(buf), "+CMT: ,%d\r\n%s", CMT_TPDU_LEN, CMT_PDU);
+
+	g_timer_start(timer);
+
+	for (i = 0; i < option_count; i++)
+		g_at_server_send_unsolicited(server, buf);
+}
+
+static void bench_urc_storm(void)
+{
+	GAtServer *server = modem_sim_get_server(sim);
+	char buf[64];
+	int i;
+
+	storm_running = TRUE;
+	g_timer_start(timer);
+
+	/* Cell reselections and signal changes, then roaming to end it */
+	for (i = 0; i < option_count; i++) {
+		snprintf(buf, sizeof(buf), "+CREG: 2,1,\"1A2B\",\"%08X\"",
+						0xF01 + i % 8);
+		g_at_server_send_unsolicited(server, buf);
+
+		snprintf(buf, sizeof(buf), "+CIEV: 1,%d", i % 6);
+		g_at_server_send_unsolicited(server, buf);
+	}
+
+	g_at_server_send_unsolicited(server,
+				"+CREG: 2,5,\"1A2B\",\"00000F01\"");
+}
+
+static void check_ready(void)
+{
+	if (online == FALSE)
+		return;
+
+	/* SMS and URC injection need the AT simulator */
+	if (modem_sim_get_server(sim) == NULL) {
+		bench_ppp();
+		return;
+	}
+
+	if (registered && has_sms && sms_started == FALSE)
+		bench_sms_send();
+}
+
+static gboolean has_interface(DBusMessageIter *iter, const char *interface)
+{
+	DBusMessageIter entry;
+
+	dbus_message_iter_recurse(iter, &entry);
+
+	while (dbus_message_iter_get_arg_type(&entry) == DBUS_TYPE_STRING) {
+		const char *str;
+
+		dbus_message_iter_get_basic(&entry, &str);
+
+		if (g_str_equal(str, interface))
+			return TRUE;
+
+		dbus_message_iter_next(&entry);
+	}
+
+	return FALSE;
+}
+
+static gboolean parse_property(DBusMessage *msg, const char **key,
+					DBusMessageIter *value)
+{
+	DBusMessageIter iter;
+
+	if (dbus_message_iter_init(msg, &iter) == FALSE)
+		return FALSE;
+
+	if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING)
+		return FALSE;
+
+	dbus_message_iter_get_basic(&iter, key);
+	dbus_message_iter_next(&iter);
+	dbus_message_iter_recurse(&iter, value);
+
+	return TRUE;
+}
+
+static gboolean modem_changed(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	DBusMessageIter value;
+	const char *key;
+	dbus_bool_t val;
+
+	if (parse_property(msg, &key, &value) == FALSE)
+		return TRUE;
+
+	if (g_str_equal(key, "Online")) {
+		dbus_message_iter_get_basic(&value, &val);
+
+		if (val && online == FALSE) {
+			online = TRUE;
+			record(BENCH_ONLINE, elapsed_ms());
+			check_ready();
+		}
+	} else if (g_str_equal(key, "Interfaces")) {
+		gboolean sms = has_interface(&value,
+					OFONO_MESSAGE_MANAGER_INTERFACE);
+
+		if (sms && has_sms == FALSE) {
+			has_sms = TRUE;
+			check_ready();
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean sim_changed(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	DBusMessageIter value;
+	const char *key;
+
+	if (parse_property(msg, &key, &value) == FALSE)
+		return TRUE;
+
+	if (g_str_equal(key, "SubscriberIdentity") == FALSE || sim_ready)
+		return TRUE;
+
+	sim_ready = TRUE;
+	record(BENCH_SIM_READY, elapsed_ms());
+
+	set_property(modem_path, OFONO_MODEM_INTERFACE, "Online", TRUE, FALSE);
+
+	return TRUE;
+}
+
+static gboolean netreg_changed(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	DBusMessageIter value;
+	const char *key, *status;
+
+	if (parse_property(msg, &key, &value) == FALSE)
+		return TRUE;
+
+	if (g_str_equal(key, "Status") == FALSE)
+		return TRUE;
+
+	dbus_message_iter_get_basic(&value, &status);
+
+	if (g_str_equal(status, "registered") && registered == FALSE) {
+		registered = TRUE;
+		check_ready();
+	} else if (g_str_equal(status, "roaming") && storm_running) {
+		storm_running = FALSE;
+		record(BENCH_URC_STORM, (2 * option_count + 1) /
+					g_timer_elapsed(timer, NULL));
+
+		g_at_server_send_unsolicited(modem_sim_get_server(sim),
+				"+CREG: 2,1,\"1A2B\",\"00000F01\"");
+
+		bench_ppp();
+	}
+
+	return TRUE;
+}
+
+static gboolean message_removed(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	if (sms_started == FALSE || ++sms_sent != (unsigned int) option_count)
+		return TRUE;
+
+	record(BENCH_SMS_SEND, option_count / g_timer_elapsed(timer, NULL));
+	bench_sms_receive();
+
+	return TRUE;
+}
+
+static gboolean incoming_message(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	if (++sms_received != (unsigned int) option_count)
+		return TRUE;
+
+	record(BENCH_SMS_RECEIVE, option_count /
+					g_timer_elapsed(timer, NULL));
+	bench_urc_storm();
+
+	return TRUE;
+}
+
+static void cmgs_pdu(GAtServer *server, const char *pdu, gpointer user_data)
+{
+	char buf[32];
+
+	if (pdu == NULL) {
+		g_at_server_send_final(server, G_AT_SERVER_RESULT_ERROR);
+		return;
+	}
+
+	snprintf(buf, sizeof(buf), "+CMGS: %u", cmgs_mr++ % 256);
+	g_at_server_send_info(server, buf, TRUE);
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void cmgs_cb(GAtServer *server, GAtServerRequestType type,
+			GAtResult *cmd, gpointer user_data)
+{
+	switch (type) {
+	case G_AT_SERVER_REQUEST_TYPE_SUPPORT:
+		g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+		break;
+	case G_AT_SERVER_REQUEST_TYPE_SET:
+		g_at_server_expect_pdu(server, cmgs_pdu, NULL);
+		break;
+	default:
+		g_at_server_send_final(server, G_AT_SERVER_RESULT_ERROR);
+		break;
+	}
+}
+
+static void ppp_receive(const unsigned char *data, gsize size,
+							gpointer user_data)
+{
+	ppp_received += size;
+
+	if (ppp_received < ppp_total)
+		return;
+
+	record(BENCH_PPP, ppp_total / g_timer_elapsed(timer, NULL) /
+							(1024 * 1024));
+	finish();
+}
+
+static gboolean ppp_send(gpointer user_data)
+{
+	static unsigned char frame[PPP_FRAME_SIZE];
+	static gsize sent;
+
+	while (sent < ppp_total) {
+		if (g_at_hdlc_send(ppp_tx, frame, sizeof(frame)) == FALSE)
+			return TRUE;
+
+		sent += sizeof(frame);
+	}
+
+	ppp_source = 0;
+
+	return FALSE;
+}
+
+/*
+ * PPP frames go through the HDLC framing of gatchat, as they would on
+ * the data channel of a modem.  Both ends run in this process.
+ */
+static void bench_ppp(void)
+{
+	GIOChannel *io;
+	int sk[2];
+
+	if (ppp_tx)
+		return;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sk) < 0) {
+		finish();
+		return;
+	}
+
+	io = g_io_channel_unix_new(sk[0]);
+	g_io_channel_set_close_on_unref(io, TRUE);
+	ppp_tx = g_at_hdlc_new(io);
+	g_io_channel_unref(io);
+
+	io = g_io_channel_unix_new(sk[1]);
+	g_io_channel_set_close_on_unref(io, TRUE);
+	ppp_rx = g_at_hdlc_new(io);
+	g_io_channel_unref(io);
+
+	g_at_hdlc_set_receive(ppp_rx, ppp_receive, NULL);
+
+	ppp_total = (gsize) option_ppp_mbytes * 1024 * 1024;
+	ppp_total -= ppp_total % PPP_FRAME_SIZE;
+
+	g_timer_start(timer);
+	ppp_source = g_idle_add(ppp_send, NULL);
+}
+
+static void power_off_reply(DBusPendingCall *call, void *user_data)
+{
+	set_property_reply(call, user_data);
+
+	g_timer_start(timer);
+	set_property(modem_path, OFONO_MODEM_INTERFACE, "Powered", TRUE, FALSE);
+}
+
+static void ofono_connect(DBusConnection *conn, void *user_data)
+{
+	DBusMessage *msg;
+	DBusMessageIter iter, value;
+	DBusPendingCall *call;
+	const char *key = "Powered";
+	dbus_bool_t val = FALSE;
+
+	g_print("oFono is up, benchmarking %s\n", modem_path);
+
+	g_dbus_add_signal_watch(conn, OFONO_SERVICE, modem_path,
+				OFONO_MODEM_INTERFACE, "PropertyChanged",
+				modem_changed, NULL, NULL);
+	g_dbus_add_signal_watch(conn, OFONO_SERVICE, modem_path,
+				OFONO_SIM_MANAGER_INTERFACE, "PropertyChanged",
+				sim_changed, NULL, NULL);
+	g_dbus_add_signal_watch(conn, OFONO_SERVICE, modem_path,
+				OFONO_NETWORK_REGISTRATION_INTERFACE,
+				"PropertyChanged", netreg_changed, NULL, NULL);
+	g_dbus_add_signal_watch(conn, OFONO_SERVICE, modem_path,
+				OFONO_MESSAGE_MANAGER_INTERFACE,
+				"MessageRemoved", message_removed, NULL, NULL);
+	g_dbus_add_signal_watch(conn, OFONO_SERVICE, modem_path,
+				OFONO_MESSAGE_MANAGER_INTERFACE,
+				"IncomingMessage", incoming_message,
+				NULL, NULL);
+
+	/* Start from a modem that is off, whatever state it was left in */
+	msg = dbus_message_new_method_call(OFONO_SERVICE, modem_path,
+					OFONO_MODEM_INTERFACE, "SetProperty");
+	if (msg == NULL) {
+		finish();
+		return;
+	}
+
+	dbus_message_iter_init_append(msg, &iter);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &key);
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT,
+					DBUS_TYPE_BOOLEAN_AS_STRING, &value);
+	dbus_message_iter_append_basic(&value, DBUS_TYPE_BOOLEAN, &val);
+	dbus_message_iter_close_container(&iter, &value);
+
+	if (dbus_connection_send_with_reply(conn, msg, &call, -1) &&
+			call != NULL) {
+		dbus_pending_call_set_notify(call, power_off_reply,
+						GINT_TO_POINTER(1), NULL);
+		dbus_pending_call_unref(call);
+	}
+
+	dbus_message_unref(msg);
+}
+
+static void ofono_disconnect(DBusConnection *conn, void *user_data)
+{
+	g_printerr("oFono went away\n");
+	finish();
+}
+
+static void sig_term(int sig)
+{
+	g_main_loop_quit(main_loop);
+}
+
+static gboolean parse_speed(const char *key, const char *value,
+					gpointer user_data, GError **error)
+{
+	char *end;
+
+	option_speed = g_ascii_strtod(value, &end);
+
+	if (*end != '\0' || option_speed < 0) {
+		g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+				"Invalid speed %s", value);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static GOptionEntry options[] = {
+	{ "session", 's', 0, G_OPTION_ARG_FILENAME, &option_session,
+				"Replay this AT session instead of the "
+				"built-in one", "FILE" },
+	{ "rild", 0, 0, G_OPTION_ARG_FILENAME, &option_rild,
+				"Replay a RIL session on the rild socket",
+				"FILE" },
+	{ "qmi", 0, 0, G_OPTION_ARG_FILENAME, &option_qmi,
+				"Replay a QMI session on a pty", "FILE" },
+	{ "speed", 0, 0, G_OPTION_ARG_CALLBACK, parse_speed,
+				"Divide the recorded delays by this, "
+				"0 drops them", "FACTOR" },
+	{ "count", 'c', 0, G_OPTION_ARG_INT, &option_count,
+				"Messages and URCs per benchmark", "N" },
+	{ "ppp-size", 0, 0, G_OPTION_ARG_INT, &option_ppp_mbytes,
+				"Megabytes to send over PPP", "MB" },
+	{ "timeout", 't', 0, G_OPTION_ARG_INT, &option_timeout,
+				"Give up after this many seconds", "SEC" },
+	{ "debug", 'd', 0, G_OPTION_ARG_NONE, &option_debug,
+				"Show the simulated modem traffic" },
+	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
+				"Show version information and exit" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	DBusError err;
+	struct sigaction sa;
+	guint watch;
+	int ret;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_version == TRUE) {
+		printf("%s\n", VERSION);
+		exit(0);
+	}
+
+	if (option_count <= 0 || option_ppp_mbytes <= 0) {
+		g_printerr("Counts must be positive\n");
+		exit(1);
+	}
+
+	main_loop = g_main_loop_new(NULL, FALSE);
+
+	if (option_rild) {
+		sim = modem_sim_new(MODEM_SIM_RIL, RILD_CMD_SOCKET,
+							option_speed);
+		ret = modem_sim_load_file(sim, option_rild);
+		modem_path = "/ril_0";
+	} else if (option_qmi) {
+		sim = modem_sim_new(MODEM_SIM_QMI, MODEMBENCH_QMI,
+							option_speed);
+		ret = modem_sim_load_file(sim, option_qmi);
+		modem_path = "/qmibench";
+	} else {
+		sim = modem_sim_new(MODEM_SIM_AT, MODEMBENCH_TTY,
+							option_speed);
+
+		if (option_session)
+			ret = modem_sim_load_file(sim, option_session);
+		else
+			ret = modem_sim_load(sim, "built-in",
+							default_session);
+	}
+
+	if (ret < 0)
+		exit(1);
+
+	modem_sim_set_debug(sim, option_debug);
+
+	ret = modem_sim_start(sim);
+	if (ret < 0) {
+		g_printerr("Unable to start the modem simulator: %s\n",
+							strerror(-ret));
+		exit(1);
+	}
+
+	if (modem_sim_get_server(sim))
+		g_at_server_register(modem_sim_get_server(sim), "+CMGS",
+							cmgs_cb, NULL, NULL);
+
+	dbus_error_init(&err);
+
+	conn = g_dbus_setup_bus(DBUS_BUS_SYSTEM, NULL, &err);
+	if (conn == NULL) {
+		if (dbus_error_is_set(&err) == TRUE) {
+			fprintf(stderr, "%s\n", err.message);
+			dbus_error_free(&err);
+		} else
+			fprintf(stderr, "Can't register with system bus\n");
+		exit(1);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sig_term;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	timer = g_timer_new();
+
+	watch = g_dbus_add_service_watch(conn, OFONO_SERVICE,
+				ofono_connect, ofono_disconnect, NULL, NULL);
+
+	timeout_source = g_timeout_add_seconds(option_timeout,
+						bench_timeout, NULL);
+
+	g_main_loop_run(main_loop);
+
+	report();
+
+	set_property(modem_path, OFONO_MODEM_INTERFACE, "Powered", FALSE, TRUE);
+	dbus_connection_flush(conn);
+
+	if (timeout_source)
+		g_source_remove(timeout_source);
+
+	if (ppp_source)
+		g_source_remove(ppp_source);
+
+	g_at_hdlc_unref(ppp_tx);
+	g_at_hdlc_unref(ppp_rx);
+
+	g_dbus_remove_watch(conn, watch);
+	dbus_connection_unref(conn);
+
+	modem_sim_free(sim);
+	g_timer_destroy(timer);
+	g_free(option_session);
+	g_free(option_rild);
+	g_free(option_qmi);
+
+	g_main_loop_unref(main_loop);
+
+	return 0;
+}
@@ -0,0 +1,1032 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <pty.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <glib.h>
+
+#include <gatchat/gatserver.h>
+#include <gatchat/ringbuffer.h>
+
+#include "src/util.h"
+
+#include "modem-sim.h"
+
+#define RIL_RESPONSE_SOLICITED		0
+#define RIL_RESPONSE_UNSOLICITED	1
+#define RIL_MAX_PARCEL			4092
+
+#define QMI_MUX_HDR_SIZE		6
+#define QMI_CONTROL_HDR_SIZE		2
+#define QMI_SERVICE_HDR_SIZE		3
+#define QMI_MESSAGE_HDR_SIZE		4
+
+struct sim_step {
+	char kind;			/* '<', '!' or '=' */
+	char *text;
+	unsigned char *data;		/* Decoded hex for RIL and QMI */
+	long len;
+	guint16 service;		/* QMI indications */
+	guint16 message;
+	int delay;
+};
+
+struct sim_rule {
+	GPtrArray *blocks;		/* Each a GPtrArray of sim_step */
+	guint next;
+};
+
+struct sim_player {
+	struct modem_sim *sim;
+	GPtrArray *steps;
+	guint pos;
+	guint source;
+	gboolean final_sent;
+	guint32 serial;			/* RIL */
+	guint8 service;			/* QMI */
+	guint8 client;
+	guint16 transaction;
+	guint16 message;
+};
+
+struct modem_sim {
+	enum modem_sim_transport transport;
+	char *path;
+	double speed;
+	gboolean debug;
+	GHashTable *rules;
+	GPtrArray *prologue;
+	GSList *players;
+	int master_fd;
+	int slave_fd;
+	int listen_fd;
+	guint listen_watch;
+	GAtServer *server;
+	GAtIO *io;
+	GByteArray *outq;
+	guint8 qmi_client[256];		/* Last client seen per service */
+};
+
+static void sim_step_free(gpointer data)
+{
+	struct sim_step *step = data;
+
+	g_free(step->text);
+	g_free(step->data);
+	g_free(step);
+}
+
+static void sim_rule_free(gpointer data)
+{
+	struct sim_rule *rule = data;
+
+	g_ptr_array_free(rule->blocks, TRUE);
+	g_free(rule);
+}
+
+static void block_free(gpointer data)
+{
+	g_ptr_array_free(data, TRUE);
+}
+
+/* Uppercases the prefix and drops blanks outside of strings */
+static char *normalize_at(const char *req)
+{
+	GString *str = g_string_new(NULL);
+	gboolean in_string = FALSE;
+	gboolean in_prefix = TRUE;
+
+	if (g_ascii_strncasecmp(req, "AT", 2) == 0)
+		req += 2;
+
+	for (; *req; req++) {
+		if (*req == '"')
+			in_string = !in_string;
+
+		if (in_string == FALSE && (*req == ' ' || *req == '\t'))
+			continue;
+
+		if (*req == '=' || *req == '?')
+			in_prefix = FALSE;
+
+		g_string_append_c(str, in_prefix ? g_ascii_toupper(*req) :
+							*req);
+	}
+
+	return g_string_free(str, FALSE);
+}
+
+static gboolean parse_id(const char *str, guint16 *service,
+					guint16 *message, const char **end)
+{
+	char *p;
+	unsigned long svc, msg;
+
+	svc = strtoul(str, &p, 0);
+	if (*p != ':' || svc > 255)
+		return FALSE;
+
+	msg = strtoul(p + 1, &p, 0);
+	if (msg > 0xffff)
+		return FALSE;
+
+	*service = svc;
+	*message = msg;
+
+	if (end)
+		*end = p;
+
+	return TRUE;
+}
+
+static char *request_key(struct modem_sim *sim, const char *req)
+{
+	guint16 service, message;
+	char *end;
+	unsigned long num;
+
+	switch (sim->transport) {
+	case MODEM_SIM_AT:
+		return normalize_at(req);
+	case MODEM_SIM_RIL:
+		num = strtoul(req, &end, 0);
+		if (*end != '\0')
+			return NULL;
+
+		return g_strdup_printf("%lu", num);
+	case MODEM_SIM_QMI:
+		if (parse_id(req, &service, &message, (const char **) &end)
+					== FALSE || *end != '\0')
+			return NULL;
+
+		return g_strdup_printf("%u:%u", service, message);
+	}
+
+	return NULL;
+}
+
+static gboolean parse_step(struct modem_sim *sim, struct sim_step *step,
+				const char *arg)
+{
+	const char *hex = arg;
+	char *end;
+
+	if (step->kind == '=') {
+		step->delay = strtol(arg, &end, 10);
+		return *end == '\0' && step->delay >= 0;
+	}
+
+	step->text = g_strdup(arg);
+
+	if (sim->transport == MODEM_SIM_AT)
+		return TRUE;
+
+	if (sim->transport == MODEM_SIM_QMI && step->kind == '!') {
+		if (parse_id(arg, &step->service, &step->message, &hex)
+								== FALSE)
+			return FALSE;
+
+		while (*hex == ' ' || *hex == '\t')
+			hex++;
+	}
+
+	if (*hex == '\0') {
+		step->data = g_new0(unsigned char, 1);
+		return TRUE;
+	}
+
+	step->data = decode_hex(hex, -1, &step->len, 0);
+
+	return step->data != NULL;
+}
+
+int modem_sim_load(struct modem_sim *sim, const char *name, const char *data)
+{
+	char **lines = g_strsplit(data, "\n", -1);
+	GPtrArray *block = sim->prologue;
+	int err = 0;
+	int i;
+
+	for (i = 0; lines[i]; i++) {
+		char *line = g_strstrip(lines[i]);
+		struct sim_step *step;
+		struct sim_rule *rule;
+		char *key;
+
+		if (line[0] == '\0' || line[0] == '#')
+			continue;
+
+		if (line[1] != ' ' && line[1] != '\0')
+			goto error;
+
+		if (line[0] == '>') {
+			key = request_key(sim, g_strstrip(line + 1));
+			if (key == NULL)
+				goto error;
+
+			rule = g_hash_table_lookup(sim->rules, key);
+			if (rule == NULL) {
+				rule = g_new0(struct sim_rule, 1);
+				rule->blocks = g_ptr_array_new_with_free_func(
+								block_free);
+				g_hash_table_insert(sim->rules, key, rule);
+			} else
+				g_free(key);
+
+			block = g_ptr_array_new_with_free_func(sim_step_free);
+			g_ptr_array_add(rule->blocks, block);
+			continue;
+		}
+
+		if (line[0] != '<' && line[0] != '!' && line[0] != '=')
+			goto error;
+
+		if (line[0] == '<' && block == sim->prologue)
+			goto error;
+
+		step = g_new0(struct sim_step, 1);
+		step->kind = line[0];
+
+		if (parse_step(sim, step, g_strstrip(line + 1)) == FALSE) {
+			sim_step_free(step);
+			goto error;
+		}
+
+		g_ptr_array_add(block, step);
+		continue;
+
+error:
+		g_printerr("%s:%d: invalid line\n", name, i + 1);
+		err = -EINVAL;
+		break;
+	}
+
+	g_strfreev(lines);
+
+	return err;
+}
+
+int modem_sim_load_file(struct modem_sim *sim, const char *filename)
+{
+	GError *error = NULL;
+	char *data;
+	int err;
+
+	if (g_file_get_contents(filename, &data, NULL, &error) == FALSE) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return -EIO;
+	}
+
+	err = modem_sim_load(sim, filename, data);
+	g_free(data);
+
+	return err;
+}
+
+static void queue_bytes(struct modem_sim *sim, const void *data, gsize len)
+{
+	if (sim->io == NULL)
+		return;
+
+	g_byte_array_append(sim->outq, data, len);
+}
+
+static gboolean can_write_data(gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+	gsize written;
+
+	if (sim->outq->len == 0)
+		return FALSE;
+
+	written = g_at_io_write(sim->io, (gchar *) sim->outq->data,
+					sim->outq->len);
+	g_byte_array_remove_range(sim->outq, 0, written);
+
+	return sim->outq->len > 0;
+}
+
+static void wakeup_writer(struct modem_sim *sim)
+{
+	if (sim->io && sim->outq->len > 0)
+		g_at_io_set_write_handler(sim->io, can_write_data, sim);
+}
+
+static void put_le16(unsigned char *p, guint16 val)
+{
+	p[0] = val & 0xff;
+	p[1] = val >> 8;
+}
+
+static guint16 get_le16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static void ril_send(struct modem_sim *sim, guint32 type, guint32 *serial,
+				const unsigned char *data, long len)
+{
+	guint32 hdr[3];
+	int n = 0;
+
+	hdr[n++] = htonl(4 + (serial ? 4 : 0) + len);
+	hdr[n++] = type;
+
+	if (serial)
+		hdr[n++] = *serial;
+
+	queue_bytes(sim, hdr, n * 4);
+	queue_bytes(sim, data, len);
+}
+
+static void qmi_send(struct modem_sim *sim, guint8 service, guint8 client,
+			guint8 type, guint16 transaction, guint16 message,
+			const unsigned char *tlv, long len)
+{
+	unsigned char hdr[QMI_MUX_HDR_SIZE + QMI_SERVICE_HDR_SIZE +
+				QMI_MESSAGE_HDR_SIZE];
+	unsigned char *p = hdr + QMI_MUX_HDR_SIZE;
+	unsigned int hlen;
+
+	if (service == 0) {
+		*p++ = type;
+		*p++ = transaction;
+	} else {
+		*p++ = type;
+		put_le16(p, transaction);
+		p += 2;
+	}
+
+	put_le16(p, message);
+	put_le16(p + 2, len);
+	p += QMI_MESSAGE_HDR_SIZE;
+
+	hlen = p - hdr;
+
+	hdr[0] = 0x01;
+	put_le16(hdr + 1, hlen - 1 + len);
+	hdr[3] = 0x80;
+	hdr[4] = service;
+	hdr[5] = client;
+
+	queue_bytes(sim, hdr, hlen);
+	queue_bytes(sim, tlv, len);
+}
+
+static gboolean is_final(const char *line)
+{
+	static const char *finals[] = { "OK", "ERROR", "NO CARRIER", "BUSY",
+					"NO ANSWER", "NO DIALTONE", NULL };
+	int i;
+
+	for (i = 0; finals[i]; i++)
+		if (g_str_equal(line, finals[i]))
+			return TRUE;
+
+	return g_str_has_prefix(line, "+CME ERROR:") ||
+		g_str_has_prefix(line, "+CMS ERROR:");
+}
+
+static GAtServerResult final_result(const char *line)
+{
+	if (g_str_equal(line, "OK"))
+		return G_AT_SERVER_RESULT_OK;
+	else if (g_str_equal(line, "ERROR"))
+		return G_AT_SERVER_RESULT_ERROR;
+	else if (g_str_equal(line, "NO CARRIER"))
+		return G_AT_SERVER_RESULT_NO_CARRIER;
+	else if (g_str_equal(line, "BUSY"))
+		return G_AT_SERVER_RESULT_BUSY;
+	else if (g_str_equal(line, "NO ANSWER"))
+		return G_AT_SERVER_RESULT_NO_ANSWER;
+	else if (g_str_equal(line, "NO DIALTONE"))
+		return G_AT_SERVER_RESULT_NO_DIALTONE;
+
+	return G_AT_SERVER_RESULT_EXT_ERROR;
+}
+
+static void play_at(struct sim_player *player, struct sim_step *step)
+{
+	GAtServer *server = player->sim->server;
+	GAtServerResult result;
+
+	if (server == NULL)
+		return;
+
+	if (step->kind == '!' || player->final_sent) {
+		g_at_server_send_unsolicited(server, step->text);
+		return;
+	}
+
+	if (is_final(step->text) == FALSE) {
+		g_at_server_send_info(server, step->text, TRUE);
+		return;
+	}
+
+	player->final_sent = TRUE;
+	result = final_result(step->text);
+
+	if (result == G_AT_SERVER_RESULT_EXT_ERROR)
+		g_at_server_send_ext_final(server, step->text);
+	else
+		g_at_server_send_final(server, result);
+}
+
+static void play_step(struct sim_player *player, struct sim_step *step)
+{
+	struct modem_sim *sim = player->sim;
+
+	switch (sim->transport) {
+	case MODEM_SIM_AT:
+		play_at(player, step);
+		break;
+	case MODEM_SIM_RIL:
+		if (step->kind == '<')
+			ril_send(sim, RIL_RESPONSE_SOLICITED, &player->serial,
+					step->data, step->len);
+		else
+			ril_send(sim, RIL_RESPONSE_UNSOLICITED, NULL,
+					step->data, step->len);
+		break;
+	case MODEM_SIM_QMI:
+		if (step->kind == '<')
+			qmi_send(sim, player->service, player->client,
+					player->service ? 0x02 : 0x01,
+					player->transaction, player->message,
+					step->data, step->len);
+		else
+			qmi_send(sim, step->service,
+					sim->qmi_client[step->service & 0xff],
+					step->service ? 0x04 : 0x02,
+					0, step->message, step->data,
+					step->len);
+		break;
+	}
+}
+
+static gboolean player_resume(gpointer user_data);
+
+static void player_run(struct sim_player *player)
+{
+	struct modem_sim *sim = player->sim;
+
+	while (player->pos < player->steps->len) {
+		struct sim_step *step;
+
+		step = g_ptr_array_index(player->steps, player->pos++);
+
+		if (step->kind == '=' && step->delay > 0 && sim->speed > 0) {
+			player->source = g_timeout_add(step->delay / sim->speed,
+							player_resume, player);
+			wakeup_writer(sim);
+			return;
+		}
+
+		if (step->kind != '=')
+			play_step(player, step);
+	}
+
+	/* A command must get a final result, even if none was recorded */
+	if (sim->transport == MODEM_SIM_AT && player->final_sent == FALSE &&
+			player->steps != sim->prologue)
+		g_at_server_send_final(sim->server, G_AT_SERVER_RESULT_OK);
+
+	wakeup_writer(sim);
+
+	sim->players = g_slist_remove(sim->players, player);
+	g_free(player);
+}
+
+static gboolean player_resume(gpointer user_data)
+{
+	struct sim_player *player = user_data;
+
+	player->source = 0;
+	player_run(player);
+
+	return FALSE;
+}
+
+static struct sim_player *play(struct modem_sim *sim, GPtrArray *steps)
+{
+	struct sim_player *player = g_new0(struct sim_player, 1);
+
+	player->sim = sim;
+	player->steps = steps;
+	sim->players = g_slist_prepend(sim->players, player);
+
+	return player;
+}
+
+static GPtrArray *next_block(struct modem_sim *sim, const char *key)
+{
+	struct sim_rule *rule = g_hash_table_lookup(sim->rules, key);
+	GPtrArray *block;
+
+	if (rule == NULL)
+		return NULL;
+
+	block = g_ptr_array_index(rule->blocks, rule->next);
+	rule->next = (rule->next + 1) % rule->blocks->len;
+
+	return block;
+}
+
+static void stop_players(struct modem_sim *sim)
+{
+	GSList *l;
+
+	for (l = sim->players; l; l = l->next) {
+		struct sim_player *player = l->data;
+
+		if (player->source)
+			g_source_remove(player->source);
+
+		g_free(player);
+	}
+
+	g_slist_free(sim->players);
+	sim->players = NULL;
+}
+
+struct at_prefix {
+	struct modem_sim *sim;
+	char *prefix;
+};
+
+static void at_prefix_free(gpointer data)
+{
+	struct at_prefix *at = data;
+
+	g_free(at->prefix);
+	g_free(at);
+}
+
+static void at_request(GAtServer *server, GAtServerRequestType type,
+				GAtResult *result, gpointer user_data)
+{
+	struct at_prefix *at = user_data;
+	struct modem_sim *sim = at->sim;
+	const char *args = result->lines->data;
+	GPtrArray *block;
+	char *key;
+
+	switch (type) {
+	case G_AT_SERVER_REQUEST_TYPE_COMMAND_ONLY:
+		key = g_strdup(at->prefix);
+		break;
+	case G_AT_SERVER_REQUEST_TYPE_QUERY:
+		key = g_strconcat(at->prefix, "?", NULL);
+		break;
+	case G_AT_SERVER_REQUEST_TYPE_SUPPORT:
+		key = g_strconcat(at->prefix, "=?", NULL);
+		break;
+	default:
+		key = g_strconcat(at->prefix, "=", args, NULL);
+		break;
+	}
+
+	block = next_block(sim, key);
+	if (block == NULL)
+		block = next_block(sim, at->prefix);
+
+	if (sim->debug)
+		g_print("%s %s\n", block ? "play" : "unknown", key);
+
+	g_free(key);
+
+	if (block == NULL) {
+		g_at_server_send_final(server, G_AT_SERVER_RESULT_ERROR);
+		return;
+	}
+
+	player_run(play(sim, block));
+}
+
+static void at_debug(const char *str, gpointer user_data)
+{
+	g_print("%s: %s\n", (char *) user_data, str);
+}
+
+static void register_prefix(gpointer key, gpointer value, gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+	struct at_prefix *at;
+	const char *cmd = key;
+	gsize len = strcspn(cmd, "=?");
+
+	if (len < 2)
+		return;
+
+	at = g_new0(struct at_prefix, 1);
+	at->sim = sim;
+	at->prefix = g_strndup(cmd, len);
+
+	g_at_server_register(sim->server, at->prefix, at_request, at,
+							at_prefix_free);
+}
+
+static int open_pty(struct modem_sim *sim)
+{
+	struct termios ti;
+	char name[PATH_MAX];
+
+	if (openpty(&sim->master_fd, &sim->slave_fd, name, NULL, NULL) < 0)
+		return -errno;
+
+	/* Keep the slave open, the master hangs up when it is closed */
+	tcgetattr(sim->slave_fd, &ti);
+	cfmakeraw(&ti);
+	tcsetattr(sim->slave_fd, TCSANOW, &ti);
+
+	fcntl(sim->master_fd, F_SETFL,
+			fcntl(sim->master_fd, F_GETFL) | O_NONBLOCK);
+
+	unlink(sim->path);
+
+	if (symlink(name, sim->path) < 0)
+		return -errno;
+
+	g_print("%s is %s\n", sim->path, name);
+
+	return 0;
+}
+
+static int start_at(struct modem_sim *sim)
+{
+	GIOChannel *io;
+	int err;
+
+	err = open_pty(sim);
+	if (err < 0)
+		return err;
+
+	io = g_io_channel_unix_new(sim->master_fd);
+	g_io_channel_set_close_on_unref(io, TRUE);
+	sim->master_fd = -1;
+
+	sim->server = g_at_server_new(io);
+	g_io_channel_unref(io);
+
+	if (sim->server == NULL)
+		return -ENOMEM;
+
+	g_at_server_set_echo(sim->server, FALSE);
+
+	if (sim->debug)
+		g_at_server_set_debug(sim->server, at_debug, "Sim");
+
+	g_hash_table_foreach(sim->rules, register_prefix, sim);
+
+	return 0;
+}
+
+static void ril_request(struct modem_sim *sim, const unsigned char *buf,
+							guint32 len)
+{
+	struct sim_player *player;
+	GPtrArray *block;
+	guint32 request;
+	char key[16];
+
+	if (len < 8)
+		return;
+
+	memcpy(&request, buf, 4);
+	snprintf(key, sizeof(key), "%u", request);
+
+	block = next_block(sim, key);
+
+	if (sim->debug)
+		g_print("%s RIL request %s\n", block ? "play" : "unknown", key);
+
+	if (block == NULL)
+		return;
+
+	player = play(sim, block);
+	memcpy(&player->serial, buf + 4, 4);
+	player_run(player);
+}
+
+static void ril_read(struct ring_buffer *rbuf, gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+	unsigned int len = ring_buffer_len(rbuf);
+	unsigned char *buf = ring_buffer_read_ptr(rbuf, 0);
+	guint32 plen;
+
+	while (len >= 4) {
+		plen = ntohl(*(guint32 *) buf);
+
+		if (plen > RIL_MAX_PARCEL) {
+			ring_buffer_drain(rbuf, len);
+			return;
+		}
+
+		if (len < plen + 4)
+			break;
+
+		ril_request(sim, buf + 4, plen);
+
+		ring_buffer_drain(rbuf, plen + 4);
+		buf += plen + 4;
+		len -= plen + 4;
+	}
+}
+
+static void qmi_request(struct modem_sim *sim, const unsigned char *buf,
+							guint16 len)
+{
+	struct sim_player *player;
+	GPtrArray *block;
+	guint8 service = buf[4];
+	guint16 transaction;
+	unsigned int offset;
+	char key[16];
+
+	if (service == 0) {
+		offset = QMI_MUX_HDR_SIZE + QMI_CONTROL_HDR_SIZE;
+		transaction = buf[QMI_MUX_HDR_SIZE + 1];
+	} else {
+		offset = QMI_MUX_HDR_SIZE + QMI_SERVICE_HDR_SIZE;
+		transaction = get_le16(buf + QMI_MUX_HDR_SIZE + 1);
+	}
+
+	if (len < offset + QMI_MESSAGE_HDR_SIZE)
+		return;
+
+	sim->qmi_client[service] = buf[5];
+
+	snprintf(key, sizeof(key), "%u:%u", service, get_le16(buf + offset));
+
+	block = next_block(sim, key);
+
+	if (sim->debug)
+		g_print("%s QMI request %s\n", block ? "play" : "unknown", key);
+
+	if (block == NULL)
+		return;
+
+	player = play(sim, block);
+	player->service = service;
+	player->client = buf[5];
+	player->transaction = transaction;
+	player->message = get_le16(buf + offset);
+	player_run(player);
+}
+
+static void qmi_read(struct ring_buffer *rbuf, gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+	unsigned int len = ring_buffer_len(rbuf);
+	unsigned char *buf = ring_buffer_read_ptr(rbuf, 0);
+	guint16 plen;
+
+	while (len >= QMI_MUX_HDR_SIZE) {
+		/* Resynchronize on the next frame marker */
+		if (buf[0] != 0x01) {
+			ring_buffer_drain(rbuf, 1);
+			buf += 1;
+			len -= 1;
+			continue;
+		}
+
+		plen = get_le16(buf + 1) + 1;
+		if (len < plen)
+			break;
+
+		if (plen >= QMI_MUX_HDR_SIZE)
+			qmi_request(sim, buf, plen);
+
+		ring_buffer_drain(rbuf, plen);
+		buf += plen;
+		len -= plen;
+	}
+}
+
+static void io_disconnect(gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+
+	g_print("Client disconnected\n");
+
+	stop_players(sim);
+	g_byte_array_set_size(sim->outq, 0);
+
+	g_at_io_unref(sim->io);
+	sim->io = NULL;
+}
+
+static void attach_io(struct modem_sim *sim, int fd, GAtIOReadFunc func)
+{
+	GIOChannel *io = g_io_channel_unix_new(fd);
+
+	g_io_channel_set_close_on_unref(io, TRUE);
+	g_io_channel_set_encoding(io, NULL, NULL);
+	g_io_channel_set_buffered(io, FALSE);
+
+	sim->io = g_at_io_new(io);
+	g_io_channel_unref(io);
+
+	g_at_io_set_read_handler(sim->io, func, sim);
+	g_at_io_set_disconnect_function(sim->io, io_disconnect, sim);
+}
+
+static gboolean ril_connected(GIOChannel *chan, GIOCondition cond,
+							gpointer user_data)
+{
+	struct modem_sim *sim = user_data;
+	int fd;
+
+	if (cond & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+		sim->listen_watch = 0;
+		return FALSE;
+	}
+
+	fd = accept4(sim->listen_fd, NULL, NULL, SOCK_NONBLOCK);
+	if (fd < 0)
+		return TRUE;
+
+	/* One rild client at a time, like the real one */
+	if (sim->io) {
+		close(fd);
+		return TRUE;
+	}
+
+	g_print("Client connected\n");
+
+	attach_io(sim, fd, ril_read);
+
+	player_run(play(sim, sim->prologue));
+
+	return TRUE;
+}
+
+static int start_ril(struct modem_sim *sim)
+{
+	struct sockaddr_un addr;
+	GIOChannel *io;
+
+	sim->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sim->listen_fd < 0)
+		return -errno;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, sim->path, sizeof(addr.sun_path) - 1);
+
+	unlink(sim->path);
+
+	if (bind(sim->listen_fd, (struct sockaddr *) &addr,
+					sizeof(addr)) < 0 ||
+			listen(sim->listen_fd, 1) < 0)
+		return -errno;
+
+	io = g_io_channel_unix_new(sim->listen_fd);
+	sim->listen_watch = g_io_add_watch(io,
+				G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+				ril_connected, sim);
+	g_io_channel_unref(io);
+
+	g_print("Listening on %s\n", sim->path);
+
+	return 0;
+}
+
+static int start_qmi(struct modem_sim *sim)
+{
+	int err;
+
+	err = open_pty(sim);
+	if (err < 0)
+		return err;
+
+	attach_io(sim, sim->master_fd, qmi_read);
+	sim->master_fd = -1;
+
+	return 0;
+}
+
+struct modem_sim *modem_sim_new(enum modem_sim_transport transport,
+					const char *path, double speed)
+{
+	struct modem_sim *sim;
+
+	sim = g_new0(struct modem_sim, 1);
+	sim->transport = transport;
+	sim->path = g_strdup(path);
+	sim->speed = speed;
+	sim->master_fd = -1;
+	sim->slave_fd = -1;
+	sim->listen_fd = -1;
+	sim->rules = g_hash_table_new_full(g_str_hash, g_str_equal,
+						g_free, sim_rule_free);
+	sim->prologue = g_ptr_array_new_with_free_func(sim_step_free);
+	sim->outq = g_byte_array_new();
+
+	return sim;
+}
+
+void modem_sim_free(struct modem_sim *sim)
+{
+	if (sim == NULL)
+		return;
+
+	stop_players(sim);
+
+	if (sim->server)
+		g_at_server_unref(sim->server);
+
+	if (sim->io)
+		g_at_io_unref(sim->io);
+
+	if (sim->listen_watch)
+		g_source_remove(sim->listen_watch);
+
+	if (sim->listen_fd >= 0)
+		close(sim->listen_fd);
+
+	if (sim->master_fd >= 0)
+		close(sim->master_fd);
+
+	if (sim->slave_fd >= 0)
+		close(sim->slave_fd);
+
+	if (sim->transport != MODEM_SIM_AT || sim->server)
+		unlink(sim->path);
+
+	g_hash_table_destroy(sim->rules);
+	g_ptr_array_free(sim->prologue, TRUE);
+	g_byte_array_free(sim->outq, TRUE);
+	g_free(sim->path);
+	g_free(sim);
+}
+
+void modem_sim_set_debug(struct modem_sim *sim, gboolean debug)
+{
+	sim->debug = debug;
+}
+
+int modem_sim_start(struct modem_sim *sim)
+{
+	int err = -EINVAL;
+
+	switch (sim->transport) {
+	case MODEM_SIM_AT:
+		err = start_at(sim);
+		break;
+	case MODEM_SIM_RIL:
+		/* The prologue is played when rild gets its client */
+		return start_ril(sim);
+	case MODEM_SIM_QMI:
+		err = start_qmi(sim);
+		break;
+	}
+
+	if (err < 0)
+		return err;
+
+	player_run(play(sim, sim->prologue));
+
+	return 0;
+}
+
+GAtServer *modem_sim_get_server(struct modem_sim *sim)
+{
+	return sim->server;
+}
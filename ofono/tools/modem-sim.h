@@ -0,0 +1,68 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Replays a recorded modem session to a real ofonod.  A session is a text
+ * file with one step per line:
+ *
+ *   # comment
+ *   > REQUEST	a request from ofonod, starts a new block
+ *   < LINE	a response to the request
+ *   ! LINE	an unsolicited message
+ *   = MS	wait MS milliseconds, divided by the speed factor
+ *
+ * Blocks recorded for the same request are played in turn, starting over
+ * after the last one.  Steps before the first request are played once the
+ * session starts.
+ *
+ * AT:	REQUEST is the extended command as sent, without "AT", e.g. +CPIN?
+ *	or +CFUN=1.  A bare prefix such as +COPS matches any form of the
+ *	command that has no block of its own.  The last response line that
+ *	is a final result ends the command, OK is sent if there is none.
+ * RIL:	REQUEST is the request number.  A response is the hex dump of the
+ *	parcel after the serial, i.e. the error code and the data.  An
+ *	unsolicited message is the hex dump after the parcel type.
+ * QMI:	REQUEST is SERVICE:MESSAGE.  A response is the hex dump of the TLVs.
+ *	An unsolicited message is SERVICE:MESSAGE followed by its TLVs.
+ */
+
+enum modem_sim_transport {
+	MODEM_SIM_AT,		/* GAtServer on a pty */
+	MODEM_SIM_RIL,		/* rild command socket */
+	MODEM_SIM_QMI,		/* QMUX on a pty */
+};
+
+struct modem_sim;
+
+struct modem_sim *modem_sim_new(enum modem_sim_transport transport,
+					const char *path, double speed);
+void modem_sim_free(struct modem_sim *sim);
+
+int modem_sim_load(struct modem_sim *sim, const char *name,
+					const char *data);
+int modem_sim_load_file(struct modem_sim *sim, const char *filename);
+
+void modem_sim_set_debug(struct modem_sim *sim, gboolean debug);
+
+int modem_sim_start(struct modem_sim *sim);
+
+/* Only set for MODEM_SIM_AT, e.g. to register handlers of your own */
+GAtServer *modem_sim_get_server(struct modem_sim *sim);
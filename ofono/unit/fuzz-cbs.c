@@ -0,0 +1,78 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "util.h"
+#include "smsutil.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("gsm7-lang", "011000320111C2327BFC76BBCBEE46A3D16834"
+			"1A8D46A3D168341A8D46A3D168341A8D46A3D168341A8D46A3D1"
+			"68341A8D46A3D168341A8D46A3D168341A8D46A3D168341A8D46"
+			"A3D168341A8D46A3D168341A8D46A3D100"),
+	FUZZ_SEED_HEX("gsm7-iso639", "0110003201114679785E96371A8D46A3D16834"
+			"1A8D46A3D168341A8D46A3D168341A8D46A3D168341A8D46A3D1"
+			"68341A8D46A3D168341A8D46A3D168341A8D46A3D168341A8D46"
+			"A3D168341A8D46A3D168341A8D46A3D100"),
+	FUZZ_SEED_HEX("gsm7-long", "001000000111E280604028180E888462C16838"
+			"1E90886442A9582E988C66C3E9783EA09068442A994EA8946AC5"
+			"6AB95EB0986C46ABD96EB89C6EC7EBF97EC0A070482C1A8FC8A4"
+			"72C96C3A9FD0A8744AAD5AAFD8AC76CB05"),
+	{ }
+};
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct sms_udh_iter iter;
+	struct cbs cbs;
+	char iso639_lang[3];
+	GSList *list;
+	char *utf8;
+
+	if (cbs_decode(data, size, &cbs) == FALSE)
+		return 0;
+
+	if (sms_udh_iter_init_from_cbs(&cbs, &iter)) {
+		while (sms_udh_iter_get_ie_type(&iter) !=
+						SMS_IEI_INVALID) {
+			unsigned char ie[256];
+
+			sms_udh_iter_get_ie_data(&iter, ie);
+			sms_udh_iter_next(&iter);
+		}
+	}
+
+	list = g_slist_prepend(NULL, &cbs);
+
+	utf8 = cbs_decode_text(list, iso639_lang);
+	g_free(utf8);
+
+	g_slist_free(list);
+
+	return 0;
+}
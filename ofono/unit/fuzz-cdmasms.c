@@ -0,0 +1,64 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "cdma-smsutil.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("wmt-deliver-1", "0000021002020501C48D159C080D00031BEE"
+			"F00106102C8CBB366F"),
+	FUZZ_SEED_HEX("wmt-deliver-2", "0000021002020702A1625155A64008180003"
+			"100040010610254CBCFA0003060308201343120D0101"),
+	{ }
+};
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct cdma_sms s;
+	char *text;
+
+	if (size > 255)
+		return 0;
+
+	memset(&s, 0, sizeof(s));
+
+	if (cdma_sms_decode(data, size, &s) == FALSE)
+		return 0;
+
+	cdma_sms_address_to_string(&s.p2p_msg.oaddr);
+
+	if (s.p2p_msg.teleservice_id != CDMA_SMS_TELESERVICE_ID_WMT)
+		return 0;
+
+	text = cdma_sms_decode_text(&s.p2p_msg.bd.wmt_deliver.ud);
+	g_free(text);
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "gsm0710.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("basic-open", "F9073F01DEF9"),
+	FUZZ_SEED_HEX("basic-data", "FFFFFFFFF907EF07123456D3F907EF07"
+			"123456D3F9"),
+	FUZZ_SEED_HEX("basic-long", "F907EF1001123456789ABCDEF0123456789ABC"
+			"DEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0"
+			"123456789ABCDEF0123456789ABCDEF0123456789ABCDEF01234"
+			"56789ABCDEF0123456789ABCDEF0123456789ABCDEF012345678"
+			"9ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABC"
+			"DEF0123456789ABCDEF0123456789ABCDEF088F9"),
+	FUZZ_SEED_HEX("advanced-open", "7E073F897E"),
+	FUZZ_SEED_HEX("advanced-data", "FFFFFF7E07EF123456057E07EF123456057E"),
+	FUZZ_SEED_HEX("advanced-escaped", "7E07EF7D5E7D5D057E"),
+	{ }
+};
+
+typedef int (*extract_func)(guint8 *data, int len,
+					guint8 *out_dlc, guint8 *out_type,
+					guint8 **frame, int *out_len);
+
+static unsigned int extract_all(extract_func extract,
+					const uint8_t *data, size_t size)
+{
+	/* The extractors unquote frames in place */
+	guint8 *buf = g_memdup(data, size);
+	unsigned int sum = 0;
+	int posn = 0;
+
+	while (posn < (int) size) {
+		guint8 dlc, type;
+		guint8 *frame = NULL;
+		int frame_len = 0;
+		int nread;
+		int i;
+
+		nread = extract(buf + posn, size - posn, &dlc, &type,
+							&frame, &frame_len);
+		if (nread <= 0)
+			break;
+
+		posn += nread;
+
+		if (frame == NULL)
+			continue;
+
+		for (i = 0; i < frame_len; i++)
+			sum += frame[i];
+
+		sum += dlc + type;
+	}
+
+	g_free(buf);
+
+	return sum;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	if (size == 0 || size > 65536)
+		return 0;
+
+	extract_all(gsm0710_basic_extract_frame, data, size);
+	extract_all(gsm0710_advanced_extract_frame, data, size);
+
+	return 0;
+}
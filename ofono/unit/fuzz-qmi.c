@@ -0,0 +1,152 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* The frame parser and TLV helpers are static to the QMI transport */
+#include "../drivers/qmimodem/qmi.c"
+
+#include "fuzz.h"
+
+#define FUZZ_SERVICE_TYPE	QMI_SERVICE_NAS
+#define FUZZ_CLIENT_ID		0x01
+#define FUZZ_SEND_MESSAGE	0x0020
+#define FUZZ_NOTIFY_MESSAGE	0x0024
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("discover", "012D0080000001012100220002040000000000011000"
+			"0300010004000101000500030100020010050003312E3000"),
+	FUZZ_SEED_HEX("response", "011E0080030102000120001200020400000000001004"
+			"007856341211010001"),
+	FUZZ_SEED_HEX("indication", "012B0080030104000024001F000101000510020034"
+			"1211080001000000000000001208006F70657261746F72"),
+	FUZZ_SEED_HEX("broadcast", "0110008003FF0400002400040001010002"),
+	FUZZ_SEED_HEX("error", "0113008003010200012000070002040001001A00"),
+	FUZZ_SEED_HEX("session", "012D0080000001012100220002040000000000011000"
+			"0300010004000101000500030100020010050003312E3000011E"
+			"0080030102000120001200020400000000001004007856341211"
+			"010001012B0080030104000024001F0001010005100200341211"
+			"080001000000000000001208006F70657261746F72"),
+	{ }
+};
+
+static void debug_func(const char *str, void *user_data)
+{
+}
+
+static void discover_func(uint8_t count, const struct qmi_version *list,
+							void *user_data)
+{
+}
+
+static void result_func(struct qmi_result *result, void *user_data)
+{
+	uint16_t error;
+	uint8_t type;
+
+	qmi_result_set_error(result, &error);
+	qmi_result_get_error(result);
+
+	for (type = 0x01; type <= 0x12; type++) {
+		uint64_t val64;
+		uint32_t val32;
+		uint16_t val16;
+		uint8_t val8;
+		uint16_t len;
+
+		qmi_result_get(result, type, &len);
+		qmi_result_get_uint8(result, type, &val8);
+		qmi_result_get_uint16(result, type, &val16);
+		qmi_result_get_uint32(result, type, &val32);
+		qmi_result_get_uint64(result, type, &val64);
+		g_free(qmi_result_get_string(result, type));
+	}
+}
+
+static void cancel_discover(gpointer data, gpointer user_data)
+{
+	struct qmi_request *req = data;
+	struct discover_data *discover = req->user_data;
+
+	if (req->callback != discover_callback)
+		return;
+
+	g_source_remove(discover->timeout);
+	g_free(discover);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	static int fd = -1;
+	struct qmi_device *device;
+	struct qmi_service *service;
+	unsigned int hash_id;
+
+	if (size > 2048)
+		return 0;
+
+	if (fd < 0)
+		fd = open("/dev/null", O_RDWR);
+
+	device = qmi_device_new(fd);
+	if (!device)
+		return 0;
+
+	qmi_device_set_debug(device, debug_func, NULL);
+
+	/* A discovery on the control channel with transaction 1 */
+	qmi_device_discover(device, discover_func, NULL, NULL);
+
+	/* A service client with one request (transaction 256) pending */
+	service = g_new0(struct qmi_service, 1);
+	service->ref_count = 1;
+	service->device = device;
+	service->type = FUZZ_SERVICE_TYPE;
+	service->client_id = FUZZ_CLIENT_ID;
+
+	hash_id = service->type | (service->client_id << 8);
+	g_hash_table_replace(device->service_list,
+				GUINT_TO_POINTER(hash_id), service);
+
+	qmi_service_register(service, FUZZ_NOTIFY_MESSAGE, result_func,
+								NULL, NULL);
+	qmi_service_send(service, FUZZ_SEND_MESSAGE, NULL, result_func,
+								NULL, NULL);
+
+	/* Move the requests from the write queue to the pending queues */
+	while (can_write_data(NULL, G_IO_OUT, device) == TRUE)
+		;
+
+	received_frames(device, data, size);
+
+	qmi_service_cancel_all(service);
+	qmi_service_unregister_all(service);
+	g_hash_table_steal(device->service_list, GUINT_TO_POINTER(hash_id));
+	g_free(service);
+
+	g_queue_foreach(device->control_queue, cancel_discover, NULL);
+
+	qmi_device_unref(device);
+
+	return 0;
+}
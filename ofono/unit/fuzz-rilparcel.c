@@ -0,0 +1,111 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <ofono/types.h>
+
+#include "gril.h"
+#include "grilreply.h"
+#include "grilunsol.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("setup-data-call", "070000000100000000000000FFFFFFFF0000"
+			"0000020000000200000049005000000000000A00000072006D00"
+			"6E00650074005F00750073006200300000000000110000003100"
+			"30002E003100380031002E003200330035002E00310035003400"
+			"2F003300300000001D0000003100370032002E00310036002E00"
+			"3100340035002E0031003000330020003100370032002E003100"
+			"36002E003100340035002E0031003000330000000E0000003100"
+			"30002E003100380031002E003200330035002E00310035003300"
+			"00000000"),
+	FUZZ_SEED_HEX("setup-data-call-null-type", "070000000100000000000000FF"
+			"FFFFFF0000000002000000FFFFFFFF0A00000072006D006E0065"
+			"0074005F0075007300620030000000000011000000310030002E"
+			"003100380031002E003200330035002E003100350034002F0033"
+			"00300000001D0000003100370032002E00310036002E00310034"
+			"0035002E0031003000330020003100370032002E00310036002E"
+			"003100340035002E0031003000330000000E000000310030002E"
+			"003100380031002E003200330035002E00310035003300000000"
+			"00"),
+	FUZZ_SEED_HEX("data-call-list", "000000D401000000F203000007000000010000"
+			"0000000000FFFFFFFF0000000001000000020000004900500000"
+			"0000000A00000072006D006E00650074005F0075007300620030"
+			"000000000011000000310030002E003200300039002E00310031"
+			"0034002E003100300032002F003300300000001D000000310037"
+			"0032002E00310036002E003100340035002E0031003000330020"
+			"003100370032002E00310036002E003100340035002E00310030"
+			"00330000000E000000310030002E003200300039002E00310031"
+			"0034002E0031003000310000000000"),
+	{ }
+};
+
+static void walk_parcel(struct ril_msg *message, const uint8_t *data,
+								size_t size)
+{
+	struct parcel rilp;
+	size_t i;
+
+	g_ril_init_parcel(message, &rilp);
+
+	/* Let the input pick which of the readers to use at each step */
+	for (i = 0; rilp.malformed == 0 && parcel_data_avail(&rilp) > 0; i++) {
+		if (data[i % size] & 1)
+			g_free(parcel_r_string(&rilp));
+		else
+			parcel_r_int32(&rilp);
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct ril_msg message;
+	struct ofono_error error;
+	struct reply_setup_data_call *reply;
+	struct unsol_data_call_list *unsol;
+
+	if (size == 0 || size > 65536)
+		return 0;
+
+	memset(&message, 0, sizeof(message));
+	message.buf = g_memdup(data, size);
+	message.buf_len = size;
+
+	walk_parcel(&message, data, size);
+
+	reply = g_ril_reply_parse_data_call(NULL, &message, &error);
+	g_ril_reply_free_setup_data_call(reply);
+
+	unsol = g_ril_unsol_parse_data_call_list(NULL, &message, &error);
+	g_ril_unsol_free_data_call_list(unsol);
+
+	g_free(message.buf);
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "util.h"
+#include "smsutil.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("simple-deliver", "07911326040000F0040B911346610089F6"
+			"0000208062917314480CC8F71D14969741F977FD07"),
+	FUZZ_SEED_HEX("alnum-sender", "0791447758100650040DD0F334FC1CA697"
+			"0100008080312170224008D4F29CDE0EA7D9"),
+	FUZZ_SEED_HEX("simple-submit", "0011000B916407281553F80000AA0AE832"
+			"9BFD4697D9EC37"),
+	FUZZ_SEED_HEX("ems-submit", "0041000B915121551532F40000631A0A0319"
+			"06200A032104100A032705040A032E05080A043807002B8ACD29"
+			"A85D9ECFC3E7F21C340EBB41E3B79B1E4EBB41697A989D1EB340"
+			"E2379BCC02B1C3F27399059AB7C36C3628EC2683C66FF65B5E26"
+			"83E8653C1D"),
+	FUZZ_SEED_HEX("ems-deliver", "079194712272303351030B915121340195F6"
+			"0000FF80230A030F07230A031806130A031E0A430A032E0D830A"
+			"033D14020A035104F60A0355010600159D9E83D2735018442FCF"
+			"E98A243DCC4E97C92C90F8CD26B3407537B92C67A7DD65320B14"
+			"76934173BA3CBD2ED3D1F277FD8C76299CEF3B280C92A7CF683A"
+			"28CC4E9FDD6532E8FE96935D"),
+	FUZZ_SEED_HEX("ucs2-concat", "038121F340048155550119906041001222"
+			"044A0500031E0303043C043D043004420443002C0020043F043E"
+			"043704300431044B0432000A0434043004360435002C00200447"
+			"0442043E002000200431044B043B0020043D04300433002E"),
+	FUZZ_SEED_HEX("status-report", "06040D91945152991136F00160124130"
+			"340A0160124130940A00"),
+	FUZZ_SEED_HEX("status-report-short", "0606098121436587F90190124130"
+			"64A0019012413045A000"),
+	FUZZ_SEED_HEX("wap-push", "0791947122725014440185F039F50180114031"
+			"1480720605040B8423F00106246170706C69636174696F6E2F76"
+			"6E642E7761702E6D6D732D6D65737361676500AF84B4868C8298"
+			"4F67514B4B42008D9089088045726F74696B009650696E2D5570"
+			"73008A808E0240008805810303F48083687474703A2F2F657073"
+			"332E64652F4F2F5A39495A4F00"),
+	{ }
+};
+
+static void decode_text(struct sms *sms)
+{
+	struct sms_udh_iter iter;
+	GSList *list;
+	char *utf8;
+	int dst, src;
+	gboolean is_8bit;
+
+	if (sms_udh_iter_init(sms, &iter)) {
+		while (sms_udh_iter_get_ie_type(&iter) !=
+						SMS_IEI_INVALID) {
+			unsigned char data[256];
+
+			sms_udh_iter_get_ie_data(&iter, data);
+			sms_udh_iter_next(&iter);
+		}
+	}
+
+	sms_extract_app_port(sms, &dst, &src, &is_8bit);
+
+	list = g_slist_prepend(NULL, sms);
+
+	utf8 = sms_decode_text(list);
+	g_free(utf8);
+
+	g_slist_free(list);
+}
+
+static void decode(const uint8_t *data, size_t size, gboolean outgoing,
+								int tpdu_len)
+{
+	struct sms sms;
+
+	if (sms_decode(data, size, outgoing, tpdu_len, &sms) == FALSE)
+		return;
+
+	if (sms.type == SMS_TYPE_DELIVER || sms.type == SMS_TYPE_SUBMIT)
+		decode_text(&sms);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int tpdu_len;
+
+	if (size == 0 || size > 176)
+		return 0;
+
+	/* With an SMSC address, as +CMT and +CMGS use */
+	tpdu_len = size - data[0] - 1;
+
+	if (tpdu_len > 0) {
+		decode(data, size, FALSE, tpdu_len);
+		decode(data, size, TRUE, tpdu_len);
+	}
+
+	/* TPDU only, as in status report assembly */
+	decode(data, size, FALSE, size);
+	decode(data, size, TRUE, size);
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include <ofono/types.h>
+
+#include "smsutil.h"
+#include "stkutil.h"
+
+#include "fuzz.h"
+
+/* One proactive command of each kind from the test-stkutil vectors */
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("display-text-111", "D01A8103012180820281028D0F04546F6F6C"
+			"6B697420546573742031"),
+	FUZZ_SEED_HEX("display-text-511", "D01A8103012180820281028D0B0442617369"
+			"632049636F6E9E020001"),
+	FUZZ_SEED_HEX("display-text-611", "D0248103012180820281028D190804170414"
+			"0420041004120421042204120423041904220415"),
+	FUZZ_SEED_HEX("get-inkey-111", "D0158103012200820281828D0A04456E746572"
+			"20222B22"),
+	FUZZ_SEED_HEX("get-inkey-511", "D0158103012204820281828D0A04456E746572"
+			"20594553"),
+	FUZZ_SEED_HEX("get-input-111", "D01B8103012300820281828D0C04456E746572"
+			"20313233343591020505"),
+	FUZZ_SEED_HEX("get-input-511", "D0238103012300820281828D0C04456E746572"
+			"203132333435910205051706043132333435"),
+	FUZZ_SEED_HEX("more-time-111", "D009810301020082028182"),
+	FUZZ_SEED_HEX("play-tone-111", "D01B81030120008202810385094469616C2054"
+			"6F6E658E010184020105"),
+	FUZZ_SEED_HEX("play-tone-411", "D0288103012000820281038510546578742041"
+			"747472696275746520318E011184020101D004001000B4"),
+	FUZZ_SEED_HEX("poll-interval-111", "D00D81030103008202818284020114"),
+	FUZZ_SEED_HEX("setup-menu-111", "D03B810301250082028182850C546F6F6C6B69"
+			"74204D656E758F07014974656D20318F07024974656D20328F07"
+			"034974656D20338F07044974656D2034"),
+	FUZZ_SEED_HEX("select-item-111", "D03D810301240082028182850E546F6F6C6B"
+			"69742053656C6563748F07014974656D20318F07024974656D20"
+			"328F07034974656D20338F07044974656D2034"),
+	FUZZ_SEED_HEX("send-sms-111", "D037810301130082028183850753656E6420534D"
+			"86099111223344556677F88B180100099110325476F840F40C54"
+			"657374204D657373616765"),
+	FUZZ_SEED_HEX("send-ss-111", "D029810301110082028183850C43616C6C20466F"
+			"7277617264891091AA120A214365870921436587A901FB"),
+	FUZZ_SEED_HEX("send-ussd-111", "D050810301120082028183850A372D62697420"
+			"555353448A39F041E19058341E9149E592D9743EA151E9945AB5"
+			"5EB1596D2B2C1E93CBE6333AAD5EB3DBEE373C2E9FD3EBF63B3E"
+			"AF6FC564335ACD76C3E560"),
+	FUZZ_SEED_HEX("setup-call-111", "D01E81030110008202818385084E6F74206275"
+			"73798609911032042143651C2C"),
+	FUZZ_SEED_HEX("refresh-121", "D0108103010101820281829205013F002FE2"),
+	FUZZ_SEED_HEX("polling-off-112", "D009810301040082028182"),
+	FUZZ_SEED_HEX("provide-local-info-121", "D009810301260182028182"),
+	FUZZ_SEED_HEX("setup-event-list-111", "D00C810301050082028182990104"),
+	FUZZ_SEED_HEX("perform-card-apdu-111", "D012810301300082028111A207A0A4"
+			"0000023F00"),
+	FUZZ_SEED_HEX("get-reader-status-111", "D009810301330082028182"),
+	FUZZ_SEED_HEX("timer-mgmt-111", "D011810301270082028182A40101A5030050"
+			"00"),
+	FUZZ_SEED_HEX("setup-idle-mode-text-111", "D01A8103012800820281828D0F04"
+			"49646C65204D6F64652054657874"),
+	FUZZ_SEED_HEX("run-at-command-111", "D012810301340082028182A80741542B43"
+			"474D49"),
+	FUZZ_SEED_HEX("send-dtmf-111", "D00D810301140082028183AC02C1F2"),
+	FUZZ_SEED_HEX("language-notification-111", "D00D810301350182028182AD02"
+			"7365"),
+	FUZZ_SEED_HEX("launch-browser-111", "D0188103011500820281823100050B4465"
+			"6661756C742055524C"),
+	FUZZ_SEED_HEX("open-channel-211", "D03681030140018202818235070203040304"
+			"1F02390205780D08F4557365724C6F670D08F455736572507764"
+			"3C0301AD9C3E052101010101"),
+	FUZZ_SEED_HEX("close-channel-111", "D009810301410082028121"),
+	FUZZ_SEED_HEX("receive-data-111", "D00C810301420082028121B701C8"),
+	FUZZ_SEED_HEX("send-data-111", "D013810301430182028121B608000102030405"
+			"0607"),
+	FUZZ_SEED_HEX("get-channel-status-111", "D009810301440082028182"),
+	{ }
+};
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct stk_command *command;
+
+	command = stk_command_new_from_pdu(data, size);
+	if (command)
+		stk_command_free(command);
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gatsyntax.h"
+#include "gatresult.h"
+
+#include "fuzz.h"
+
+const struct fuzz_seed fuzz_seeds[] = {
+	FUZZ_SEED_HEX("ok", "0D0A4F4B0D0A"),
+	FUZZ_SEED_HEX("echo-ok", "41542B4350494E3F0D0D0A2B4350494E3A2052454144"
+			"590D0A0D0A4F4B0D0A"),
+	FUZZ_SEED_HEX("cops-list", "0D0A2B434F50533A2028322C224F70657261746F72"
+			"222C224F50222C223236323031222C32292C28312C224F746865"
+			"72222C224F54222C223236323032222C30292C2C28302D34292C"
+			"28302D32290D0A0D0A4F4B0D0A"),
+	FUZZ_SEED_HEX("cmt", "0D0A2B434D543A202C32330D0A3037393139343731323237"
+			"3233303333303430433931393437313232373233303333303030"
+			"303031353032303831313030303435303434314531393030380D"
+			"0A"),
+	FUZZ_SEED_HEX("cmgs-prompt", "0D0A3E20"),
+	FUZZ_SEED_HEX("clcc", "0D0A2B434C43433A20312C312C342C302C302C222B313535"
+			"3531323334353637222C3134350D0A0D0A2B4352494E473A2056"
+			"4F4943450D0A"),
+	FUZZ_SEED_HEX("error", "0D0A2B434D45204552524F523A2031300D0A"),
+	{ }
+};
+
+static void parse_line(char *line)
+{
+	GAtResult result;
+	GAtResultIter iter;
+	GSList l;
+	char *prefix = NULL;
+	char *colon;
+
+	l.data = line;
+	l.next = NULL;
+
+	result.lines = &l;
+	result.final_or_pdu = NULL;
+
+	colon = strchr(line, ':');
+	if (colon)
+		prefix = g_strndup(line, colon - line + 1);
+
+	g_at_result_iter_init(&iter, &result);
+
+	if (g_at_result_iter_next(&iter, prefix) == FALSE)
+		goto out;
+
+	/* Walk the fields with whichever getter accepts each one */
+	while (TRUE) {
+		unsigned int pos = iter.line_pos;
+		const guint8 *hex;
+		const char *str;
+		gint min, max;
+		gint len;
+
+		if (g_at_result_iter_open_list(&iter) ||
+				g_at_result_iter_close_list(&iter))
+			continue;
+
+		if (!g_at_result_iter_next_range(&iter, &min, &max) &&
+				!g_at_result_iter_next_string(&iter, &str) &&
+				!g_at_result_iter_next_hexstring(&iter,
+								&hex, &len))
+			g_at_result_iter_next_unquoted_string(&iter, &str);
+
+		if (iter.line_pos == pos &&
+				g_at_result_iter_skip_next(&iter) == FALSE)
+			break;
+	}
+
+out:
+	g_free(prefix);
+}
+
+static char *extract_line(const char *buf, gsize len)
+{
+	gboolean in_string = FALSE;
+	gsize start = 0;
+	gsize end;
+
+	while (start < len && (buf[start] == '\r' || buf[start] == '\n'))
+		start += 1;
+
+	for (end = start; end < len; end++) {
+		if (in_string == FALSE && (buf[end] == '\r' ||
+						buf[end] == '\n'))
+			break;
+
+		if (buf[end] == '"')
+			in_string = !in_string;
+	}
+
+	return g_strndup(buf + start, end - start);
+}
+
+static void feed_all(GAtSyntax *syntax, const char *buf, gsize size)
+{
+	while (size > 0) {
+		GAtSyntaxResult result;
+		gsize len = size;
+		char *line;
+
+		result = syntax->feed(syntax, buf, &len);
+
+		if (len > size)
+			abort();
+
+		buf += len;
+		size -= len;
+
+		switch (result) {
+		case G_AT_SYNTAX_RESULT_LINE:
+		case G_AT_SYNTAX_RESULT_MULTILINE:
+			line = extract_line(buf - len, len);
+
+			/* As GAtChat does for a +CMT style notifier */
+			if (g_str_has_prefix(line, "+CMT:") && syntax->set_hint)
+				syntax->set_hint(syntax,
+						G_AT_SYNTAX_EXPECT_PDU);
+
+			parse_line(line);
+			g_free(line);
+			break;
+		case G_AT_SYNTAX_RESULT_PDU:
+			line = extract_line(buf - len, len);
+			g_free(line);
+			break;
+		case G_AT_SYNTAX_RESULT_UNSURE:
+			/* Everything left is a partial line */
+			if (len == 0)
+				return;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	GAtSyntax *syntax;
+
+	if (size > 65536)
+		return 0;
+
+	syntax = g_at_syntax_new_gsmv1();
+	feed_all(syntax, (const char *) data, size);
+	g_at_syntax_unref(syntax);
+
+	syntax = g_at_syntax_new_gsm_permissive();
+	feed_all(syntax, (const char *) data, size);
+	g_at_syntax_unref(syntax);
+
+	return 0;
+}
@@ -0,0 +1,347 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifndef HAVE_LIBFUZZER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "util.h"
+#include "fuzz.h"
+
+struct input {
+	char *name;
+	unsigned char *data;
+	size_t len;
+};
+
+static gint option_iterations = 2000;
+static gint option_mutations = 500;
+static gint option_seed = 1;
+static gchar *option_dump;
+static gboolean option_quiet;
+
+static GOptionEntry options[] = {
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &option_iterations,
+				"Timed runs of each input", "N" },
+	{ "mutations", 'm', 0, G_OPTION_ARG_INT, &option_mutations,
+				"Mutated copies of each input", "N" },
+	{ "seed", 's', 0, G_OPTION_ARG_INT, &option_seed,
+				"Seed of the mutator", "N" },
+	{ "dump-corpus", 'd', 0, G_OPTION_ARG_FILENAME, &option_dump,
+				"Write the seeds to a libFuzzer corpus "
+				"directory and exit", "DIR" },
+	{ "quiet", 'q', 0, G_OPTION_ARG_NONE, &option_quiet,
+				"Only print the summary" },
+	{ NULL },
+};
+
+static guint32 rand_state;
+
+static guint32 next_rand(void)
+{
+	/* xorshift32, the same sequence on every host */
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static void add_input(GPtrArray *inputs, const char *name,
+				const unsigned char *data, size_t len)
+{
+	struct input *input = g_new0(struct input, 1);
+
+	input->name = g_strdup(name);
+	input->data = g_memdup(data, len);
+	input->len = len;
+
+	g_ptr_array_add(inputs, input);
+}
+
+static void input_free(gpointer data)
+{
+	struct input *input = data;
+
+	g_free(input->name);
+	g_free(input->data);
+	g_free(input);
+}
+
+static void add_seeds(GPtrArray *inputs)
+{
+	const struct fuzz_seed *seed;
+
+	for (seed = fuzz_seeds; seed->name; seed++) {
+		unsigned char *data;
+		long len;
+
+		data = decode_hex(seed->hex, -1, &len, 0);
+		if (data == NULL) {
+			g_printerr("Seed %s is not hex\n", seed->name);
+			exit(1);
+		}
+
+		add_input(inputs, seed->name, data, len);
+		g_free(data);
+	}
+}
+
+static void add_file(GPtrArray *inputs, const char *path)
+{
+	GError *error = NULL;
+	char *contents;
+	gsize len;
+
+	if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+		GDir *dir = g_dir_open(path, 0, &error);
+		const char *name;
+
+		if (dir == NULL)
+			goto error;
+
+		while ((name = g_dir_read_name(dir))) {
+			char *file = g_build_filename(path, name, NULL);
+
+			add_file(inputs, file);
+			g_free(file);
+		}
+
+		g_dir_close(dir);
+		return;
+	}
+
+	if (g_file_get_contents(path, &contents, &len, &error) == FALSE)
+		goto error;
+
+	add_input(inputs, path, (unsigned char *) contents, len);
+	g_free(contents);
+
+	return;
+
+error:
+	g_printerr("%s\n", error->message);
+	g_error_free(error);
+	exit(1);
+}
+
+static int dump_corpus(GPtrArray *inputs, const char *path)
+{
+	unsigned int i;
+
+	if (g_mkdir_with_parents(path, 0755) < 0) {
+		perror(path);
+		return 1;
+	}
+
+	for (i = 0; i < inputs->len; i++) {
+		struct input *input = g_ptr_array_index(inputs, i);
+		char *file = g_build_filename(path, input->name, NULL);
+		GError *error = NULL;
+
+		if (g_file_set_contents(file, (const char *) input->data,
+					input->len, &error) == FALSE) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+			g_free(file);
+			return 1;
+		}
+
+		g_free(file);
+	}
+
+	return 0;
+}
+
+static double run_timed(const struct input *input, int iterations)
+{
+	unsigned char *data = g_memdup(input->data, input->len);
+	GTimer *timer = g_timer_new();
+	double elapsed;
+	int i;
+
+	for (i = 0; i < iterations; i++)
+		LLVMFuzzerTestOneInput(data, input->len);
+
+	elapsed = g_timer_elapsed(timer, NULL);
+
+	g_timer_destroy(timer);
+	g_free(data);
+
+	return elapsed * 1e9 / iterations;
+}
+
+/*
+ * Length and count fields are the usual suspects, so besides flipping
+ * bits the mutator likes boundary values, truncation and repetition.
+ */
+static size_t mutate(unsigned char *buf, size_t len, size_t max)
+{
+	static const unsigned char interesting[] = {
+		0x00, 0x01, 0x7f, 0x80, 0xfe, 0xff
+	};
+	int ops = 1 + next_rand() % 4;
+	size_t pos, n;
+
+	while (ops--) {
+		pos = len ? next_rand() % len : 0;
+
+		switch (next_rand() % 6) {
+		case 0:
+			if (len)
+				buf[pos] ^= 1 << (next_rand() % 8);
+			break;
+		case 1:
+			if (len)
+				buf[pos] = next_rand();
+			break;
+		case 2:
+			if (len)
+				buf[pos] = interesting[next_rand() %
+						sizeof(interesting)];
+			break;
+		case 3:
+			len = len ? next_rand() % len : 0;
+			break;
+		case 4:
+			/* Repeat a chunk at the end */
+			n = MIN(next_rand() % 16, max - len);
+			n = MIN(n, len - pos);
+			memcpy(buf + len, buf + pos, n);
+			len += n;
+			break;
+		case 5:
+			n = MIN(next_rand() % 8, max - len);
+			while (n--)
+				buf[len++] = next_rand();
+			break;
+		}
+	}
+
+	return len;
+}
+
+static void run_mutated(const struct input *input, int mutations)
+{
+	size_t max = input->len + 64;
+	unsigned char *buf = g_malloc(max);
+	int i;
+
+	for (i = 0; i < mutations; i++) {
+		unsigned char *data;
+		size_t len;
+
+		memcpy(buf, input->data, input->len);
+		len = mutate(buf, input->len, max);
+
+		/* Exactly sized, so that overreads hit the redzone */
+		data = g_memdup(buf, len);
+		LLVMFuzzerTestOneInput(data, len);
+		g_free(data);
+	}
+
+	g_free(buf);
+}
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	GPtrArray *inputs;
+	char *name;
+	double total = 0;
+	unsigned int i;
+	int ret = 0;
+
+	context = g_option_context_new("[CORPUS...]");
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (option_iterations < 1 || option_mutations < 0) {
+		g_printerr("Invalid number of runs\n");
+		exit(1);
+	}
+
+	name = g_path_get_basename(argv[0]);
+	inputs = g_ptr_array_new_with_free_func(input_free);
+
+	add_seeds(inputs);
+
+	if (option_dump) {
+		ret = dump_corpus(inputs, option_dump);
+		goto done;
+	}
+
+	for (i = 1; i < (unsigned int) argc; i++)
+		add_file(inputs, argv[i]);
+
+	if (!option_quiet)
+		g_print("%-40s %6s %10s\n", "Input", "Bytes", "ns/PDU");
+
+	for (i = 0; i < inputs->len; i++) {
+		struct input *input = g_ptr_array_index(inputs, i);
+		double ns = run_timed(input, option_iterations);
+
+		if (!option_quiet)
+			g_print("%-40s %6zu %10.1f\n", input->name,
+							input->len, ns);
+
+		total += ns;
+	}
+
+	g_print("%s: %u inputs, %.1f ns/PDU average\n", name,
+					inputs->len, total / inputs->len);
+
+	rand_state = option_seed ? option_seed : 1;
+
+	for (i = 0; i < inputs->len; i++)
+		run_mutated(g_ptr_array_index(inputs, i), option_mutations);
+
+	g_print("%s: %u mutated inputs decoded\n", name,
+					inputs->len * option_mutations);
+
+done:
+	g_ptr_array_free(inputs, TRUE);
+	g_free(option_dump);
+	g_free(name);
+
+	return ret;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Every fuzz target provides the libFuzzer entry point and a seed corpus
+ * taken from the unit test vectors.  Built with --enable-libfuzzer the
+ * target is driven by libFuzzer.  Otherwise unit/fuzz.c supplies main(),
+ * which times the decoder on the seeds, reporting ns/PDU, and then feeds
+ * it mutated seeds.
+ */
+struct fuzz_seed {
+	const char *name;
+	const char *hex;
+};
+
+#define FUZZ_SEED_HEX(name, hex)	{ name, hex }
+
+/* NULL terminated */
+extern const struct fuzz_seed fuzz_seeds[];
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
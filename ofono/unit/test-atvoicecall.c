@@ -0,0 +1,602 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <glib.h>
+
+#include <ofono/modem.h>
+#include <ofono/voicecall.h>
+
+#include "gatchat.h"
+#include "gatserver.h"
+
+#include "common.h"
+#include <drivers/atmodem/atmodem.h>
+#include <drivers/atmodem/vendor.h>
+
+/*
+ * The atmodem voicecall driver runs against a scripted modem built on
+ * GAtServer.  The modem announces call state changes, the tests check
+ * the order in which the driver reports them to the core and how many
+ * commands it sends to the modem for that.
+ *
+ * GAtServer only parses V.250 commands, so the link to the driver runs
+ * through a relay which answers vendor '#' commands itself and passes
+ * everything else on to the server.
+ */
+
+#define WAIT_TIMEOUT		2000
+#define MAX_TRANSITIONS		8
+
+struct ofono_voicecall {
+	void *driver_data;
+};
+
+struct test_call {
+	int status;
+	int type;
+	int notified;
+	int transitions[MAX_TRANSITIONS];
+	enum ofono_disconnect_reason reason;
+	char number[OFONO_MAX_PHONE_NUMBER_LENGTH + 1];
+};
+
+static const struct ofono_voicecall_driver *driver;
+static struct ofono_voicecall voicecall;
+static struct test_call calls[8];
+static gboolean registered;
+
+static GAtServer *server;
+static GAtChat *chat;
+static GIOChannel *relay_chat_io;
+static GIOChannel *relay_server_io;
+static guint relay_chat_watch;
+static guint relay_server_watch;
+static GString *relay_line;
+static char *modem_clcc;
+static const char *modem_dial_urc;
+static int clcc_queries;
+static int modem_commands;
+static gboolean dial_done;
+
+int ofono_voicecall_driver_register(const struct ofono_voicecall_driver *d)
+{
+	driver = d;
+
+	return 0;
+}
+
+void ofono_voicecall_driver_unregister(const struct ofono_voicecall_driver *d)
+{
+	driver = NULL;
+}
+
+void ofono_voicecall_set_data(struct ofono_voicecall *vc, void *data)
+{
+	vc->driver_data = data;
+}
+
+void *ofono_voicecall_get_data(struct ofono_voicecall *vc)
+{
+	return vc->driver_data;
+}
+
+void ofono_voicecall_register(struct ofono_voicecall *vc)
+{
+	registered = TRUE;
+}
+
+int ofono_voicecall_get_next_callid(struct ofono_voicecall *vc)
+{
+	unsigned int i;
+
+	for (i = 1; i < G_N_ELEMENTS(calls); i++)
+		if (calls[i].notified == 0 ||
+				calls[i].status == CALL_STATUS_DISCONNECTED)
+			return i;
+
+	return 0;
+}
+
+void ofono_voicecall_notify(struct ofono_voicecall *vc,
+				const struct ofono_call *call)
+{
+	struct test_call *tc;
+
+	g_assert(call->id > 0 && call->id < (int) G_N_ELEMENTS(calls));
+
+	tc = &calls[call->id];
+	g_assert(tc->notified < MAX_TRANSITIONS);
+
+	tc->status = call->status;
+	tc->type = call->type;
+	tc->transitions[tc->notified++] = call->status;
+	strcpy(tc->number, call->phone_number.number);
+
+	if (g_test_verbose())
+		g_print("call %d: status %d number %s\n", call->id,
+				call->status, call->phone_number.number);
+}
+
+void ofono_voicecall_notify_list(struct ofono_voicecall *vc,
+					const struct ofono_call *list,
+					unsigned int num_calls)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_calls; i++)
+		ofono_voicecall_notify(vc, &list[i]);
+}
+
+void ofono_voicecall_disconnected(struct ofono_voicecall *vc, int id,
+				enum ofono_disconnect_reason reason,
+				const struct ofono_error *error)
+{
+	struct test_call *tc;
+
+	g_assert(id > 0 && id < (int) G_N_ELEMENTS(calls));
+
+	tc = &calls[id];
+	g_assert(tc->notified < MAX_TRANSITIONS);
+
+	tc->status = CALL_STATUS_DISCONNECTED;
+	tc->reason = reason;
+	tc->transitions[tc->notified++] = CALL_STATUS_DISCONNECTED;
+
+	if (g_test_verbose())
+		g_print("call %d: disconnected, reason %d\n", id, reason);
+}
+
+void ofono_voicecall_ssn_mo_notify(struct ofono_voicecall *vc, unsigned int id,
+					int code, int index)
+{
+}
+
+void ofono_voicecall_ssn_mt_notify(struct ofono_voicecall *vc, unsigned int id,
+					int code, int index,
+					const struct ofono_phone_number *ph)
+{
+}
+
+static void server_clcc(GAtServer *server, GAtServerRequestType type,
+			GAtResult *result, gpointer user_data)
+{
+	char **lines;
+	int i;
+
+	modem_commands += 1;
+
+	switch (type) {
+	case G_AT_SERVER_REQUEST_TYPE_COMMAND_ONLY:
+		clcc_queries += 1;
+
+		if (modem_clcc == NULL) {
+			g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+			return;
+		}
+
+		lines = g_strsplit(modem_clcc, "\n", 0);
+
+		for (i = 0; lines[i]; i++)
+			g_at_server_send_info(server, lines[i],
+						lines[i + 1] == NULL);
+
+		g_strfreev(lines);
+		g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+		return;
+	case G_AT_SERVER_REQUEST_TYPE_SET:
+		/* Only answered by modems with call progress reporting */
+		if (GPOINTER_TO_UINT(user_data) == OFONO_VENDOR_SIMCOM) {
+			g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_ERROR);
+}
+
+static void server_ok(GAtServer *server, GAtServerRequestType type,
+			GAtResult *result, gpointer user_data)
+{
+	modem_commands += 1;
+
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void server_dial(GAtServer *server, GAtServerRequestType type,
+			GAtResult *result, gpointer user_data)
+{
+	modem_commands += 1;
+
+	/* Modems with call progress reporting tend to beat the OK */
+	if (modem_dial_urc)
+		g_at_server_send_unsolicited(server, modem_dial_urc);
+
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void relay_write(GIOChannel *io, const char *buf, gsize len)
+{
+	int fd = g_io_channel_unix_get_fd(io);
+
+	g_assert(write(fd, buf, len) == (ssize_t) len);
+}
+
+static gboolean relay_from_chat(GIOChannel *io, GIOCondition cond,
+				gpointer user_data)
+{
+	char buf[256];
+	ssize_t len;
+	ssize_t i;
+
+	if (cond & (G_IO_HUP | G_IO_ERR | G_IO_NVAL))
+		return FALSE;
+
+	len = read(g_io_channel_unix_get_fd(io), buf, sizeof(buf));
+	if (len <= 0)
+		return FALSE;
+
+	for (i = 0; i < len; i++) {
+		g_string_append_c(relay_line, buf[i]);
+
+		if (buf[i] != '\r')
+			continue;
+
+		if (g_str_has_prefix(relay_line->str, "AT#")) {
+			modem_commands += 1;
+			relay_write(relay_chat_io, "\r\nOK\r\n", 6);
+		} else
+			relay_write(relay_server_io, relay_line->str,
+							relay_line->len);
+
+		g_string_truncate(relay_line, 0);
+	}
+
+	return TRUE;
+}
+
+static gboolean relay_from_server(GIOChannel *io, GIOCondition cond,
+					gpointer user_data)
+{
+	char buf[256];
+	ssize_t len;
+
+	if (cond & (G_IO_HUP | G_IO_ERR | G_IO_NVAL))
+		return FALSE;
+
+	len = read(g_io_channel_unix_get_fd(io), buf, sizeof(buf));
+	if (len <= 0)
+		return FALSE;
+
+	relay_write(relay_chat_io, buf, len);
+
+	return TRUE;
+}
+
+static GIOChannel *relay_channel(int fd, GIOFunc func, guint *watch)
+{
+	GIOChannel *io = g_io_channel_unix_new(fd);
+
+	g_io_channel_set_close_on_unref(io, TRUE);
+	*watch = g_io_add_watch(io, G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				func, NULL);
+
+	return io;
+}
+
+static void set_modem_calls(const char *clcc)
+{
+	g_free(modem_clcc);
+	modem_clcc = g_strdup(clcc);
+}
+
+static gboolean wait_timeout(gpointer user_data)
+{
+	gboolean *expired = user_data;
+
+	*expired = TRUE;
+
+	return FALSE;
+}
+
+static gboolean wait_for(gboolean (*cond)(void *data), void *data)
+{
+	gboolean expired = FALSE;
+	guint source;
+
+	source = g_timeout_add(WAIT_TIMEOUT, wait_timeout, &expired);
+
+	while (!cond(data) && !expired)
+		g_main_context_iteration(NULL, TRUE);
+
+	if (!expired)
+		g_source_remove(source);
+
+	return !expired;
+}
+
+static gboolean is_ready(void *data)
+{
+	return registered && clcc_queries > 0;
+}
+
+static gboolean is_dial_done(void *data)
+{
+	return dial_done;
+}
+
+struct call_wait {
+	int id;
+	int status;
+};
+
+static gboolean has_status(void *data)
+{
+	struct call_wait *wait = data;
+
+	return calls[wait->id].notified &&
+			calls[wait->id].status == wait->status;
+}
+
+/* Sends a URC and waits for the driver to report the call status */
+static void modem_send(const char *urc, int id, int status)
+{
+	struct call_wait wait = { id, status };
+
+	if (urc)
+		g_at_server_send_unsolicited(server, urc);
+
+	g_assert(wait_for(has_status, &wait));
+}
+
+static void check_transitions(int id, const int *expected, int num)
+{
+	int i;
+
+	g_assert(calls[id].notified == num);
+
+	for (i = 0; i < num; i++)
+		g_assert(calls[id].transitions[i] == expected[i]);
+}
+
+static void dial_cb(const struct ofono_error *error, void *data)
+{
+	g_assert(error->type == OFONO_ERROR_TYPE_NO_ERROR);
+
+	dial_done = TRUE;
+}
+
+static void dial(const char *number)
+{
+	struct ofono_phone_number ph;
+
+	strcpy(ph.number, number);
+	ph.type = 129;
+
+	dial_done = FALSE;
+	driver->dial(&voicecall, &ph, OFONO_CLIR_OPTION_DEFAULT,
+			dial_cb, NULL);
+
+	g_assert(wait_for(is_dial_done, NULL));
+}
+
+static void setup(unsigned int vendor)
+{
+	GIOChannel *modem_io, *client_io;
+	GAtSyntax *syntax;
+	int sv[2];
+	int rv[2];
+
+	memset(calls, 0, sizeof(calls));
+	registered = FALSE;
+	clcc_queries = 0;
+	modem_dial_urc = NULL;
+	set_modem_calls(NULL);
+
+	g_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+	g_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, rv) == 0);
+
+	relay_line = g_string_new(NULL);
+	relay_chat_io = relay_channel(sv[0], relay_from_chat,
+					&relay_chat_watch);
+	relay_server_io = relay_channel(rv[1], relay_from_server,
+					&relay_server_watch);
+
+	modem_io = g_io_channel_unix_new(rv[0]);
+	g_io_channel_set_close_on_unref(modem_io, TRUE);
+
+	server = g_at_server_new(modem_io);
+	g_io_channel_unref(modem_io);
+	g_assert(server != NULL);
+
+	g_at_server_set_echo(server, FALSE);
+	g_at_server_register(server, "+CLCC", server_clcc,
+				GUINT_TO_POINTER(vendor), NULL);
+	g_at_server_register(server, "+CCWA", server_ok, NULL, NULL);
+	g_at_server_register(server, "D", server_dial, NULL, NULL);
+
+	client_io = g_io_channel_unix_new(sv[1]);
+	g_io_channel_set_close_on_unref(client_io, TRUE);
+
+	syntax = g_at_syntax_new_gsm_permissive();
+	chat = g_at_chat_new(client_io, syntax);
+	g_at_syntax_unref(syntax);
+	g_io_channel_unref(client_io);
+	g_assert(chat != NULL);
+
+	at_voicecall_init();
+	g_assert(driver != NULL);
+
+	g_assert(driver->probe(&voicecall, vendor, chat) == 0);
+	g_assert(wait_for(is_ready, NULL));
+
+	/* Only count what the call handling needs from here on */
+	modem_commands = 0;
+}
+
+static void teardown(void)
+{
+	driver->remove(&voicecall);
+	at_voicecall_exit();
+
+	g_at_chat_unref(chat);
+	g_at_server_unref(server);
+
+	g_source_remove(relay_chat_watch);
+	g_source_remove(relay_server_watch);
+	g_io_channel_unref(relay_chat_io);
+	g_io_channel_unref(relay_server_io);
+	g_string_free(relay_line, TRUE);
+
+	set_modem_calls(NULL);
+}
+
+static void test_ecam_mo(void)
+{
+	static const int expected[] = {
+		CALL_STATUS_DIALING,
+		CALL_STATUS_ALERTING,
+		CALL_STATUS_ACTIVE,
+		CALL_STATUS_DISCONNECTED,
+	};
+
+	setup(OFONO_VENDOR_TELIT);
+
+	modem_dial_urc = "#ECAM: 1,1,1";
+	dial("123");
+
+	g_assert(calls[1].notified == 1);
+	g_assert(calls[1].status == CALL_STATUS_DIALING);
+
+	modem_send("#ECAM: 1,2,1", 1, CALL_STATUS_ALERTING);
+	modem_send("#ECAM: 1,3,1", 1, CALL_STATUS_ACTIVE);
+	modem_send("#ECAM: 1,0,1", 1, CALL_STATUS_DISCONNECTED);
+
+	check_transitions(1, expected, G_N_ELEMENTS(expected));
+	g_assert(calls[1].reason == OFONO_DISCONNECT_REASON_REMOTE_HANGUP);
+
+	/* The dial is the only round trip, no CLCC polling */
+	g_assert(modem_commands == 1);
+	g_assert(clcc_queries == 1);
+
+	teardown();
+}
+
+static void test_clcc_mt(void)
+{
+	static const int expected[] = {
+		CALL_STATUS_INCOMING,
+		CALL_STATUS_ACTIVE,
+		CALL_STATUS_DISCONNECTED,
+	};
+
+	setup(OFONO_VENDOR_SIMCOM);
+
+	modem_send("+CLCC: 1,1,4,0,0,\"+15551234\",145",
+				1, CALL_STATUS_INCOMING);
+	g_assert(g_str_equal(calls[1].number, "+15551234"));
+
+	modem_send("+CLCC: 1,1,0,0,0,\"+15551234\",145",
+				1, CALL_STATUS_ACTIVE);
+	modem_send("+CLCC: 1,1,6,0,0,\"+15551234\",145",
+				1, CALL_STATUS_DISCONNECTED);
+
+	check_transitions(1, expected, G_N_ELEMENTS(expected));
+
+	/* Tracked from the indications alone */
+	g_assert(modem_commands == 0);
+
+	teardown();
+}
+
+static void test_clcc_reconcile(void)
+{
+	static const int expected[] = {
+		CALL_STATUS_ACTIVE,
+		CALL_STATUS_DISCONNECTED,
+	};
+
+	setup(OFONO_VENDOR_SIMCOM);
+
+	/* An active call the driver never saw set up asks for CLCC */
+	set_modem_calls("+CLCC: 2,0,0,0,0,\"123\",129");
+	modem_send("+CLCC: 2,0,0,0,0,\"123\",129", 2, CALL_STATUS_ACTIVE);
+	g_assert(modem_commands == 1);
+	g_assert(clcc_queries == 2);
+
+	set_modem_calls(NULL);
+	modem_send("+CLCC: 2,0,6,0,0,\"123\",129", 2,
+				CALL_STATUS_DISCONNECTED);
+
+	check_transitions(2, expected, G_N_ELEMENTS(expected));
+	g_assert(modem_commands == 1);
+
+	teardown();
+}
+
+static void test_poll_fallback(void)
+{
+	static const int expected[] = {
+		CALL_STATUS_ACTIVE,
+		CALL_STATUS_DISCONNECTED,
+	};
+
+	setup(OFONO_VENDOR_GENERIC);
+
+	dial("123");
+
+	/* Without call progress reporting only CLCC tells us */
+	set_modem_calls("+CLCC: 1,0,0,0,0,\"123\",129");
+	modem_send(NULL, 1, CALL_STATUS_ACTIVE);
+	g_assert(clcc_queries > 1);
+	g_assert(modem_commands == clcc_queries);
+
+	set_modem_calls(NULL);
+	modem_send("NO CARRIER", 1, CALL_STATUS_DISCONNECTED);
+
+	check_transitions(1, expected, G_N_ELEMENTS(expected));
+
+	teardown();
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testatvoicecall/ecam_mo", test_ecam_mo);
+	g_test_add_func("/testatvoicecall/clcc_mt", test_clcc_mt);
+	g_test_add_func("/testatvoicecall/clcc_reconcile",
+						test_clcc_reconcile);
+	g_test_add_func("/testatvoicecall/poll_fallback", test_poll_fallback);
+
+	return g_test_run();
+}
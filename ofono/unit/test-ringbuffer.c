@@ -0,0 +1,167 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "ringbuffer.h"
+
+static void fill(unsigned char *data, unsigned int len, unsigned char start)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		data[i] = start + i;
+}
+
+static void test_wrap(void)
+{
+	struct ring_buffer *buf;
+	unsigned char data[4096];
+	unsigned char *ptr;
+	int capacity;
+	int len;
+
+	buf = ring_buffer_new_mirrored(4096);
+	g_assert(buf);
+
+	capacity = ring_buffer_capacity(buf);
+	g_assert(capacity >= 4096);
+
+	/* Move the read and write counters close to the end */
+	len = ring_buffer_write_advance(buf, capacity - 100);
+	g_assert(len == capacity - 100);
+	g_assert(ring_buffer_drain(buf, len) == len);
+
+	ring_buffer_write_advance(buf, 1);
+	ring_buffer_drain(buf, 1);
+
+	/* Writes across the end are contiguous */
+	g_assert(ring_buffer_avail_no_wrap(buf) == capacity);
+
+	fill(data, 1000, 0);
+	ptr = ring_buffer_write_ptr(buf, 0);
+	memcpy(ptr, data, 1000);
+	g_assert(ring_buffer_write_advance(buf, 1000) == 1000);
+
+	/* And so are reads */
+	g_assert(ring_buffer_len(buf) == 1000);
+	g_assert(ring_buffer_len_no_wrap(buf) == 1000);
+	g_assert(memcmp(ring_buffer_read_ptr(buf, 0), data, 1000) == 0);
+
+	ring_buffer_free(buf);
+}
+
+static void test_plain(void)
+{
+	struct ring_buffer *buf;
+	unsigned char data[100];
+	unsigned char out[100];
+
+	buf = ring_buffer_new(256);
+	g_assert(buf);
+	g_assert(ring_buffer_capacity(buf) == 256);
+
+	ring_buffer_write_advance(buf, 200);
+	ring_buffer_drain(buf, 199);
+
+	/* Without a mirror, data across the end comes in two pieces */
+	fill(data, sizeof(data), 3);
+	g_assert(ring_buffer_write(buf, data, sizeof(data)) == sizeof(data));
+	g_assert(ring_buffer_drain(buf, 1) == 1);
+
+	g_assert(ring_buffer_len(buf) == 100);
+	g_assert(ring_buffer_len_no_wrap(buf) == 56);
+	g_assert(ring_buffer_avail_no_wrap(buf) == 156);
+
+	g_assert(ring_buffer_read(buf, out, sizeof(out)) == sizeof(out));
+	g_assert(memcmp(data, out, sizeof(data)) == 0);
+
+	ring_buffer_free(buf);
+}
+
+static void test_limit(void)
+{
+	struct ring_buffer *buf;
+
+	g_assert(ring_buffer_new(262144 + 1) == NULL);
+	g_assert(ring_buffer_new_mirrored(262144 + 1) == NULL);
+
+	buf = ring_buffer_new_mirrored(262144);
+	g_assert(buf);
+	g_assert(ring_buffer_capacity(buf) == 262144);
+	ring_buffer_free(buf);
+
+	buf = ring_buffer_new_mirrored(4096);
+	g_assert(buf);
+	g_assert(ring_buffer_grow(buf, 262144 + 1) == -1);
+	g_assert(ring_buffer_capacity(buf) == 4096);
+	ring_buffer_free(buf);
+}
+
+static void test_grow(void)
+{
+	struct ring_buffer *buf;
+	unsigned char data[3000];
+	unsigned char out[3000];
+	int capacity;
+
+	buf = ring_buffer_new_mirrored(4096);
+	g_assert(buf);
+
+	capacity = ring_buffer_capacity(buf);
+	g_assert(ring_buffer_grow(buf, capacity) == -1);
+
+	/* Leave data that wraps around the end of the buffer */
+	ring_buffer_write_advance(buf, capacity - 1000);
+	ring_buffer_drain(buf, capacity - 1000);
+
+	fill(data, sizeof(data), 7);
+	g_assert(ring_buffer_write(buf, data, sizeof(data)) == sizeof(data));
+
+	g_assert(ring_buffer_grow(buf, capacity + 1) == capacity * 2);
+	g_assert(ring_buffer_capacity(buf) == capacity * 2);
+	g_assert(ring_buffer_len(buf) == sizeof(data));
+	g_assert(ring_buffer_avail(buf) == capacity * 2 - (int) sizeof(data));
+
+	g_assert(ring_buffer_read(buf, out, sizeof(out)) == sizeof(out));
+	g_assert(memcmp(data, out, sizeof(data)) == 0);
+	g_assert(ring_buffer_len(buf) == 0);
+
+	ring_buffer_free(buf);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testringbuffer/wrap", test_wrap);
+	g_test_add_func("/testringbuffer/plain", test_plain);
+	g_test_add_func("/testringbuffer/limit", test_limit);
+	g_test_add_func("/testringbuffer/grow", test_grow);
+
+	return g_test_run();
+}
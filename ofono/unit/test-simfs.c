@@ -0,0 +1,230 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <ofono/types.h>
+#include <ofono/sim.h>
+
+#include "simutil.h"
+#include "simfs.h"
+
+/*
+ * simfs runs against a fake SIM driver that completes reads right away
+ * and writes from an idle callback.  Without an ICCID nothing is
+ * cached, so each read that is not coalesced with another one reaches
+ * the driver.
+ */
+
+#define EF_HEAD		0x6f42
+#define EF_TEST		0x6f40
+#define EF_LENGTH	4
+
+static unsigned char card[EF_LENGTH];
+static int card_reads;
+static int card_writes;
+
+static unsigned char results[4][EF_LENGTH];
+static int n_results;
+static int n_writes;
+
+const char *ofono_sim_get_iccid(struct ofono_sim *sim)
+{
+	return NULL;
+}
+
+const char *ofono_sim_get_imsi(struct ofono_sim *sim)
+{
+	return NULL;
+}
+
+enum ofono_sim_phase ofono_sim_get_phase(struct ofono_sim *sim)
+{
+	return OFONO_SIM_PHASE_UNKNOWN;
+}
+
+static void fake_read_file_info(struct ofono_sim *sim, int fileid,
+				const unsigned char *path,
+				unsigned int path_len,
+				ofono_sim_file_info_cb_t cb, void *data)
+{
+	struct ofono_error error = { OFONO_ERROR_TYPE_NO_ERROR, 0 };
+	unsigned char access[3] = { 0x00, 0x00, 0x00 };
+
+	cb(&error, EF_LENGTH, OFONO_SIM_FILE_STRUCTURE_TRANSPARENT, 0,
+		access, SIM_FILE_STATUS_VALID, data);
+}
+
+static void fake_read_file_transparent(struct ofono_sim *sim, int fileid,
+				int start, int length,
+				const unsigned char *path,
+				unsigned int path_len,
+				ofono_sim_read_cb_t cb, void *data)
+{
+	struct ofono_error error = { OFONO_ERROR_TYPE_NO_ERROR, 0 };
+
+	card_reads += 1;
+	cb(&error, card + start, length, data);
+}
+
+static ofono_sim_write_cb_t write_done_cb;
+static void *write_done_data;
+
+static gboolean write_done(gpointer user_data)
+{
+	struct ofono_error error = { OFONO_ERROR_TYPE_NO_ERROR, 0 };
+
+	write_done_cb(&error, write_done_data);
+
+	return FALSE;
+}
+
+/* simfs still owns the value while the write is submitted */
+static void fake_write_file_transparent(struct ofono_sim *sim, int fileid,
+				int start, int length,
+				const unsigned char *value,
+				const unsigned char *path,
+				unsigned int path_len,
+				ofono_sim_write_cb_t cb, void *data)
+{
+	card_writes += 1;
+	memcpy(card + start, value, length);
+
+	write_done_cb = cb;
+	write_done_data = data;
+	g_idle_add(write_done, NULL);
+}
+
+static const struct ofono_sim_driver fake_driver = {
+	.name			= "fake",
+	.read_file_info		= fake_read_file_info,
+	.read_file_transparent	= fake_read_file_transparent,
+	.write_file_transparent	= fake_write_file_transparent,
+};
+
+static void read_cb(int ok, int total_length, int record,
+			const unsigned char *data,
+			int record_length, void *userdata)
+{
+	g_assert(ok);
+	g_assert(total_length == EF_LENGTH);
+
+	if (GPOINTER_TO_INT(userdata) != EF_TEST)
+		return;
+
+	memcpy(results[n_results++], data, EF_LENGTH);
+}
+
+static void write_cb(int ok, void *userdata)
+{
+	g_assert(ok);
+	n_writes += 1;
+}
+
+static void run_queue(void)
+{
+	while (g_main_context_iteration(NULL, FALSE))
+		;
+}
+
+static void setup(void)
+{
+	memset(card, 0x11, sizeof(card));
+	card_reads = 0;
+	card_writes = 0;
+	n_results = 0;
+	n_writes = 0;
+}
+
+static void queue_read(struct ofono_sim_context *context, int id)
+{
+	g_assert(sim_fs_read(context, id,
+				OFONO_SIM_FILE_STRUCTURE_TRANSPARENT,
+				0, 0, NULL, 0, read_cb,
+				GINT_TO_POINTER(id)) == 0);
+}
+
+static void test_coalesce(void)
+{
+	struct sim_fs *fs = sim_fs_new(NULL, &fake_driver);
+	struct ofono_sim_context *context = sim_fs_context_new(fs);
+
+	setup();
+
+	queue_read(context, EF_HEAD);
+	queue_read(context, EF_TEST);
+	queue_read(context, EF_TEST);
+	run_queue();
+
+	g_assert(n_results == 2);
+	g_assert(card_reads == 2);
+
+	sim_fs_context_free(context);
+	sim_fs_free(fs);
+}
+
+static void test_read_write_read(void)
+{
+	struct sim_fs *fs = sim_fs_new(NULL, &fake_driver);
+	struct ofono_sim_context *context = sim_fs_context_new(fs);
+	unsigned char value[EF_LENGTH];
+
+	setup();
+	memset(value, 0x22, sizeof(value));
+
+	queue_read(context, EF_HEAD);
+	queue_read(context, EF_TEST);
+	g_assert(sim_fs_write(context, EF_TEST, write_cb,
+				OFONO_SIM_FILE_STRUCTURE_TRANSPARENT, 0,
+				value, EF_LENGTH, NULL) == 0);
+	queue_read(context, EF_TEST);
+	queue_read(context, EF_TEST);
+	run_queue();
+
+	g_assert(n_writes == 1);
+	g_assert(card_writes == 1);
+
+	/* The read after the write is not served the old contents */
+	g_assert(n_results == 3);
+	g_assert(card_reads == 3);
+	g_assert(memcmp(results[0], "\x11\x11\x11\x11", EF_LENGTH) == 0);
+	g_assert(memcmp(results[1], value, EF_LENGTH) == 0);
+	g_assert(memcmp(results[2], value, EF_LENGTH) == 0);
+
+	sim_fs_context_free(context);
+	sim_fs_free(fs);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testsimfs/coalesce", test_coalesce);
+	g_test_add_func("/testsimfs/read_write_read", test_read_write_read);
+
+	return g_test_run();
+}
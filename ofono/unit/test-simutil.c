@@ -383,6 +383,86 @@ static void test_eons(void)
 	sim_eons_free(eons_info);
 }
 
+static const unsigned char lac_efopl[][8] = {
+	/* 234 15, LACs 0x0100 - 0x01ff */
+	{ 0x32, 0xf4, 0x51, 0x01, 0x00, 0x01, 0xff, 0x01 },
+	/* 234 15, LACs 0x0180 - 0x02ff, partly shadowed by the above */
+	{ 0x32, 0xf4, 0x51, 0x01, 0x80, 0x02, 0xff, 0x02 },
+	/* 234 15, any LAC */
+	{ 0x32, 0xf4, 0x51, 0x00, 0x00, 0xff, 0xfe, 0x02 },
+	/* 23x 15, any LAC */
+	{ 0x32, 0xfd, 0x51, 0x00, 0x00, 0xff, 0xfe, 0x01 },
+	/* 310 410, LACs 0x0010 - 0x0020 */
+	{ 0x13, 0x00, 0x14, 0x00, 0x10, 0x00, 0x20, 0x01 },
+	/* 31x 410, any LAC */
+	{ 0x13, 0x0d, 0x14, 0x00, 0x00, 0xff, 0xfe, 0x02 },
+	/* 310 41, any LAC, invalid record id */
+	{ 0x13, 0xf0, 0x14, 0x00, 0x00, 0xff, 0xfe, 0x00 },
+};
+
+static const char *eons_longname(struct sim_eons *eons, const char *mcc,
+					const char *mnc, int lac)
+{
+	const struct sim_eons_operator_info *op_info;
+
+	if (lac < 0)
+		op_info = sim_eons_lookup(eons, mcc, mnc);
+	else
+		op_info = sim_eons_lookup_with_lac(eons, mcc, mnc, lac);
+
+	return op_info ? op_info->longname : NULL;
+}
+
+static void test_eons_lac(void)
+{
+	struct sim_eons *eons_info;
+	unsigned int i;
+
+	eons_info = sim_eons_new(2);
+
+	sim_eons_add_pnn_record(eons_info, 1,
+			valid_efpnn[0], sizeof(valid_efpnn[0]));
+	sim_eons_add_pnn_record(eons_info, 2,
+			valid_efpnn[1], sizeof(valid_efpnn[1]));
+
+	for (i = 0; i < G_N_ELEMENTS(lac_efopl); i++)
+		sim_eons_add_opl_record(eons_info, lac_efopl[i],
+						sizeof(lac_efopl[i]));
+
+	sim_eons_optimize(eons_info);
+
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", -1),
+				"Long"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", 0x150),
+				"Tux Comm"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", 0x1c0),
+				"Tux Comm"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", 0x250),
+				"Long"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", 0x050),
+				"Long"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "234", "15", 0xffff),
+				"Long"));
+
+	g_assert(!g_strcmp0(eons_longname(eons_info, "235", "15", -1),
+				"Tux Comm"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "235", "15", 0x150),
+				"Tux Comm"));
+	g_assert(eons_longname(eons_info, "235", "16", -1) == NULL);
+
+	g_assert(!g_strcmp0(eons_longname(eons_info, "310", "410", 0x15),
+				"Tux Comm"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "310", "410", 0x30),
+				"Long"));
+	g_assert(!g_strcmp0(eons_longname(eons_info, "310", "410", -1),
+				"Long"));
+
+	g_assert(eons_longname(eons_info, "310", "41", -1) == NULL);
+	g_assert(eons_longname(eons_info, "999", "99", 0x150) == NULL);
+
+	sim_eons_free(eons_info);
+}
+
 static void test_ef_db(void)
 {
 	struct sim_ef_info *info;
@@ -506,6 +586,7 @@ int main(int argc, char **argv)
 	g_test_add_func("/testsimutil/ber tlv encode 3G Status response",
 			test_ber_tlv_builder_3g_status);
 	g_test_add_func("/testsimutil/EONS Handling", test_eons);
+	g_test_add_func("/testsimutil/EONS LAC Handling", test_eons_lac);
 	g_test_add_func("/testsimutil/Elementary File DB", test_ef_db);
 	g_test_add_func("/testsimutil/3G Status response", test_3g_status_data);
 	g_test_add_func("/testsimutil/Application entries decoding",
@@ -0,0 +1,136 @@
+/*
+ *
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2008-2011  Intel Corporation. All rights reserved.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "spscqueue.h"
+
+#define THREAD_ITEMS 1000000
+
+static void test_wrap(void)
+{
+	struct spsc_queue *queue;
+	unsigned int i;
+	unsigned int round;
+
+	g_assert(spsc_queue_new(0) == NULL);
+
+	queue = spsc_queue_new(5);
+	g_assert(queue);
+	g_assert(spsc_queue_capacity(queue) == 8);
+
+	g_assert(spsc_queue_peek(queue) == NULL);
+	g_assert(spsc_queue_pop(queue) == NULL);
+	g_assert(spsc_queue_push(queue, NULL) == FALSE);
+
+	/* Go around the end a few times, partly filled and full */
+	for (round = 0; round < 5; round++) {
+		for (i = 1; i <= 8; i++)
+			g_assert(spsc_queue_push(queue, GUINT_TO_POINTER(i)));
+
+		g_assert(spsc_queue_push(queue, GUINT_TO_POINTER(9)) == FALSE);
+		g_assert(spsc_queue_len(queue) == 8);
+
+		for (i = 1; i <= 3 + round; i++)
+			g_assert(spsc_queue_pop(queue) == GUINT_TO_POINTER(i));
+
+		g_assert(spsc_queue_peek(queue) == GUINT_TO_POINTER(i));
+		g_assert(spsc_queue_len(queue) == 8 - (3 + round));
+
+		while (spsc_queue_pop(queue))
+			;
+
+		g_assert(spsc_queue_len(queue) == 0);
+	}
+
+	spsc_queue_free(queue);
+}
+
+#ifdef NEED_THREADS
+static gpointer producer(gpointer user_data)
+{
+	struct spsc_queue *queue = user_data;
+	unsigned int i;
+
+	for (i = 1; i <= THREAD_ITEMS; i++)
+		while (spsc_queue_push(queue, GUINT_TO_POINTER(i)) == FALSE)
+			g_thread_yield();
+
+	return NULL;
+}
+
+static void test_threads(void)
+{
+	struct spsc_queue *queue;
+	GThread *thread;
+	unsigned int next = 1;
+	gpointer item;
+
+	queue = spsc_queue_new(64);
+	g_assert(queue);
+
+#if GLIB_CHECK_VERSION(2, 32, 0)
+	thread = g_thread_new("producer", producer, queue);
+#else
+	thread = g_thread_create(producer, queue, TRUE, NULL);
+#endif
+	g_assert(thread);
+
+	/* Every item arrives exactly once and in order */
+	while (next <= THREAD_ITEMS) {
+		item = spsc_queue_pop(queue);
+		if (item == NULL) {
+			g_thread_yield();
+			continue;
+		}
+
+		g_assert(item == GUINT_TO_POINTER(next));
+		next += 1;
+	}
+
+	g_thread_join(thread);
+
+	g_assert(spsc_queue_pop(queue) == NULL);
+
+	spsc_queue_free(queue);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+#ifdef NEED_THREADS
+	if (g_thread_supported() == FALSE)
+		g_thread_init(NULL);
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testspscqueue/wrap", test_wrap);
+#ifdef NEED_THREADS
+	g_test_add_func("/testspscqueue/threads", test_threads);
+#endif
+
+	return g_test_run();
+}
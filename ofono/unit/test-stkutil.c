@@ -41,6 +41,52 @@
 
 #define MAX_ITEM 100
 
+#ifdef __GLIBC__
+/*
+ * Count heap allocations by interposing the libc allocator, GLib allocates
+ * through it as well so g_malloc and friends are accounted for too.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned int alloc_count;
+
+void *malloc(size_t size)
+{
+	alloc_count += 1;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	alloc_count += 1;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	alloc_count += 1;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+
+static unsigned int get_alloc_count(void)
+{
+	return alloc_count;
+}
+#else
+static unsigned int get_alloc_count(void)
+{
+	return 0;
+}
+#endif
+
 struct sms_submit_test {
 	gboolean rd;
 	enum sms_validity_period_format vpf;
@@ -16220,8 +16266,11 @@ static void test_terminal_response_encoding(gconstpointer data)
 	const struct terminal_response_test *test = data;
 	const unsigned char *pdu;
 	unsigned int pdu_len;
+	unsigned int allocs;
 
+	allocs = get_alloc_count();
 	pdu = stk_pdu_from_response(&test->response, &pdu_len);
+	g_assert(get_alloc_count() == allocs);
 
 	if (test->pdu)
 		g_assert(pdu);
@@ -16732,6 +16781,24 @@ static const struct terminal_response_test get_input_response_data_111 = {
 	},
 };
 
+static void test_terminal_response_own_buf(gconstpointer data)
+{
+	const struct terminal_response_test *test = data;
+	unsigned char buf[256];
+	const unsigned char *pdu;
+	unsigned int pdu_len;
+
+	pdu = stk_pdu_from_response_own_buf(&test->response, &pdu_len,
+						buf, test->pdu_len);
+	g_assert(pdu == buf);
+	g_assert(pdu_len == test->pdu_len);
+	g_assert(memcmp(pdu, test->pdu, pdu_len) == 0);
+
+	pdu = stk_pdu_from_response_own_buf(&test->response, &pdu_len,
+						buf, test->pdu_len - 1);
+	g_assert(pdu == NULL);
+}
+
 static const struct terminal_response_test get_input_response_data_121 = {
 	.pdu = get_input_response_121,
 	.pdu_len = sizeof(get_input_response_121),
@@ -20240,8 +20307,11 @@ static void test_envelope_encoding(gconstpointer data)
 	const struct envelope_test *test = data;
 	const unsigned char *pdu;
 	unsigned int pdu_len;
+	unsigned int allocs;
 
+	allocs = get_alloc_count();
 	pdu = stk_pdu_from_envelope(&test->envelope, &pdu_len);
+	g_assert(get_alloc_count() == allocs);
 
 	if (test->pdu)
 		g_assert(pdu);
@@ -20797,6 +20867,90 @@ static const struct envelope_test call_control_data_131b = {
 	},
 };
 
+static const unsigned char call_control_alpha_id_gsm[] = {
+	0xd4, 0x2c, 0x82, 0x02, 0x82, 0x81, 0x86, 0x0b,
+	0x91, 0x10, 0x32, 0x54, 0x76, 0x98, 0x10, 0x32,
+	0x54, 0x76, 0x98, 0x07, 0x07, 0x06, 0x60, 0x04,
+	0x02, 0x00, 0x05, 0x81, 0x13, 0x09, 0x00, 0xf1,
+	0x10, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x05,
+	0x05, 0x41, 0x6c, 0x70, 0x68, 0x61,
+};
+
+static const struct envelope_test call_control_data_alpha_id_gsm = {
+	.pdu = call_control_alpha_id_gsm,
+	.pdu_len = sizeof(call_control_alpha_id_gsm),
+	.envelope = {
+		.type = STK_ENVELOPE_TYPE_CALL_CONTROL,
+		.src = STK_DEVICE_IDENTITY_TYPE_TERMINAL,
+		.dst = STK_DEVICE_IDENTITY_TYPE_UICC,
+		{ .call_control = {
+			.type = STK_CC_TYPE_CALL_SETUP,
+			{ .address = {
+				.ton_npi = 0x91, /* Intl, ISDN */
+				.number = "01234567890123456789",
+			}},
+			.ccp1 = {
+				.ccp = {
+					0x60, 0x04, 0x02, 0x00, 0x05, 0x81,
+				},
+				.len = 6,
+			},
+			.location = {
+				.mcc = "001",
+				.mnc = "01",
+				.lac_tac = 0x0001,
+				.has_ci = TRUE,
+				.ci = 0x0001,
+				.has_ext_ci = TRUE,
+				.ext_ci = 0x0001,
+			},
+			.alpha_id = "Alpha",
+		}},
+	},
+};
+
+static const unsigned char call_control_alpha_id_ucs2[] = {
+	0xd4, 0x2c, 0x82, 0x02, 0x82, 0x81, 0x86, 0x0b,
+	0x91, 0x10, 0x32, 0x54, 0x76, 0x98, 0x10, 0x32,
+	0x54, 0x76, 0x98, 0x07, 0x07, 0x06, 0x60, 0x04,
+	0x02, 0x00, 0x05, 0x81, 0x13, 0x09, 0x00, 0xf1,
+	0x10, 0x00, 0x01, 0x00, 0x01, 0x00, 0x01, 0x05,
+	0x05, 0x80, 0x04, 0x16, 0x04, 0x14,
+};
+
+static const struct envelope_test call_control_data_alpha_id_ucs2 = {
+	.pdu = call_control_alpha_id_ucs2,
+	.pdu_len = sizeof(call_control_alpha_id_ucs2),
+	.envelope = {
+		.type = STK_ENVELOPE_TYPE_CALL_CONTROL,
+		.src = STK_DEVICE_IDENTITY_TYPE_TERMINAL,
+		.dst = STK_DEVICE_IDENTITY_TYPE_UICC,
+		{ .call_control = {
+			.type = STK_CC_TYPE_CALL_SETUP,
+			{ .address = {
+				.ton_npi = 0x91, /* Intl, ISDN */
+				.number = "01234567890123456789",
+			}},
+			.ccp1 = {
+				.ccp = {
+					0x60, 0x04, 0x02, 0x00, 0x05, 0x81,
+				},
+				.len = 6,
+			},
+			.location = {
+				.mcc = "001",
+				.mnc = "01",
+				.lac_tac = 0x0001,
+				.has_ci = TRUE,
+				.ci = 0x0001,
+				.has_ext_ci = TRUE,
+				.ext_ci = 0x0001,
+			},
+			.alpha_id = "\xd0\x96\xd0\x94",
+		}},
+	},
+};
+
 static const unsigned char mo_short_message_control_111a[] = {
 	0xd5, 0x22, 0x02, 0x02, 0x82, 0x81, 0x06, 0x09,
 	0x91, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
@@ -22307,6 +22461,310 @@ static void test_img_to_xpm(gconstpointer data)
 	g_free(xpm);
 }
 
+#define CORPUS(pdu) { pdu, sizeof(pdu) }
+
+/* Every proactive command PDU in the test vectors, valid or not */
+static const struct {
+	const unsigned char *pdu;
+	unsigned int pdu_len;
+} parse_corpus[] = {
+	CORPUS(display_text_111), CORPUS(display_text_131),
+	CORPUS(display_text_141), CORPUS(display_text_151),
+	CORPUS(display_text_161), CORPUS(display_text_171),
+	CORPUS(display_text_181), CORPUS(display_text_191),
+	CORPUS(display_text_211), CORPUS(display_text_311),
+	CORPUS(display_text_411), CORPUS(display_text_421),
+	CORPUS(display_text_431), CORPUS(display_text_511),
+	CORPUS(display_text_521), CORPUS(display_text_531),
+	CORPUS(display_text_611), CORPUS(display_text_711),
+	CORPUS(display_text_811), CORPUS(display_text_812),
+	CORPUS(display_text_821), CORPUS(display_text_831),
+	CORPUS(display_text_841), CORPUS(display_text_851),
+	CORPUS(display_text_861), CORPUS(display_text_871),
+	CORPUS(display_text_881), CORPUS(display_text_891),
+	CORPUS(display_text_8101), CORPUS(display_text_911),
+	CORPUS(display_text_1011), CORPUS(get_inkey_111), CORPUS(get_inkey_121),
+	CORPUS(get_inkey_131), CORPUS(get_inkey_141), CORPUS(get_inkey_151),
+	CORPUS(get_inkey_161), CORPUS(get_inkey_211), CORPUS(get_inkey_311),
+	CORPUS(get_inkey_321), CORPUS(get_inkey_411), CORPUS(get_inkey_511),
+	CORPUS(get_inkey_512), CORPUS(get_inkey_611), CORPUS(get_inkey_621),
+	CORPUS(get_inkey_631), CORPUS(get_inkey_641), CORPUS(get_inkey_811),
+	CORPUS(get_inkey_911), CORPUS(get_inkey_921), CORPUS(get_inkey_931),
+	CORPUS(get_inkey_941), CORPUS(get_inkey_951), CORPUS(get_inkey_961),
+	CORPUS(get_inkey_971), CORPUS(get_inkey_981), CORPUS(get_inkey_991),
+	CORPUS(get_inkey_9101), CORPUS(get_inkey_1011), CORPUS(get_inkey_1021),
+	CORPUS(get_inkey_1111), CORPUS(get_inkey_1211), CORPUS(get_inkey_1221),
+	CORPUS(get_inkey_1311), CORPUS(get_input_111), CORPUS(get_input_121),
+	CORPUS(get_input_131), CORPUS(get_input_141), CORPUS(get_input_151),
+	CORPUS(get_input_161), CORPUS(get_input_171), CORPUS(get_input_181),
+	CORPUS(get_input_191), CORPUS(get_input_1101), CORPUS(get_input_211),
+	CORPUS(get_input_311), CORPUS(get_input_321), CORPUS(get_input_411),
+	CORPUS(get_input_421), CORPUS(get_input_511), CORPUS(get_input_521),
+	CORPUS(get_input_611), CORPUS(get_input_621), CORPUS(get_input_631),
+	CORPUS(get_input_641), CORPUS(get_input_811), CORPUS(get_input_821),
+	CORPUS(get_input_831), CORPUS(get_input_841), CORPUS(get_input_851),
+	CORPUS(get_input_861), CORPUS(get_input_871), CORPUS(get_input_881),
+	CORPUS(get_input_891), CORPUS(get_input_8101), CORPUS(get_input_911),
+	CORPUS(get_input_921), CORPUS(get_input_1011), CORPUS(get_input_1021),
+	CORPUS(get_input_1111), CORPUS(get_input_1121), CORPUS(get_input_1211),
+	CORPUS(get_input_1221), CORPUS(more_time_111), CORPUS(play_tone_111),
+	CORPUS(play_tone_112), CORPUS(play_tone_113), CORPUS(play_tone_114),
+	CORPUS(play_tone_115), CORPUS(play_tone_116), CORPUS(play_tone_117),
+	CORPUS(play_tone_118), CORPUS(play_tone_119), CORPUS(play_tone_1110),
+	CORPUS(play_tone_1111), CORPUS(play_tone_1112), CORPUS(play_tone_1113),
+	CORPUS(play_tone_1114), CORPUS(play_tone_1115), CORPUS(play_tone_211),
+	CORPUS(play_tone_212), CORPUS(play_tone_213), CORPUS(play_tone_311),
+	CORPUS(play_tone_321), CORPUS(play_tone_331), CORPUS(play_tone_341),
+	CORPUS(play_tone_411), CORPUS(play_tone_412), CORPUS(play_tone_421),
+	CORPUS(play_tone_422), CORPUS(play_tone_431), CORPUS(play_tone_432),
+	CORPUS(play_tone_441), CORPUS(play_tone_442), CORPUS(play_tone_443),
+	CORPUS(play_tone_451), CORPUS(play_tone_452), CORPUS(play_tone_453),
+	CORPUS(play_tone_461), CORPUS(play_tone_462), CORPUS(play_tone_463),
+	CORPUS(play_tone_471), CORPUS(play_tone_472), CORPUS(play_tone_473),
+	CORPUS(play_tone_481), CORPUS(play_tone_482), CORPUS(play_tone_483),
+	CORPUS(play_tone_491), CORPUS(play_tone_492), CORPUS(play_tone_493),
+	CORPUS(play_tone_4101), CORPUS(play_tone_4102), CORPUS(play_tone_511),
+	CORPUS(play_tone_512), CORPUS(play_tone_513), CORPUS(play_tone_611),
+	CORPUS(play_tone_612), CORPUS(play_tone_613), CORPUS(poll_interval_111),
+	CORPUS(get_inkey_711), CORPUS(get_inkey_712), CORPUS(get_inkey_912),
+	CORPUS(get_inkey_922), CORPUS(get_inkey_932), CORPUS(get_inkey_942),
+	CORPUS(get_inkey_943), CORPUS(get_inkey_952), CORPUS(get_inkey_953),
+	CORPUS(get_inkey_962), CORPUS(get_inkey_963), CORPUS(get_inkey_972),
+	CORPUS(get_inkey_973), CORPUS(get_inkey_982), CORPUS(get_inkey_983),
+	CORPUS(get_inkey_992a), CORPUS(get_inkey_992b), CORPUS(get_inkey_993),
+	CORPUS(get_inkey_9102), CORPUS(get_input_711), CORPUS(get_input_812),
+	CORPUS(get_input_822), CORPUS(get_input_832), CORPUS(get_input_842),
+	CORPUS(get_input_843), CORPUS(get_input_852), CORPUS(get_input_853),
+	CORPUS(get_input_862), CORPUS(get_input_863), CORPUS(get_input_872),
+	CORPUS(get_input_873), CORPUS(get_input_882), CORPUS(get_input_883),
+	CORPUS(get_input_892), CORPUS(get_input_893), CORPUS(get_input_8102),
+	CORPUS(setup_menu_111), CORPUS(setup_menu_112), CORPUS(setup_menu_113),
+	CORPUS(setup_menu_121), CORPUS(setup_menu_122), CORPUS(setup_menu_123),
+	CORPUS(setup_menu_211), CORPUS(setup_menu_311), CORPUS(setup_menu_411),
+	CORPUS(setup_menu_421), CORPUS(setup_menu_511), CORPUS(setup_menu_611),
+	CORPUS(setup_menu_612), CORPUS(setup_menu_621), CORPUS(setup_menu_622),
+	CORPUS(setup_menu_631), CORPUS(setup_menu_632), CORPUS(setup_menu_641),
+	CORPUS(setup_menu_642), CORPUS(setup_menu_643), CORPUS(setup_menu_651),
+	CORPUS(setup_menu_661), CORPUS(setup_menu_671), CORPUS(setup_menu_681),
+	CORPUS(setup_menu_691), CORPUS(setup_menu_6101), CORPUS(setup_menu_711),
+	CORPUS(setup_menu_712), CORPUS(setup_menu_713), CORPUS(setup_menu_811),
+	CORPUS(setup_menu_812), CORPUS(setup_menu_813), CORPUS(setup_menu_911),
+	CORPUS(setup_menu_912), CORPUS(setup_menu_913),
+	CORPUS(setup_menu_neg_1), CORPUS(setup_menu_neg_2),
+	CORPUS(setup_menu_neg_3), CORPUS(setup_menu_neg_4),
+	CORPUS(select_item_111), CORPUS(select_item_121),
+	CORPUS(select_item_131), CORPUS(select_item_141),
+	CORPUS(select_item_151), CORPUS(select_item_161),
+	CORPUS(select_item_211), CORPUS(select_item_311),
+	CORPUS(select_item_411), CORPUS(select_item_511),
+	CORPUS(select_item_521), CORPUS(select_item_611),
+	CORPUS(select_item_621), CORPUS(select_item_711),
+	CORPUS(select_item_811), CORPUS(select_item_911),
+	CORPUS(select_item_912), CORPUS(select_item_921),
+	CORPUS(select_item_922), CORPUS(select_item_931),
+	CORPUS(select_item_932), CORPUS(select_item_941),
+	CORPUS(select_item_942), CORPUS(select_item_943),
+	CORPUS(select_item_951), CORPUS(select_item_952),
+	CORPUS(select_item_953), CORPUS(select_item_961),
+	CORPUS(select_item_962), CORPUS(select_item_963),
+	CORPUS(select_item_971), CORPUS(select_item_972),
+	CORPUS(select_item_973), CORPUS(select_item_981),
+	CORPUS(select_item_982), CORPUS(select_item_983),
+	CORPUS(select_item_991), CORPUS(select_item_992),
+	CORPUS(select_item_993), CORPUS(select_item_9101),
+	CORPUS(select_item_9102), CORPUS(select_item_1011),
+	CORPUS(select_item_1021), CORPUS(select_item_1031),
+	CORPUS(select_item_1111), CORPUS(select_item_1211),
+	CORPUS(select_item_1221), CORPUS(select_item_1231),
+	CORPUS(send_sms_111), CORPUS(send_sms_121), CORPUS(send_sms_131),
+	CORPUS(send_sms_141), CORPUS(send_sms_151), CORPUS(send_sms_161),
+	CORPUS(send_sms_171), CORPUS(send_sms_181), CORPUS(send_sms_211),
+	CORPUS(send_sms_212), CORPUS(send_sms_213), CORPUS(send_sms_311),
+	CORPUS(send_sms_321), CORPUS(send_sms_411), CORPUS(send_sms_412),
+	CORPUS(send_sms_421), CORPUS(send_sms_422), CORPUS(send_sms_431),
+	CORPUS(send_sms_432), CORPUS(send_sms_441), CORPUS(send_sms_442),
+	CORPUS(send_sms_443), CORPUS(send_sms_451), CORPUS(send_sms_452),
+	CORPUS(send_sms_453), CORPUS(send_sms_461), CORPUS(send_sms_462),
+	CORPUS(send_sms_463), CORPUS(send_sms_471), CORPUS(send_sms_472),
+	CORPUS(send_sms_473), CORPUS(send_sms_481), CORPUS(send_sms_482),
+	CORPUS(send_sms_483), CORPUS(send_sms_491), CORPUS(send_sms_492),
+	CORPUS(send_sms_493), CORPUS(send_sms_4101), CORPUS(send_sms_4102),
+	CORPUS(send_sms_511), CORPUS(send_sms_512), CORPUS(send_sms_513),
+	CORPUS(send_sms_611), CORPUS(send_sms_612), CORPUS(send_sms_613),
+	CORPUS(send_ss_111), CORPUS(send_ss_141), CORPUS(send_ss_151),
+	CORPUS(send_ss_161), CORPUS(send_ss_211), CORPUS(send_ss_221),
+	CORPUS(send_ss_231), CORPUS(send_ss_241), CORPUS(send_ss_311),
+	CORPUS(send_ss_411), CORPUS(send_ss_412), CORPUS(send_ss_421),
+	CORPUS(send_ss_422), CORPUS(send_ss_431), CORPUS(send_ss_432),
+	CORPUS(send_ss_441), CORPUS(send_ss_442), CORPUS(send_ss_443),
+	CORPUS(send_ss_451), CORPUS(send_ss_452), CORPUS(send_ss_453),
+	CORPUS(send_ss_461), CORPUS(send_ss_462), CORPUS(send_ss_463),
+	CORPUS(send_ss_471), CORPUS(send_ss_472), CORPUS(send_ss_473),
+	CORPUS(send_ss_481), CORPUS(send_ss_482), CORPUS(send_ss_483),
+	CORPUS(send_ss_491), CORPUS(send_ss_492), CORPUS(send_ss_493),
+	CORPUS(send_ss_4101), CORPUS(send_ss_4102), CORPUS(send_ss_511),
+	CORPUS(send_ss_611), CORPUS(send_ussd_111), CORPUS(send_ussd_121),
+	CORPUS(send_ussd_131), CORPUS(send_ussd_161), CORPUS(send_ussd_171),
+	CORPUS(send_ussd_181), CORPUS(send_ussd_211), CORPUS(send_ussd_221),
+	CORPUS(send_ussd_231), CORPUS(send_ussd_241), CORPUS(send_ussd_311),
+	CORPUS(send_ussd_411), CORPUS(send_ussd_412), CORPUS(send_ussd_421),
+	CORPUS(send_ussd_422), CORPUS(send_ussd_431), CORPUS(send_ussd_432),
+	CORPUS(send_ussd_441), CORPUS(send_ussd_442), CORPUS(send_ussd_443),
+	CORPUS(send_ussd_451), CORPUS(send_ussd_452), CORPUS(send_ussd_453),
+	CORPUS(send_ussd_461), CORPUS(send_ussd_462), CORPUS(send_ussd_463),
+	CORPUS(send_ussd_471), CORPUS(send_ussd_472), CORPUS(send_ussd_473),
+	CORPUS(send_ussd_481), CORPUS(send_ussd_482), CORPUS(send_ussd_483),
+	CORPUS(send_ussd_491), CORPUS(send_ussd_492), CORPUS(send_ussd_493),
+	CORPUS(send_ussd_4101), CORPUS(send_ussd_4102), CORPUS(send_ussd_511),
+	CORPUS(send_ussd_611), CORPUS(setup_call_111), CORPUS(setup_call_141),
+	CORPUS(setup_call_151), CORPUS(setup_call_181), CORPUS(setup_call_191),
+	CORPUS(setup_call_1101), CORPUS(setup_call_1111),
+	CORPUS(setup_call_1121), CORPUS(setup_call_211), CORPUS(setup_call_311),
+	CORPUS(setup_call_321), CORPUS(setup_call_331), CORPUS(setup_call_341),
+	CORPUS(setup_call_411), CORPUS(setup_call_412), CORPUS(setup_call_421),
+	CORPUS(setup_call_422), CORPUS(setup_call_431), CORPUS(setup_call_432),
+	CORPUS(setup_call_441), CORPUS(setup_call_442), CORPUS(setup_call_443),
+	CORPUS(setup_call_451), CORPUS(setup_call_452), CORPUS(setup_call_453),
+	CORPUS(setup_call_461), CORPUS(setup_call_462), CORPUS(setup_call_463),
+	CORPUS(setup_call_471), CORPUS(setup_call_472), CORPUS(setup_call_473),
+	CORPUS(setup_call_481), CORPUS(setup_call_482), CORPUS(setup_call_483),
+	CORPUS(setup_call_491), CORPUS(setup_call_492), CORPUS(setup_call_493),
+	CORPUS(setup_call_4101), CORPUS(setup_call_4102),
+	CORPUS(setup_call_511), CORPUS(setup_call_521), CORPUS(setup_call_611),
+	CORPUS(setup_call_621), CORPUS(setup_call_711), CORPUS(setup_call_721),
+	CORPUS(refresh_121), CORPUS(refresh_151), CORPUS(polling_off_112),
+	CORPUS(provide_local_info_121), CORPUS(provide_local_info_141),
+	CORPUS(provide_local_info_151), CORPUS(provide_local_info_181),
+	CORPUS(provide_local_info_191), CORPUS(provide_local_info_1111),
+	CORPUS(setup_event_list_111), CORPUS(setup_event_list_121),
+	CORPUS(setup_event_list_122), CORPUS(setup_event_list_131),
+	CORPUS(setup_event_list_132), CORPUS(setup_event_list_141),
+	CORPUS(perform_card_apdu_111), CORPUS(perform_card_apdu_112),
+	CORPUS(perform_card_apdu_121), CORPUS(perform_card_apdu_122),
+	CORPUS(perform_card_apdu_123), CORPUS(perform_card_apdu_124),
+	CORPUS(perform_card_apdu_125), CORPUS(perform_card_apdu_151),
+	CORPUS(perform_card_apdu_211), CORPUS(get_reader_status_111),
+	CORPUS(timer_mgmt_111), CORPUS(timer_mgmt_112), CORPUS(timer_mgmt_113),
+	CORPUS(timer_mgmt_114), CORPUS(timer_mgmt_121), CORPUS(timer_mgmt_122),
+	CORPUS(timer_mgmt_123), CORPUS(timer_mgmt_124), CORPUS(timer_mgmt_131),
+	CORPUS(timer_mgmt_132), CORPUS(timer_mgmt_133), CORPUS(timer_mgmt_134),
+	CORPUS(timer_mgmt_141), CORPUS(timer_mgmt_142), CORPUS(timer_mgmt_143),
+	CORPUS(timer_mgmt_144), CORPUS(timer_mgmt_145), CORPUS(timer_mgmt_146),
+	CORPUS(timer_mgmt_147), CORPUS(timer_mgmt_148), CORPUS(timer_mgmt_151),
+	CORPUS(timer_mgmt_152), CORPUS(timer_mgmt_153), CORPUS(timer_mgmt_154),
+	CORPUS(timer_mgmt_155), CORPUS(timer_mgmt_156), CORPUS(timer_mgmt_157),
+	CORPUS(timer_mgmt_158), CORPUS(timer_mgmt_161), CORPUS(timer_mgmt_162),
+	CORPUS(timer_mgmt_163), CORPUS(timer_mgmt_164), CORPUS(timer_mgmt_165),
+	CORPUS(timer_mgmt_166), CORPUS(timer_mgmt_167), CORPUS(timer_mgmt_168),
+	CORPUS(timer_mgmt_211), CORPUS(timer_mgmt_221),
+	CORPUS(setup_idle_mode_text_111), CORPUS(setup_idle_mode_text_121),
+	CORPUS(setup_idle_mode_text_131), CORPUS(setup_idle_mode_text_171),
+	CORPUS(setup_idle_mode_text_211), CORPUS(setup_idle_mode_text_221),
+	CORPUS(setup_idle_mode_text_231), CORPUS(setup_idle_mode_text_241),
+	CORPUS(setup_idle_mode_text_311), CORPUS(setup_idle_mode_text_411),
+	CORPUS(setup_idle_mode_text_412), CORPUS(setup_idle_mode_text_421),
+	CORPUS(setup_idle_mode_text_422), CORPUS(setup_idle_mode_text_431),
+	CORPUS(setup_idle_mode_text_432), CORPUS(setup_idle_mode_text_441),
+	CORPUS(setup_idle_mode_text_442), CORPUS(setup_idle_mode_text_443),
+	CORPUS(setup_idle_mode_text_451), CORPUS(setup_idle_mode_text_452),
+	CORPUS(setup_idle_mode_text_453), CORPUS(setup_idle_mode_text_461),
+	CORPUS(setup_idle_mode_text_462), CORPUS(setup_idle_mode_text_463),
+	CORPUS(setup_idle_mode_text_471), CORPUS(setup_idle_mode_text_472),
+	CORPUS(setup_idle_mode_text_473), CORPUS(setup_idle_mode_text_481),
+	CORPUS(setup_idle_mode_text_482), CORPUS(setup_idle_mode_text_483),
+	CORPUS(setup_idle_mode_text_491), CORPUS(setup_idle_mode_text_492),
+	CORPUS(setup_idle_mode_text_493), CORPUS(setup_idle_mode_text_4101),
+	CORPUS(setup_idle_mode_text_4102), CORPUS(setup_idle_mode_text_511),
+	CORPUS(setup_idle_mode_text_611), CORPUS(run_at_command_111),
+	CORPUS(run_at_command_121), CORPUS(run_at_command_131),
+	CORPUS(run_at_command_211), CORPUS(run_at_command_221),
+	CORPUS(run_at_command_231), CORPUS(run_at_command_241),
+	CORPUS(run_at_command_251), CORPUS(run_at_command_311),
+	CORPUS(run_at_command_312), CORPUS(run_at_command_321),
+	CORPUS(run_at_command_322), CORPUS(run_at_command_331),
+	CORPUS(run_at_command_332), CORPUS(run_at_command_341),
+	CORPUS(run_at_command_342), CORPUS(run_at_command_343),
+	CORPUS(run_at_command_351), CORPUS(run_at_command_352),
+	CORPUS(run_at_command_353), CORPUS(run_at_command_361),
+	CORPUS(run_at_command_362), CORPUS(run_at_command_363),
+	CORPUS(run_at_command_371), CORPUS(run_at_command_372),
+	CORPUS(run_at_command_373), CORPUS(run_at_command_381),
+	CORPUS(run_at_command_382), CORPUS(run_at_command_383),
+	CORPUS(run_at_command_391), CORPUS(run_at_command_392),
+	CORPUS(run_at_command_393), CORPUS(run_at_command_3101),
+	CORPUS(run_at_command_3102), CORPUS(run_at_command_411),
+	CORPUS(run_at_command_511), CORPUS(run_at_command_611),
+	CORPUS(send_dtmf_111), CORPUS(send_dtmf_121), CORPUS(send_dtmf_131),
+	CORPUS(send_dtmf_211), CORPUS(send_dtmf_221), CORPUS(send_dtmf_231),
+	CORPUS(send_dtmf_311), CORPUS(send_dtmf_411), CORPUS(send_dtmf_412),
+	CORPUS(send_dtmf_421), CORPUS(send_dtmf_422), CORPUS(send_dtmf_431),
+	CORPUS(send_dtmf_432), CORPUS(send_dtmf_441), CORPUS(send_dtmf_442),
+	CORPUS(send_dtmf_443), CORPUS(send_dtmf_451), CORPUS(send_dtmf_452),
+	CORPUS(send_dtmf_453), CORPUS(send_dtmf_461), CORPUS(send_dtmf_462),
+	CORPUS(send_dtmf_463), CORPUS(send_dtmf_471), CORPUS(send_dtmf_472),
+	CORPUS(send_dtmf_473), CORPUS(send_dtmf_481), CORPUS(send_dtmf_482),
+	CORPUS(send_dtmf_483), CORPUS(send_dtmf_491), CORPUS(send_dtmf_492),
+	CORPUS(send_dtmf_493), CORPUS(send_dtmf_4101), CORPUS(send_dtmf_4102),
+	CORPUS(send_dtmf_511), CORPUS(send_dtmf_611),
+	CORPUS(language_notification_111), CORPUS(language_notification_121),
+	CORPUS(launch_browser_111), CORPUS(launch_browser_121),
+	CORPUS(launch_browser_131), CORPUS(launch_browser_141),
+	CORPUS(launch_browser_211), CORPUS(launch_browser_221),
+	CORPUS(launch_browser_231), CORPUS(launch_browser_311),
+	CORPUS(launch_browser_411), CORPUS(launch_browser_421),
+	CORPUS(launch_browser_511), CORPUS(launch_browser_512),
+	CORPUS(launch_browser_521), CORPUS(launch_browser_522),
+	CORPUS(launch_browser_531), CORPUS(launch_browser_532),
+	CORPUS(launch_browser_541), CORPUS(launch_browser_542),
+	CORPUS(launch_browser_543), CORPUS(launch_browser_551),
+	CORPUS(launch_browser_552), CORPUS(launch_browser_553),
+	CORPUS(launch_browser_561), CORPUS(launch_browser_562),
+	CORPUS(launch_browser_563), CORPUS(launch_browser_571),
+	CORPUS(launch_browser_572), CORPUS(launch_browser_573),
+	CORPUS(launch_browser_581), CORPUS(launch_browser_582),
+	CORPUS(launch_browser_583), CORPUS(launch_browser_591),
+	CORPUS(launch_browser_592), CORPUS(launch_browser_593),
+	CORPUS(launch_browser_5101), CORPUS(launch_browser_5102),
+	CORPUS(launch_browser_611), CORPUS(launch_browser_711),
+	CORPUS(open_channel_211), CORPUS(open_channel_221),
+	CORPUS(open_channel_231), CORPUS(open_channel_241),
+	CORPUS(open_channel_511), CORPUS(close_channel_111),
+	CORPUS(close_channel_211), CORPUS(receive_data_111),
+	CORPUS(receive_data_211), CORPUS(send_data_111), CORPUS(send_data_121),
+	CORPUS(send_data_211), CORPUS(get_channel_status_111),
+};
+
+#define PARSE_BENCHMARK_ROUNDS 1000
+
+static void test_parse_benchmark(void)
+{
+	unsigned int round;
+	unsigned int i;
+	unsigned int count = 0;
+	double elapsed;
+
+	g_test_timer_start();
+
+	for (round = 0; round < PARSE_BENCHMARK_ROUNDS; round++) {
+		for (i = 0; i < G_N_ELEMENTS(parse_corpus); i++) {
+			struct stk_command *command;
+
+			command = stk_command_new_from_pdu(parse_corpus[i].pdu,
+							parse_corpus[i].pdu_len);
+			if (command)
+				stk_command_free(command);
+
+			count++;
+		}
+	}
+
+	elapsed = g_test_timer_elapsed();
+
+	g_test_minimized_result(elapsed * 1e9 / count,
+				"%.1f ns/PDU over %u PDUs",
+				elapsed * 1e9 / count, count);
+}
+
 int main(int argc, char **argv)
 {
 	g_test_init(&argc, &argv, NULL);
@@ -22660,6 +23118,9 @@ int main(int argc, char **argv)
 	g_test_add_data_func("/teststk/Get Input response 1.2.1",
 				&get_input_response_data_121,
 				test_terminal_response_encoding);
+	g_test_add_data_func("/teststk/Get Input response 1.2.1 own buf",
+				&get_input_response_data_121,
+				test_terminal_response_own_buf);
 	g_test_add_data_func("/teststk/Get Input response 1.3.1",
 				&get_input_response_data_131,
 				test_terminal_response_encoding);
@@ -24258,6 +24719,11 @@ int main(int argc, char **argv)
 			&call_control_data_131a, test_envelope_encoding);
 	g_test_add_data_func("/teststk/Call Control 1.3.1B",
 			&call_control_data_131b, test_envelope_encoding);
+	g_test_add_data_func("/teststk/Call Control alpha id GSM",
+			&call_control_data_alpha_id_gsm, test_envelope_encoding);
+	g_test_add_data_func("/teststk/Call Control alpha id UCS2",
+			&call_control_data_alpha_id_ucs2,
+			test_envelope_encoding);
 
 	g_test_add_data_func("/teststk/MO Short Message Control 1.1.1A",
 			&mo_short_message_control_data_111a,
@@ -24419,5 +24885,9 @@ int main(int argc, char **argv)
 	g_test_add_data_func("/teststk/IMG to XPM Test 6",
 				&xpm_test_6, test_img_to_xpm);
 
+	if (g_test_perf())
+		g_test_add_func("/teststk/Parse benchmark",
+					test_parse_benchmark);
+
 	return g_test_run();
 }
@@ -1012,6 +1012,41 @@ static void test_unicode_to_gsm(void)
 	}
 }
 
+static void test_own_buf_conversions(void)
+{
+	unsigned char buf[8];
+	long nwritten;
+
+	memset(buf, 0xff, sizeof(buf));
+	g_assert(convert_utf8_to_gsm_own_buf("a\xe2\x82\xac", -1, NULL,
+						&nwritten, 0xff, buf, 4) == buf);
+	g_assert(nwritten == 3);
+	g_assert(buf[0] == 0x61 && buf[1] == 0x1b && buf[2] == 0x65);
+	g_assert(buf[3] == 0xff);
+
+	/* Does not fit, the buffer must not be touched */
+	memset(buf, 0xff, sizeof(buf));
+	g_assert(convert_utf8_to_gsm_own_buf("a\xe2\x82\xac", -1, NULL,
+						&nwritten, 0xff, buf, 3) == NULL);
+	g_assert(buf[0] == 0xff);
+
+	g_assert(convert_utf8_to_gsm_own_buf("\xd0\x96", -1, NULL,
+						&nwritten, 0, buf, 8) == NULL);
+
+	g_assert(convert_utf8_to_ucs2_own_buf("a\xd0\x96", -1, &nwritten,
+						buf, 4) == buf);
+	g_assert(nwritten == 4);
+	g_assert(buf[0] == 0x00 && buf[1] == 0x61);
+	g_assert(buf[2] == 0x04 && buf[3] == 0x16);
+
+	g_assert(convert_utf8_to_ucs2_own_buf("a\xd0\x96", -1, &nwritten,
+						buf, 3) == NULL);
+	g_assert(convert_utf8_to_ucs2_own_buf("\xf0\x9f\x98\x80", -1,
+						&nwritten, buf, 8) == NULL);
+	g_assert(convert_utf8_to_ucs2_own_buf("\xd0", -1, &nwritten,
+						buf, 8) == NULL);
+}
+
 int main(int argc, char **argv)
 {
 	g_test_init(&argc, &argv, NULL);
@@ -1028,6 +1063,8 @@ int main(int argc, char **argv)
 	g_test_add_func("/testutil/SIM conversions", test_sim);
 	g_test_add_func("/testutil/Valid Unicode to GSM Conversion",
 			test_unicode_to_gsm);
+	g_test_add_func("/testutil/Own buffer conversions",
+			test_own_buf_conversions);
 
 	return g_test_run();
 }